@@ -26,26 +26,82 @@
 #ifndef __UKARCH_SPINLOCK_H__
 #define __UKARCH_SPINLOCK_H__
 
+#include <uk/config.h>
+#include <uk/arch/types.h>
+#include <uk/arch/lcpu.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-typedef struct {} spinlock_t;
+#if CONFIG_HAVE_SMP
+/*
+ * Ticket lock: lockers take a ticket from `next` and spin until `owner`
+ * reaches it. This keeps acquisitions in FIFO order, so that no CPU
+ * starves under contention.
+ */
+typedef struct {
+	__u16 next;
+	__u16 owner;
+} spinlock_t;
+
+#define ukarch_spin_lock_init(lock)					\
+	do {								\
+		(lock)->next = 0;					\
+		(lock)->owner = 0;					\
+	} while (0)
 
-#ifdef CONFIG_SMP
-#error "Define your spinlock operations!"
-#else
+#define ukarch_spin_is_locked(lock)					\
+	(__atomic_load_n(&(lock)->owner, __ATOMIC_RELAXED)		\
+	 != __atomic_load_n(&(lock)->next, __ATOMIC_RELAXED))
+
+static inline void ukarch_spin_lock(spinlock_t *lock)
+{
+	__u16 ticket;
+
+	ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+	while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket)
+		ukarch_spinwait();
+}
+
+/* Returns 1 if the lock was taken, 0 otherwise */
+static inline int ukarch_spin_trylock(spinlock_t *lock)
+{
+	__u16 owner;
+	__u16 ticket;
+
+	owner = __atomic_load_n(&lock->owner, __ATOMIC_RELAXED);
+	ticket = owner;
+	return __atomic_compare_exchange_n(&lock->next, &ticket,
+					   (__u16) (owner + 1), 0,
+					   __ATOMIC_ACQUIRE,
+					   __ATOMIC_RELAXED);
+}
+
+static inline void ukarch_spin_unlock(spinlock_t *lock)
+{
+	__atomic_store_n(&lock->owner, (__u16) (lock->owner + 1),
+			 __ATOMIC_RELEASE);
+}
+
+#define UKARCH_SPINLOCK_INITIALIZER()    { 0, 0 }
+
+#else /* !CONFIG_HAVE_SMP */
+
+typedef struct {} spinlock_t;
 
 #define ukarch_spin_lock_init(lock)      (void)(lock)
-#define ukarch_spin_is_locked(lock)      (void)(lock)
+#define ukarch_spin_is_locked(lock)      ((void)(lock), 0)
 #define ukarch_spin_lock(lock)           (void)(lock)
-#define ukarch_spin_trylock(lock)        (void)(lock)
+#define ukarch_spin_trylock(lock)        ((void)(lock), 1)
 #define ukarch_spin_unlock(lock)         (void)(lock)
 
-/* Defines a preinitialized spin_lock in unlocked state */
-#define DEFINE_SPINLOCK(lock)            spinlock_t lock = {}
+#define UKARCH_SPINLOCK_INITIALIZER()    {}
 
-#endif
+#endif /* !CONFIG_HAVE_SMP */
+
+#define DEFINE_SPINLOCK(lock)						\
+	spinlock_t lock = UKARCH_SPINLOCK_INITIALIZER()
 
 #ifdef __cplusplus
 }
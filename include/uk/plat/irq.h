@@ -56,6 +56,19 @@ typedef int (*irq_handler_func_t)(void *);
  */
 int ukplat_irq_register(unsigned long irq, irq_handler_func_t func, void *arg);
 
+typedef void (*irq_exit_func_t)(void);
+
+/**
+ * Sets a function that is called at the end of each interrupt, after the
+ * interrupt was acknowledged. The function is called on the stack of the
+ * interrupted thread with interrupts disabled, so it may switch to another
+ * thread (e.g., to preempt the interrupted one).
+ * @param func Exit function, NULL to remove it
+ * @return 0 on success, -ENOTSUP if the platform cannot switch threads
+ *         from interrupt context
+ */
+int ukplat_irq_set_exit_handler(irq_exit_func_t func);
+
 #ifdef __cplusplus
 }
 #endif
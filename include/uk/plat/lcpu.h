@@ -34,16 +34,49 @@
 #ifndef __UKPLAT_LCPU_H__
 #define __UKPLAT_LCPU_H__
 
+#include <uk/config.h>
 #include <uk/arch/time.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#if UKPLAT_LCPU_MULTICORE
+#if CONFIG_HAVE_SMP
+#define UKPLAT_LCPU_MAXCOUNT CONFIG_UKPLAT_LCPU_MAXCOUNT
+
+/**
+ * Returns the ID of the current logical CPU. The boot CPU has always ID 0,
+ * the remaining ones are numbered contiguously up to ukplat_lcpu_count() - 1
+ */
 __u8 ukplat_lcpu_id(void);
+
+/**
+ * Returns the number of logical CPUs that can be started
+ */
 __u8 ukplat_lcpu_count(void);
+
+typedef void (*ukplat_lcpu_entry_t)(void *arg);
+
+/**
+ * Starts a secondary logical CPU. The CPU begins executing `entry` on a
+ * small platform-provided stack with interrupts disabled. `entry` must not
+ * return; it is expected to switch to a thread context.
+ * @param id ID of the logical CPU (1 .. ukplat_lcpu_count() - 1)
+ * @param entry Function to execute on the logical CPU
+ * @param arg Argument passed to `entry`
+ * @return 0 on success, negative errno value otherwise
+ */
+int ukplat_lcpu_start(__u8 id, ukplat_lcpu_entry_t entry, void *arg);
+
+/**
+ * Kicks a logical CPU out of a halt. Calling it for a CPU that is not
+ * halted has no effect other than a spurious return from its next halt.
+ * @param id ID of the logical CPU
+ */
+void ukplat_lcpu_wakeup(__u8 id);
 #else
+#define UKPLAT_LCPU_MAXCOUNT 1
+
 #define ukplat_lcpu_id()    (0)
 #define ukplat_lcpu_count() (1)
 #endif
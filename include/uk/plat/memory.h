@@ -156,6 +156,15 @@ int ukplat_memallocator_set(struct uk_alloc *a);
  */
 struct uk_alloc *ukplat_memallocator_get(void);
 
+/**
+ * Returns the size of the huge pages with which the platform maps its
+ * allocatable memory. Any chunk of allocatable memory that is aligned to
+ * this size is backed by a single huge page mapping.
+ * @return Huge page size in bytes, 0 if the platform does not map memory
+ *         with huge pages
+ */
+__sz ukplat_mem_hugepage_size(void);
+
 /**
  * Sets the current thread address on top of kernel stack
  * @param thread_addr Current thread address
@@ -46,6 +46,23 @@ void ukplat_time_fini(void);
 __nsec ukplat_monotonic_clock(void);
 __nsec ukplat_wall_clock(void);
 
+/**
+ * Requests a timer interrupt at (or shortly after) the given monotonic
+ * time. Only the latest request is kept and idling the CPU with
+ * ukplat_lcpu_halt_to() overrides it. The interrupt may also fire early,
+ * so callers have to check the time and re-arm if needed. Platforms with
+ * a periodic timer tick may ignore the request.
+ * @param deadline Monotonic time in nanoseconds
+ */
+void ukplat_time_set_deadline(__nsec deadline);
+
+/**
+ * Returns the number of timer interrupts on all logical CPUs since boot.
+ * Sampling it twice gives the timer interrupt rate, e.g., to check that an
+ * idle system does not wake up periodically.
+ */
+__u64 ukplat_time_irq_count(void);
+
 /* Time tick length */
 #define UKPLAT_TIME_TICK_NSEC  (UKARCH_NSEC_PER_SEC / CONFIG_HZ)
 #define UKPLAT_TIME_TICK_MSEC  ukarch_time_nsec_to_msec(UKPLAT_TIME_TICK_NSEC)
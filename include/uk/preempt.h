@@ -34,7 +34,46 @@
 #ifndef __UK_PREEMPT_H__
 #define __UK_PREEMPT_H__
 
+#include <uk/config.h>
+#include <uk/arch/lcpu.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if CONFIG_HAVE_PREEMPT
+/* Preemption is deferred while this counter is non-zero. It is provided by
+ * the preemptive scheduler.
+ */
+extern unsigned long uk_preempt_count;
+/* Set when the scheduler wants to switch threads while preemption is
+ * disabled
+ */
+extern int uk_preempt_pending;
+
+/* Performs a deferred reschedule, provided by the preemptive scheduler */
+void uk_preempt_schedule(void);
+
+#define uk_preempt_disable()			\
+	do {					\
+		uk_preempt_count++;		\
+		barrier();			\
+	} while (0)
+#define uk_preempt_enable()					\
+	do {							\
+		barrier();					\
+		if (--uk_preempt_count == 0 && uk_preempt_pending) \
+			uk_preempt_schedule();			\
+	} while (0)
+#define uk_preempt_disabled() (uk_preempt_count != 0)
+#else /* !CONFIG_HAVE_PREEMPT */
 #define uk_preempt_disable()  barrier()
 #define uk_preempt_enable()   barrier()
+#define uk_preempt_disabled() (1)
+#endif /* !CONFIG_HAVE_PREEMPT */
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* __UK_PREEMPT_H__ */
@@ -45,6 +45,7 @@ extern "C" {
 #define __NEED_ssize_t
 #define __NEED_off_t
 #define __NEED_useconds_t
+#define __NEED_pid_t
 
 /*
  * Sysconf name values
@@ -60,6 +61,8 @@ unsigned int sleep(unsigned int seconds);
 #endif
 
 #if CONFIG_LIBPOSIX_PROCESS
+pid_t getpid(void);
+pid_t getppid(void);
 int execl(const char *path, const char *arg, ...
 		/* (char  *) NULL */);
 int execlp(const char *file, const char *arg, ...
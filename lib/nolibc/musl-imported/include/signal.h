@@ -65,12 +65,22 @@ typedef __sigset_t sigset_t;
 
 #define NSIG _NSIG
 
+union sigval {
+	int    sival_int;	/* Integer signal value */
+	void  *sival_ptr;	/* Pointer signal value */
+};
+
 typedef struct {
 	int          si_signo;    /* Signal number */
 	int          si_code;     /* Cause of the signal */
 	pid_t	       si_pid;	    /* Sending process ID */
+	union sigval si_value;    /* Signal value */
 } siginfo_t;
 
+#define SI_USER   0
+#define SI_QUEUE  (-1)
+#define SI_TIMER  (-2)
+
 struct sigaction {
 	union {
 		void (*sa_handler)(int);
@@ -119,11 +129,9 @@ int sigaddset(sigset_t *set, int signo);
 int sigdelset(sigset_t *set, int signo);
 int sigismember(const sigset_t *set, int signo);
 
-/* TODO: not used - defined just for newlib */
-union sigval {
-	int    sival_int;	/* Integer signal value */
-	void  *sival_ptr;	/* Pointer signal value */
-};
+#define SIGEV_SIGNAL 0
+#define SIGEV_NONE   1
+#define SIGEV_THREAD 2
 
 struct sigevent {
 	int              sigev_notify;	/* Notification type */
@@ -40,6 +40,7 @@
 #include <uk/assert.h>
 #include <uk/arch/limits.h>
 #include <uk/arch/lcpu.h>
+#include <uk/plat/memory.h>
 
 #define size_to_num_pages(size) \
 	(ALIGN_UP((unsigned long)(size), __PAGE_SIZE) / __PAGE_SIZE)
@@ -51,6 +52,8 @@ int uk_alloc_register(struct uk_alloc *a)
 {
 	struct uk_alloc *this = _uk_alloc_head;
 
+	uk_alloc_lock_init(a);
+
 	if (!_uk_alloc_head) {
 		_uk_alloc_head = a;
 		a->next = __NULL;
@@ -552,6 +555,68 @@ long uk_alloc_pavailmem_compat(struct uk_alloc *a)
 	return (long) (mem >> __PAGE_SHIFT);
 }
 
+/* Returns the number of pages to request for a huge page allocation,
+ * 0 if the request cannot be served with huge pages
+ */
+static inline unsigned long huge_num_pages(unsigned long num_pages,
+					   __sz hp_size)
+{
+	unsigned long hp_num_pages;
+
+	if (!hp_size)
+		return 0;
+
+	hp_num_pages = hp_size >> __PAGE_SHIFT;
+	if (num_pages < hp_num_pages)
+		return 0;
+	return ALIGN_UP(num_pages, hp_num_pages);
+}
+
+void *uk_palloc_huge(struct uk_alloc *a, unsigned long num_pages)
+{
+	unsigned long hnum_pages;
+	__sz hp_size;
+	void *ptr;
+
+	UK_ASSERT(a);
+
+	hp_size = ukplat_mem_hugepage_size();
+	hnum_pages = huge_num_pages(num_pages, hp_size);
+	if (!hnum_pages)
+		return uk_palloc(a, num_pages);
+
+	ptr = uk_palloc(a, hnum_pages);
+	if (unlikely(!ptr))
+		return __NULL;
+
+	if (likely(((__uptr) ptr & (hp_size - 1)) == 0))
+		uk_alloc_stats_count_huge(a, ((__sz) hnum_pages
+					      << __PAGE_SHIFT) / hp_size);
+	else
+		uk_alloc_stats_count_huge(a, 0);
+	return ptr;
+}
+
+void uk_pfree_huge(struct uk_alloc *a, void *ptr, unsigned long num_pages)
+{
+	unsigned long hnum_pages;
+	__sz hp_size;
+
+	UK_ASSERT(a);
+
+	hp_size = ukplat_mem_hugepage_size();
+	hnum_pages = huge_num_pages(num_pages, hp_size);
+	if (!hnum_pages) {
+		uk_pfree(a, ptr, num_pages);
+		return;
+	}
+
+	if (likely(((__uptr) ptr & (hp_size - 1)) == 0))
+		uk_alloc_stats_count_hugefree(a, ((__sz) hnum_pages
+						  << __PAGE_SHIFT) / hp_size);
+	uk_pfree(a, ptr, hnum_pages);
+}
+
 __sz uk_alloc_availmem_total(void)
 {
 	struct uk_alloc *a;
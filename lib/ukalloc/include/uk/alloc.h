@@ -38,6 +38,11 @@
 #include <uk/config.h>
 #include <uk/assert.h>
 #include <uk/essentials.h>
+#include <uk/preempt.h>
+#if CONFIG_HAVE_SMP
+#include <uk/arch/spinlock.h>
+#include <uk/plat/lcpu.h>
+#endif
 #include <errno.h>
 
 #ifdef __cplusplus
@@ -58,6 +63,8 @@ typedef void* (*uk_alloc_realloc_func_t)
 		(struct uk_alloc *a, void *ptr, __sz size);
 typedef void  (*uk_alloc_free_func_t)
 		(struct uk_alloc *a, void *ptr);
+typedef int   (*uk_alloc_free_fast_func_t)
+		(struct uk_alloc *a, void *ptr);
 typedef void* (*uk_alloc_palloc_func_t)
 		(struct uk_alloc *a, unsigned long num_pages);
 typedef void  (*uk_alloc_pfree_func_t)
@@ -84,6 +91,14 @@ struct uk_alloc_stats {
 	__ssz max_mem_use; /* maximum amount of memory used by allocations */
 
 	__u64 nb_enomem; /* number of times failing allocation requests */
+
+	__u64 nb_lookups; /* number of internal metadata lookups */
+	__u64 nb_lookup_steps; /* steps (e.g., comparisons) spent on lookups */
+
+	__u64 tot_nb_huge_allocs; /* allocations backed by huge pages */
+	__u64 nb_huge_fallbacks; /* huge requests not backed by huge pages */
+	__sz cur_nb_huge_pages; /* huge pages currently handed out */
+	__sz max_nb_huge_pages; /* maximum of handed out huge pages */
 };
 #endif /* CONFIG_LIBUKALLOC_IFSTATS */
 
@@ -95,6 +110,12 @@ struct uk_alloc {
 	uk_alloc_posix_memalign_func_t posix_memalign;
 	uk_alloc_memalign_func_t memalign;
 	uk_alloc_free_func_t free;
+	/* optional lock-free fast paths, called before the allocator lock is
+	 * taken: they return NULL (malloc) or non-zero (free) if the request
+	 * has to go to the interfaces above
+	 */
+	uk_alloc_malloc_func_t malloc_fast;
+	uk_alloc_free_fast_func_t free_fast;
 
 #if CONFIG_LIBUKALLOC_IFMALLOC
 	uk_alloc_free_func_t free_backend;
@@ -116,6 +137,12 @@ struct uk_alloc {
 	struct uk_alloc_stats _stats;
 #endif
 
+#if CONFIG_HAVE_SMP
+	spinlock_t lock;
+	__u8 lock_owner; /* logical CPU ID + 1 of the lock holder, 0 if free */
+	unsigned int lock_depth;
+#endif
+
 	/* internal */
 	struct uk_alloc *next;
 	__u8 priv[];
@@ -138,11 +165,75 @@ static inline struct uk_alloc *uk_alloc_get_default(void)
 }
 #endif /* !CONFIG_LIBUKALLOC_IFSTATS_PERLIB */
 
+#if CONFIG_HAVE_SMP
+/* Allocator implementations are not reentrant: every call holds the lock of
+ * the allocator with interrupts disabled. The lock is recursive because
+ * compatibility helpers (e.g., uk_realloc_compat()) call the wrappers again.
+ */
+#define uk_alloc_lock_init(a)						\
+	do {								\
+		ukarch_spin_lock_init(&(a)->lock);			\
+		(a)->lock_owner = 0;					\
+		(a)->lock_depth = 0;					\
+	} while (0)
+
+static inline unsigned long uk_alloc_lock(struct uk_alloc *a)
+{
+	unsigned long flags = ukplat_lcpu_save_irqf();
+	__u8 self = ukplat_lcpu_id() + 1;
+
+	if (__atomic_load_n(&a->lock_owner, __ATOMIC_RELAXED) != self) {
+		ukarch_spin_lock(&a->lock);
+		__atomic_store_n(&a->lock_owner, self, __ATOMIC_RELAXED);
+	}
+	a->lock_depth++;
+	return flags;
+}
+
+static inline void uk_alloc_unlock(struct uk_alloc *a, unsigned long flags)
+{
+	if (--a->lock_depth == 0) {
+		__atomic_store_n(&a->lock_owner, 0, __ATOMIC_RELAXED);
+		ukarch_spin_unlock(&a->lock);
+	}
+	ukplat_lcpu_restore_irqf(flags);
+}
+#else /* !CONFIG_HAVE_SMP */
+/* Allocator implementations are not reentrant, so they are called with
+ * preemption disabled
+ */
+#define uk_alloc_lock_init(a) do {} while (0)
+
+static inline unsigned long uk_alloc_lock(struct uk_alloc *a __unused)
+{
+	uk_preempt_disable();
+	return 0;
+}
+
+static inline void uk_alloc_unlock(struct uk_alloc *a __unused,
+				   unsigned long flags __unused)
+{
+	uk_preempt_enable();
+}
+#endif /* !CONFIG_HAVE_SMP */
+
 /* wrapper functions */
 static inline void *uk_do_malloc(struct uk_alloc *a, __sz size)
 {
+	void *ptr;
+	unsigned long flags;
+
 	UK_ASSERT(a);
-	return a->malloc(a, size);
+	if (a->malloc_fast) {
+		ptr = a->malloc_fast(a, size);
+		if (likely(ptr))
+			return ptr;
+	}
+
+	flags = uk_alloc_lock(a);
+	ptr = a->malloc(a, size);
+	uk_alloc_unlock(a, flags);
+	return ptr;
 }
 
 static inline void *uk_malloc(struct uk_alloc *a, __sz size)
@@ -157,8 +248,14 @@ static inline void *uk_malloc(struct uk_alloc *a, __sz size)
 static inline void *uk_do_calloc(struct uk_alloc *a,
 				 __sz nmemb, __sz size)
 {
+	void *ptr;
+	unsigned long flags;
+
 	UK_ASSERT(a);
-	return a->calloc(a, nmemb, size);
+	flags = uk_alloc_lock(a);
+	ptr = a->calloc(a, nmemb, size);
+	uk_alloc_unlock(a, flags);
+	return ptr;
 }
 
 static inline void *uk_calloc(struct uk_alloc *a,
@@ -177,8 +274,14 @@ static inline void *uk_calloc(struct uk_alloc *a,
 static inline void *uk_do_realloc(struct uk_alloc *a,
 				  void *ptr, __sz size)
 {
+	void *ret;
+	unsigned long flags;
+
 	UK_ASSERT(a);
-	return a->realloc(a, ptr, size);
+	flags = uk_alloc_lock(a);
+	ret = a->realloc(a, ptr, size);
+	uk_alloc_unlock(a, flags);
+	return ret;
 }
 
 static inline void *uk_realloc(struct uk_alloc *a, void *ptr, __sz size)
@@ -193,8 +296,14 @@ static inline void *uk_realloc(struct uk_alloc *a, void *ptr, __sz size)
 static inline int uk_do_posix_memalign(struct uk_alloc *a, void **memptr,
 				       __sz align, __sz size)
 {
+	int ret;
+	unsigned long flags;
+
 	UK_ASSERT(a);
-	return a->posix_memalign(a, memptr, align, size);
+	flags = uk_alloc_lock(a);
+	ret = a->posix_memalign(a, memptr, align, size);
+	uk_alloc_unlock(a, flags);
+	return ret;
 }
 
 static inline int uk_posix_memalign(struct uk_alloc *a, void **memptr,
@@ -210,8 +319,14 @@ static inline int uk_posix_memalign(struct uk_alloc *a, void **memptr,
 static inline void *uk_do_memalign(struct uk_alloc *a,
 				   __sz align, __sz size)
 {
+	void *ptr;
+	unsigned long flags;
+
 	UK_ASSERT(a);
-	return a->memalign(a, align, size);
+	flags = uk_alloc_lock(a);
+	ptr = a->memalign(a, align, size);
+	uk_alloc_unlock(a, flags);
+	return ptr;
 }
 
 static inline void *uk_memalign(struct uk_alloc *a,
@@ -224,8 +339,15 @@ static inline void *uk_memalign(struct uk_alloc *a,
 
 static inline void uk_do_free(struct uk_alloc *a, void *ptr)
 {
+	unsigned long flags;
+
 	UK_ASSERT(a);
+	if (a->free_fast && likely(a->free_fast(a, ptr) == 0))
+		return;
+
+	flags = uk_alloc_lock(a);
 	a->free(a, ptr);
+	uk_alloc_unlock(a, flags);
 }
 
 static inline void uk_free(struct uk_alloc *a, void *ptr)
@@ -235,8 +357,14 @@ static inline void uk_free(struct uk_alloc *a, void *ptr)
 
 static inline void *uk_do_palloc(struct uk_alloc *a, unsigned long num_pages)
 {
+	void *ptr;
+	unsigned long flags;
+
 	UK_ASSERT(a);
-	return a->palloc(a, num_pages);
+	flags = uk_alloc_lock(a);
+	ptr = a->palloc(a, num_pages);
+	uk_alloc_unlock(a, flags);
+	return ptr;
 }
 
 static inline void *uk_palloc(struct uk_alloc *a, unsigned long num_pages)
@@ -249,8 +377,12 @@ static inline void *uk_palloc(struct uk_alloc *a, unsigned long num_pages)
 static inline void uk_do_pfree(struct uk_alloc *a, void *ptr,
 			       unsigned long num_pages)
 {
+	unsigned long flags;
+
 	UK_ASSERT(a);
+	flags = uk_alloc_lock(a);
 	a->pfree(a, ptr, num_pages);
+	uk_alloc_unlock(a, flags);
 }
 
 static inline void uk_pfree(struct uk_alloc *a, void *ptr,
@@ -303,6 +435,39 @@ static inline long uk_alloc_pavailmem(struct uk_alloc *a)
 	return a->pavailmem(a);
 }
 
+/**
+ * Allocates `num_pages` pages that are backed by huge page mappings of
+ * the platform whenever the request is big enough: The request is rounded
+ * up to a multiple of the platform's huge page size and a chunk is
+ * handed out that is aligned to it, so that every huge page is covered by
+ * a single TLB entry. This requires an allocator that returns naturally
+ * aligned page allocations (e.g., ukallocbbuddy). Requests smaller than a
+ * huge page or on platforms without huge page mappings are served like
+ * uk_palloc().
+ * Memory must be released with uk_pfree_huge().
+ *
+ * @param a
+ *  Allocator to allocate from.
+ * @param num_pages
+ *  Number of requested pages.
+ * @return
+ *  - (NULL): If allocation failed.
+ *  - Pointer to allocated memory.
+ */
+void *uk_palloc_huge(struct uk_alloc *a, unsigned long num_pages);
+
+/**
+ * Releases memory that was allocated with uk_palloc_huge().
+ *
+ * @param a
+ *  Allocator that was used for allocation.
+ * @param ptr
+ *  Pointer to the allocated memory.
+ * @param num_pages
+ *  Number of pages that was passed to uk_palloc_huge().
+ */
+void uk_pfree_huge(struct uk_alloc *a, void *ptr, unsigned long num_pages);
+
 __sz uk_alloc_availmem_total(void);
 
 unsigned long uk_alloc_pavailmem_total(void);
@@ -318,9 +483,45 @@ void uk_alloc_stats_get_global(struct uk_alloc_stats *dst);
 #endif /* CONFIG_LIBUKALLOC_IFSTATS_GLOBAL */
 
 #if CONFIG_LIBUKALLOC_IFSTATS_PERLIB
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE
+/* log2 buckets of request sizes */
+#define UK_ALLOC_PROFILE_SIZE_BUCKETS		(sizeof(__sz) * 8)
+/* decimal buckets of object lifetimes: <1us, <10us, ..., <10s, >=10s */
+#define UK_ALLOC_PROFILE_LIFETIME_BUCKETS	9
+
+struct uk_alloc_callsite {
+	void *addr; /* return address of sampled allocation requests */
+	__u64 nb_samples; /* number of samples from this call site */
+	__sz tot_size; /* sum of sampled request sizes */
+};
+
+struct uk_alloc_profile {
+	/* size_hist[i] counts requests of [2^i, 2^(i+1)) bytes;
+	 * size_hist[0] includes requests of 0 bytes
+	 */
+	__u64 size_hist[UK_ALLOC_PROFILE_SIZE_BUCKETS];
+	/* lifetime_hist[0] counts sampled objects that were free'd within
+	 * 1us, lifetime_hist[i] within [10^(i-1), 10^i) us,
+	 * the last bucket counts all lifetimes of 10s or more
+	 */
+	__u64 lifetime_hist[UK_ALLOC_PROFILE_LIFETIME_BUCKETS];
+
+	__u64 nb_samples; /* number of sampled allocation requests */
+	__u64 nb_samples_dropped; /* samples lost due to full tables */
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE_CALLSITES
+	struct uk_alloc_callsite
+		callsites[CONFIG_LIBUKALLOC_IFSTATS_PROFILE_CALLSITES];
+#endif
+};
+#endif /* CONFIG_LIBUKALLOC_IFSTATS_PROFILE */
+
 struct uk_alloc_libstats_entry {
 	const char *libname;
 	struct uk_alloc *a; /* default allocator wrapper for the library */
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE
+	struct uk_alloc_profile *profile;
+	void (*profile_reset)(void); /* clears profile and sampled objects */
+#endif
 };
 
 extern struct uk_alloc_libstats_entry _uk_alloc_libstats_start[];
@@ -332,6 +533,32 @@ extern struct uk_alloc_libstats_entry _uk_alloc_libstats_end;
 	     (iter) = (struct uk_alloc_libstats_entry *) ((__uptr)(iter) \
 		      + ALIGN_UP(sizeof(struct uk_alloc_libstats_entry), 8)))
 
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE
+/**
+ * Copies the allocation profile of a library.
+ *
+ * @param a
+ *  Per-library allocator wrapper (see `struct uk_alloc_libstats_entry`)
+ * @param dst
+ *  Destination for the profile
+ * @return
+ *  - (0): On success
+ *  - (-ENOENT): `a` is not a per-library allocator wrapper
+ */
+int uk_alloc_profile_get(struct uk_alloc *a, struct uk_alloc_profile *dst);
+
+/**
+ * Resets the allocation profile of a library.
+ *
+ * @param a
+ *  Per-library allocator wrapper
+ * @return
+ *  - (0): On success
+ *  - (-ENOENT): `a` is not a per-library allocator wrapper
+ */
+int uk_alloc_profile_reset(struct uk_alloc *a);
+#endif /* CONFIG_LIBUKALLOC_IFSTATS_PROFILE */
+
 #endif /* CONFIG_LIBUKALLOC_IFSTATS_PERLIB */
 #endif /* CONFIG_LIBUKALLOC_IFSTATS */
 
@@ -89,6 +89,27 @@ long uk_alloc_pmaxalloc_compat(struct uk_alloc *a);
 extern struct uk_alloc_stats _uk_alloc_stats_global;
 #endif /* CONFIG_LIBUKALLOC_IFSTATS_GLOBAL */
 
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE
+#include <uk/arch/time.h>
+
+/* Objects that were sampled by the per-library allocation profiles.
+ * The table is shared by all libraries because an object can be free'd
+ * through the allocator wrapper of another library than the one that
+ * allocated it.
+ */
+#define UK_ALLOC_PROFILE_LIVE_SIZE 64 /* must be a power of two */
+
+struct uk_alloc_profile_live {
+	void *ptr;
+	__nsec ts;
+	struct uk_alloc_profile *profile; /* profile that sampled the object */
+};
+
+extern struct uk_alloc_profile_live
+	_uk_alloc_profile_live[UK_ALLOC_PROFILE_LIVE_SIZE];
+extern unsigned int _uk_alloc_profile_live_count;
+#endif /* CONFIG_LIBUKALLOC_IFSTATS_PROFILE */
+
 /* NOTE: Please do not use this function directly */
 static inline void _uk_alloc_stats_refresh_minmax(struct uk_alloc_stats *stats)
 {
@@ -145,16 +166,66 @@ static inline void _uk_alloc_stats_count_free(struct uk_alloc_stats *stats,
 	uk_preempt_enable();
 }
 
+/* NOTE: Please do not use this function directly */
+static inline void _uk_alloc_stats_count_lookup(struct uk_alloc_stats *stats,
+						unsigned long steps)
+{
+	/* TODO: SMP safety */
+	uk_preempt_disable();
+	stats->nb_lookups++;
+	stats->nb_lookup_steps += steps;
+	uk_preempt_enable();
+}
+
+/* NOTE: Please do not use this function directly */
+static inline void _uk_alloc_stats_count_huge(struct uk_alloc_stats *stats,
+					      __sz nr_hpages)
+{
+	/* TODO: SMP safety */
+	uk_preempt_disable();
+	if (likely(nr_hpages)) {
+		stats->tot_nb_huge_allocs++;
+		stats->cur_nb_huge_pages += nr_hpages;
+		if (stats->cur_nb_huge_pages > stats->max_nb_huge_pages)
+			stats->max_nb_huge_pages = stats->cur_nb_huge_pages;
+	} else {
+		stats->nb_huge_fallbacks++;
+	}
+	uk_preempt_enable();
+}
+
+/* NOTE: Please do not use this function directly */
+static inline void _uk_alloc_stats_count_hugefree(struct uk_alloc_stats *stats,
+						  __sz nr_hpages)
+{
+	/* TODO: SMP safety */
+	uk_preempt_disable();
+	stats->cur_nb_huge_pages -= nr_hpages;
+	uk_preempt_enable();
+}
+
 #if CONFIG_LIBUKALLOC_IFSTATS_GLOBAL
 #define _uk_alloc_stats_global_count_alloc(ptr, size) \
 	_uk_alloc_stats_count_alloc(&_uk_alloc_stats_global, (ptr), (size))
 #define _uk_alloc_stats_global_count_free(ptr, freed_size) \
 	_uk_alloc_stats_count_free(&_uk_alloc_stats_global, (ptr), (freed_size))
+#define _uk_alloc_stats_global_count_lookup(steps) \
+	_uk_alloc_stats_count_lookup(&_uk_alloc_stats_global, (steps))
+#define _uk_alloc_stats_global_count_huge(nr_hpages) \
+	_uk_alloc_stats_count_huge(&_uk_alloc_stats_global, (nr_hpages))
+#define _uk_alloc_stats_global_count_hugefree(nr_hpages) \
+	_uk_alloc_stats_count_hugefree(&_uk_alloc_stats_global, (nr_hpages))
 #else /* !CONFIG_LIBUKALLOC_IFSTATS_GLOBAL */
 #define _uk_alloc_stats_global_count_alloc(ptr, size) \
 	do {} while (0)
 #define _uk_alloc_stats_global_count_free(ptr, freed_size) \
 	do {} while (0)
+#define _uk_alloc_stats_global_count_lookup(steps) \
+	do {} while (0)
+#define _uk_alloc_stats_global_count_huge(nr_hpages) \
+	do {} while (0)
+#define _uk_alloc_stats_global_count_hugefree(nr_hpages) \
+	do {} while (0)
 #endif /* !CONFIG_LIBUKALLOC_IFSTATS_GLOBAL */
 
 /*
@@ -189,6 +260,32 @@ static inline void _uk_alloc_stats_count_free(struct uk_alloc_stats *stats,
 	uk_alloc_stats_count_free((a), (ptr),				\
 				  ((__sz) (num_pages)) << __PAGE_SHIFT)
 
+/* Accounts an internal metadata lookup (e.g., finding the memory region
+ * of an address) that took `steps` iterations
+ */
+#define uk_alloc_stats_count_lookup(a, steps)				\
+	do {								\
+		_uk_alloc_stats_count_lookup(&((a)->_stats), (steps));	\
+		_uk_alloc_stats_global_count_lookup((steps));		\
+	} while (0)
+
+/* Accounts an allocation of `nr_hpages` huge pages.
+ * NOTE: If nr_hpages is 0, a huge page request is counted that could not
+ *       be backed by huge pages
+ */
+#define uk_alloc_stats_count_huge(a, nr_hpages)				\
+	do {								\
+		_uk_alloc_stats_count_huge(&((a)->_stats),		\
+					   (nr_hpages));		\
+		_uk_alloc_stats_global_count_huge((nr_hpages));		\
+	} while (0)
+#define uk_alloc_stats_count_hugefree(a, nr_hpages)			\
+	do {								\
+		_uk_alloc_stats_count_hugefree(&((a)->_stats),		\
+					       (nr_hpages));		\
+		_uk_alloc_stats_global_count_hugefree((nr_hpages));	\
+	} while (0)
+
 #define uk_alloc_stats_reset(a)						\
 	memset(&(a)->_stats, 0, sizeof((a)->_stats))
 
@@ -199,6 +296,9 @@ static inline void _uk_alloc_stats_count_free(struct uk_alloc_stats *stats,
 #define uk_alloc_stats_count_penomem(a, num_pages) do {} while (0)
 #define uk_alloc_stats_count_free(a, ptr, freed_size) do {} while (0)
 #define uk_alloc_stats_count_pfree(a, ptr, num_pages) do {} while (0)
+#define uk_alloc_stats_count_lookup(a, steps) do {} while (0)
+#define uk_alloc_stats_count_huge(a, nr_hpages) do {} while (0)
+#define uk_alloc_stats_count_hugefree(a, nr_hpages) do {} while (0)
 #define uk_alloc_stats_reset(a) do {} while (0)
 #endif /* !CONFIG_LIBUKALLOC_IFSTATS */
 
@@ -215,6 +315,8 @@ static inline void _uk_alloc_stats_count_free(struct uk_alloc_stats *stats,
 		(a)->posix_memalign = (posix_memalign_f);		\
 		(a)->memalign       = (memalign_f);			\
 		(a)->free           = (free_f);				\
+		(a)->malloc_fast    = NULL;				\
+		(a)->free_fast      = NULL;				\
 		(a)->palloc         = uk_palloc_compat;			\
 		(a)->pfree          = uk_pfree_compat;			\
 		(a)->availmem       = (availmem_f);			\
@@ -241,6 +343,8 @@ static inline void _uk_alloc_stats_count_free(struct uk_alloc_stats *stats,
 		(a)->malloc_backend = (malloc_f);			\
 		(a)->free_backend   = (free_f);				\
 		(a)->free           = uk_free_ifmalloc;			\
+		(a)->malloc_fast    = NULL;				\
+		(a)->free_fast      = NULL;				\
 		(a)->palloc         = uk_palloc_compat;			\
 		(a)->pfree          = uk_pfree_compat;			\
 		(a)->availmem       = (availmem_f);			\
@@ -268,6 +372,8 @@ static inline void _uk_alloc_stats_count_free(struct uk_alloc_stats *stats,
 		(a)->posix_memalign = uk_posix_memalign_ifpages;	\
 		(a)->memalign       = uk_memalign_compat;		\
 		(a)->free           = uk_free_ifpages;			\
+		(a)->malloc_fast    = NULL;				\
+		(a)->free_fast      = NULL;				\
 		(a)->palloc         = (palloc_func);			\
 		(a)->pfree          = (pfree_func);			\
 		(a)->pavailmem      = (pavailmem_func);			\
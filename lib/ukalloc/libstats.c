@@ -47,6 +47,10 @@
 #include <uk/alloc_impl.h>
 #include <uk/essentials.h>
 #include <uk/preempt.h>
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE
+#include <uk/arch/atomic.h>
+#include <uk/plat/time.h>
+#endif
 
 static inline struct uk_alloc *_uk_alloc_get_actual_default(void)
 {
@@ -114,6 +118,152 @@ static inline void update_stats(struct uk_alloc_stats *stats,
 	uk_preempt_enable();
 }
 
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE
+/*
+ * Allocation profile
+ * ------------------
+ * The size of every allocation request is counted into a log2 histogram.
+ * Every Nth request is sampled: The object is remembered in a small hash
+ * table together with a timestamp so that its lifetime can be recorded
+ * when it is free'd, and the return address of the request is counted
+ * into the call site table. The hash table is shared by all libraries
+ * (see `_uk_alloc_profile_live`) and each entry points to the profile that
+ * sampled the object, so that the lifetime is accounted to the allocating
+ * library even if another library frees the object. Samples are dropped if
+ * a table slot is already occupied. Non-sampled requests cost only a
+ * counter update, and free requests a single hash table probe while sampled
+ * objects are alive.
+ */
+static struct uk_alloc_profile _uk_alloc_lib_profile = { 0 };
+static unsigned int _profile_countdown = CONFIG_LIBUKALLOC_IFSTATS_PROFILE_RATE;
+
+static void profile_reset(void)
+{
+	unsigned int i;
+
+	/* Sampled objects of before the reset must not be counted anymore */
+	uk_preempt_disable();
+	memset(&_uk_alloc_lib_profile, 0, sizeof(_uk_alloc_lib_profile));
+	for (i = 0; i < UK_ALLOC_PROFILE_LIVE_SIZE; ++i) {
+		if (_uk_alloc_profile_live[i].profile
+		    != &_uk_alloc_lib_profile)
+			continue;
+		_uk_alloc_profile_live[i].ptr = NULL;
+		_uk_alloc_profile_live[i].profile = NULL;
+		_uk_alloc_profile_live_count--;
+	}
+	uk_preempt_enable();
+}
+
+static inline unsigned long profile_hash(const void *ptr)
+{
+	/* Fibonacci hashing; the lower bits of addresses are mostly zero */
+	return ((unsigned long) ptr >> 4) * 2654435761UL;
+}
+
+static inline unsigned int profile_lifetime_bucket(__nsec lifetime)
+{
+	unsigned int i;
+	__nsec limit = 1000; /* 1us */
+
+	for (i = 0; i < UK_ALLOC_PROFILE_LIFETIME_BUCKETS - 1; ++i) {
+		if (lifetime < limit)
+			break;
+		limit *= 10;
+	}
+	return i;
+}
+
+static void profile_sample(void *ptr, __sz size, void *caller)
+{
+	struct uk_alloc_profile *prof = &_uk_alloc_lib_profile;
+	struct uk_alloc_profile_live *live;
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE_CALLSITES
+	struct uk_alloc_callsite *cs;
+	unsigned long h;
+	unsigned int i;
+#endif
+
+	prof->nb_samples++;
+
+	live = &_uk_alloc_profile_live[profile_hash(ptr)
+				       & (UK_ALLOC_PROFILE_LIVE_SIZE - 1)];
+	if (!live->ptr) {
+		live->ptr = ptr;
+		live->ts  = ukplat_monotonic_clock();
+		live->profile = prof;
+		_uk_alloc_profile_live_count++;
+	} else {
+		prof->nb_samples_dropped++;
+	}
+
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE_CALLSITES
+	/* Open addressing with linear probing */
+	h = profile_hash(caller);
+	for (i = 0; i < CONFIG_LIBUKALLOC_IFSTATS_PROFILE_CALLSITES; ++i) {
+		cs = &prof->callsites[(h + i)
+				      % CONFIG_LIBUKALLOC_IFSTATS_PROFILE_CALLSITES];
+		if (cs->addr == caller || !cs->addr) {
+			cs->addr = caller;
+			cs->nb_samples++;
+			cs->tot_size += size;
+			return;
+		}
+	}
+	prof->nb_samples_dropped++;
+#else
+	(void) size;
+	(void) caller;
+#endif
+}
+
+static inline void profile_alloc(void *ptr, __sz size, void *caller)
+{
+	uk_preempt_disable();
+	_uk_alloc_lib_profile.size_hist[size ? ukarch_flsl(size) : 0]++;
+	if (unlikely(--_profile_countdown == 0)) {
+		_profile_countdown = CONFIG_LIBUKALLOC_IFSTATS_PROFILE_RATE;
+		profile_sample(ptr, size, caller);
+	}
+	uk_preempt_enable();
+}
+
+static inline void profile_free(void *ptr)
+{
+	struct uk_alloc_profile_live *live;
+	__nsec lifetime;
+
+	if (likely(!_uk_alloc_profile_live_count) || !ptr)
+		return;
+
+	uk_preempt_disable();
+	live = &_uk_alloc_profile_live[profile_hash(ptr)
+				       & (UK_ALLOC_PROFILE_LIVE_SIZE - 1)];
+	if (live->ptr == ptr) {
+		/* Account to the library that allocated the object */
+		lifetime = ukplat_monotonic_clock() - live->ts;
+		live->profile->lifetime_hist[
+			profile_lifetime_bucket(lifetime)]++;
+		live->ptr = NULL;
+		live->profile = NULL;
+		_uk_alloc_profile_live_count--;
+	}
+	uk_preempt_enable();
+}
+
+#define PROFILE_ALLOC(ptr, size)					\
+	do {								\
+		if (ptr)						\
+			profile_alloc((ptr), (size),			\
+				      __builtin_return_address(0));	\
+	} while (0)
+#define PROFILE_FREE(ptr)						\
+	profile_free(ptr)
+#else /* !CONFIG_LIBUKALLOC_IFSTATS_PROFILE */
+#define PROFILE_ALLOC(ptr, size) do {} while (0)
+#define PROFILE_FREE(ptr) do {} while (0)
+#endif /* !CONFIG_LIBUKALLOC_IFSTATS_PROFILE */
+
 static void *wrapper_malloc(struct uk_alloc *a, __sz size)
 {
 	struct uk_alloc *p = _uk_alloc_get_actual_default();
@@ -130,6 +280,7 @@ static void *wrapper_malloc(struct uk_alloc *a, __sz size)
 	WATCH_STATS_START(p);
 	ret = uk_do_malloc(p, size);
 	WATCH_STATS_END(p, &nb_allocs, &nb_enomem, &mem_use, &alloc_size);
+	PROFILE_ALLOC(ret, size);
 
 	/* NOTE: We record `alloc_size` only when allocation was successful */
 	update_stats(&a->_stats, nb_allocs, nb_enomem, mem_use,
@@ -153,6 +304,7 @@ static void *wrapper_calloc(struct uk_alloc *a, __sz nmemb, __sz size)
 	WATCH_STATS_START(p);
 	ret = uk_do_calloc(p, nmemb, size);
 	WATCH_STATS_END(p, &nb_allocs, &nb_enomem, &mem_use, &alloc_size);
+	PROFILE_ALLOC(ret, nmemb * size);
 
 	update_stats(&a->_stats, nb_allocs, nb_enomem, mem_use,
 		     ret != NULL ? alloc_size : 0);
@@ -175,6 +327,7 @@ static int wrapper_posix_memalign(struct uk_alloc *a, void **memptr,
 	WATCH_STATS_START(p);
 	ret = uk_do_posix_memalign(p, memptr, align, size);
 	WATCH_STATS_END(p, &nb_allocs, &nb_enomem, &mem_use, &alloc_size);
+	PROFILE_ALLOC(ret == 0 ? *memptr : NULL, size);
 
 	update_stats(&a->_stats, nb_allocs, nb_enomem, mem_use,
 		     ret == 0 ? alloc_size : 0);
@@ -197,6 +350,7 @@ static void *wrapper_memalign(struct uk_alloc *a, __sz align, __sz size)
 	WATCH_STATS_START(p);
 	ret = uk_do_memalign(p, align, size);
 	WATCH_STATS_END(p, &nb_allocs, &nb_enomem, &mem_use, &alloc_size);
+	PROFILE_ALLOC(ret, size);
 
 	update_stats(&a->_stats, nb_allocs, nb_enomem, mem_use,
 		     ret != NULL ? alloc_size : 0);
@@ -219,6 +373,11 @@ static void *wrapper_realloc(struct uk_alloc *a, void *ptr, __sz size)
 	WATCH_STATS_START(p);
 	ret = uk_do_realloc(p, ptr, size);
 	WATCH_STATS_END(p, &nb_allocs, &nb_enomem, &mem_use, &alloc_size);
+	if (ret) {
+		/* A reallocation ends the lifetime of the previous object */
+		PROFILE_FREE(ptr);
+		PROFILE_ALLOC(ret, size);
+	}
 
 	update_stats(&a->_stats, nb_allocs, nb_enomem, mem_use,
 		     ret != NULL ? alloc_size : 0);
@@ -233,6 +392,7 @@ static void wrapper_free(struct uk_alloc *a, void *ptr)
 
 	UK_ASSERT(p);
 
+	PROFILE_FREE(ptr);
 	WATCH_STATS_START(p);
 	uk_do_free(p, ptr);
 	WATCH_STATS_END(p, &nb_allocs, &nb_enomem, &mem_use, &alloc_size);
@@ -252,6 +412,7 @@ static void *wrapper_palloc(struct uk_alloc *a, unsigned long num_pages)
 	WATCH_STATS_START(p);
 	ret = uk_do_palloc(p, num_pages);
 	WATCH_STATS_END(p, &nb_allocs, &nb_enomem, &mem_use, &alloc_size);
+	PROFILE_ALLOC(ret, ((__sz) num_pages) << __PAGE_SHIFT);
 
 	update_stats(&a->_stats, nb_allocs, nb_enomem, mem_use,
 		     ret != NULL ? alloc_size : 0);
@@ -267,6 +428,7 @@ static void wrapper_pfree(struct uk_alloc *a, void *ptr,
 
 	UK_ASSERT(p);
 
+	PROFILE_FREE(ptr);
 	WATCH_STATS_START(p);
 	uk_do_pfree(p, ptr, num_pages);
 	WATCH_STATS_END(p, &nb_allocs, &nb_enomem, &mem_use, &alloc_size);
@@ -330,6 +492,10 @@ static __used __section(".uk_alloc_libstats") __align(8)
 struct uk_alloc_libstats_entry _uk_alloc_libstats_entry = {
 	.libname = STRINGIFY(__LIBNAME__),
 	.a       = &_uk_alloc_lib_default,
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE
+	.profile = &_uk_alloc_lib_profile,
+	.profile_reset = profile_reset,
+#endif
 };
 
 /* Return this wrapper allocator instead of the actual default allocator */
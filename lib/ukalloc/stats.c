@@ -32,11 +32,18 @@
  */
 
 #include <uk/alloc_impl.h>
+#include <errno.h>
 
 #if CONFIG_LIBUKALLOC_IFSTATS_GLOBAL
 struct uk_alloc_stats _uk_alloc_stats_global = { 0 };
 #endif
 
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE
+struct uk_alloc_profile_live
+	_uk_alloc_profile_live[UK_ALLOC_PROFILE_LIVE_SIZE] = { 0 };
+unsigned int _uk_alloc_profile_live_count;
+#endif
+
 void uk_alloc_stats_get(struct uk_alloc *a,
 			struct uk_alloc_stats *dst)
 {
@@ -58,3 +65,47 @@ void uk_alloc_stats_get_global(struct uk_alloc_stats *dst)
 	uk_preempt_enable();
 }
 #endif
+
+#if CONFIG_LIBUKALLOC_IFSTATS_PROFILE
+static struct uk_alloc_libstats_entry *_profile_find(struct uk_alloc *a)
+{
+	struct uk_alloc_libstats_entry *entry;
+
+	uk_alloc_foreach_libstats(entry) {
+		if (entry->a == a)
+			return entry;
+	}
+	return NULL;
+}
+
+int uk_alloc_profile_get(struct uk_alloc *a, struct uk_alloc_profile *dst)
+{
+	struct uk_alloc_libstats_entry *entry;
+
+	UK_ASSERT(a);
+	UK_ASSERT(dst);
+
+	entry = _profile_find(a);
+	if (!entry)
+		return -ENOENT;
+
+	uk_preempt_disable();
+	memcpy(dst, entry->profile, sizeof(*dst));
+	uk_preempt_enable();
+	return 0;
+}
+
+int uk_alloc_profile_reset(struct uk_alloc *a)
+{
+	struct uk_alloc_libstats_entry *entry;
+
+	UK_ASSERT(a);
+
+	entry = _profile_find(a);
+	if (!entry)
+		return -ENOENT;
+
+	entry->profile_reset();
+	return 0;
+}
+#endif /* CONFIG_LIBUKALLOC_IFSTATS_PROFILE */
@@ -66,6 +66,12 @@ struct chunk_tail_st {
 #define FREELIST_SIZE ((sizeof(void *) << 3) - __PAGE_SHIFT)
 #define FREELIST_EMPTY(_l) ((_l)->next == NULL)
 
+/* Maximum number of memory regions that are kept in the sorted lookup
+ * index. Regions that exceed this number are still usable but are found
+ * with a linear search.
+ */
+#define MEMR_IDX_SIZE 32
+
 /* keep a bitmap for each memory region separately */
 struct uk_bbpalloc_memr {
 	struct uk_bbpalloc_memr *next;
@@ -77,11 +83,44 @@ struct uk_bbpalloc_memr {
 
 struct uk_bbpalloc {
 	unsigned long nr_free_pages;
+	/* bit i set => free_head[i] is not empty */
+	unsigned long free_bitmap;
 	chunk_head_t *free_head[FREELIST_SIZE];
 	chunk_head_t free_tail[FREELIST_SIZE];
 	struct uk_bbpalloc_memr *memr_head;
+	/* memory regions sorted by first_page, for binary search */
+	unsigned long memr_idx_count;
+	struct uk_bbpalloc_memr *memr_idx[MEMR_IDX_SIZE];
+	/* set when a region did not fit into memr_idx */
+	int memr_idx_overflow;
 };
 
+#define bbpalloc_to_alloc(b) \
+	((struct uk_alloc *)((uintptr_t)(b) - __offsetof(struct uk_alloc, priv)))
+
+UK_CTASSERT(FREELIST_SIZE <= sizeof(unsigned long) * 8);
+
+static inline void freelist_add(struct uk_bbpalloc *b, chunk_head_t *ch,
+				unsigned int order)
+{
+	ch->level = order;
+	ch->next = b->free_head[order];
+	ch->pprev = &b->free_head[order];
+	ch->next->pprev = &ch->next;
+	b->free_head[order] = ch;
+	b->free_bitmap |= (1UL << order);
+}
+
+static inline void freelist_del(struct uk_bbpalloc *b, chunk_head_t *ch)
+{
+	unsigned int order = ch->level;
+
+	*(ch->pprev) = ch->next;
+	ch->next->pprev = ch->pprev;
+	if (FREELIST_EMPTY(b->free_head[order]))
+		b->free_bitmap &= ~(1UL << order);
+}
+
 /*********************
  * ALLOCATION BITMAP
  *  One bit per page of memory. Bit set => page is allocated.
@@ -97,27 +136,83 @@ struct uk_bbpalloc {
 #define BYTES_PER_MAPWORD   (sizeof(unsigned long))
 #define PAGES_PER_MAPWORD   (BYTES_PER_MAPWORD * BITS_PER_BYTE)
 
+static inline int memr_contains(struct uk_bbpalloc_memr *memr,
+				unsigned long page_va)
+{
+	return (page_va >= memr->first_page)
+		&& (page_va < (memr->first_page +
+			       (memr->nr_pages << __PAGE_SHIFT)));
+}
+
 static inline struct uk_bbpalloc_memr *map_get_memr(struct uk_bbpalloc *b,
 						    unsigned long page_va)
 {
 	struct uk_bbpalloc_memr *memr = NULL;
+	unsigned long lo, hi, mid;
+	unsigned long steps = 0;
 
 	/*
-	 * Find bitmap of according memory region
-	 * This is a linear search but it is expected that we have only a few
-	 * of them. It should be just one region in most cases
+	 * Find bitmap of according memory region with a binary search
+	 * over the sorted region index. In most cases there is just one
+	 * region so that this finishes with a single comparison.
 	 */
-	for (memr = b->memr_head; memr != NULL; memr = memr->next) {
-		if ((page_va >= memr->first_page)
-		    && (page_va < (memr->first_page +
-		    (memr->nr_pages << __PAGE_SHIFT))))
-			return memr;
+	lo = 0;
+	hi = b->memr_idx_count;
+	while (lo < hi) {
+		steps++;
+		mid = lo + ((hi - lo) >> 1);
+		memr = b->memr_idx[mid];
+		if (page_va < memr->first_page) {
+			hi = mid;
+		} else if (memr_contains(memr, page_va)) {
+			goto out;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	/*
+	 * Regions that did not fit into the index are found with a
+	 * linear search.
+	 */
+	if (unlikely(b->memr_idx_overflow)) {
+		for (memr = b->memr_head; memr != NULL; memr = memr->next) {
+			steps++;
+			if (memr_contains(memr, page_va))
+				goto out;
+		}
 	}
 
 	/*
 	 * No region found
 	 */
-	return NULL;
+	memr = NULL;
+out:
+	uk_alloc_stats_count_lookup(bbpalloc_to_alloc(b), steps);
+	return memr;
+}
+
+static void map_add_memr(struct uk_bbpalloc *b, struct uk_bbpalloc_memr *memr)
+{
+	unsigned long i;
+
+	/* add to list */
+	memr->next = b->memr_head;
+	b->memr_head = memr;
+
+	if (unlikely(b->memr_idx_count == MEMR_IDX_SIZE)) {
+		b->memr_idx_overflow = 1;
+		return;
+	}
+
+	/* insert into index by keeping it sorted */
+	for (i = b->memr_idx_count; i > 0; i--) {
+		if (b->memr_idx[i - 1]->first_page < memr->first_page)
+			break;
+		b->memr_idx[i] = b->memr_idx[i - 1];
+	}
+	b->memr_idx[i] = memr;
+	b->memr_idx_count++;
 }
 
 static inline unsigned long allocated_in_map(struct uk_bbpalloc *b,
@@ -238,6 +333,7 @@ static void *bbuddy_palloc(struct uk_alloc *a, unsigned long num_pages)
 {
 	struct uk_bbpalloc *b;
 	size_t i;
+	unsigned long avail;
 	chunk_head_t *alloc_ch, *spare_ch;
 	chunk_tail_t *spare_ct;
 
@@ -247,17 +343,17 @@ static void *bbuddy_palloc(struct uk_alloc *a, unsigned long num_pages)
 	size_t order = (size_t)num_pages_to_order(num_pages);
 
 	/* Find smallest order which can satisfy the request. */
-	for (i = order; i < FREELIST_SIZE; i++) {
-		if (!FREELIST_EMPTY(b->free_head[i]))
-			break;
-	}
-	if (i == FREELIST_SIZE)
+	if (unlikely(order >= FREELIST_SIZE))
 		goto no_memory;
+	avail = b->free_bitmap & ~((1UL << order) - 1);
+	if (!avail)
+		goto no_memory;
+	i = (size_t)ukarch_ffsl(avail);
+	UK_ASSERT(!FREELIST_EMPTY(b->free_head[i]));
 
 	/* Unlink a chunk. */
 	alloc_ch = b->free_head[i];
-	b->free_head[i] = alloc_ch->next;
-	alloc_ch->next->pprev = alloc_ch->pprev;
+	freelist_del(b, alloc_ch);
 
 	/* We may have to break the chunk a number of times. */
 	while (i != order) {
@@ -268,15 +364,9 @@ static void *bbuddy_palloc(struct uk_alloc *a, unsigned long num_pages)
 		spare_ct = (chunk_tail_t *)((char *)spare_ch
 					    + (1UL << (i + __PAGE_SHIFT))) - 1;
 
-		/* Create new header for spare chunk. */
-		spare_ch->level = i;
-		spare_ch->next = b->free_head[i];
-		spare_ch->pprev = &b->free_head[i];
+		/* Create new header for spare chunk and link it in. */
 		spare_ct->level = i;
-
-		/* Link in the spare chunk. */
-		spare_ch->next->pprev = &spare_ch->next;
-		b->free_head[i] = spare_ch;
+		freelist_add(b, spare_ch, i);
 	}
 	map_alloc(b, (uintptr_t)alloc_ch, 1UL << order);
 
@@ -340,40 +430,30 @@ static void bbuddy_pfree(struct uk_alloc *a, void *obj, unsigned long num_pages)
 		}
 
 		/* We are commited to merging, unlink the chunk */
-		*(to_merge_ch->pprev) = to_merge_ch->next;
-		to_merge_ch->next->pprev = to_merge_ch->pprev;
+		freelist_del(b, to_merge_ch);
 
 		order++;
 	}
 
 	/* Link the new chunk */
-	freed_ch->level = order;
-	freed_ch->next = b->free_head[order];
-	freed_ch->pprev = &b->free_head[order];
 	freed_ct->level = order;
-
-	freed_ch->next->pprev = &freed_ch->next;
-	b->free_head[order] = freed_ch;
+	freelist_add(b, freed_ch, order);
 }
 
 static long bbuddy_pmaxalloc(struct uk_alloc *a)
 {
 	struct uk_bbpalloc *b;
-	size_t i, order;
+	size_t order;
 
 	UK_ASSERT(a != NULL);
 	b = (struct uk_bbpalloc *)&a->priv;
 
 	/* Find biggest order that has still elements available */
-	order = FREELIST_SIZE;
-	for (i = 0; i < FREELIST_SIZE; i++) {
-		if (!FREELIST_EMPTY(b->free_head[i]))
-			order = i;
-	}
-	if (order == FREELIST_SIZE)
+	if (!b->free_bitmap)
 		return 0; /* no memory left */
+	order = (size_t)ukarch_flsl(b->free_bitmap);
 
-	return (long) (1 << order);
+	return (long) (1UL << order);
 }
 
 static long bbuddy_pavailmem(struct uk_alloc *a)
@@ -447,9 +527,8 @@ static int bbuddy_addmem(struct uk_alloc *a, void *base, size_t len)
 	 * Initialize region's bitmap
 	 */
 	memr->first_page = min;
-	/* add to list */
-	memr->next = b->memr_head;
-	b->memr_head = memr;
+	/* add to list and lookup index */
+	map_add_memr(b, memr);
 
 	/* All allocated by default. */
 	memset(memr->mm_alloc_bitmap, (unsigned char) ~0,
@@ -477,12 +556,8 @@ static int bbuddy_addmem(struct uk_alloc *a, void *base, size_t len)
 		range -= 1UL << i;
 		ct = (chunk_tail_t *)min - 1;
 		i -= __PAGE_SHIFT;
-		ch->level = i;
-		ch->next = b->free_head[i];
-		ch->pprev = &b->free_head[i];
-		ch->next->pprev = &ch->next;
-		b->free_head[i] = ch;
 		ct->level = i;
+		freelist_add(b, ch, i);
 		count++;
 	}
 
@@ -524,6 +599,9 @@ struct uk_alloc *uk_allocbbuddy_init(void *base, size_t len)
 		b->free_tail[i].next = NULL;
 	}
 	b->memr_head = NULL;
+	b->free_bitmap = 0;
+	b->memr_idx_count = 0;
+	b->memr_idx_overflow = 0;
 
 	/* initialize and register allocator interface */
 	uk_alloc_init_palloc(a, bbuddy_palloc, bbuddy_pfree,
@@ -110,6 +110,25 @@ void uk_allocpool_free(struct uk_allocpool *p);
 struct uk_allocpool *uk_allocpool_init(void *base, __sz len,
 				       __sz obj_len, __sz obj_align);
 
+/**
+ * Enables (or disables) on-demand growing of a memory pool.
+ * Whenever the pool runs out of free objects, a chunk of `grow_count`
+ * additional objects is allocated from the parent allocator. Growing
+ * happens only on the take path (e.g., uk_allocpool_take()), so objects
+ * can still be returned from contexts in which the parent allocator
+ * must not be called (e.g., interrupt handlers).
+ * Note: Only pools that were allocated with uk_allocpool_alloc() can grow.
+ *
+ * @param p
+ *  Pointer to memory pool.
+ * @param grow_count
+ *  Number of objects that are added with each chunk; 0 disables growing.
+ * @return
+ *  - (0): On success.
+ *  - (-EINVAL): The pool does not have a parent allocator.
+ */
+int uk_allocpool_set_grow(struct uk_allocpool *p, unsigned int grow_count);
+
 /**
  * Return uk_alloc compatible interface for allocpool.
  * With this interface, uk_malloc(), uk_free(), etc. can
@@ -175,6 +194,8 @@ unsigned int uk_allocpool_take_batch(struct uk_allocpool *p,
  * Return one object back to a pool.
  * HINT: It is recommended to use this call instead of uk_free() whenever
  *       feasible. This call is avoiding indirections.
+ * NOTE: Objects can be returned concurrently from multiple contexts
+ *       (e.g., interrupt handlers); the free list is lock-free.
  *
  * @param p
  *  Pointer to memory pool.
@@ -37,7 +37,7 @@
 #include <uk/essentials.h>
 #include <uk/alloc_impl.h>
 #include <uk/allocpool.h>
-#include <uk/list.h>
+#include <uk/arch/atomic.h>
 #include <string.h>
 #include <errno.h>
 
@@ -58,15 +58,58 @@
  *          +=======================+
  *          |         ...           |
  *          v                       v
+ *
+ * Pools that are allowed to grow (see uk_allocpool_set_grow()) allocate
+ * additional chunks from the parent allocator on demand:
+ *
+ *          ++---------------------++
+ *          ||  struct pool_chunk  ||
+ *          ++---------------------++
+ *          |    // padding //      |
+ *          +=======================+
+ *          |       OBJECT 1        |
+ *          +=======================+
+ *          |         ...           |
+ *          v                       v
+ *
+ * POOL: FREE LIST
+ *
+ * Free objects are kept on a lock-free LIFO (Treiber stack) so that
+ * objects can be returned from multiple contexts (e.g., interrupt
+ * handlers and threads) concurrently. In order to prevent the ABA problem,
+ * the list head carries a modification tag in its upper bits that is
+ * incremented with every update of the head.
  */
 
 #define MIN_OBJ_ALIGN sizeof(void *)
-#define MIN_OBJ_LEN   sizeof(struct uk_list_head)
+#define MIN_OBJ_LEN   sizeof(struct free_obj)
+
+#if __SIZEOF_POINTER__ == 8
+#define FREE_HEAD_TAG_SHIFT 48
+#else
+#define FREE_HEAD_TAG_SHIFT 32
+#endif
+#define FREE_HEAD_PTR_MASK  ((1ULL << FREE_HEAD_TAG_SHIFT) - 1)
+
+#define free_head_ptr(head) \
+	((struct free_obj *) (__uptr) ((head) & FREE_HEAD_PTR_MASK))
+#define free_head_tag(head) \
+	((head) >> FREE_HEAD_TAG_SHIFT)
+#define free_head_make(ptr, tag) \
+	(((__u64) (__uptr) (ptr)) | ((__u64) (tag) << FREE_HEAD_TAG_SHIFT))
+
+struct free_obj {
+	struct free_obj *next;
+};
+
+struct pool_chunk {
+	struct pool_chunk *next;
+};
 
 struct uk_allocpool {
 	struct uk_alloc self;
 
-	struct uk_list_head free_obj;
+	__u64 free_head; /* tagged pointer to first free object */
 	unsigned int free_obj_count;
 
 	__sz obj_align;
@@ -75,10 +118,9 @@ struct uk_allocpool {
 
 	struct uk_alloc *parent;
 	void *base;
-};
 
-struct free_obj {
-	struct uk_list_head list;
+	unsigned int grow_count; /* objects per chunk, 0: disabled */
+	struct pool_chunk *chunks;
 };
 
 static inline struct uk_allocpool *ukalloc2pool(struct uk_alloc *a)
@@ -96,33 +138,134 @@ struct uk_alloc *uk_allocpool2ukalloc(struct uk_allocpool *p)
 	return allocpool2ukalloc(p);
 }
 
-static inline void _prepend_free_obj(struct uk_allocpool *p, void *obj)
+/* Prepends a chain of `count` objects (`first` to `last`) to the free list */
+static inline void _prepend_free_objs(struct uk_allocpool *p,
+				      struct free_obj *first,
+				      struct free_obj *last,
+				      unsigned int count)
 {
-	struct uk_list_head *entry;
+	__u64 old, new;
 
 	UK_ASSERT(p);
+	UK_ASSERT(first);
+	UK_ASSERT(last);
+	UK_ASSERT(((__u64) (__uptr) first & ~FREE_HEAD_PTR_MASK) == 0);
+
+	/* The counter is increased before the objects become visible on the
+	 * list. This way, it never underflows when the objects are taken
+	 * concurrently.
+	 */
+	ukarch_fetch_add(&p->free_obj_count, count);
+	UK_ASSERT(ukarch_load_n(&p->free_obj_count)
+		  <= ukarch_load_n(&p->obj_count));
+
+	old = __atomic_load_n(&p->free_head, __ATOMIC_RELAXED);
+	do {
+		last->next = free_head_ptr(old);
+		new = free_head_make(first, free_head_tag(old) + 1);
+	} while (!__atomic_compare_exchange_n(&p->free_head, &old, new, 1,
+					      __ATOMIC_RELEASE,
+					      __ATOMIC_RELAXED));
+}
+
+static inline void _prepend_free_obj(struct uk_allocpool *p, void *obj)
+{
 	UK_ASSERT(obj);
-	UK_ASSERT(p->free_obj_count < p->obj_count);
 
-	entry = &((struct free_obj *) obj)->list;
-	uk_list_add(entry, &p->free_obj);
-	p->free_obj_count++;
+	_prepend_free_objs(p, (struct free_obj *) obj,
+			   (struct free_obj *) obj, 1);
 }
 
 static inline void *_take_free_obj(struct uk_allocpool *p)
 {
 	struct free_obj *obj;
+	__u64 old, new;
 
 	UK_ASSERT(p);
-	UK_ASSERT(p->free_obj_count > 0);
 
 	/* get object from list head */
-	obj = uk_list_first_entry(&p->free_obj, struct free_obj, list);
-	uk_list_del(&obj->list);
-	p->free_obj_count--;
+	old = __atomic_load_n(&p->free_head, __ATOMIC_ACQUIRE);
+	do {
+		obj = free_head_ptr(old);
+		if (!obj)
+			return NULL;
+
+		/* `obj` might be taken and modified concurrently. In such a
+		 * case `next` is garbage but the tag of the head changed, so
+		 * the exchange below fails.
+		 */
+		new = free_head_make(UK_READ_ONCE(obj->next),
+				     free_head_tag(old) + 1);
+	} while (!__atomic_compare_exchange_n(&p->free_head, &old, new, 1,
+					      __ATOMIC_ACQUIRE,
+					      __ATOMIC_ACQUIRE));
+
+	ukarch_dec(&p->free_obj_count);
 	return (void *) obj;
 }
 
+/*
+ * Allocates a new chunk of objects from the parent allocator and adds
+ * the objects to the free list
+ */
+static int _pool_grow(struct uk_allocpool *p)
+{
+	struct pool_chunk *chunk;
+	struct free_obj *first, *last, *obj;
+	unsigned int count, i;
+	__uptr obj_ptr;
+
+	count = UK_READ_ONCE(p->grow_count);
+	if (!count || !p->parent)
+		return -ENOMEM;
+
+	chunk = uk_malloc(p->parent, sizeof(*chunk) + p->obj_align
+			  + ((__sz) count * p->obj_len));
+	if (unlikely(!chunk))
+		return -ENOMEM;
+
+	/* Build the chain of new objects */
+	obj_ptr = ALIGN_UP((__uptr) chunk + sizeof(*chunk), p->obj_align);
+	first = NULL;
+	last  = (struct free_obj *) obj_ptr;
+	for (i = 0; i < count; ++i) {
+		obj = (struct free_obj *) obj_ptr;
+		obj->next = first;
+		first = obj;
+		obj_ptr += p->obj_len;
+	}
+
+	/* Remember chunk for uk_allocpool_free() */
+	chunk->next = __atomic_load_n(&p->chunks, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&p->chunks, &chunk->next, chunk, 1,
+					    __ATOMIC_RELEASE,
+					    __ATOMIC_RELAXED))
+		;
+
+	ukarch_fetch_add(&p->obj_count, count);
+	_prepend_free_objs(p, first, last, count);
+
+	uk_pr_debug("%p: Pool grown by %u objs (chunk %p)\n",
+		    p, count, chunk);
+	return 0;
+}
+
+/*
+ * Takes an object from the free list; grows the pool when it is empty
+ */
+static inline void *_take_or_grow(struct uk_allocpool *p)
+{
+	void *obj;
+
+	do {
+		obj = _take_free_obj(p);
+		if (likely(obj))
+			return obj;
+	} while (_pool_grow(p) == 0);
+
+	return NULL;
+}
+
 static void pool_free(struct uk_alloc *a, void *ptr)
 {
 	struct uk_allocpool *p = ukalloc2pool(a);
@@ -138,33 +281,43 @@ static void *pool_malloc(struct uk_alloc *a, __sz size)
 	struct uk_allocpool *p = ukalloc2pool(a);
 	void *obj;
 
-	if (unlikely((size > p->obj_len)
-		     || uk_list_empty(&p->free_obj))) {
-		uk_alloc_stats_count_enomem(a, p->obj_len);
-		errno = ENOMEM;
-		return NULL;
-	}
+	if (unlikely(size > p->obj_len))
+		goto enomem;
+
+	obj = _take_or_grow(p);
+	if (unlikely(!obj))
+		goto enomem;
 
-	obj = _take_free_obj(p);
 	uk_alloc_stats_count_alloc(a, obj, p->obj_len);
 	return obj;
+
+enomem:
+	uk_alloc_stats_count_enomem(a, p->obj_len);
+	errno = ENOMEM;
+	return NULL;
 }
 
 static int pool_posix_memalign(struct uk_alloc *a, void **memptr, __sz align,
 			       __sz size)
 {
 	struct uk_allocpool *p = ukalloc2pool(a);
+	void *obj;
 
 	if (unlikely((size > p->obj_len)
-		     || (align > p->obj_align)
-		     || uk_list_empty(&p->free_obj))) {
-		uk_alloc_stats_count_enomem(a, p->obj_len);
-		return ENOMEM;
-	}
+		     || (align > p->obj_align)))
+		goto enomem;
 
-	*memptr = _take_free_obj(p);
+	obj = _take_or_grow(p);
+	if (unlikely(!obj))
+		goto enomem;
+
+	*memptr = obj;
 	uk_alloc_stats_count_alloc(a, *memptr, p->obj_len);
 	return 0;
+
+enomem:
+	uk_alloc_stats_count_enomem(a, p->obj_len);
+	return ENOMEM;
 }
 
 void *uk_allocpool_take(struct uk_allocpool *p)
@@ -173,13 +326,13 @@ void *uk_allocpool_take(struct uk_allocpool *p)
 
 	UK_ASSERT(p);
 
-	if (unlikely(uk_list_empty(&p->free_obj))) {
+	obj = _take_or_grow(p);
+	if (unlikely(!obj)) {
 		uk_alloc_stats_count_enomem(allocpool2ukalloc(p),
 					    p->obj_len);
 		return NULL;
 	}
 
-	obj = _take_free_obj(p);
 	uk_alloc_stats_count_alloc(allocpool2ukalloc(p),
 				   obj, p->obj_len);
 	return obj;
@@ -194,9 +347,9 @@ unsigned int uk_allocpool_take_batch(struct uk_allocpool *p,
 	UK_ASSERT(obj);
 
 	for (i = 0; i < count; ++i) {
-		if (unlikely(uk_list_empty(&p->free_obj)))
+		obj[i] = _take_or_grow(p);
+		if (unlikely(!obj[i]))
 			break;
-		obj[i] = _take_free_obj(p);
 		uk_alloc_stats_count_alloc(allocpool2ukalloc(p),
 					   obj[i], p->obj_len);
 	}
@@ -220,23 +373,37 @@ void uk_allocpool_return(struct uk_allocpool *p, void *obj)
 void uk_allocpool_return_batch(struct uk_allocpool *p,
 			       void *obj[], unsigned int count)
 {
+	struct free_obj *first, *cur;
 	unsigned int i;
 
 	UK_ASSERT(p);
 	UK_ASSERT(obj);
 
-	for (i = 0; i < count; ++i) {
-		_prepend_free_obj(p, obj[i]);
+	if (unlikely(count == 0))
+		return;
+
+	/* Chain the objects locally and publish them with a single update
+	 * of the list head
+	 */
+	first = (struct free_obj *) obj[0];
+	cur = first;
+	for (i = 1; i < count; ++i) {
+		UK_ASSERT(obj[i]);
+		cur->next = (struct free_obj *) obj[i];
+		cur = cur->next;
+	}
+	_prepend_free_objs(p, first, cur, count);
+
+	for (i = 0; i < count; ++i)
 		uk_alloc_stats_count_free(allocpool2ukalloc(p),
 					  obj[i], p->obj_len);
-	}
 }
 
 static __ssz pool_availmem(struct uk_alloc *a)
 {
 	struct uk_allocpool *p = ukalloc2pool(a);
 
-	return (__ssz) (p->free_obj_count * p->obj_len);
+	return (__ssz) (uk_allocpool_availcount(p) * p->obj_len);
 }
 
 static __ssz pool_maxalloc(struct uk_alloc *a)
@@ -263,7 +430,7 @@ __sz uk_allocpool_reqmem(unsigned int obj_count, __sz obj_len,
 
 unsigned int uk_allocpool_availcount(struct uk_allocpool *p)
 {
-	return p->free_obj_count;
+	return ukarch_load_n(&p->free_obj_count);
 }
 
 __sz uk_allocpool_objlen(struct uk_allocpool *p)
@@ -271,6 +438,18 @@ __sz uk_allocpool_objlen(struct uk_allocpool *p)
 	return p->obj_len;
 }
 
+int uk_allocpool_set_grow(struct uk_allocpool *p, unsigned int grow_count)
+{
+	UK_ASSERT(p);
+
+	/* Only pools with a parent allocator can grow */
+	if (grow_count && !p->parent)
+		return -EINVAL;
+
+	UK_WRITE_ONCE(p->grow_count, grow_count);
+	return 0;
+}
+
 struct uk_allocpool *uk_allocpool_init(void *base, __sz len,
 				       __sz obj_len, __sz obj_align)
 {
@@ -308,7 +487,7 @@ struct uk_allocpool *uk_allocpool_init(void *base, __sz len,
 
 	p->obj_count = 0;
 	p->free_obj_count = 0;
-	UK_INIT_LIST_HEAD(&p->free_obj);
+	p->free_head = free_head_make(NULL, 0);
 	while (left >= obj_alen) {
 		++p->obj_count;
 		_prepend_free_obj(p, obj_ptr);
@@ -321,6 +500,8 @@ out:
 	p->obj_align       = obj_align;
 	p->base            = base;
 	p->parent          = NULL;
+	p->grow_count      = 0;
+	p->chunks          = NULL;
 
 	uk_alloc_init_malloc(a,
 			     pool_malloc,
@@ -365,6 +546,8 @@ struct uk_allocpool *uk_allocpool_alloc(struct uk_alloc *parent,
 
 void uk_allocpool_free(struct uk_allocpool *p)
 {
+	struct pool_chunk *chunk, *next;
+
 	/* If we do not have a parent, this pool was created with
 	 * uk_allocpool_init(). Such a pool cannot be free'd with
 	 * this function since we are not the owner of the allocation
@@ -378,5 +561,9 @@ void uk_allocpool_free(struct uk_allocpool *p)
 	/* TODO: Provide unregistration interface at `lib/ukalloc` */
 	UK_CRASH("Unregistering from `lib/ukalloc` not implemented.\n");
 
+	for (chunk = p->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		uk_free(p->parent, chunk);
+	}
 	uk_free(p->parent, p->base);
 }
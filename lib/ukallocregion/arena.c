@@ -0,0 +1,360 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Arena allocator on top of ukallocregion: a chain of region chunks that
+ * are bump-allocated one after another. Memory is only released in bulk by
+ * rewinding the allocation position (mark/release, reset), which makes
+ * arenas a good fit for per-request or per-phase allocations.
+ *
+ * The chunk chain is ordered by allocation position: `cur` is the chunk we
+ * currently allocate from, chunks before it are full, chunks after it are
+ * spare chunks that were left behind by a release. Spare chunks are reused
+ * before new memory is requested from the parent allocator.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <uk/allocregion.h>
+#include <uk/alloc_impl.h>
+#include <uk/essentials.h>
+#include <uk/assert.h>
+#include <uk/print.h>
+#include "region.h"
+
+#define ARENA_ALIGN (sizeof(void *))
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	struct uk_allocregion region;
+};
+
+struct uk_arena {
+	struct uk_alloc self;
+
+	struct uk_alloc *parent;
+	size_t chunk_len;
+
+	struct arena_chunk *head; /* first chunk, embedded in the arena */
+	struct arena_chunk *cur;  /* chunk we allocate from */
+};
+
+UK_CTASSERT((sizeof(struct arena_chunk) % ARENA_ALIGN) == 0);
+
+static inline struct uk_arena *ukalloc2arena(struct uk_alloc *a)
+{
+	UK_ASSERT(a);
+	return __containerof(a, struct uk_arena, self);
+}
+
+#define arena2ukalloc(arena) \
+	(&(arena)->self)
+
+static inline void *chunk_start(struct arena_chunk *c)
+{
+	return (void *)((uintptr_t) c + sizeof(*c));
+}
+
+static inline void chunk_init(struct arena_chunk *c, size_t len)
+{
+	c->next = NULL;
+	c->region.heap_base = chunk_start(c);
+	c->region.heap_top  = (void *)((uintptr_t) c + len);
+}
+
+static inline void chunk_rewind(struct arena_chunk *c)
+{
+	c->region.heap_base = chunk_start(c);
+}
+
+static inline size_t chunk_leftspace(struct arena_chunk *c)
+{
+	return (uintptr_t) c->region.heap_top
+		- (uintptr_t) c->region.heap_base;
+}
+
+/* Allocates a new chunk from the parent that can satisfy the given request
+ * and links it directly after the current chunk
+ */
+static struct arena_chunk *arena_grow(struct uk_arena *arena,
+				      size_t size, size_t align)
+{
+	struct arena_chunk *c;
+	size_t len;
+
+	/* worst-case padding for alignment */
+	if (size > SIZE_MAX - sizeof(*c) - (align - 1))
+		return NULL;
+	len = MAX(arena->chunk_len, sizeof(*c) + size + (align - 1));
+
+	c = uk_malloc(arena->parent, len);
+	if (!c)
+		return NULL;
+	chunk_init(c, len);
+
+	c->next = arena->cur->next;
+	arena->cur->next = c;
+	arena->cur = c;
+	return c;
+}
+
+static void *arena_bump(struct uk_arena *arena, size_t size, size_t align)
+{
+	struct arena_chunk *next;
+	void *ptr;
+
+	ptr = uk_allocregion_bump(&arena->cur->region, size, align);
+	if (likely(ptr))
+		return ptr;
+	if (unlikely(!size))
+		return NULL;
+
+	/* Continue on the next spare chunk if the request fits into it.
+	 * Otherwise, the spare chunk is left for later requests and a new
+	 * chunk is inserted in front of it.
+	 */
+	next = arena->cur->next;
+	if (next) {
+		chunk_rewind(next);
+		ptr = uk_allocregion_bump(&next->region, size, align);
+		if (ptr) {
+			arena->cur = next;
+			return ptr;
+		}
+	}
+
+	if (!arena_grow(arena, size, align))
+		return NULL;
+	return uk_allocregion_bump(&arena->cur->region, size, align);
+}
+
+static void *arena_malloc(struct uk_alloc *a, size_t size)
+{
+	struct uk_arena *arena = ukalloc2arena(a);
+	void *ptr;
+
+	ptr = arena_bump(arena, size, ARENA_ALIGN);
+	if (unlikely(!ptr)) {
+		uk_alloc_stats_count_enomem(a, size);
+		return NULL;
+	}
+
+	uk_alloc_stats_count_alloc(a, ptr, size);
+	return ptr;
+}
+
+static int arena_posix_memalign(struct uk_alloc *a, void **memptr,
+				size_t align, size_t size)
+{
+	struct uk_arena *arena = ukalloc2arena(a);
+	void *ptr;
+
+	/* align must be a power of two */
+	UK_ASSERT(((align - 1) & align) == 0);
+
+	/* align must be larger than pointer size */
+	UK_ASSERT((align % sizeof(void *)) == 0);
+
+	if (!size) {
+		*memptr = NULL;
+		return EINVAL;
+	}
+
+	ptr = arena_bump(arena, size, align);
+	if (unlikely(!ptr)) {
+		uk_alloc_stats_count_enomem(a, size);
+		return ENOMEM;
+	}
+
+	*memptr = ptr;
+	uk_alloc_stats_count_alloc(a, ptr, size);
+	return 0;
+}
+
+static void arena_free(struct uk_alloc *a __maybe_unused,
+		       void *ptr __maybe_unused)
+{
+	/* Memory is released with uk_arena_release_to() or uk_arena_reset().
+	 * Count a free operation but do not release memory from stats
+	 */
+	uk_alloc_stats_count_free(a, ptr, 0);
+}
+
+static ssize_t arena_maxalloc(struct uk_alloc *a)
+{
+	struct uk_arena *arena = ukalloc2arena(a);
+	ssize_t parent_max;
+	size_t left;
+
+	left = chunk_leftspace(arena->cur);
+	parent_max = uk_alloc_maxalloc(arena->parent);
+	if (parent_max > (ssize_t) (sizeof(struct arena_chunk) + ARENA_ALIGN))
+		left = MAX(left, (size_t) parent_max
+			   - sizeof(struct arena_chunk) - ARENA_ALIGN);
+	return (ssize_t) left;
+}
+
+static ssize_t arena_availmem(struct uk_alloc *a)
+{
+	struct uk_arena *arena = ukalloc2arena(a);
+	ssize_t parent_avail;
+	ssize_t left;
+
+	left = (ssize_t) chunk_leftspace(arena->cur);
+	parent_avail = uk_alloc_availmem(arena->parent);
+	if (parent_avail > 0)
+		left += parent_avail;
+	return left;
+}
+
+struct uk_arena *uk_arena_alloc(struct uk_alloc *parent, size_t chunk_len)
+{
+	struct uk_arena *arena;
+	struct uk_alloc *a;
+	size_t metalen = sizeof(*arena) + sizeof(struct arena_chunk);
+
+	UK_ASSERT(parent);
+
+	if (chunk_len <= metalen + ARENA_ALIGN) {
+		uk_pr_debug("Arena chunk size %"__PRIsz" B too small\n",
+			    chunk_len);
+		return NULL;
+	}
+
+	arena = uk_malloc(parent, chunk_len);
+	if (!arena)
+		return NULL;
+
+	arena->parent    = parent;
+	arena->chunk_len = chunk_len;
+	arena->head      = (struct arena_chunk *)((uintptr_t) arena
+						  + sizeof(*arena));
+	arena->cur       = arena->head;
+	chunk_init(arena->head, chunk_len - sizeof(*arena));
+
+	/* The arena is not registered with lib/ukalloc so that it can be
+	 * free'd again: fill in the interface without uk_alloc_init_malloc()
+	 */
+	a = arena2ukalloc(arena);
+	a->malloc         = arena_malloc;
+	a->calloc         = uk_calloc_compat;
+	a->realloc        = uk_realloc_compat;
+	a->posix_memalign = arena_posix_memalign;
+	a->memalign       = uk_memalign_compat;
+	a->free           = arena_free;
+	a->malloc_fast    = NULL;
+	a->free_fast      = NULL;
+#if CONFIG_LIBUKALLOC_IFMALLOC
+	a->free_backend   = NULL;
+	a->malloc_backend = NULL;
+#endif
+	a->palloc         = uk_palloc_compat;
+	a->pfree          = uk_pfree_compat;
+	a->maxalloc       = arena_maxalloc;
+	a->availmem       = arena_availmem;
+	a->pmaxalloc      = uk_alloc_pmaxalloc_compat;
+	a->pavailmem      = uk_alloc_pavailmem_compat;
+	a->addmem         = NULL;
+	a->next           = NULL;
+	uk_alloc_lock_init(a);
+	uk_alloc_stats_reset(a);
+
+	uk_pr_debug("%p: Arena created on %p, chunk size %"__PRIsz" B\n",
+		    arena, parent, chunk_len);
+	return arena;
+}
+
+void uk_arena_free(struct uk_arena *arena)
+{
+	struct arena_chunk *c, *next;
+
+	UK_ASSERT(arena);
+
+	for (c = arena->head->next; c; c = next) {
+		next = c->next;
+		uk_free(arena->parent, c);
+	}
+	uk_free(arena->parent, arena);
+}
+
+struct uk_arena_mark uk_arena_mark(struct uk_arena *arena)
+{
+	struct uk_arena_mark mark;
+
+	UK_ASSERT(arena);
+
+	mark.chunk = arena->cur;
+	mark.pos   = arena->cur->region.heap_base;
+	return mark;
+}
+
+void uk_arena_release_to(struct uk_arena *arena, struct uk_arena_mark mark)
+{
+	struct arena_chunk *c = (struct arena_chunk *) mark.chunk;
+
+	UK_ASSERT(arena);
+	UK_ASSERT(c);
+	UK_ASSERT((uintptr_t) mark.pos >= (uintptr_t) chunk_start(c));
+	UK_ASSERT((uintptr_t) mark.pos <= (uintptr_t) c->region.heap_top);
+
+	/* Chunks after `c` become spare chunks, they get rewound lazily
+	 * when we move on to them
+	 */
+	c->region.heap_base = mark.pos;
+	arena->cur = c;
+}
+
+void uk_arena_reset(struct uk_arena *arena)
+{
+	UK_ASSERT(arena);
+
+	chunk_rewind(arena->head);
+	arena->cur = arena->head;
+}
+
+void uk_arena_trim(struct uk_arena *arena)
+{
+	struct arena_chunk *c, *next;
+
+	UK_ASSERT(arena);
+
+	for (c = arena->cur->next; c; c = next) {
+		next = c->next;
+		uk_free(arena->parent, c);
+	}
+	arena->cur->next = NULL;
+}
+
+struct uk_alloc *uk_arena2ukalloc(struct uk_arena *arena)
+{
+	UK_ASSERT(arena);
+	return arena2ukalloc(arena);
+}
@@ -43,6 +43,100 @@ extern "C" {
 /* allocator initialization */
 struct uk_alloc *uk_allocregion_init(void *base, size_t len);
 
+/*
+ * Arenas bump-allocate from a chain of region chunks that are taken from a
+ * parent allocator on demand. Single objects cannot be released: memory is
+ * given back in bulk by rewinding to a previously taken mark or by resetting
+ * the whole arena. Chunks that become unused this way are kept and reused by
+ * following allocations until the arena is trimmed or free'd.
+ * Arenas are not registered with lib/ukalloc, so they never become the
+ * default allocator and can be free'd again.
+ */
+struct uk_arena;
+
+/* Allocation position within an arena, see uk_arena_mark() */
+struct uk_arena_mark {
+	void *chunk;
+	void *pos;
+};
+
+/**
+ * Allocates an arena on a parent allocator. The arena metadata is placed
+ * in the first chunk.
+ *
+ * @param parent
+ *  Allocator from which chunks are taken.
+ * @param chunk_len
+ *  Size of a chunk (bytes), including chunk metadata. Allocations that do
+ *  not fit into a chunk of this size get a dedicated, larger chunk.
+ * @return
+ *  - (NULL): If allocation failed (e.g., ENOMEM) or `chunk_len` is too small.
+ *  - pointer to allocated arena.
+ */
+struct uk_arena *uk_arena_alloc(struct uk_alloc *parent, size_t chunk_len);
+
+/**
+ * Frees an arena that was allocated with uk_arena_alloc(). All chunks,
+ * including spare ones, are returned to the parent allocator.
+ *
+ * @param arena
+ *  Pointer to arena that will be free'd.
+ */
+void uk_arena_free(struct uk_arena *arena);
+
+/**
+ * Returns the current allocation position of an arena.
+ * A mark is invalidated when the arena is released to an older mark or
+ * reset.
+ *
+ * @param arena
+ *  Pointer to arena.
+ * @return
+ *  Mark that can be passed to uk_arena_release_to().
+ */
+struct uk_arena_mark uk_arena_mark(struct uk_arena *arena);
+
+/**
+ * Releases all memory that was allocated from an arena after `mark` was
+ * taken. Chunks behind the mark are kept as spare chunks. Runs in O(1).
+ *
+ * @param arena
+ *  Pointer to arena.
+ * @param mark
+ *  Position returned by uk_arena_mark().
+ */
+void uk_arena_release_to(struct uk_arena *arena, struct uk_arena_mark mark);
+
+/**
+ * Releases all memory that was allocated from an arena.
+ * Equivalent to releasing to a mark taken directly after uk_arena_alloc().
+ *
+ * @param arena
+ *  Pointer to arena.
+ */
+void uk_arena_reset(struct uk_arena *arena);
+
+/**
+ * Returns spare chunks of an arena (i.e., chunks behind the current
+ * allocation position) to the parent allocator. Runs in O(chunks).
+ *
+ * @param arena
+ *  Pointer to arena.
+ */
+void uk_arena_trim(struct uk_arena *arena);
+
+/**
+ * Return uk_alloc compatible interface for an arena.
+ * With this interface, uk_malloc(), uk_posix_memalign(), etc. can be used
+ * with the arena. uk_free() is accepted but does not release memory.
+ *
+ * @param arena
+ *  Pointer to arena.
+ * @return
+ *  Pointer to uk_alloc interface of given arena.
+ */
+struct uk_alloc *uk_arena2ukalloc(struct uk_arena *arena);
+
 #ifdef __cplusplus
 }
 #endif
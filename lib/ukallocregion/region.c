@@ -53,16 +53,12 @@
 #include <uk/allocregion.h>
 #include <uk/alloc_impl.h>
 #include <uk/page.h>	/* round_pgup() */
-
-struct uk_allocregion {
-	void *heap_top;
-	void *heap_base;
-};
+#include "region.h"
 
 static void *uk_allocregion_malloc(struct uk_alloc *a, size_t size)
 {
 	struct uk_allocregion *b;
-	uintptr_t intptr, newbase;
+	void *ptr;
 
 	UK_ASSERT(a != NULL);
 
@@ -73,21 +69,12 @@ static void *uk_allocregion_malloc(struct uk_alloc *a, size_t size)
 	/* return aligned pointers: this is a requirement for some
 	 * embedded systems archs, and more generally good for performance
 	 */
-	intptr = ALIGN_UP(((uintptr_t) b->heap_base),
-			     (uintptr_t) sizeof(void *));
-
-	newbase  = intptr + size;
-	if (newbase > (uintptr_t) b->heap_top)
-		goto enomem; /* OOM */
-
-	/* Check for overflow, handle malloc(0) */
-	if (newbase <= (uintptr_t) b->heap_base)
+	ptr = uk_allocregion_bump(b, size, (uintptr_t) sizeof(void *));
+	if (!ptr)
 		goto enomem;
 
-	b->heap_base = (void *)(newbase);
-
-	uk_alloc_stats_count_alloc(a, (void *) intptr, size);
-	return (void *) intptr;
+	uk_alloc_stats_count_alloc(a, ptr, size);
+	return ptr;
 
 enomem:
 	uk_alloc_stats_count_enomem(a, size);
@@ -98,7 +85,7 @@ static int uk_allocregion_posix_memalign(struct uk_alloc *a, void **memptr,
 					 size_t align, size_t size)
 {
 	struct uk_allocregion *b;
-	uintptr_t intptr, newbase;
+	void *ptr;
 
 	UK_ASSERT(a != NULL);
 
@@ -117,20 +104,13 @@ static int uk_allocregion_posix_memalign(struct uk_alloc *a, void **memptr,
 		return EINVAL;
 	}
 
-	intptr = ALIGN_UP((uintptr_t) b->heap_base, (uintptr_t) align);
-
-	newbase  = intptr + size;
-	if (newbase > (uintptr_t) b->heap_top)
-		goto enomem; /* out-of-memory */
-
-	/* Check for overflow */
-	if (newbase <= (uintptr_t) b->heap_base)
+	ptr = uk_allocregion_bump(b, size, (uintptr_t) align);
+	if (!ptr)
 		goto enomem;
 
-	*memptr = (void *)intptr;
-	b->heap_base = (void *)(newbase);
+	*memptr = ptr;
 
-	uk_alloc_stats_count_alloc(a, (void *) intptr, size);
+	uk_alloc_stats_count_alloc(a, ptr, size);
 	return 0;
 
 enomem:
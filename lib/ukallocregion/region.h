@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UKALLOCREGION_REGION_H__
+#define __UKALLOCREGION_REGION_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <uk/essentials.h>
+
+struct uk_allocregion {
+	void *heap_top;
+	void *heap_base;
+};
+
+/* Bump `size` bytes aligned to `align` off the region. Returns NULL if the
+ * region is exhausted, on overflow, or for zero-sized requests.
+ */
+static inline void *uk_allocregion_bump(struct uk_allocregion *b,
+					size_t size, uintptr_t align)
+{
+	uintptr_t intptr, newbase;
+
+	intptr = ALIGN_UP((uintptr_t) b->heap_base, align);
+
+	newbase  = intptr + size;
+	if (newbase > (uintptr_t) b->heap_top)
+		return NULL; /* out-of-memory */
+
+	/* Check for overflow, handle malloc(0) */
+	if (newbase <= (uintptr_t) b->heap_base)
+		return NULL;
+
+	b->heap_base = (void *) newbase;
+	return (void *) intptr;
+}
+
+#endif /* __UKALLOCREGION_REGION_H__ */
@@ -0,0 +1,791 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* ukallocslab serves small allocations from size-classed slabs.
+ *
+ * A slab is a naturally aligned chunk of SLAB_SIZE bytes that is taken from a
+ * binary buddy backend. The slab header is placed at the beginning of the
+ * chunk so that the slab of an object is found by aligning its address down.
+ * Requests larger than SLAB_MAX_OBJ_SIZE bypass the slabs and are served with
+ * whole pages from the backend (see uk_malloc_ifpages()).
+ *
+ * Every size class is a multiple of 16 bytes, so that every object has the
+ * alignment that malloc() guarantees for any type. Size classes are 16 bytes
+ * apart up to 256 bytes. Above that, each power of two is split into eight
+ * classes. From 128 bytes on, a request is thus rounded up by at most 12.5%
+ * of its size; smaller requests by less than 16 bytes.
+ * posix_memalign() picks a class that is a multiple of the alignment.
+ *
+ * Page-based allocations are not SLAB_SIZE aligned, so the header of a slab
+ * cannot be told apart from arbitrary data by looking at memory alone. For
+ * this reason, a bitmap with one bit per SLAB_SIZE block is kept for each
+ * memory region; a set bit marks a block that is used as slab.
+ *
+ * With CONFIG_LIBUKALLOCSLAB_TCACHE, each thread additionally caches a few
+ * free objects per size class in magazines. Frees push to and allocations
+ * pop from the magazine of the current thread, so that the common case
+ * touches neither the slab headers nor the shared slab lists. Because the
+ * magazines are private to their thread, they are also used by lock-free
+ * fast paths that bypass the allocator lock of lib/ukalloc.
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <uk/allocslab.h>
+#include <uk/allocbbuddy.h>
+#include <uk/alloc_impl.h>
+#include <uk/arch/limits.h>
+#include <uk/arch/atomic.h>
+#include <uk/bitops.h>
+#include <uk/list.h>
+#include <uk/print.h>
+#include <uk/assert.h>
+#include <uk/page.h>
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+#include <uk/sched.h>
+#include <uk/thread.h>
+#endif
+
+#define SLAB_PAGE_ORDER		3
+#define SLAB_SHIFT		(SLAB_PAGE_ORDER + __PAGE_SHIFT)
+#define SLAB_SIZE		(1UL << SLAB_SHIFT)
+#define SLAB_HDR_SIZE		64 /* objects are aligned to this size */
+#define SLAB_MAX_ALIGN		SLAB_HDR_SIZE
+#define SLAB_MAX_OBJ_SIZE	4096
+#define SLAB_NR_CLASSES		48
+
+/* keep a slab bitmap for each memory region separately */
+struct slab_memr {
+	struct slab_memr *next;
+	__uptr start;
+	__uptr end;
+	__uptr first_slab; /* address of the block that map[0] refers to */
+	unsigned long map[];
+};
+
+struct slab_class {
+	__sz obj_size;
+	unsigned int nr_objs;  /* number of objects per slab */
+	unsigned int nr_empty; /* number of slabs without used objects */
+	struct uk_list_head partial; /* slabs with at least one free object */
+};
+
+struct slab {
+	struct uk_list_head list;
+	struct slab_class *cls;
+	void *free_obj;  /* list of returned objects */
+	__uptr unused;   /* first object that was never handed out */
+	unsigned int nr_used;
+};
+
+UK_CTASSERT(sizeof(struct slab) <= SLAB_HDR_SIZE);
+
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+#define SLAB_MAG_SIZE CONFIG_LIBUKALLOCSLAB_MAGAZINE_SIZE
+
+struct slab_magazine {
+	unsigned int rounds;
+	void *obj[SLAB_MAG_SIZE];
+};
+
+struct uk_allocslab_tcache {
+	struct uk_alloc *a; /* owning allocator */
+	int busy; /* the magazines are being modified */
+	struct slab_magazine mag[SLAB_NR_CLASSES];
+};
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+struct uk_allocslab {
+	struct uk_alloc *backend;
+	struct slab_memr *memr_head;
+	struct slab_class cls[SLAB_NR_CLASSES];
+};
+
+#define ukalloc2slab(a) \
+	((struct uk_allocslab *) &(a)->priv)
+
+/*********************
+ * SIZE CLASSES
+ */
+static inline unsigned int size_to_class(__sz size)
+{
+	unsigned long order;
+
+	UK_ASSERT(size > 0 && size <= SLAB_MAX_OBJ_SIZE);
+
+	if (size <= 128)
+		return (size - 1) >> 4;
+
+	/* Class sizes are: 2^order + n * 2^(order - 3), n = 1..8 */
+	order = ukarch_flsl(size - 1);
+	return ((order - 7) << 3) + ((size - 1) >> (order - 3));
+}
+
+static inline __sz class_to_size(unsigned int idx)
+{
+	unsigned long order;
+
+	UK_ASSERT(idx < SLAB_NR_CLASSES);
+
+	if (idx < 8)
+		return (idx + 1) << 4;
+
+	order = 7 + ((idx - 8) >> 3);
+	return (1UL << order) + ((((idx - 8) & 7) + 1) << (order - 3));
+}
+
+/*********************
+ * SLAB BITMAP
+ */
+static inline struct slab_memr *map_get_memr(struct uk_allocslab *s,
+					     __uptr addr)
+{
+	struct slab_memr *memr;
+
+	for (memr = __atomic_load_n(&s->memr_head, __ATOMIC_ACQUIRE);
+	     memr != NULL; memr = memr->next) {
+		if (addr >= memr->start && addr < memr->end)
+			return memr;
+	}
+	return NULL;
+}
+
+static inline void map_set_slab(struct uk_allocslab *s, struct slab *slab,
+				int is_slab)
+{
+	struct slab_memr *memr = map_get_memr(s, (__uptr) slab);
+	unsigned long idx;
+
+	UK_ASSERT(memr != NULL);
+
+	idx = ((__uptr) slab - memr->first_slab) >> SLAB_SHIFT;
+	if (is_slab)
+		memr->map[UK_BIT_WORD(idx)] |= UK_BIT_MASK(idx);
+	else
+		memr->map[UK_BIT_WORD(idx)] &= ~UK_BIT_MASK(idx);
+}
+
+/* Returns the slab of an object or NULL for page-based allocations */
+static inline struct slab *obj_to_slab(struct uk_allocslab *s,
+				       const void *ptr)
+{
+	struct slab_memr *memr = map_get_memr(s, (__uptr) ptr);
+	unsigned long idx;
+
+	/* the object was clearly not allocated by us */
+	UK_ASSERT(memr != NULL);
+
+	idx = (ALIGN_DOWN((__uptr) ptr, SLAB_SIZE) - memr->first_slab)
+	      >> SLAB_SHIFT;
+	if (!(memr->map[UK_BIT_WORD(idx)] & UK_BIT_MASK(idx)))
+		return NULL;
+	return (struct slab *) ALIGN_DOWN((__uptr) ptr, SLAB_SIZE);
+}
+
+/*********************
+ * SLABS
+ */
+static struct slab *slab_create(struct uk_allocslab *s,
+				struct slab_class *cls)
+{
+	struct slab *slab;
+
+	slab = uk_palloc(s->backend, 1UL << SLAB_PAGE_ORDER);
+	if (unlikely(!slab))
+		return NULL;
+
+	/* buddy chunks are naturally aligned */
+	UK_ASSERT(ALIGN_DOWN((__uptr) slab, SLAB_SIZE) == (__uptr) slab);
+
+	slab->cls = cls;
+	slab->free_obj = NULL;
+	slab->unused = (__uptr) slab + SLAB_HDR_SIZE;
+	slab->nr_used = 0;
+	map_set_slab(s, slab, 1);
+
+	uk_list_add(&slab->list, &cls->partial);
+	cls->nr_empty++;
+	return slab;
+}
+
+static void slab_destroy(struct uk_allocslab *s, struct slab *slab)
+{
+	UK_ASSERT(slab->nr_used == 0);
+
+	uk_list_del(&slab->list);
+	map_set_slab(s, slab, 0);
+	uk_pfree(s->backend, slab, 1UL << SLAB_PAGE_ORDER);
+}
+
+static void *slab_class_alloc(struct uk_allocslab *s, struct slab_class *cls)
+{
+	struct slab *slab;
+	void *obj;
+
+	if (unlikely(uk_list_empty(&cls->partial))) {
+		slab = slab_create(s, cls);
+		if (unlikely(!slab))
+			return NULL;
+	} else {
+		slab = uk_list_first_entry(&cls->partial, struct slab, list);
+	}
+
+	if (slab->nr_used == 0)
+		cls->nr_empty--;
+
+	if (slab->free_obj) {
+		obj = slab->free_obj;
+		slab->free_obj = *((void **) obj);
+	} else {
+		obj = (void *) slab->unused;
+		slab->unused += cls->obj_size;
+	}
+
+	/* full slabs are not kept on any list */
+	if (++slab->nr_used == cls->nr_objs)
+		uk_list_del(&slab->list);
+	return obj;
+}
+
+static void slab_class_free(struct uk_allocslab *s, struct slab *slab,
+			    void *obj)
+{
+	struct slab_class *cls = slab->cls;
+
+	UK_ASSERT(slab->nr_used > 0);
+	UK_ASSERT(((__uptr) obj - (__uptr) slab - SLAB_HDR_SIZE)
+		  % cls->obj_size == 0);
+
+	*((void **) obj) = slab->free_obj;
+	slab->free_obj = obj;
+
+	if (slab->nr_used-- == cls->nr_objs)
+		uk_list_add(&slab->list, &cls->partial);
+
+	if (slab->nr_used == 0) {
+		/* Keep one empty slab per class so that an alloc/free
+		 * sequence on a slab boundary does not hit the backend
+		 * every time.
+		 */
+		if (cls->nr_empty > 0)
+			slab_destroy(s, slab);
+		else
+			cls->nr_empty++;
+	}
+}
+
+/*********************
+ * PER-THREAD MAGAZINES
+ */
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+static void slab_free(struct uk_alloc *a, void *ptr);
+static void *slab_malloc(struct uk_alloc *a, __sz size);
+
+/* Returns the magazines of the current thread. When `create` is set, they
+ * are allocated on first use.
+ */
+static inline struct uk_allocslab_tcache *tcache_get(struct uk_alloc *a,
+						     int create)
+{
+	struct uk_sched *sched = uk_sched_get_default();
+	struct uk_allocslab_tcache *tc;
+	struct uk_thread *current;
+	unsigned int i;
+
+	/* There is no current thread before the scheduler has started */
+	if (unlikely(!sched || !uk_sched_started(sched)))
+		return NULL;
+
+	current = uk_thread_current();
+	tc = current->slab_tcache;
+	/* An interrupt handler that allocates must not use the magazines
+	 * while the interrupted thread modifies them
+	 */
+	if (likely(tc))
+		return (tc->a == a && !tc->busy) ? tc : NULL;
+	if (!create)
+		return NULL;
+
+	/* NOTE: current->slab_tcache is still unset, so this allocation
+	 *       is served directly by the slabs.
+	 */
+	tc = slab_malloc(a, sizeof(*tc));
+	if (unlikely(!tc))
+		return NULL;
+
+	tc->a = a;
+	tc->busy = 0;
+	for (i = 0; i < SLAB_NR_CLASSES; ++i)
+		tc->mag[i].rounds = 0;
+	barrier();
+	current->slab_tcache = tc;
+	return tc;
+}
+
+/* Every access to the magazines is bracketed by these: an interrupt handler
+ * that allocates while the magazines are busy does not get them from
+ * tcache_get(). The allocator lock does not keep interrupt handlers out.
+ */
+static inline void tcache_enter(struct uk_allocslab_tcache *tc)
+{
+	tc->busy = 1;
+	barrier();
+}
+
+static inline void tcache_leave(struct uk_allocslab_tcache *tc)
+{
+	barrier();
+	tc->busy = 0;
+}
+
+/* Returns the `count` least recently freed objects to their slabs */
+static void mag_flush(struct uk_allocslab *s, struct slab_magazine *mag,
+		      unsigned int count)
+{
+	unsigned int i;
+
+	UK_ASSERT(count <= mag->rounds);
+
+	for (i = 0; i < count; ++i)
+		slab_class_free(s, obj_to_slab(s, mag->obj[i]), mag->obj[i]);
+
+	mag->rounds -= count;
+	memmove(&mag->obj[0], &mag->obj[count],
+		mag->rounds * sizeof(mag->obj[0]));
+}
+
+static int slab_thread_init(struct uk_thread *thread)
+{
+	thread->slab_tcache = NULL;
+	return 0;
+}
+
+static void slab_thread_fini(struct uk_thread *thread)
+{
+	struct uk_allocslab_tcache *tc = thread->slab_tcache;
+	struct uk_alloc *a;
+	struct uk_allocslab *s;
+	unsigned long flags;
+	unsigned int i;
+
+	if (!tc)
+		return;
+
+	/* We are not called through the lib/ukalloc wrappers */
+	a = tc->a;
+	s = ukalloc2slab(a);
+	flags = uk_alloc_lock(a);
+	tcache_enter(tc);
+	thread->slab_tcache = NULL;
+	for (i = 0; i < SLAB_NR_CLASSES; ++i)
+		mag_flush(s, &tc->mag[i], tc->mag[i].rounds);
+	slab_free(a, tc);
+	uk_alloc_unlock(a, flags);
+}
+
+UK_THREAD_INIT(slab_thread_init, slab_thread_fini);
+
+#if !CONFIG_LIBUKALLOC_IFSTATS
+/* Lock-free fast paths: they only use the magazines of the current thread
+ * and leave everything else to slab_malloc() and slab_free(). Allocator
+ * statistics are not updated atomically, so the fast paths are not used
+ * when statistics are enabled.
+ */
+static void *slab_malloc_fast(struct uk_alloc *a, __sz size)
+{
+	struct uk_allocslab_tcache *tc;
+	struct slab_magazine *mag;
+	void *obj = NULL;
+
+	if (unlikely(!size || size > SLAB_MAX_OBJ_SIZE))
+		return NULL;
+
+	tc = tcache_get(a, 0);
+	if (unlikely(!tc))
+		return NULL;
+
+	tcache_enter(tc);
+	mag = &tc->mag[size_to_class(size)];
+	if (likely(mag->rounds))
+		obj = mag->obj[--mag->rounds];
+	tcache_leave(tc);
+	return obj;
+}
+
+static int slab_free_fast(struct uk_alloc *a, void *ptr)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+	struct uk_allocslab_tcache *tc;
+	struct slab_magazine *mag;
+	struct slab *slab;
+	int rc = -1;
+
+	if (!ptr)
+		return 0;
+
+	/* The slab of a used object cannot go away */
+	slab = obj_to_slab(s, ptr);
+	if (unlikely(!slab))
+		return -1;
+
+	tc = tcache_get(a, 0);
+	if (unlikely(!tc))
+		return -1;
+
+	tcache_enter(tc);
+	mag = &tc->mag[slab->cls - s->cls];
+	if (likely(mag->rounds < SLAB_MAG_SIZE)) {
+		mag->obj[mag->rounds++] = ptr;
+		rc = 0;
+	}
+	tcache_leave(tc);
+	return rc;
+}
+#endif /* !CONFIG_LIBUKALLOC_IFSTATS */
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+static inline void *slab_obj_alloc(struct uk_alloc *a, unsigned int idx)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+	struct uk_allocslab_tcache *tc = tcache_get(a, 0);
+	struct slab_magazine *mag;
+	void *obj = NULL;
+
+	if (tc) {
+		tcache_enter(tc);
+		mag = &tc->mag[idx];
+		if (mag->rounds)
+			obj = mag->obj[--mag->rounds];
+		tcache_leave(tc);
+		if (obj)
+			return obj;
+	}
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+	return slab_class_alloc(s, &s->cls[idx]);
+}
+
+static inline void slab_obj_free(struct uk_alloc *a, struct slab *slab,
+				 void *obj)
+{
+	struct uk_allocslab *s = ukalloc2slab(a);
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+	struct uk_allocslab_tcache *tc = tcache_get(a, 1);
+	struct slab_magazine *mag;
+
+	if (tc) {
+		tcache_enter(tc);
+		mag = &tc->mag[slab->cls - s->cls];
+		if (unlikely(mag->rounds == SLAB_MAG_SIZE))
+			mag_flush(s, mag, (SLAB_MAG_SIZE + 1) / 2);
+		mag->obj[mag->rounds++] = obj;
+		tcache_leave(tc);
+		return;
+	}
+#endif /* CONFIG_LIBUKALLOCSLAB_TCACHE */
+
+	slab_class_free(s, slab, obj);
+}
+
+/*********************
+ * UK_ALLOC INTERFACE
+ */
+static void *slab_malloc(struct uk_alloc *a, __sz size)
+{
+	unsigned int idx;
+	void *obj;
+
+	UK_ASSERT(a != NULL);
+
+	if (unlikely(!size))
+		return NULL;
+	if (size > SLAB_MAX_OBJ_SIZE)
+		return uk_malloc_ifpages(a, size);
+
+	idx = size_to_class(size);
+	obj = slab_obj_alloc(a, idx);
+	uk_alloc_stats_count_alloc(a, obj, class_to_size(idx));
+	if (unlikely(!obj))
+		errno = ENOMEM;
+	return obj;
+}
+
+static void slab_free(struct uk_alloc *a, void *ptr)
+{
+	struct slab *slab;
+
+	UK_ASSERT(a != NULL);
+	if (!ptr)
+		return;
+
+	slab = obj_to_slab(ukalloc2slab(a), ptr);
+	if (!slab) {
+		uk_free_ifpages(a, ptr);
+		return;
+	}
+
+	uk_alloc_stats_count_free(a, ptr, slab->cls->obj_size);
+	slab_obj_free(a, slab, ptr);
+}
+
+static int slab_posix_memalign(struct uk_alloc *a, void **memptr,
+			       __sz align, __sz size)
+{
+	struct uk_allocslab *s;
+	unsigned int idx;
+	void *obj;
+
+	UK_ASSERT(a != NULL);
+	s = ukalloc2slab(a);
+
+	if (((align - 1) & align) != 0
+	    || (align % sizeof(void *)) != 0)
+		return EINVAL;
+
+	/* Leave memptr untouched. See comment in uk_posix_memalign_ifpages. */
+	if (!size)
+		return EINVAL;
+
+	if (align > SLAB_MAX_ALIGN || size > SLAB_MAX_OBJ_SIZE)
+		return uk_posix_memalign_ifpages(a, memptr, align, size);
+
+	/* Objects start SLAB_MAX_ALIGN-aligned within a slab. Picking a class
+	 * whose size is a multiple of `align` keeps every object aligned.
+	 * The largest class is a power of two, so this search terminates.
+	 */
+	for (idx = size_to_class(size); idx < SLAB_NR_CLASSES; ++idx)
+		if ((s->cls[idx].obj_size & (align - 1)) == 0)
+			break;
+	UK_ASSERT(idx < SLAB_NR_CLASSES);
+
+	obj = slab_obj_alloc(a, idx);
+	uk_alloc_stats_count_alloc(a, obj, s->cls[idx].obj_size);
+	if (unlikely(!obj))
+		return ENOMEM;
+
+	*memptr = obj;
+	return 0;
+}
+
+static void *slab_realloc(struct uk_alloc *a, void *ptr, __sz size)
+{
+	struct slab *slab;
+	void *retptr;
+
+	UK_ASSERT(a != NULL);
+	if (!ptr)
+		return slab_malloc(a, size);
+
+	if (!size) {
+		slab_free(a, ptr);
+		return NULL;
+	}
+
+	slab = obj_to_slab(ukalloc2slab(a), ptr);
+	if (!slab)
+		return uk_realloc_ifpages(a, ptr, size);
+
+	/* shrinking or growing within the size class */
+	if (size <= slab->cls->obj_size)
+		return ptr;
+
+	retptr = slab_malloc(a, size);
+	if (!retptr)
+		return NULL;
+
+	memcpy(retptr, ptr, slab->cls->obj_size);
+	slab_free(a, ptr);
+	return retptr;
+}
+
+static void *slab_palloc(struct uk_alloc *a, unsigned long num_pages)
+{
+	void *ptr;
+
+	UK_ASSERT(a != NULL);
+
+	ptr = uk_palloc(ukalloc2slab(a)->backend, num_pages);
+	uk_alloc_stats_count_palloc(a, ptr, num_pages);
+	return ptr;
+}
+
+static void slab_pfree(struct uk_alloc *a, void *ptr, unsigned long num_pages)
+{
+	UK_ASSERT(a != NULL);
+
+	uk_alloc_stats_count_pfree(a, ptr, num_pages);
+	uk_pfree(ukalloc2slab(a)->backend, ptr, num_pages);
+}
+
+static long slab_pmaxalloc(struct uk_alloc *a)
+{
+	UK_ASSERT(a != NULL);
+
+	return uk_alloc_pmaxalloc(ukalloc2slab(a)->backend);
+}
+
+/* Returns the number of bytes that are needed for the slab bitmap of a
+ * memory region.
+ */
+static __sz slab_memr_size(__uptr min, __uptr max)
+{
+	unsigned long nr_slabs;
+
+	nr_slabs = ((max - ALIGN_DOWN(min, SLAB_SIZE)) >> SLAB_SHIFT) + 1;
+	return round_pgup(sizeof(struct slab_memr)
+			  + UK_BITS_TO_LONGS(nr_slabs) * sizeof(long));
+}
+
+static int slab_addmem(struct uk_alloc *a, void *base, __sz len)
+{
+	struct uk_allocslab *s;
+	struct slab_memr *memr;
+	__uptr min, max;
+	__sz memr_size;
+	int rc;
+
+	UK_ASSERT(a != NULL);
+	UK_ASSERT(base != NULL);
+	s = ukalloc2slab(a);
+
+	min = round_pgup((__uptr) base);
+	max = round_pgdown((__uptr) base + (__uptr) len);
+	if (max <= min) {
+		uk_pr_err("%"__PRIuptr": Failed to add memory region %"__PRIuptr"-%"__PRIuptr": Invalid range after applying page alignments\n",
+			  (__uptr) a, (__uptr) base, (__uptr) base + len);
+		return -EINVAL;
+	}
+
+	/* We should have space for the bitmap and the backend metadata */
+	memr_size = slab_memr_size(min, max);
+	if (max - min < memr_size + 4 * __PAGE_SIZE) {
+		uk_pr_err("%"__PRIuptr": Failed to add memory region %"__PRIuptr"-%"__PRIuptr": Not enough space after applying page alignments\n",
+			  (__uptr) a, (__uptr) base, (__uptr) base + len);
+		return -EINVAL;
+	}
+
+	memr = (struct slab_memr *) min;
+	memset(memr, 0, memr_size);
+	min += memr_size;
+	memr->start = min;
+	memr->end = max;
+	memr->first_slab = ALIGN_DOWN(min, SLAB_SIZE);
+
+	if (!s->backend) {
+		s->backend = uk_allocbbuddy_init((void *) min, max - min);
+		if (!s->backend)
+			return -ENOMEM;
+	} else {
+		rc = uk_alloc_addmem(s->backend, (void *) min, max - min);
+		if (rc < 0)
+			return rc;
+	}
+
+	/* Published last: the fast paths look up slabs without the lock */
+	memr->next = s->memr_head;
+	__atomic_store_n(&s->memr_head, memr, __ATOMIC_RELEASE);
+	return 0;
+}
+
+struct uk_alloc *uk_allocslab_init(void *base, size_t len)
+{
+	struct uk_alloc *a;
+	struct uk_allocslab *s;
+	struct slab_class *cls;
+	size_t metalen;
+	uintptr_t min, max;
+	unsigned int i;
+
+	min = round_pgup((uintptr_t)base);
+	max = round_pgdown((uintptr_t)base + (uintptr_t)len);
+	UK_ASSERT(max > min);
+
+	/* Allocate space for allocator descriptor */
+	metalen = round_pgup(sizeof(*a) + sizeof(*s));
+
+	/* enough space for allocator, bitmap and backend available?
+	 * NOTE: We check this before registering the allocator because
+	 *       allocators cannot be unregistered.
+	 */
+	if (min + metalen > max
+	    || max - min - metalen < slab_memr_size(min + metalen, max)
+				     + 4 * __PAGE_SIZE) {
+		uk_pr_err("Not enough space for allocator: %"__PRIsz" B required but only %"__PRIuptr" B usable\n",
+			  (__sz) (metalen + 4 * __PAGE_SIZE), (max - min));
+		return NULL;
+	}
+
+	a = (struct uk_alloc *)min;
+	uk_pr_info("Initialize slab allocator %"__PRIuptr"\n", (uintptr_t)a);
+	min += metalen;
+	memset(a, 0, metalen);
+	s = ukalloc2slab(a);
+
+	for (i = 0; i < SLAB_NR_CLASSES; ++i) {
+		cls = &s->cls[i];
+		cls->obj_size = class_to_size(i);
+		cls->nr_objs = (SLAB_SIZE - SLAB_HDR_SIZE) / cls->obj_size;
+		cls->nr_empty = 0;
+		UK_INIT_LIST_HEAD(&cls->partial);
+	}
+
+	/* NOTE: The memory of this allocator is also counted by its
+	 *       backend, so availmem and pavailmem are not provided.
+	 */
+	a->malloc         = slab_malloc;
+	a->calloc         = uk_calloc_compat;
+	a->realloc        = slab_realloc;
+	a->posix_memalign = slab_posix_memalign;
+	a->memalign       = uk_memalign_compat;
+	a->free           = slab_free;
+#if CONFIG_LIBUKALLOCSLAB_TCACHE && !CONFIG_LIBUKALLOC_IFSTATS
+	a->malloc_fast    = slab_malloc_fast;
+	a->free_fast      = slab_free_fast;
+#endif
+	a->palloc         = slab_palloc;
+	a->pfree          = slab_pfree;
+	a->pmaxalloc      = slab_pmaxalloc;
+	a->maxalloc       = uk_alloc_maxalloc_ifpages;
+	a->addmem         = slab_addmem;
+
+	/* Register before the backend is created so that we become the
+	 * default allocator
+	 */
+	uk_alloc_stats_reset(a);
+	uk_alloc_register(a);
+
+	/* add left memory - ignore return value */
+	slab_addmem(a, (void *) min, (size_t) (max - min));
+	return a;
+}
@@ -0,0 +1,149 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <errno.h>
+#include <uk/essentials.h>
+#include <uk/alloc.h>
+#include <uk/tlsf.h>
+#include <uk/print.h>
+#include <uk/xorshift.h>
+#include <uk/plat/time.h>
+
+#define BENCH_SLOTS		256
+#define BENCH_MAX_SHIFT		12 /* requests of up to 4 KiB */
+
+enum bench_op {
+	BENCH_MALLOC = 0,
+	BENCH_FREE,
+	BENCH_REALLOC,
+	BENCH_POSIX_MEMALIGN,
+	BENCH_NR_OPS
+};
+
+static const char *const bench_op_name[BENCH_NR_OPS] = {
+	[BENCH_MALLOC]         = "malloc",
+	[BENCH_FREE]           = "free",
+	[BENCH_REALLOC]        = "realloc",
+	[BENCH_POSIX_MEMALIGN] = "posix_memalign",
+};
+
+struct bench_op_stats {
+	__u64 count;
+	__nsec total;
+	__nsec max;
+};
+
+/* Request sizes are spread evenly over the powers of two up to 4 KiB */
+static inline __sz bench_size(__u32 *state)
+{
+	__u32 r = uk_xorshift32(state);
+
+	return (r >> 8) % (1UL << (r % (BENCH_MAX_SHIFT + 1))) + 1;
+}
+
+static inline void bench_account(struct bench_op_stats *stats,
+				 enum bench_op op, __nsec start)
+{
+	__nsec elapsed = ukplat_monotonic_clock() - start;
+
+	stats[op].count++;
+	stats[op].total += elapsed;
+	if (elapsed > stats[op].max)
+		stats[op].max = elapsed;
+}
+
+int uk_tlsf_bench(struct uk_alloc *a, unsigned int count)
+{
+	struct bench_op_stats stats[BENCH_NR_OPS] = { 0 };
+	void *slot[BENCH_SLOTS] = { NULL };
+	__u32 seed = 0x2545f491;
+	unsigned int i, idx;
+	__nsec start;
+	__sz size;
+	void *ptr;
+	int rc = 0;
+
+	UK_ASSERT(a);
+	UK_ASSERT(count > 0);
+
+	for (i = 0; i < count; i++) {
+		idx = uk_xorshift32(&seed) % BENCH_SLOTS;
+		size = bench_size(&seed);
+
+		if (!slot[idx]) {
+			if (i % 8 == 0) {
+				start = ukplat_monotonic_clock();
+				if (uk_posix_memalign(a, &ptr,
+						      64UL << (i % 7), size))
+					ptr = NULL;
+				bench_account(stats, BENCH_POSIX_MEMALIGN,
+					      start);
+			} else {
+				start = ukplat_monotonic_clock();
+				ptr = uk_malloc(a, size);
+				bench_account(stats, BENCH_MALLOC, start);
+			}
+			if (!ptr) {
+				uk_pr_err("Allocation %u failed\n", i);
+				rc = -ENOMEM;
+				break;
+			}
+			slot[idx] = ptr;
+		} else if (i % 4 == 0) {
+			start = ukplat_monotonic_clock();
+			ptr = uk_realloc(a, slot[idx], size);
+			bench_account(stats, BENCH_REALLOC, start);
+			if (!ptr) {
+				uk_pr_err("Reallocation %u failed\n", i);
+				rc = -ENOMEM;
+				break;
+			}
+			slot[idx] = ptr;
+		} else {
+			start = ukplat_monotonic_clock();
+			uk_free(a, slot[idx]);
+			bench_account(stats, BENCH_FREE, start);
+			slot[idx] = NULL;
+		}
+	}
+
+	for (idx = 0; idx < BENCH_SLOTS; idx++)
+		uk_free(a, slot[idx]);
+
+	for (i = 0; i < BENCH_NR_OPS; i++) {
+		uk_pr_info("%-14s: %"__PRIu64" ops, avg %"__PRInsec
+			   " ns, max %"__PRInsec" ns\n",
+			   bench_op_name[i], stats[i].count,
+			   stats[i].count ? stats[i].total / stats[i].count : 0,
+			   stats[i].max);
+	}
+	return rc;
+}
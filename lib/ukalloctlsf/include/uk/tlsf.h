@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __LIBUKALLOCTLSF_H__
+#define __LIBUKALLOCTLSF_H__
+
+#include <uk/alloc.h>
+#if CONFIG_LIBUKALLOCTLSF_LATENCY
+#include <uk/arch/time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* allocator initialization */
+struct uk_alloc *uk_tlsf_init(void *base, size_t len);
+
+#if CONFIG_LIBUKALLOCTLSF_LATENCY
+/* Worst-case durations (in nanoseconds) of allocator operations */
+struct uk_tlsf_latency {
+	__nsec malloc;
+	__nsec free;
+	__nsec realloc;
+	__nsec posix_memalign;
+};
+
+/**
+ * Copies the worst-case operation latencies of a TLSF allocator.
+ *
+ * @param a
+ *  TLSF allocator (returned by uk_tlsf_init())
+ * @param dst
+ *  Destination for the latencies
+ */
+void uk_tlsf_latency_get(struct uk_alloc *a, struct uk_tlsf_latency *dst);
+
+/**
+ * Resets the recorded worst-case operation latencies of a TLSF allocator.
+ *
+ * @param a
+ *  TLSF allocator (returned by uk_tlsf_init())
+ */
+void uk_tlsf_latency_reset(struct uk_alloc *a);
+#endif /* CONFIG_LIBUKALLOCTLSF_LATENCY */
+
+#if CONFIG_LIBUKALLOCTLSF_BENCH
+/**
+ * Runs a mix of `count` malloc(), free(), realloc() and posix_memalign()
+ * requests with sizes of up to 4 KiB on an allocator. Prints the number
+ * of requests and the average and worst-case duration of each operation
+ * type on the kernel console. Any allocator can be measured, so that the
+ * numbers can be compared, e.g., with the binary buddy allocator.
+ *
+ * @param a
+ *  Allocator to measure
+ * @param count
+ *  Number of requests
+ * @return
+ *  - (0): on success
+ *  - (-ENOMEM): an allocation failed; the run was stopped
+ */
+int uk_tlsf_bench(struct uk_alloc *a, unsigned int count);
+#endif /* CONFIG_LIBUKALLOCTLSF_BENCH */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBUKALLOCTLSF_H__ */
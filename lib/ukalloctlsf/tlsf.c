@@ -0,0 +1,843 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2006-2016, Matthew Conte. All rights reserved.
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* ukalloctlsf is a two-level segregated fit (TLSF) allocator.
+ *
+ * Free blocks are kept in segregated lists: The first level splits the
+ * size range in powers of two, the second level splits each power of two
+ * linearly into SL_INDEX_COUNT lists. A bitmap per level records which
+ * lists are non-empty, so that a suitable free block is found with two
+ * find-first-set operations. Requests are rounded up to the next list
+ * boundary (good fit), so that any block of the found list satisfies the
+ * request without walking the list. Free blocks are coalesced with their
+ * physical neighbours immediately, which needs a constant number of
+ * steps as well. malloc() and free() are thus O(1).
+ *
+ * Each block carries a one word header with its size and two flags
+ * (block free, previous block free). The word in front of the header
+ * holds a pointer to the previous physical block; it is only valid when
+ * that block is free and overlaps with its payload otherwise. Every
+ * memory region is terminated by a zero sized sentinel block.
+ *
+ * Derived from the TLSF 3.1 implementation by Matthew Conte
+ * (http://tlsf.baisoku.org), distributed under the license above.
+ */
+
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+#include <uk/tlsf.h>
+#include <uk/alloc_impl.h>
+#include <uk/arch/limits.h>
+#include <uk/arch/atomic.h>
+#include <uk/print.h>
+#include <uk/assert.h>
+#include <uk/page.h>
+#if CONFIG_LIBUKALLOCTLSF_LATENCY
+#include <uk/plat/time.h>
+#endif
+
+#if __SIZEOF_POINTER__ == 8
+#define ALIGN_SIZE_LOG2		3
+#define FL_INDEX_MAX		40 /* maximum block size: 1 TiB */
+#else
+#define ALIGN_SIZE_LOG2		2
+#define FL_INDEX_MAX		30 /* maximum block size: 1 GiB */
+#endif
+#define ALIGN_SIZE		(1UL << ALIGN_SIZE_LOG2)
+
+#define SL_INDEX_COUNT_LOG2	5
+#define SL_INDEX_COUNT		(1U << SL_INDEX_COUNT_LOG2)
+
+/* Blocks smaller than SMALL_BLOCK_SIZE are all in the first level list 0 */
+#define FL_INDEX_SHIFT		(SL_INDEX_COUNT_LOG2 + ALIGN_SIZE_LOG2)
+#define FL_INDEX_COUNT		(FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE	(1UL << FL_INDEX_SHIFT)
+
+UK_CTASSERT(FL_INDEX_COUNT <= sizeof(unsigned long) * 8);
+UK_CTASSERT(SL_INDEX_COUNT <= sizeof(unsigned int) * 8);
+
+struct tlsf_block {
+	/* Only valid if the previous physical block is free */
+	struct tlsf_block *prev_phys;
+	/* Size of the payload, flags are stored in the lower bits */
+	__sz size;
+	/* Only valid if this block is free */
+	struct tlsf_block *next_free;
+	struct tlsf_block *prev_free;
+};
+
+#define BLOCK_FREE_BIT		0x1UL
+#define BLOCK_PREV_FREE_BIT	0x2UL
+#define BLOCK_FLAGS		(BLOCK_FREE_BIT | BLOCK_PREV_FREE_BIT)
+
+/* Only the size field is overhead of a used block */
+#define BLOCK_OVERHEAD		(sizeof(__sz))
+/* Offset of the payload from the block start */
+#define BLOCK_START_OFFSET	(__offsetof(struct tlsf_block, size) \
+				 + sizeof(__sz))
+#define BLOCK_SIZE_MIN		(sizeof(struct tlsf_block) \
+				 - sizeof(struct tlsf_block *))
+#define BLOCK_SIZE_MAX		(1UL << FL_INDEX_MAX)
+
+struct uk_tlsf {
+	/* Empty lists point to this block */
+	struct tlsf_block null_block;
+
+	unsigned long fl_bitmap;
+	unsigned int sl_bitmap[FL_INDEX_COUNT];
+	struct tlsf_block *blocks[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+	__sz free_mem; /* sum of payloads of free blocks */
+#if CONFIG_LIBUKALLOCTLSF_LATENCY
+	struct uk_tlsf_latency latency;
+#endif
+};
+
+#define ukalloc2tlsf(a) \
+	((struct uk_tlsf *) &(a)->priv)
+
+/*********************
+ * BLOCK HELPERS
+ */
+static inline __sz block_size(const struct tlsf_block *b)
+{
+	return b->size & ~BLOCK_FLAGS;
+}
+
+static inline void block_set_size(struct tlsf_block *b, __sz size)
+{
+	b->size = size | (b->size & BLOCK_FLAGS);
+}
+
+static inline int block_is_last(const struct tlsf_block *b)
+{
+	return block_size(b) == 0;
+}
+
+static inline int block_is_free(const struct tlsf_block *b)
+{
+	return !!(b->size & BLOCK_FREE_BIT);
+}
+
+static inline void block_set_free(struct tlsf_block *b)
+{
+	b->size |= BLOCK_FREE_BIT;
+}
+
+static inline void block_set_used(struct tlsf_block *b)
+{
+	b->size &= ~BLOCK_FREE_BIT;
+}
+
+static inline int block_is_prev_free(const struct tlsf_block *b)
+{
+	return !!(b->size & BLOCK_PREV_FREE_BIT);
+}
+
+static inline void block_set_prev_free(struct tlsf_block *b)
+{
+	b->size |= BLOCK_PREV_FREE_BIT;
+}
+
+static inline void block_set_prev_used(struct tlsf_block *b)
+{
+	b->size &= ~BLOCK_PREV_FREE_BIT;
+}
+
+static inline struct tlsf_block *block_from_ptr(const void *ptr)
+{
+	return (struct tlsf_block *) ((__uptr) ptr - BLOCK_START_OFFSET);
+}
+
+static inline void *block_to_ptr(const struct tlsf_block *b)
+{
+	return (void *) ((__uptr) b + BLOCK_START_OFFSET);
+}
+
+static inline struct tlsf_block *offset_to_block(const void *ptr, __ssz off)
+{
+	return (struct tlsf_block *) ((__uptr) ptr + off);
+}
+
+static inline struct tlsf_block *block_prev(const struct tlsf_block *b)
+{
+	UK_ASSERT(block_is_prev_free(b));
+	return b->prev_phys;
+}
+
+static inline struct tlsf_block *block_next(const struct tlsf_block *b)
+{
+	UK_ASSERT(!block_is_last(b));
+	return offset_to_block(block_to_ptr(b),
+			       (__ssz) (block_size(b) - BLOCK_OVERHEAD));
+}
+
+/* Link a block to its physical successor and return the successor */
+static inline struct tlsf_block *block_link_next(struct tlsf_block *b)
+{
+	struct tlsf_block *next = block_next(b);
+
+	next->prev_phys = b;
+	return next;
+}
+
+static inline void block_mark_as_free(struct tlsf_block *b)
+{
+	struct tlsf_block *next = block_link_next(b);
+
+	block_set_prev_free(next);
+	block_set_free(b);
+}
+
+static inline void block_mark_as_used(struct tlsf_block *b)
+{
+	struct tlsf_block *next = block_next(b);
+
+	block_set_prev_used(next);
+	block_set_used(b);
+}
+
+/* Round up request size to alignment and minimum block size;
+ * returns 0 for invalid sizes
+ */
+static inline __sz adjust_request_size(__sz size, __sz align)
+{
+	__sz aligned;
+
+	if (!size)
+		return 0;
+
+	aligned = ALIGN_UP(size, align);
+	if (unlikely(aligned < size || aligned >= BLOCK_SIZE_MAX))
+		return 0;
+	return MAX(aligned, BLOCK_SIZE_MIN);
+}
+
+/*********************
+ * SEGREGATED LISTS
+ */
+static inline void mapping_insert(__sz size, unsigned int *fli,
+				  unsigned int *sli)
+{
+	unsigned int fl, sl;
+
+	if (size < SMALL_BLOCK_SIZE) {
+		fl = 0;
+		sl = (unsigned int) size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+	} else {
+		fl = (unsigned int) ukarch_flsl(size);
+		sl = (unsigned int) (size >> (fl - SL_INDEX_COUNT_LOG2))
+		     ^ SL_INDEX_COUNT;
+		fl -= (FL_INDEX_SHIFT - 1);
+	}
+	*fli = fl;
+	*sli = sl;
+}
+
+/* Like mapping_insert() but rounds up to the next list so that every block
+ * of the found list satisfies the request
+ */
+static inline void mapping_search(__sz size, unsigned int *fli,
+				  unsigned int *sli)
+{
+	if (size >= SMALL_BLOCK_SIZE)
+		size += (1UL << (ukarch_flsl(size) - SL_INDEX_COUNT_LOG2)) - 1;
+	mapping_insert(size, fli, sli);
+}
+
+static inline struct tlsf_block *search_suitable_block(struct uk_tlsf *t,
+						       unsigned int *fli,
+						       unsigned int *sli)
+{
+	unsigned int fl = *fli;
+	unsigned int sl = *sli;
+	unsigned long fl_map;
+	unsigned int sl_map;
+
+	/* First, search in the second level of the current first level */
+	sl_map = t->sl_bitmap[fl] & (~0U << sl);
+	if (!sl_map) {
+		/* No block available, search next larger first level */
+		fl_map = t->fl_bitmap & (~0UL << (fl + 1));
+		if (!fl_map)
+			return NULL; /* out of memory */
+
+		fl = (unsigned int) ukarch_ffsl(fl_map);
+		sl_map = t->sl_bitmap[fl];
+		UK_ASSERT(sl_map);
+	}
+	sl = (unsigned int) ukarch_ffsl(sl_map);
+
+	*fli = fl;
+	*sli = sl;
+	return t->blocks[fl][sl];
+}
+
+static inline void remove_free_block(struct uk_tlsf *t, struct tlsf_block *b,
+				     unsigned int fl, unsigned int sl)
+{
+	struct tlsf_block *prev = b->prev_free;
+	struct tlsf_block *next = b->next_free;
+
+	UK_ASSERT(prev);
+	UK_ASSERT(next);
+
+	next->prev_free = prev;
+	prev->next_free = next;
+
+	/* If this block is the head of the list, set new head */
+	if (t->blocks[fl][sl] == b) {
+		t->blocks[fl][sl] = next;
+
+		if (next == &t->null_block) {
+			t->sl_bitmap[fl] &= ~(1U << sl);
+			if (!t->sl_bitmap[fl])
+				t->fl_bitmap &= ~(1UL << fl);
+		}
+	}
+	t->free_mem -= block_size(b);
+}
+
+static inline void insert_free_block(struct uk_tlsf *t, struct tlsf_block *b,
+				     unsigned int fl, unsigned int sl)
+{
+	struct tlsf_block *current = t->blocks[fl][sl];
+
+	UK_ASSERT(current);
+	UK_ASSERT(((__uptr) block_to_ptr(b) & (ALIGN_SIZE - 1)) == 0);
+
+	b->next_free = current;
+	b->prev_free = &t->null_block;
+	current->prev_free = b;
+
+	t->blocks[fl][sl] = b;
+	t->fl_bitmap |= (1UL << fl);
+	t->sl_bitmap[fl] |= (1U << sl);
+	t->free_mem += block_size(b);
+}
+
+static inline void block_remove(struct uk_tlsf *t, struct tlsf_block *b)
+{
+	unsigned int fl, sl;
+
+	mapping_insert(block_size(b), &fl, &sl);
+	remove_free_block(t, b, fl, sl);
+}
+
+static inline void block_insert(struct uk_tlsf *t, struct tlsf_block *b)
+{
+	unsigned int fl, sl;
+
+	mapping_insert(block_size(b), &fl, &sl);
+	insert_free_block(t, b, fl, sl);
+}
+
+/*********************
+ * SPLITTING AND COALESCING
+ */
+static inline int block_can_split(struct tlsf_block *b, __sz size)
+{
+	return block_size(b) >= sizeof(struct tlsf_block) + size;
+}
+
+/* Split a block into two, the second of which is free */
+static inline struct tlsf_block *block_split(struct tlsf_block *b, __sz size)
+{
+	struct tlsf_block *remaining;
+	__sz remain_size;
+
+	remaining = offset_to_block(block_to_ptr(b),
+				    (__ssz) (size - BLOCK_OVERHEAD));
+	remain_size = block_size(b) - (size + BLOCK_OVERHEAD);
+
+	UK_ASSERT(remain_size >= BLOCK_SIZE_MIN);
+	block_set_size(remaining, remain_size);
+
+	block_set_size(b, size);
+	block_mark_as_free(remaining);
+	return remaining;
+}
+
+/* Absorb a free block's storage into an adjacent previous free block */
+static inline struct tlsf_block *block_absorb(struct tlsf_block *prev,
+					      struct tlsf_block *b)
+{
+	UK_ASSERT(!block_is_last(prev));
+
+	/* Note: Leaves flags untouched */
+	prev->size += block_size(b) + BLOCK_OVERHEAD;
+	block_link_next(prev);
+	return prev;
+}
+
+static inline struct tlsf_block *block_merge_prev(struct uk_tlsf *t,
+						  struct tlsf_block *b)
+{
+	struct tlsf_block *prev;
+
+	if (block_is_prev_free(b)) {
+		prev = block_prev(b);
+		UK_ASSERT(block_is_free(prev));
+		block_remove(t, prev);
+		b = block_absorb(prev, b);
+	}
+	return b;
+}
+
+static inline struct tlsf_block *block_merge_next(struct uk_tlsf *t,
+						  struct tlsf_block *b)
+{
+	struct tlsf_block *next = block_next(b);
+
+	if (block_is_free(next)) {
+		UK_ASSERT(!block_is_last(b));
+		block_remove(t, next);
+		b = block_absorb(b, next);
+	}
+	return b;
+}
+
+/* Trim any trailing block space off the end of a free block */
+static inline void block_trim_free(struct uk_tlsf *t, struct tlsf_block *b,
+				   __sz size)
+{
+	struct tlsf_block *remaining;
+
+	UK_ASSERT(block_is_free(b));
+	if (block_can_split(b, size)) {
+		remaining = block_split(b, size);
+		block_link_next(b);
+		block_set_prev_free(remaining);
+		block_insert(t, remaining);
+	}
+}
+
+/* Trim any trailing block space off the end of a used block */
+static inline void block_trim_used(struct uk_tlsf *t, struct tlsf_block *b,
+				   __sz size)
+{
+	struct tlsf_block *remaining;
+
+	UK_ASSERT(!block_is_free(b));
+	if (block_can_split(b, size)) {
+		remaining = block_split(b, size);
+		block_set_prev_used(remaining);
+
+		remaining = block_merge_next(t, remaining);
+		block_insert(t, remaining);
+	}
+}
+
+/* Trim leading block space of a free block, returns the trailing part */
+static inline struct tlsf_block *block_trim_free_leading(struct uk_tlsf *t,
+							 struct tlsf_block *b,
+							 __sz size)
+{
+	struct tlsf_block *remaining = b;
+
+	if (block_can_split(b, size)) {
+		/* We want the second block */
+		remaining = block_split(b, size - BLOCK_OVERHEAD);
+		block_set_prev_free(remaining);
+
+		block_link_next(b);
+		block_insert(t, b);
+	}
+	return remaining;
+}
+
+static inline struct tlsf_block *block_locate_free(struct uk_tlsf *t,
+						   __sz size)
+{
+	struct tlsf_block *b;
+	unsigned int fl, sl;
+
+	if (!size)
+		return NULL;
+
+	mapping_search(size, &fl, &sl);
+
+	/* Rounding up may exceed the largest list */
+	if (unlikely(fl >= FL_INDEX_COUNT))
+		return NULL;
+
+	b = search_suitable_block(t, &fl, &sl);
+	if (b) {
+		UK_ASSERT(block_size(b) >= size);
+		remove_free_block(t, b, fl, sl);
+	}
+	return b;
+}
+
+static inline void *block_prepare_used(struct uk_tlsf *t,
+				       struct tlsf_block *b, __sz size)
+{
+	if (!b)
+		return NULL;
+
+	UK_ASSERT(size);
+	block_trim_free(t, b, size);
+	block_mark_as_used(b);
+	return block_to_ptr(b);
+}
+
+/*********************
+ * LATENCY RECORDING
+ */
+#if CONFIG_LIBUKALLOCTLSF_LATENCY
+#define LATENCY_START()							\
+	__nsec _latency_start = ukplat_monotonic_clock()
+#define LATENCY_END(t, op)						\
+	do {								\
+		__nsec _latency = ukplat_monotonic_clock()		\
+				  - _latency_start;			\
+		if (_latency > (t)->latency.op)				\
+			(t)->latency.op = _latency;			\
+	} while (0)
+#else /* !CONFIG_LIBUKALLOCTLSF_LATENCY */
+#define LATENCY_START() do {} while (0)
+#define LATENCY_END(t, op) do {} while (0)
+#endif /* !CONFIG_LIBUKALLOCTLSF_LATENCY */
+
+/*********************
+ * ALLOCATOR INTERFACE
+ */
+static void *tlsf_malloc(struct uk_alloc *a, __sz size)
+{
+	struct uk_tlsf *t = ukalloc2tlsf(a);
+	struct tlsf_block *b;
+	__sz adjust;
+	void *ptr;
+
+	if (unlikely(!size))
+		return NULL;
+
+	LATENCY_START();
+	adjust = adjust_request_size(size, ALIGN_SIZE);
+	b = block_locate_free(t, adjust);
+	ptr = block_prepare_used(t, b, adjust);
+	LATENCY_END(t, malloc);
+
+	if (unlikely(!ptr)) {
+		uk_alloc_stats_count_enomem(a, size);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	uk_alloc_stats_count_alloc(a, ptr, block_size(b));
+	return ptr;
+}
+
+static void tlsf_free(struct uk_alloc *a, void *ptr)
+{
+	struct uk_tlsf *t = ukalloc2tlsf(a);
+	struct tlsf_block *b;
+
+	if (unlikely(!ptr))
+		return;
+
+	b = block_from_ptr(ptr);
+	UK_ASSERT(!block_is_free(b));
+	uk_alloc_stats_count_free(a, ptr, block_size(b));
+
+	LATENCY_START();
+	block_mark_as_free(b);
+	b = block_merge_prev(t, b);
+	b = block_merge_next(t, b);
+	block_insert(t, b);
+	LATENCY_END(t, free);
+}
+
+static int tlsf_posix_memalign(struct uk_alloc *a, void **memptr,
+			       __sz align, __sz size)
+{
+	struct uk_tlsf *t = ukalloc2tlsf(a);
+	const __sz gap_minimum = sizeof(struct tlsf_block);
+	struct tlsf_block *b;
+	__sz adjust, size_with_gap, aligned_size, gap;
+	__uptr ptr, aligned;
+
+	UK_ASSERT(memptr);
+
+	/* align must be a power of two and a multiple of sizeof(void *) */
+	if (unlikely(!align || (align & (align - 1))
+		     || (align & (sizeof(void *) - 1))))
+		return EINVAL;
+
+	/* Leave memptr untouched. See comment in uk_posix_memalign_ifpages. */
+	if (unlikely(!size))
+		return EINVAL;
+
+	LATENCY_START();
+	adjust = adjust_request_size(size, ALIGN_SIZE);
+
+	/* We must allocate an additional minimum block size bytes so that if
+	 * our free block will leave an alignment gap which is smaller, we
+	 * can trim a leading free block and release it back to the pool.
+	 */
+	size_with_gap = adjust_request_size(adjust + align + gap_minimum,
+					    align);
+
+	/* If alignment is less than or equal to the base alignment, we are
+	 * aligned already
+	 */
+	aligned_size = (adjust && align > ALIGN_SIZE) ? size_with_gap : adjust;
+
+	b = block_locate_free(t, aligned_size);
+	if (b) {
+		ptr = (__uptr) block_to_ptr(b);
+		aligned = ALIGN_UP(ptr, align);
+		gap = aligned - ptr;
+
+		/* If gap size is too small, offset to next aligned boundary */
+		if (gap && gap < gap_minimum) {
+			aligned = ALIGN_UP(aligned + MAX(gap_minimum - gap,
+							 align),
+					   align);
+			gap = aligned - ptr;
+		}
+
+		if (gap) {
+			UK_ASSERT(gap >= gap_minimum);
+			b = block_trim_free_leading(t, b, gap);
+		}
+	}
+	*memptr = block_prepare_used(t, b, adjust);
+	LATENCY_END(t, posix_memalign);
+
+	if (unlikely(!*memptr)) {
+		uk_alloc_stats_count_enomem(a, size);
+		return ENOMEM;
+	}
+
+	UK_ASSERT(((__uptr) *memptr & (align - 1)) == 0);
+	uk_alloc_stats_count_alloc(a, *memptr, block_size(b));
+	return 0;
+}
+
+static void *tlsf_realloc(struct uk_alloc *a, void *ptr, __sz size)
+{
+	struct uk_tlsf *t = ukalloc2tlsf(a);
+	struct tlsf_block *b, *next;
+	__sz cursize, combined, adjust;
+	void *p;
+
+	if (!ptr)
+		return tlsf_malloc(a, size);
+
+	if (!size) {
+		tlsf_free(a, ptr);
+		return NULL;
+	}
+
+	b = block_from_ptr(ptr);
+	UK_ASSERT(!block_is_free(b));
+
+	cursize = block_size(b);
+	next = block_next(b);
+	combined = cursize + block_size(next) + BLOCK_OVERHEAD;
+	adjust = adjust_request_size(size, ALIGN_SIZE);
+	if (unlikely(!adjust)) {
+		uk_alloc_stats_count_enomem(a, size);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	/* If the next block is used, or when combined with the current block,
+	 * does not offer enough space, we must reallocate and copy.
+	 */
+	if (adjust > cursize && (!block_is_free(next) || adjust > combined)) {
+		p = tlsf_malloc(a, size);
+		if (p) {
+			memcpy(p, ptr, MIN(cursize, size));
+			tlsf_free(a, ptr);
+		}
+		return p;
+	}
+
+	uk_alloc_stats_count_free(a, ptr, cursize);
+
+	LATENCY_START();
+	/* Do we need to expand to the next block? */
+	if (adjust > cursize) {
+		block_merge_next(t, b);
+		block_mark_as_used(b);
+	}
+
+	/* Trim the resulting block and return the original pointer */
+	block_trim_used(t, b, adjust);
+	LATENCY_END(t, realloc);
+
+	uk_alloc_stats_count_alloc(a, ptr, block_size(b));
+	return ptr;
+}
+
+static __ssz tlsf_maxalloc(struct uk_alloc *a)
+{
+	struct uk_tlsf *t = ukalloc2tlsf(a);
+	unsigned int fl, sl;
+
+	if (!t->fl_bitmap)
+		return 0;
+
+	fl = (unsigned int) ukarch_flsl(t->fl_bitmap);
+	sl = (unsigned int) ukarch_flsl(t->sl_bitmap[fl]);
+
+	/* Return the lower bound of the largest non-empty list: this is the
+	 * largest request that is guaranteed to be satisfied by it
+	 */
+	if (fl == 0)
+		return (__ssz) (sl * (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+	return (__ssz) ((1UL << (fl + FL_INDEX_SHIFT - 1))
+			+ ((__sz) sl << (fl + FL_INDEX_SHIFT - 1
+					  - SL_INDEX_COUNT_LOG2)));
+}
+
+static __ssz tlsf_availmem(struct uk_alloc *a)
+{
+	struct uk_tlsf *t = ukalloc2tlsf(a);
+
+	return (__ssz) t->free_mem;
+}
+
+static int tlsf_addmem(struct uk_alloc *a, void *base, __sz len)
+{
+	struct uk_tlsf *t = ukalloc2tlsf(a);
+	struct tlsf_block *b, *next;
+	__uptr min, max;
+	__sz pool_bytes;
+
+	UK_ASSERT(base);
+
+	/* A region needs space for a header and the sentinel block */
+	min = ALIGN_UP((__uptr) base, ALIGN_SIZE);
+	max = ALIGN_DOWN((__uptr) base + len, ALIGN_SIZE);
+	if (max < min + 2 * BLOCK_OVERHEAD + BLOCK_SIZE_MIN) {
+		uk_pr_err("%p: Failed to add memory region %p-%p: Not enough space after applying alignments\n",
+			  a, base, (void *) ((__uptr) base + len));
+		return -EINVAL;
+	}
+
+	/* Regions that are bigger than the maximum block size are split */
+	while (max - min >= 2 * BLOCK_OVERHEAD + BLOCK_SIZE_MIN) {
+		pool_bytes = MIN(max - min - 2 * BLOCK_OVERHEAD,
+				 ALIGN_DOWN(BLOCK_SIZE_MAX - 1, ALIGN_SIZE));
+
+		/* The region is described by one big free block. The first
+		 * block is placed so that its `prev_phys` field is outside of
+		 * the region; it is never accessed because there is no
+		 * previous block.
+		 */
+		b = offset_to_block((void *) min, -(__ssz) BLOCK_OVERHEAD);
+		b->size = 0;
+		block_set_size(b, pool_bytes);
+		block_set_free(b);
+		block_set_prev_used(b);
+		block_insert(t, b);
+
+		/* Split the block to create a zero-size sentinel block */
+		next = block_link_next(b);
+		next->size = 0;
+		block_set_used(next);
+		block_set_prev_free(next);
+
+		uk_pr_debug("%p: Add memory region %p-%p\n", a,
+			    (void *) min,
+			    (void *) (min + pool_bytes + 2 * BLOCK_OVERHEAD));
+		min += pool_bytes + 2 * BLOCK_OVERHEAD;
+	}
+	return 0;
+}
+
+#if CONFIG_LIBUKALLOCTLSF_LATENCY
+void uk_tlsf_latency_get(struct uk_alloc *a, struct uk_tlsf_latency *dst)
+{
+	UK_ASSERT(a);
+	UK_ASSERT(dst);
+
+	memcpy(dst, &ukalloc2tlsf(a)->latency, sizeof(*dst));
+}
+
+void uk_tlsf_latency_reset(struct uk_alloc *a)
+{
+	UK_ASSERT(a);
+
+	memset(&ukalloc2tlsf(a)->latency, 0, sizeof(struct uk_tlsf_latency));
+}
+#endif /* CONFIG_LIBUKALLOCTLSF_LATENCY */
+
+struct uk_alloc *uk_tlsf_init(void *base, size_t len)
+{
+	struct uk_alloc *a;
+	struct uk_tlsf *t;
+	size_t metalen;
+	uintptr_t min, max;
+	unsigned int i, j;
+
+	min = ALIGN_UP((uintptr_t) base, sizeof(void *));
+	max = (uintptr_t) base + len;
+	metalen = ALIGN_UP(sizeof(*a) + sizeof(*t), ALIGN_SIZE);
+
+	/* enough space for allocator available? */
+	if (max < min || min + metalen > max) {
+		uk_pr_err("Not enough space for allocator: %"__PRIsz" B required but only %"__PRIuptr" B usable\n",
+			  metalen, (max > min) ? (max - min) : 0);
+		return NULL;
+	}
+
+	a = (struct uk_alloc *) min;
+	uk_pr_info("Initialize TLSF allocator %p\n", a);
+	min += metalen;
+	memset(a, 0, metalen);
+	t = ukalloc2tlsf(a);
+
+	t->null_block.next_free = &t->null_block;
+	t->null_block.prev_free = &t->null_block;
+	for (i = 0; i < FL_INDEX_COUNT; ++i)
+		for (j = 0; j < SL_INDEX_COUNT; ++j)
+			t->blocks[i][j] = &t->null_block;
+
+	/* initialize and register allocator interface */
+	uk_alloc_init_malloc(a, tlsf_malloc, uk_calloc_compat, tlsf_realloc,
+			     tlsf_free, tlsf_posix_memalign,
+			     uk_memalign_compat, tlsf_maxalloc,
+			     tlsf_availmem, tlsf_addmem);
+
+	if (max > min) {
+		/* add left memory - ignore return value */
+		tlsf_addmem(a, (void *) min, (size_t) (max - min));
+	}
+
+	return a;
+}
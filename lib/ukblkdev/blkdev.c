@@ -70,6 +70,35 @@ static struct uk_blkdev_data *_alloc_data(struct uk_alloc *a,
 	return data;
 }
 
+/* Generic batch submission for drivers that only implement submit_one */
+static int _submit_each(struct uk_blkdev *dev,
+		struct uk_blkdev_queue *queue,
+		struct uk_blkreq **reqs, uint16_t *cnt)
+{
+	int rc = 0;
+	uint16_t i;
+
+	for (i = 0; i < *cnt; i++) {
+		rc = dev->submit_one(dev, queue, reqs[i]);
+		if (unlikely(rc < 0)) {
+			if (i == 0) {
+				*cnt = 0;
+				return rc;
+			}
+			/* Report the error with the next call */
+			rc = 0x0;
+			break;
+		}
+		if (!(rc & UK_BLKDEV_STATUS_MORE)) {
+			i++;
+			break;
+		}
+	}
+
+	*cnt = i;
+	return UK_BLKDEV_STATUS_SUCCESS | (rc & UK_BLKDEV_STATUS_MORE);
+}
+
 int uk_blkdev_drv_register(struct uk_blkdev *dev, struct uk_alloc *a,
 		const char *drv_name)
 {
@@ -91,6 +120,9 @@ int uk_blkdev_drv_register(struct uk_blkdev *dev, struct uk_alloc *a,
 			|| (!dev->dev_ops->queue_intr_enable
 				&& !dev->dev_ops->queue_intr_disable));
 
+	if (!dev->submit)
+		dev->submit = _submit_each;
+
 	dev->_data = _alloc_data(a, blkdev_count,  drv_name);
 	if (!dev->_data)
 		return -ENOMEM;
@@ -396,6 +428,22 @@ int uk_blkdev_queue_submit_one(struct uk_blkdev *dev,
 	return dev->submit_one(dev, dev->_queue[queue_id], req);
 }
 
+int uk_blkdev_queue_submit(struct uk_blkdev *dev,
+		uint16_t queue_id,
+		struct uk_blkreq **reqs, uint16_t *cnt)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(dev->submit);
+	UK_ASSERT(queue_id < CONFIG_LIBUKBLKDEV_MAXNBQUEUES);
+	UK_ASSERT(dev->_data->state == UK_BLKDEV_RUNNING);
+	UK_ASSERT(!PTRISERR(dev->_queue[queue_id]));
+	UK_ASSERT(reqs);
+	UK_ASSERT(cnt && *cnt > 0);
+
+	return dev->submit(dev, dev->_queue[queue_id], reqs, cnt);
+}
+
 int uk_blkdev_queue_finish_reqs(struct uk_blkdev *dev,
 		uint16_t queue_id)
 {
@@ -338,6 +338,37 @@ static inline int uk_blkdev_queue_intr_disable(struct uk_blkdev *dev,
 int uk_blkdev_queue_submit_one(struct uk_blkdev *dev, uint16_t queue_id,
 		struct uk_blkreq *req);
 
+/**
+ * Make several aio requests to the device. This is the batched version of
+ * uk_blkdev_queue_submit_one(): the requests are put on the queue in order
+ * and the device is notified once per call.
+ *
+ * @param dev
+ *	The Unikraft Block Device
+ * @param queue_id
+ *	The index of the queue to submit to.
+ *	The value must be in the range [0, nb_queue - 1] previously supplied
+ *	to uk_blkdev_configure().
+ * @param reqs
+ *	Array of `*cnt` request structures
+ * @param cnt
+ *	Number of requests to submit (must be greater than 0). It is updated
+ *	with the number of requests that were put to the queue; these are the
+ *	first ones of `reqs`.
+ * @return
+ *	- (>=0): Positive value with status flags
+ *		- UK_BLKDEV_STATUS_SUCCESS: At least one request was put to the
+ *		queue.
+ *		- UK_BLKDEV_STATUS_MORE: Indicates there is still at least
+ *		one descriptor available for a subsequent transmission.
+ *		This may only be set together with UK_BLKDEV_STATUS_SUCCESS.
+ *	- (<0): Negative value with error code from driver, no request was sent,
+ *	e.g., because the queue is full. An error that occurs after the first
+ *	request was put to the queue is reported by the next call.
+ */
+int uk_blkdev_queue_submit(struct uk_blkdev *dev, uint16_t queue_id,
+		struct uk_blkreq **reqs, uint16_t *cnt);
+
 /**
  * Tests for status flags returned by `uk_blkdev_submit_one`
  * When the function returned an error code or one of the selected flags is
@@ -194,6 +194,13 @@ typedef int (*uk_blkdev_queue_intr_disable_t)(struct uk_blkdev *dev,
 /** Driver callback type to submit a request to Unikraft block device. */
 typedef int (*uk_blkdev_queue_submit_one_t)(struct uk_blkdev *dev,
 		struct uk_blkdev_queue *queue, struct uk_blkreq *req);
+/**
+ * Driver callback type to submit up to `*cnt` requests to Unikraft block
+ * device. `*cnt` is updated with the number of submitted requests.
+ */
+typedef int (*uk_blkdev_queue_submit_t)(struct uk_blkdev *dev,
+		struct uk_blkdev_queue *queue, struct uk_blkreq **reqs,
+		uint16_t *cnt);
 /**
  * Driver callback type to finish
  * a bunch of requests to Unikraft block device.
@@ -287,6 +294,8 @@ struct uk_blkdev_data {
 struct uk_blkdev {
 	/* Pointer to submit request function */
 	uk_blkdev_queue_submit_one_t submit_one;
+	/* Pointer to submit requests function, optional */
+	uk_blkdev_queue_submit_t submit;
 	/* Pointer to handle_responses function */
 	uk_blkdev_queue_finish_reqs_t finish_reqs;
 	/* Pointer to API-internal state data. */
@@ -41,6 +41,8 @@
 
 #if CONFIG_LIBUKBOOT_INITBBUDDY
 #include <uk/allocbbuddy.h>
+#elif CONFIG_LIBUKBOOT_INITSLAB
+#include <uk/allocslab.h>
 #elif CONFIG_LIBUKBOOT_INITREGION
 #include <uk/allocregion.h>
 #elif CONFIG_LIBUKBOOT_INITMIMALLOC
@@ -238,6 +240,8 @@ void ukplat_entry(int argc, char *argv[])
 		if (!a) {
 #if CONFIG_LIBUKBOOT_INITBBUDDY
 			a = uk_allocbbuddy_init(md.base, md.len);
+#elif CONFIG_LIBUKBOOT_INITSLAB
+			a = uk_allocslab_init(md.base, md.len);
 #elif CONFIG_LIBUKBOOT_INITREGION
 			a = uk_allocregion_init(md.base, md.len);
 #elif CONFIG_LIBUKBOOT_INITMIMALLOC
@@ -0,0 +1,206 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <errno.h>
+#include <uk/essentials.h>
+#include <uk/alloc.h>
+#include <uk/sched.h>
+#include <uk/thread.h>
+#include <uk/fiber.h>
+#include <uk/print.h>
+#include <uk/plat/time.h>
+#include <uk/mutex.h>
+#include <uk/semaphore.h>
+
+struct bench_lock {
+	struct uk_mutex mutex;
+	struct uk_semaphore sem;
+	int use_sem;
+	unsigned int count; /* acquisitions per thread */
+	__nsec wait_max;
+};
+
+static inline void bench_lock(struct bench_lock *b)
+{
+	if (b->use_sem)
+		uk_semaphore_down(&b->sem);
+	else
+		uk_mutex_lock(&b->mutex);
+}
+
+static inline void bench_unlock(struct bench_lock *b)
+{
+	if (b->use_sem)
+		uk_semaphore_up(&b->sem);
+	else
+		uk_mutex_unlock(&b->mutex);
+}
+
+/* Switches to the other threads, or to the other fibers within a fiber */
+static inline void bench_yield(void)
+{
+#if CONFIG_LIBUKSCHED_FIBER
+	if (uk_fiber_current()) {
+		uk_fiber_yield();
+		return;
+	}
+#endif
+	uk_sched_yield();
+}
+
+static void bench_locker(void *arg)
+{
+	struct bench_lock *b = arg;
+	__nsec start, wait;
+	unsigned int i;
+
+	for (i = 0; i < b->count; i++) {
+		start = ukplat_monotonic_clock();
+		bench_lock(b);
+		wait = ukplat_monotonic_clock() - start;
+		b->wait_max = MAX(b->wait_max, wait);
+
+		/* Let the other threads queue up on the lock */
+		bench_yield();
+		bench_unlock(b);
+	}
+}
+
+/* Runs `nb_threads` threads that take the lock `count` times each and
+ * returns the average time per acquisition
+ */
+static __nsec bench_run(struct bench_lock *b, struct uk_thread **threads,
+			unsigned int nb_threads)
+{
+	unsigned int i, nb_created;
+	__nsec start, elapsed;
+
+	b->wait_max = 0;
+	start = ukplat_monotonic_clock();
+	for (nb_created = 0; nb_created < nb_threads; nb_created++) {
+		threads[nb_created] = uk_thread_create("locker", bench_locker,
+						       b);
+		if (!threads[nb_created])
+			break;
+	}
+	for (i = 0; i < nb_created; i++)
+		uk_thread_wait(threads[i]);
+	elapsed = ukplat_monotonic_clock() - start;
+
+	if (nb_created < nb_threads) {
+		uk_pr_err("Failed to create locking thread %u\n", nb_created);
+		return 0;
+	}
+	return elapsed / ((__nsec) nb_threads * b->count);
+}
+
+#if CONFIG_LIBUKSCHED_FIBER
+/* Like bench_run(), with fibers of a scheduler that the calling thread
+ * runs. The contending fibers must block themselves, not their host.
+ */
+static __nsec bench_run_fibers(struct bench_lock *b, unsigned int nb_fibers)
+{
+	struct uk_fiber_sched fs;
+	struct uk_fiber *fiber;
+	unsigned int nb_created;
+	__nsec start, elapsed;
+
+	b->wait_max = 0;
+	uk_fiber_sched_init(&fs, uk_alloc_get_default());
+	for (nb_created = 0; nb_created < nb_fibers; nb_created++) {
+		fiber = uk_fiber_create(&fs, bench_locker, b);
+		if (!fiber)
+			break;
+		uk_fiber_detach(fiber);
+	}
+	start = ukplat_monotonic_clock();
+	uk_fiber_sched_run(&fs);
+	elapsed = ukplat_monotonic_clock() - start;
+	uk_fiber_sched_fini(&fs);
+
+	if (nb_created < nb_fibers) {
+		uk_pr_err("Failed to create locking fiber %u\n", nb_created);
+		return 0;
+	}
+	return elapsed / ((__nsec) nb_fibers * b->count);
+}
+#endif /* CONFIG_LIBUKSCHED_FIBER */
+
+int uk_mutex_bench(unsigned int nb_waiters, unsigned int count)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	struct uk_thread **threads;
+	struct bench_lock b;
+	__nsec barging, handoff;
+	__nsec barging_max;
+
+	UK_ASSERT(count > 0);
+
+	threads = uk_calloc(a, nb_waiters + 1, sizeof(*threads));
+	if (!threads)
+		return -ENOMEM;
+
+	uk_mutex_init(&b.mutex);
+	uk_semaphore_init(&b.sem, 1);
+	b.count = count;
+
+	/* The mutex lets a running thread take it again ahead of the woken
+	 * waiter, until that waiter waited for UK_MUTEX_HANDOFF_NSEC
+	 */
+	b.use_sem = 0;
+	barging = bench_run(&b, threads, nb_waiters + 1);
+	barging_max = b.wait_max;
+
+	/* A binary semaphore hands every unit to the longest waiter */
+	b.use_sem = 1;
+	handoff = bench_run(&b, threads, nb_waiters + 1);
+
+	uk_free(a, threads);
+	if (!barging || !handoff)
+		return -ENOMEM;
+
+	uk_pr_info("Lock with %u waiters: mutex (barging) %"__PRInsec
+		   " ns, max wait %"__PRInsec" ns; semaphore (handoff) %"
+		   __PRInsec" ns, max wait %"__PRInsec" ns\n",
+		   nb_waiters, barging, barging_max, handoff, b.wait_max);
+
+#if CONFIG_LIBUKSCHED_FIBER
+	/* Two fibers of one thread contend for the lock */
+	b.use_sem = 0;
+	barging = bench_run_fibers(&b, 2);
+	b.use_sem = 1;
+	handoff = bench_run_fibers(&b, 2);
+	if (!barging || !handoff)
+		return -ENOMEM;
+
+	uk_pr_info("Lock with 2 fibers of one thread: mutex %"__PRInsec
+		   " ns, semaphore %"__PRInsec" ns\n", barging, handoff);
+#endif
+	return 0;
+}
@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UK_CONDVAR_H__
+#define __UK_CONDVAR_H__
+
+#include <uk/config.h>
+
+#if CONFIG_LIBUKLOCK_CONDVAR
+#include <uk/assert.h>
+#include <uk/mutex.h>
+#include <uk/plat/lcpu.h>
+#include <uk/plat/spinlock.h>
+#include <uk/thread.h>
+#include <uk/wait.h>
+#include <uk/wait_types.h>
+#include <uk/plat/time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Condition variable that relies on a scheduler
+ * uses wait queues for threads
+ *
+ * Waiters release the given mutex and re-acquire it before returning.
+ * Wake-ups can be spurious, so callers re-check their predicate.
+ */
+struct uk_condvar {
+	struct uk_waitq wait;
+};
+
+#define	UK_CONDVAR_INITIALIZER(name)				\
+	{ __WAIT_QUEUE_INITIALIZER((name).wait) }
+
+void uk_condvar_init(struct uk_condvar *cv);
+
+/*
+ * The waiter is queued and blocked before it releases `m`, so a signal
+ * sent by the next owner of `m` always finds it. Returns 1 if the waiter
+ * was signaled, 0 otherwise.
+ */
+static inline int __uk_condvar_wait(struct uk_condvar *cv,
+				    struct uk_mutex *m, __nsec deadline)
+{
+	struct uk_waitq_entry wait;
+	unsigned long irqf;
+	int signaled;
+
+	UK_ASSERT(cv);
+	UK_ASSERT(m);
+	UK_ASSERT(m->owner == uk_mutex_self() && m->lock_count == 1);
+
+	uk_waitq_entry_init_self(&wait);
+	wait.flags = UK_WAITQ_EXCLUSIVE;
+	ukplat_spin_lock_irqsave(&cv->wait.sl, irqf);
+	uk_waitq_add(&cv->wait, &wait);
+	uk_waitq_entry_block(&wait, deadline);
+	ukplat_spin_unlock_irqrestore(&cv->wait.sl, irqf);
+
+	uk_mutex_unlock(m);
+	uk_waitq_entry_yield(&wait);
+
+	ukplat_spin_lock_irqsave(&cv->wait.sl, irqf);
+	signaled = !wait.waiting;
+	uk_waitq_remove(&cv->wait, &wait);
+	ukplat_spin_unlock_irqrestore(&cv->wait.sl, irqf);
+
+	uk_mutex_lock(m);
+	return signaled;
+}
+
+static inline void uk_condvar_wait(struct uk_condvar *cv, struct uk_mutex *m)
+{
+	__uk_condvar_wait(cv, m, 0);
+}
+
+/* Returns __NSEC_MAX on timeout, expired time otherwise */
+static inline __nsec uk_condvar_wait_to(struct uk_condvar *cv,
+					struct uk_mutex *m, __nsec timeout)
+{
+	__nsec then = ukplat_monotonic_clock();
+	__nsec deadline = then + timeout;
+	__nsec now;
+
+	if (__uk_condvar_wait(cv, m, deadline))
+		return ukplat_monotonic_clock() - then;
+
+	now = ukplat_monotonic_clock();
+	return now >= deadline ? __NSEC_MAX : now - then;
+}
+
+/* Wakes up the thread that waits the longest */
+static inline void uk_condvar_signal(struct uk_condvar *cv)
+{
+	UK_ASSERT(cv);
+
+	uk_waitq_wake_up_one(&cv->wait);
+}
+
+static inline void uk_condvar_broadcast(struct uk_condvar *cv)
+{
+	UK_ASSERT(cv);
+
+	uk_waitq_wake_up(&cv->wait);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_LIBUKLOCK_CONDVAR */
+
+#endif /* __UK_CONDVAR_H__ */
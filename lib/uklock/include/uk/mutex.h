@@ -37,7 +37,9 @@
 
 #if CONFIG_LIBUKLOCK_MUTEX
 #include <uk/assert.h>
+#include <uk/fiber.h>
 #include <uk/plat/lcpu.h>
+#include <uk/plat/spinlock.h>
 #include <uk/thread.h>
 #include <uk/wait.h>
 #include <uk/wait_types.h>
@@ -50,57 +52,110 @@ extern "C" {
 /*
  * Mutex that relies on a scheduler
  * uses wait queues for threads
+ *
+ * The wait queue lock protects the whole mutex. Unlocking a contended
+ * mutex wakes up only the thread that waits the longest. That thread may
+ * lose the mutex to a running thread, in which case it goes back to the
+ * head of the queue. Once it has waited for UK_MUTEX_HANDOFF_NSEC, the
+ * next unlock hands the mutex directly to it. Handing over every time
+ * would make each lock operation wait for a wake-up, possibly on another
+ * CPU, while the unlocking thread is still running.
+ *
+ * Within a fiber, the fiber owns the mutex rather than its host thread,
+ * so that another fiber of the same thread does not take it recursively.
+ * A contending fiber blocks only itself, not its host thread.
  */
 struct uk_mutex {
 	int lock_count;
-	struct uk_thread *owner;
+	void *owner; /* thread or fiber, the waiter's entry during a handoff */
 	struct uk_waitq wait;
+	int handoff; /* next unlock hands over to the first waiter */
 };
 
+#define UK_MUTEX_HANDOFF_NSEC ukarch_time_msec_to_nsec(1)
+
 #define	UK_MUTEX_INITIALIZER(name)				\
-	{ 0, NULL, __WAIT_QUEUE_INITIALIZER((name).wait) }
+	{ 0, NULL, __WAIT_QUEUE_INITIALIZER((name).wait), 0 }
 
 void uk_mutex_init(struct uk_mutex *m);
 
+/* Returns the running fiber, or the current thread outside of fibers */
+static inline void *uk_mutex_self(void)
+{
+#if CONFIG_LIBUKSCHED_FIBER
+	struct uk_fiber *fiber = uk_fiber_current();
+
+	if (fiber)
+		return fiber;
+#endif
+	return uk_thread_current();
+}
+
 static inline void uk_mutex_lock(struct uk_mutex *m)
 {
-	struct uk_thread *current;
+	struct uk_waitq_entry wait;
 	unsigned long irqf;
+	__nsec since;
+	void *self;
 
 	UK_ASSERT(m);
 
-	current = uk_thread_current();
+	self = uk_mutex_self();
+
+	ukplat_spin_lock_irqsave(&m->wait.sl, irqf);
+	if (m->owner == self || (m->lock_count == 0 && !m->handoff))
+		goto out;
 
+	since = ukplat_monotonic_clock();
+	uk_waitq_entry_init_self(&wait);
+	wait.flags = UK_WAITQ_EXCLUSIVE;
+	uk_waitq_add(&m->wait, &wait);
 	for (;;) {
-		uk_waitq_wait_event(&m->wait,
-			m->lock_count == 0 || m->owner == current);
-		irqf = ukplat_lcpu_save_irqf();
-		if (m->lock_count == 0 || m->owner == current)
-			break;
-		ukplat_lcpu_restore_irqf(irqf);
+		uk_waitq_entry_block(&wait, 0);
+		ukplat_spin_unlock_irqrestore(&m->wait.sl, irqf);
+		uk_waitq_entry_yield(&wait);
+		ukplat_spin_lock_irqsave(&m->wait.sl, irqf);
+
+		if (m->owner == &wait) {
+			/* Handed over by uk_mutex_unlock() */
+			UK_ASSERT(!wait.waiting);
+			m->owner = self;
+			ukplat_spin_unlock_irqrestore(&m->wait.sl, irqf);
+			return;
+		}
+		if (wait.waiting)
+			continue; /* not woken by uk_mutex_unlock() */
+		if (m->lock_count == 0 && !m->handoff)
+			goto out;
+
+		uk_waitq_add_head(&m->wait, &wait);
+		if (ukplat_monotonic_clock() - since >= UK_MUTEX_HANDOFF_NSEC)
+			m->handoff = 1;
 	}
+
+out:
 	m->lock_count++;
-	m->owner = current;
-	ukplat_lcpu_restore_irqf(irqf);
+	m->owner = self;
+	ukplat_spin_unlock_irqrestore(&m->wait.sl, irqf);
 }
 
 static inline int uk_mutex_trylock(struct uk_mutex *m)
 {
-	struct uk_thread *current;
 	unsigned long irqf;
 	int ret = 0;
+	void *self;
 
 	UK_ASSERT(m);
 
-	current = uk_thread_current();
+	self = uk_mutex_self();
 
-	irqf = ukplat_lcpu_save_irqf();
-	if (m->lock_count == 0 || m->owner == current) {
+	ukplat_spin_lock_irqsave(&m->wait.sl, irqf);
+	if (m->owner == self || (m->lock_count == 0 && !m->handoff)) {
 		ret = 1;
 		m->lock_count++;
-		m->owner = current;
+		m->owner = self;
 	}
-	ukplat_lcpu_restore_irqf(irqf);
+	ukplat_spin_unlock_irqrestore(&m->wait.sl, irqf);
 	return ret;
 }
 
@@ -115,15 +170,43 @@ static inline void uk_mutex_unlock(struct uk_mutex *m)
 
 	UK_ASSERT(m);
 
-	irqf = ukplat_lcpu_save_irqf();
+	ukplat_spin_lock_irqsave(&m->wait.sl, irqf);
 	UK_ASSERT(m->lock_count > 0);
 	if (--m->lock_count == 0) {
 		m->owner = NULL;
-		uk_waitq_wake_up(&m->wait);
+		if (m->handoff) {
+			/* Only set while a waiter is queued */
+			m->owner = UK_STAILQ_FIRST(&m->wait.list);
+			UK_ASSERT(m->owner);
+			m->lock_count = 1;
+			m->handoff = 0;
+		}
+		__uk_waitq_wake_up_nr(&m->wait, 1);
 	}
-	ukplat_lcpu_restore_irqf(irqf);
+	ukplat_spin_unlock_irqrestore(&m->wait.sl, irqf);
 }
 
+#if CONFIG_LIBUKLOCK_BENCH
+/**
+ * Runs `nb_waiters` + 1 threads that take a lock `count` times each and
+ * yield while they hold it, so that the other threads queue up. This is
+ * done with a mutex, which lets a running thread take it ahead of a woken
+ * waiter (barging), and with a binary semaphore, which hands every unit to
+ * the longest waiter (handoff). Prints the average time per acquisition
+ * and the longest wait of both on the kernel console. With fibers, both
+ * locks are also contended by two fibers of the calling thread.
+ *
+ * @param nb_waiters
+ *   Number of threads that wait for the lock while it is held
+ * @param count
+ *   Number of acquisitions per thread
+ * @return
+ *   - (0): on success
+ *   - (-ENOMEM): a thread or fiber could not be created
+ */
+int uk_mutex_bench(unsigned int nb_waiters, unsigned int count);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
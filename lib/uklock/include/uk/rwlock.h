@@ -0,0 +1,215 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UK_RWLOCK_H__
+#define __UK_RWLOCK_H__
+
+#include <uk/config.h>
+
+#if CONFIG_LIBUKLOCK_RWLOCK
+#include <uk/assert.h>
+#include <uk/plat/lcpu.h>
+#include <uk/plat/spinlock.h>
+#include <uk/thread.h>
+#include <uk/wait.h>
+#include <uk/wait_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Reader-writer lock that relies on a scheduler
+ * uses wait queues for threads
+ *
+ * Any number of readers or a single writer may hold the lock. Writers are
+ * preferred: as soon as a writer waits, new readers queue up behind it.
+ * Releasing the lock wakes up one waiting writer or, if there is none,
+ * all waiting readers.
+ */
+struct uk_rwlock {
+	int nr_readers;
+	int nr_writers_waiting;
+	struct uk_thread *writer;
+	struct uk_waitq shared;
+	struct uk_waitq exclusive;
+	spinlock_t sl;
+};
+
+#define	UK_RWLOCK_INITIALIZER(name)				\
+	{ 0, 0, NULL, __WAIT_QUEUE_INITIALIZER((name).shared),	\
+	  __WAIT_QUEUE_INITIALIZER((name).exclusive),		\
+	  UKARCH_SPINLOCK_INITIALIZER() }
+
+void uk_rwlock_init(struct uk_rwlock *rwl);
+
+#define __uk_rwlock_can_read(rwl) \
+	(!(rwl)->writer && !(rwl)->nr_writers_waiting)
+#define __uk_rwlock_can_write(rwl) \
+	(!(rwl)->writer && !(rwl)->nr_readers)
+
+static inline void uk_rwlock_rlock(struct uk_rwlock *rwl)
+{
+	unsigned long irqf;
+
+	UK_ASSERT(rwl);
+
+	for (;;) {
+		uk_waitq_wait_event(&rwl->shared, __uk_rwlock_can_read(rwl));
+		ukplat_spin_lock_irqsave(&rwl->sl, irqf);
+		if (__uk_rwlock_can_read(rwl))
+			break;
+		ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+	}
+	rwl->nr_readers++;
+	ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+}
+
+static inline void uk_rwlock_wlock(struct uk_rwlock *rwl)
+{
+	struct uk_thread *current;
+	unsigned long irqf;
+
+	UK_ASSERT(rwl);
+
+	current = uk_thread_current();
+
+	ukplat_spin_lock_irqsave(&rwl->sl, irqf);
+	UK_ASSERT(rwl->writer != current);
+	if (__uk_rwlock_can_write(rwl)) {
+		rwl->writer = current;
+		ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+		return;
+	}
+	/* Holds off new readers until we got the lock */
+	rwl->nr_writers_waiting++;
+	ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+
+	for (;;) {
+		uk_waitq_wait_event_exclusive(&rwl->exclusive,
+					      __uk_rwlock_can_write(rwl));
+		ukplat_spin_lock_irqsave(&rwl->sl, irqf);
+		if (__uk_rwlock_can_write(rwl))
+			break;
+		ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+	}
+	rwl->nr_writers_waiting--;
+	rwl->writer = current;
+	ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+}
+
+static inline int uk_rwlock_tryrlock(struct uk_rwlock *rwl)
+{
+	unsigned long irqf;
+	int ret = 0;
+
+	UK_ASSERT(rwl);
+
+	ukplat_spin_lock_irqsave(&rwl->sl, irqf);
+	if (__uk_rwlock_can_read(rwl)) {
+		ret = 1;
+		rwl->nr_readers++;
+	}
+	ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+	return ret;
+}
+
+static inline int uk_rwlock_trywlock(struct uk_rwlock *rwl)
+{
+	unsigned long irqf;
+	int ret = 0;
+
+	UK_ASSERT(rwl);
+
+	ukplat_spin_lock_irqsave(&rwl->sl, irqf);
+	if (__uk_rwlock_can_write(rwl)) {
+		ret = 1;
+		rwl->writer = uk_thread_current();
+	}
+	ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+	return ret;
+}
+
+static inline void uk_rwlock_runlock(struct uk_rwlock *rwl)
+{
+	unsigned long irqf;
+
+	UK_ASSERT(rwl);
+
+	ukplat_spin_lock_irqsave(&rwl->sl, irqf);
+	UK_ASSERT(rwl->nr_readers > 0);
+	if (--rwl->nr_readers == 0 && rwl->nr_writers_waiting)
+		uk_waitq_wake_up_one(&rwl->exclusive);
+	ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+}
+
+static inline void uk_rwlock_wunlock(struct uk_rwlock *rwl)
+{
+	unsigned long irqf;
+
+	UK_ASSERT(rwl);
+
+	ukplat_spin_lock_irqsave(&rwl->sl, irqf);
+	UK_ASSERT(rwl->writer == uk_thread_current());
+	rwl->writer = NULL;
+	if (rwl->nr_writers_waiting)
+		uk_waitq_wake_up_one(&rwl->exclusive);
+	else
+		uk_waitq_wake_up(&rwl->shared);
+	ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+}
+
+/*
+ * Turns the write lock held by the current thread into a read lock
+ * without letting another writer in between. Waiting readers join only if
+ * no writer waits.
+ */
+static inline void uk_rwlock_downgrade(struct uk_rwlock *rwl)
+{
+	unsigned long irqf;
+
+	UK_ASSERT(rwl);
+
+	ukplat_spin_lock_irqsave(&rwl->sl, irqf);
+	UK_ASSERT(rwl->writer == uk_thread_current());
+	rwl->writer = NULL;
+	rwl->nr_readers = 1;
+	if (!rwl->nr_writers_waiting)
+		uk_waitq_wake_up(&rwl->shared);
+	ukplat_spin_unlock_irqrestore(&rwl->sl, irqf);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_LIBUKLOCK_RWLOCK */
+
+#endif /* __UK_RWLOCK_H__ */
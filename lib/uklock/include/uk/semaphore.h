@@ -31,6 +31,7 @@
 #include <uk/print.h>
 #include <uk/assert.h>
 #include <uk/plat/lcpu.h>
+#include <uk/plat/spinlock.h>
 #include <uk/thread.h>
 #include <uk/wait.h>
 #include <uk/wait_types.h>
@@ -43,6 +44,11 @@ extern "C" {
 /*
  * Semaphore that relies on a scheduler
  * uses wait queues for threads
+ *
+ * The wait queue lock protects the whole semaphore. uk_semaphore_up()
+ * hands the unit directly to the thread that waits the longest instead
+ * of increasing the count, so `count` is only positive while no thread
+ * waits and waiters are served in FIFO order.
  */
 struct uk_semaphore {
 	long count;
@@ -51,24 +57,52 @@ struct uk_semaphore {
 
 void uk_semaphore_init(struct uk_semaphore *s, long count);
 
+/*
+ * Waits until uk_semaphore_up() hands a unit over or, with a non-zero
+ * `deadline`, until the deadline passed. Called and returns with
+ * `s->wait.sl` held. Returns 1 if the unit was handed over.
+ */
+static inline int __uk_semaphore_wait(struct uk_semaphore *s,
+				      __nsec deadline, unsigned long *irqf)
+{
+	struct uk_waitq_entry wait;
+
+	uk_waitq_entry_init_self(&wait);
+	wait.flags = UK_WAITQ_EXCLUSIVE;
+	uk_waitq_add(&s->wait, &wait);
+	do {
+		uk_waitq_entry_block(&wait, deadline);
+		ukplat_spin_unlock_irqrestore(&s->wait.sl, *irqf);
+		uk_waitq_entry_yield(&wait);
+		ukplat_spin_lock_irqsave(&s->wait.sl, *irqf);
+		if (wait.waiting && deadline &&
+		    ukplat_monotonic_clock() >= deadline) {
+			uk_waitq_remove(&s->wait, &wait);
+			return 0;
+		}
+	} while (wait.waiting);
+	return 1;
+}
+
 static inline void uk_semaphore_down(struct uk_semaphore *s)
 {
 	unsigned long irqf;
 
 	UK_ASSERT(s);
 
-	for (;;) {
-		uk_waitq_wait_event(&s->wait, s->count > 0);
-		irqf = ukplat_lcpu_save_irqf();
-		if (s->count > 0)
-			break;
-		ukplat_lcpu_restore_irqf(irqf);
-	}
-	--s->count;
+	ukplat_spin_lock_irqsave(&s->wait.sl, irqf);
+	if (s->count > 0) {
+		--s->count;
 #ifdef UK_SEMAPHORE_DEBUG
-	uk_pr_debug("Decreased semaphore %p to %ld\n", s, s->count);
+		uk_pr_debug("Decreased semaphore %p to %ld\n", s, s->count);
 #endif
-	ukplat_lcpu_restore_irqf(irqf);
+	} else {
+		__uk_semaphore_wait(s, 0, &irqf);
+#ifdef UK_SEMAPHORE_DEBUG
+		uk_pr_debug("Got semaphore %p handed over\n", s);
+#endif
+	}
+	ukplat_spin_unlock_irqrestore(&s->wait.sl, irqf);
 }
 
 static inline int uk_semaphore_down_try(struct uk_semaphore *s)
@@ -78,7 +112,7 @@ static inline int uk_semaphore_down_try(struct uk_semaphore *s)
 
 	UK_ASSERT(s);
 
-	irqf = ukplat_lcpu_save_irqf();
+	ukplat_spin_lock_irqsave(&s->wait.sl, irqf);
 	if (s->count > 0) {
 		ret = 1;
 		--s->count;
@@ -87,7 +121,7 @@ static inline int uk_semaphore_down_try(struct uk_semaphore *s)
 			    s, s->count);
 #endif
 	}
-	ukplat_lcpu_restore_irqf(irqf);
+	ukplat_spin_unlock_irqrestore(&s->wait.sl, irqf);
 	return ret;
 }
 
@@ -103,25 +137,25 @@ static inline __nsec uk_semaphore_down_to(struct uk_semaphore *s,
 
 	deadline = then + timeout;
 
-	for (;;) {
-		uk_waitq_wait_event_deadline(&s->wait, s->count > 0, deadline);
-		irqf = ukplat_lcpu_save_irqf();
-		if (s->count > 0 || (deadline &&
-				     ukplat_monotonic_clock() >= deadline))
-			break;
-		ukplat_lcpu_restore_irqf(irqf);
-	}
+	ukplat_spin_lock_irqsave(&s->wait.sl, irqf);
 	if (s->count > 0) {
 		s->count--;
 #ifdef UK_SEMAPHORE_DEBUG
 		uk_pr_debug("Decreased semaphore %p to %ld\n",
 			    s, s->count);
 #endif
-		ukplat_lcpu_restore_irqf(irqf);
+		ukplat_spin_unlock_irqrestore(&s->wait.sl, irqf);
+		return ukplat_monotonic_clock() - then;
+	}
+	if (__uk_semaphore_wait(s, deadline, &irqf)) {
+#ifdef UK_SEMAPHORE_DEBUG
+		uk_pr_debug("Got semaphore %p handed over\n", s);
+#endif
+		ukplat_spin_unlock_irqrestore(&s->wait.sl, irqf);
 		return ukplat_monotonic_clock() - then;
 	}
 
-	ukplat_lcpu_restore_irqf(irqf);
+	ukplat_spin_unlock_irqrestore(&s->wait.sl, irqf);
 #ifdef UK_SEMAPHORE_DEBUG
 	uk_pr_debug("Timed out while waiting for semaphore %p\n", s);
 #endif
@@ -134,14 +168,15 @@ static inline void uk_semaphore_up(struct uk_semaphore *s)
 
 	UK_ASSERT(s);
 
-	irqf = ukplat_lcpu_save_irqf();
-	++s->count;
+	ukplat_spin_lock_irqsave(&s->wait.sl, irqf);
+	if (!__uk_waitq_wake_up_nr(&s->wait, 1)) {
+		++s->count;
 #ifdef UK_SEMAPHORE_DEBUG
-	uk_pr_debug("Increased semaphore %p to %ld\n",
-		    s, s->count);
+		uk_pr_debug("Increased semaphore %p to %ld\n",
+			    s, s->count);
 #endif
-	uk_waitq_wake_up(&s->wait);
-	ukplat_lcpu_restore_irqf(irqf);
+	}
+	ukplat_spin_unlock_irqrestore(&s->wait.sl, irqf);
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,197 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <uk/essentials.h>
+#include <uk/alloc.h>
+#include <uk/mbox.h>
+#include <uk/sched.h>
+#include <uk/thread.h>
+#include <uk/print.h>
+#include <uk/plat/time.h>
+
+/* Messages are sequence numbers starting at 1, so that NULL is never sent */
+#define BENCH_MSG(i)	((void *) (uintptr_t) ((i) + 1))
+
+#define BENCH_BATCH_MAX	64
+#define BENCH_MBOX_SIZE	(2 * BENCH_BATCH_MAX)
+
+struct bench_peer {
+	struct uk_mbox *in;
+	struct uk_mbox *out;
+	unsigned int count;
+	unsigned int batch;
+};
+
+/* Sends every message it receives straight back */
+static void bench_echo(void *arg)
+{
+	struct bench_peer *p = arg;
+	void *msg;
+	unsigned int i;
+
+	for (i = 0; i < p->count; i++) {
+		uk_mbox_recv(p->in, &msg);
+		uk_mbox_post(p->out, msg);
+	}
+}
+
+/* Posts `count` messages in batches of `batch` */
+static void bench_producer(void *arg)
+{
+	struct bench_peer *p = arg;
+	void *msgs[BENCH_BATCH_MAX];
+	unsigned int i, j, n;
+
+	for (i = 0; i < p->count; i += n) {
+		n = MIN(p->batch, p->count - i);
+		for (j = 0; j < n; j++)
+			msgs[j] = BENCH_MSG(i + j);
+		if (n == 1)
+			uk_mbox_post(p->out, msgs[0]);
+		else
+			uk_mbox_post_batch(p->out, msgs, n);
+	}
+}
+
+static __u64 bench_rate(unsigned int count, __nsec elapsed)
+{
+	return (__u64) count * ukarch_time_sec_to_nsec(1)
+	       / MAX(elapsed, (__nsec) 1);
+}
+
+static int bench_pingpong(struct uk_sched *s, struct uk_mbox *req,
+			  struct uk_mbox *resp, unsigned int count)
+{
+	struct bench_peer peer = { .in = req, .out = resp, .count = count };
+	struct uk_thread *thread;
+	__nsec start, elapsed;
+	unsigned int i;
+	void *msg;
+	int rc = 0;
+
+	thread = uk_sched_thread_create(s, "mbox-echo", NULL,
+					bench_echo, &peer);
+	if (!thread) {
+		uk_pr_err("Failed to create echo thread\n");
+		return -ENOMEM;
+	}
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < count; i++) {
+		uk_mbox_post(req, BENCH_MSG(i));
+		uk_mbox_recv(resp, &msg);
+		if (unlikely(msg != BENCH_MSG(i)))
+			rc = -EIO;
+	}
+	elapsed = ukplat_monotonic_clock() - start;
+	uk_thread_wait(thread);
+
+	uk_pr_info("Ping-pong: %u round trips, %"__PRInsec" ns each\n",
+		   count, elapsed / count);
+	return rc;
+}
+
+static int bench_stream(struct uk_sched *s, struct uk_mbox *m,
+			unsigned int count, unsigned int batch)
+{
+	struct bench_peer peer = { .out = m, .count = count, .batch = batch };
+	struct uk_mbox_stats stats;
+	struct uk_thread *thread;
+	__nsec start, elapsed;
+	void *msgs[BENCH_BATCH_MAX];
+	unsigned int i, j, n;
+	int rc = 0;
+
+	uk_mbox_reset_hwm(m);
+	thread = uk_sched_thread_create(s, "mbox-producer", NULL,
+					bench_producer, &peer);
+	if (!thread) {
+		uk_pr_err("Failed to create producer thread\n");
+		return -ENOMEM;
+	}
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < count; i += n) {
+		if (batch == 1) {
+			uk_mbox_recv(m, &msgs[0]);
+			n = 1;
+		} else {
+			n = uk_mbox_recv_batch(m, msgs, batch);
+		}
+		for (j = 0; j < n; j++)
+			if (unlikely(msgs[j] != BENCH_MSG(i + j)))
+				rc = -EIO;
+	}
+	elapsed = ukplat_monotonic_clock() - start;
+	uk_thread_wait(thread);
+
+	uk_mbox_get_stats(m, &stats);
+	uk_pr_info("Streaming in batches of %u: %u messages in %"__PRInsec
+		   " ns: %"__PRIu64" msgs/s, peak occupancy %"__PRIsz
+		   "/%"__PRIsz"\n", batch, count, elapsed,
+		   bench_rate(count, elapsed), stats.hwm, stats.size);
+	return rc;
+}
+
+int uk_mbox_bench(struct uk_alloc *a, unsigned int count, unsigned int batch)
+{
+	struct uk_sched *s = uk_thread_current()->sched;
+	struct uk_mbox *req, *resp;
+	int rc;
+
+	UK_ASSERT(a);
+	UK_ASSERT(s);
+	UK_ASSERT(count > 0);
+	UK_ASSERT(batch > 0 && batch <= BENCH_BATCH_MAX);
+
+	req = uk_mbox_create(a, BENCH_MBOX_SIZE);
+	resp = uk_mbox_create(a, BENCH_MBOX_SIZE);
+	if (!req || !resp) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	rc = bench_pingpong(s, req, resp, count);
+	if (!rc)
+		rc = bench_stream(s, req, count, 1);
+	if (!rc && batch > 1)
+		rc = bench_stream(s, req, count, batch);
+	if (rc == -EIO)
+		uk_pr_err("Messages arrived out of order\n");
+
+out:
+	if (resp)
+		uk_mbox_free(a, resp);
+	if (req)
+		uk_mbox_free(a, req);
+	return rc;
+}
@@ -38,7 +38,7 @@
 
 #if CONFIG_LIBUKMPI_MBOX
 #include <errno.h>
-#include <uk/semaphore.h>
+#include <uk/wait.h>
 #include <uk/alloc.h>
 
 #ifdef __cplusplus
@@ -47,6 +47,13 @@ extern "C" {
 
 struct uk_mbox;
 
+struct uk_mbox_stats {
+	size_t size;  /* number of messages that fit */
+	size_t count; /* number of queued messages */
+	size_t hwm;   /* highest count since creation or the last reset */
+};
+
+/* The mailbox holds at most `size` messages */
 struct uk_mbox *uk_mbox_create(struct uk_alloc *a, size_t size);
 void uk_mbox_free(struct uk_alloc *a, struct uk_mbox *m);
 
@@ -54,10 +61,74 @@ void uk_mbox_post(struct uk_mbox *m, void *msg);
 int uk_mbox_post_try(struct uk_mbox *m, void *msg);
 __nsec uk_mbox_post_to(struct uk_mbox *m, void *msg, __nsec timeout);
 
+/**
+ * Posts `count` messages in order, blocking while the mailbox is full.
+ *
+ * @return
+ *  `count`
+ */
+unsigned int uk_mbox_post_batch(struct uk_mbox *m, void **msgs,
+				unsigned int count);
+
+/**
+ * Posts as many of `count` messages as fit without blocking. Can be
+ * called from interrupt context.
+ *
+ * @return
+ *  Number of messages posted, the first ones of `msgs`
+ */
+unsigned int uk_mbox_post_batch_try(struct uk_mbox *m, void **msgs,
+				    unsigned int count);
+
 void uk_mbox_recv(struct uk_mbox *m, void **msg);
 int uk_mbox_recv_try(struct uk_mbox *m, void **msg);
 __nsec uk_mbox_recv_to(struct uk_mbox *m, void **msg, __nsec timeout);
 
+/**
+ * Blocks until the mailbox has messages and fetches up to `count` of them.
+ * `msgs` may be NULL to drop the messages.
+ *
+ * @return
+ *  Number of messages received, at least 1
+ */
+unsigned int uk_mbox_recv_batch(struct uk_mbox *m, void **msgs,
+				unsigned int count);
+
+/**
+ * Fetches up to `count` messages without blocking.
+ *
+ * @return
+ *  Number of messages received, 0 if the mailbox is empty
+ */
+unsigned int uk_mbox_recv_batch_try(struct uk_mbox *m, void **msgs,
+				    unsigned int count);
+
+/* Occupancy of the mailbox, e.g., to size it */
+void uk_mbox_get_stats(struct uk_mbox *m, struct uk_mbox_stats *stats);
+void uk_mbox_reset_hwm(struct uk_mbox *m);
+
+#if CONFIG_LIBUKMPI_MBOX_BENCH
+/**
+ * Bounces `count` messages between the calling thread and a new thread
+ * through two mailboxes, then streams `count` messages from a new thread
+ * to the calling one, first one by one and then in batches of `batch`.
+ * Prints the round trip time and the streaming throughput on the kernel
+ * console.
+ *
+ * @param a
+ *   Allocator for the mailboxes
+ * @param count
+ *   Number of messages of each run
+ * @param batch
+ *   Batch size of the last run, at most 64
+ * @return
+ *   - (0): on success
+ *   - (-ENOMEM): a mailbox or thread could not be created
+ *   - (-EIO): messages were lost or reordered
+ */
+int uk_mbox_bench(struct uk_alloc *a, unsigned int count, unsigned int batch);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -1,34 +1,56 @@
 #include <uk/mbox.h>
 #include <uk/assert.h>
+#include <uk/arch/atomic.h>
 #include <uk/arch/limits.h>
+#include <uk/plat/lcpu.h>
+#include <uk/plat/time.h>
+#include <uk/ring.h>
 
+/*
+ * Messages are kept in a lock-free uk_ring. Readers and writers only go
+ * through the wait queues when they have to block: a reader sleeps on an
+ * empty mailbox and a writer on a full one. Posting wakes up readers only
+ * when someone waits on the mailbox, and then at most one reader per
+ * posted message; receiving wakes up writers in the same way.
+ *
+ * The ring is rounded up to a power of two. Writers reserve a slot in
+ * `used` before they enqueue, so that the mailbox never holds more than
+ * the requested number of messages.
+ */
 struct uk_mbox {
-	size_t len;
-	struct uk_semaphore readsem;
-	long readpos;
-	struct uk_semaphore writesem;
-	long writepos;
-
-	void *msgs[];
+	struct uk_ring *ring;
+	size_t size;
+	size_t used; /* reserved slots, queued messages included */
+	size_t hwm; /* highest number of queued messages */
+	struct uk_waitq readq;  /* readers waiting for messages */
+	struct uk_waitq writeq; /* writers waiting for room */
 };
 
 struct uk_mbox *uk_mbox_create(struct uk_alloc *a, size_t size)
 {
 	struct uk_mbox *m;
+	int count = 1;
 
-	UK_ASSERT(size <= __L_MAX);
+	UK_ASSERT(size < (size_t) __I_MAX / 2);
 
-	m = uk_malloc(a, sizeof(*m) + (sizeof(void *) * (size + 1)));
+	m = uk_malloc(a, sizeof(*m));
 	if (!m)
 		return NULL;
 
-	m->len = size + 1;
-
-	uk_semaphore_init(&m->readsem, 0);
-	m->readpos = 0;
+	/* The ring keeps one slot free */
+	while ((size_t) count < size + 1)
+		count <<= 1;
+	m->ring = uk_ring_alloc(count, a);
+	if (!m->ring) {
+		uk_free(a, m);
+		return NULL;
+	}
 
-	uk_semaphore_init(&m->writesem, (long) size);
-	m->writepos = 0;
+	m->size = size;
+	m->used = 0;
+	m->hwm = 0;
+	uk_waitq_init(&m->readq);
+	uk_waitq_init(&m->writeq);
 
 	uk_pr_debug("Created mailbox %p\n", m);
 	return m;
@@ -44,87 +66,200 @@ void uk_mbox_free(struct uk_alloc *a, struct uk_mbox *m)
 
 	UK_ASSERT(a);
 	UK_ASSERT(m);
-	UK_ASSERT(m->readpos == m->writepos);
+	UK_ASSERT(uk_ring_empty(m->ring));
 
+	uk_ring_free(m->ring, a);
 	uk_free(a, m);
 }
 
-/* Posts the "msg" to the mailbox, internal version that actually does the
- * post.
+/*
+ * A waiter queues itself before it checks the ring and a waker changes
+ * the ring before it checks the queue. The full barriers on both sides
+ * make sure that at least one of them sees the other.
  */
-static inline void _do_mbox_post(struct uk_mbox *m, void *msg)
+static inline int mbox_has_msgs(struct uk_mbox *m)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return !uk_ring_empty(m->ring);
+}
+
+static inline int mbox_has_room(struct uk_mbox *m)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return ukarch_load_n(&m->used) < m->size;
+}
+
+/*
+ * Waiters are exclusive, so `nr` messages or slots wake up at most `nr`
+ * of them. A woken waiter always retries before it gives up, so a wake-up
+ * is never lost on a waiter that times out.
+ */
+static inline void mbox_wake(struct uk_waitq *wq, unsigned int nr)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!uk_waitq_empty(wq))
+		uk_waitq_wake_up_nr(wq, (int) nr);
+}
+
+/* Reserves up to `count` slots, returns how many. */
+static unsigned int mbox_reserve(struct uk_mbox *m, unsigned int count)
+{
+	size_t used, n;
+
+	do {
+		used = ukarch_load_n(&m->used);
+		n = MIN((size_t) count, m->size - used);
+		if (!n)
+			return 0;
+	} while (ukarch_compare_exchange_sync(&m->used, used, used + n)
+		 != used + n);
+	return (unsigned int) n;
+}
+
+static inline void mbox_update_hwm(struct uk_mbox *m, size_t count)
+{
+	size_t hwm = ukarch_load_n(&m->hwm);
+
+	while (count > hwm
+	       && ukarch_compare_exchange_sync(&m->hwm, hwm, count) != count)
+		hwm = ukarch_load_n(&m->hwm);
+}
+
+/* Posts as many of the `count` messages as fit, returns how many. */
+static unsigned int _do_mbox_post(struct uk_mbox *m, void **msgs,
+				  unsigned int count)
 {
-	/* The caller got a semaphore token, so we are now allowed to increment
-	 * writer, but we still need to prevent concurrency between writers
-	 * (interrupt handler vs main)
-	 */
 	unsigned long irqf;
+	unsigned int i;
 
 	UK_ASSERT(m);
 
+	count = mbox_reserve(m, count);
+	if (!count)
+		return 0;
+
+	/* Interrupt handlers may post too, and they must not spin on an
+	 * enqueue that they interrupted on the same CPU
+	 */
 	irqf = ukplat_lcpu_save_irqf();
-	m->msgs[m->writepos] = msg;
-	m->writepos = (m->writepos + 1) % m->len;
-	UK_ASSERT(m->readpos != m->writepos);
+	i = uk_ring_enqueue_burst(m->ring, msgs, count);
 	ukplat_lcpu_restore_irqf(irqf);
-	uk_pr_debug("Posted message %p to mailbox %p\n", msg, m);
 
-	uk_semaphore_up(&m->readsem);
+	/* The ring has room for every reserved slot */
+	UK_ASSERT(i == count);
+
+	uk_pr_debug("Posted %u messages to mailbox %p\n", i, m);
+	mbox_update_hwm(m, (size_t) uk_ring_count(m->ring));
+	mbox_wake(&m->readq, i);
+	return i;
 }
 
-void uk_mbox_post(struct uk_mbox *m, void *msg)
+unsigned int uk_mbox_post_batch(struct uk_mbox *m, void **msgs,
+				unsigned int count)
 {
-	/* The caller got a semaphore token, so we are now allowed to increment
-	 * writer, but we still need to prevent concurrency between writers
-	 * (interrupt handler vs main)
-	 */
+	unsigned int posted = 0;
+
 	UK_ASSERT(m);
+	UK_ASSERT(msgs || !count);
+
+	for (;;) {
+		posted += _do_mbox_post(m, msgs + posted, count - posted);
+		if (posted == count)
+			break;
+		uk_waitq_wait_event_exclusive(&m->writeq,
+					      mbox_has_room(m));
+	}
+	return count;
+}
+
+unsigned int uk_mbox_post_batch_try(struct uk_mbox *m, void **msgs,
+				    unsigned int count)
+{
+	UK_ASSERT(msgs || !count);
 
-	uk_semaphore_down(&m->writesem);
-	_do_mbox_post(m, msg);
+	return _do_mbox_post(m, msgs, count);
 }
 
-int uk_mbox_post_try(struct uk_mbox *m, void *msg)
+void uk_mbox_post(struct uk_mbox *m, void *msg)
 {
-	UK_ASSERT(m);
+	uk_mbox_post_batch(m, &msg, 1);
+}
 
-	if (!uk_semaphore_down_try(&m->writesem))
+int uk_mbox_post_try(struct uk_mbox *m, void *msg)
+{
+	if (!_do_mbox_post(m, &msg, 1))
 		return -ENOBUFS;
-	_do_mbox_post(m, msg);
 	return 0;
 }
 
 __nsec uk_mbox_post_to(struct uk_mbox *m, void *msg, __nsec timeout)
 {
-	__nsec ret;
-
-	UK_ASSERT(m);
-
-	ret = uk_semaphore_down_to(&m->writesem, timeout);
-	if (ret != __NSEC_MAX)
-		_do_mbox_post(m, msg);
-	return ret;
+	__nsec then = ukplat_monotonic_clock();
+	__nsec deadline = then + timeout;
+
+	while (!_do_mbox_post(m, &msg, 1)) {
+		if (ukplat_monotonic_clock() >= deadline)
+			return __NSEC_MAX;
+		uk_waitq_wait_event_deadline_exclusive(&m->writeq,
+						       mbox_has_room(m),
+						       deadline);
+	}
+	return ukplat_monotonic_clock() - then;
 }
 
 /*
- * Fetch a message from a mailbox. Internal version that actually does the
- * fetch.
+ * Fetches up to `count` messages from a mailbox, returns how many. Internal
+ * version that actually does the fetch. `msgs` may be NULL to drop them.
  */
-static inline void *_do_mbox_recv(struct uk_mbox *m)
+static unsigned int _do_mbox_recv(struct uk_mbox *m, void **msgs,
+				  unsigned int count)
 {
 	unsigned long irqf;
-	void *ret;
+	unsigned int i;
+	void *msg;
+
+	UK_ASSERT(m);
 
-	uk_pr_debug("Receive message from mailbox %p\n", m);
 	irqf = ukplat_lcpu_save_irqf();
-	UK_ASSERT(m->readpos != m->writepos);
-	ret = m->msgs[m->readpos];
-	m->readpos = (m->readpos + 1) % m->len;
+	if (msgs) {
+		i = uk_ring_dequeue_burst_mc(m->ring, msgs, count);
+	} else {
+		for (i = 0; i < count; i++)
+			if (!uk_ring_dequeue_burst_mc(m->ring, &msg, 1))
+				break;
+	}
 	ukplat_lcpu_restore_irqf(irqf);
 
-	uk_semaphore_up(&m->writesem);
+	if (i) {
+		uk_pr_debug("Received %u messages from mailbox %p\n", i, m);
+		__atomic_fetch_sub(&m->used, (size_t) i, __ATOMIC_SEQ_CST);
+		mbox_wake(&m->writeq, i);
+	}
+	return i;
+}
+
+/* Blocks the thread until at least one message arrives in the mailbox and
+ * fetches up to `count` messages.
+ */
+unsigned int uk_mbox_recv_batch(struct uk_mbox *m, void **msgs,
+				unsigned int count)
+{
+	unsigned int n;
+
+	UK_ASSERT(m);
+	UK_ASSERT(count > 0);
 
-	return ret;
+	/* Other readers may take the messages before us */
+	while (!(n = _do_mbox_recv(m, msgs, count)))
+		uk_waitq_wait_event_exclusive(&m->readq,
+					      mbox_has_msgs(m));
+	return n;
+}
+
+unsigned int uk_mbox_recv_batch_try(struct uk_mbox *m, void **msgs,
+				    unsigned int count)
+{
+	return _do_mbox_recv(m, msgs, count);
 }
 
 /* Blocks the thread until a message arrives in the mailbox.
@@ -133,14 +268,7 @@ static inline void *_do_mbox_recv(struct uk_mbox *m)
  */
 void uk_mbox_recv(struct uk_mbox *m, void **msg)
 {
-	void *rmsg;
-
-	UK_ASSERT(m);
-
-	uk_semaphore_down(&m->readsem);
-	rmsg =  _do_mbox_recv(m);
-	if (msg)
-		*msg = rmsg;
+	uk_mbox_recv_batch(m, msg, 1);
 }
 
 
@@ -157,16 +285,8 @@ void uk_mbox_recv(struct uk_mbox *m, void **msg)
  */
 int uk_mbox_recv_try(struct uk_mbox *m, void **msg)
 {
-	void *rmsg;
-
-	UK_ASSERT(m);
-
-	if (!uk_semaphore_down_try(&m->readsem))
+	if (!_do_mbox_recv(m, msg, 1))
 		return -ENOMSG;
-
-	rmsg =  _do_mbox_recv(m);
-	if (msg)
-		*msg = rmsg;
 	return 0;
 }
 
@@ -184,16 +304,35 @@ int uk_mbox_recv_try(struct uk_mbox *m, void **msg)
  */
 __nsec uk_mbox_recv_to(struct uk_mbox *m, void **msg, __nsec timeout)
 {
-	void *rmsg = NULL;
-	__nsec ret;
+	__nsec then = ukplat_monotonic_clock();
+	__nsec deadline = then + timeout;
+
+	while (!_do_mbox_recv(m, msg, 1)) {
+		if (ukplat_monotonic_clock() >= deadline) {
+			if (msg)
+				*msg = NULL;
+			return __NSEC_MAX;
+		}
+		uk_waitq_wait_event_deadline_exclusive(&m->readq,
+						       mbox_has_msgs(m),
+						       deadline);
+	}
+	return ukplat_monotonic_clock() - then;
+}
 
+void uk_mbox_get_stats(struct uk_mbox *m, struct uk_mbox_stats *stats)
+{
 	UK_ASSERT(m);
+	UK_ASSERT(stats);
 
-	ret = uk_semaphore_down_to(&m->readsem, timeout);
-	if (ret != __NSEC_MAX)
-		rmsg = _do_mbox_recv(m);
+	stats->size = m->size;
+	stats->count = (size_t) uk_ring_count(m->ring);
+	stats->hwm = ukarch_load_n(&m->hwm);
+}
+
+void uk_mbox_reset_hwm(struct uk_mbox *m)
+{
+	UK_ASSERT(m);
 
-	if (msg)
-		*msg = rmsg;
-	return ret;
+	ukarch_store_n(&m->hwm, (size_t) uk_ring_count(m->ring));
 }
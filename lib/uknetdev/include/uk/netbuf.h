@@ -109,6 +109,15 @@ struct uk_netbuf {
 	uint16_t len;          /**< Payload length (should be <= buflen). */
 	__atomic refcount;     /**< Reference counter */
 
+	uint16_t flags;        /**< Packet flags (UK_NETBUF_F_*) */
+	uint32_t hash;         /**< Flow hash, see UK_NETBUF_F_HASH */
+
+	/* Offload meta data, see UK_NETBUF_F_PARTIAL_CSUM and UK_NETBUF_F_GSO_* */
+	uint16_t csum_start;   /**< Start of the checksummed data */
+	uint16_t csum_offset;  /**< Offset of the checksum from csum_start */
+	uint16_t gso_size;     /**< Payload bytes of each segment */
+	uint16_t hdr_len;      /**< Length of the headers of each segment */
+
 	void *priv;            /**< Reference to user-provided private data */
 
 	void *buf;             /**< Start address of contiguous buffer. */
@@ -119,6 +128,34 @@ struct uk_netbuf {
 	void *_b;              /**< @internal Base address for free'ing */
 };
 
+/**
+ * `hash` contains the flow hash of the packet. The flag is kept when
+ * headers are pushed or pulled with uk_netbuf_header(), so that the hash
+ * of a received frame stays available after the Ethernet header was
+ * stripped. Code that rewrites addresses or ports has to clear it with
+ * uk_netbuf_rss_hash_clear().
+ */
+#define UK_NETBUF_F_HASH		0x0001
+/**
+ * The checksum over the data starting at `csum_start` still has to be
+ * computed and stored at `csum_start + csum_offset`. The checksum field is
+ * pre-filled with the checksum of the pseudo header.
+ */
+#define UK_NETBUF_F_PARTIAL_CSUM	0x0002
+/** The checksums of the received packet were already validated */
+#define UK_NETBUF_F_DATA_VALID		0x0004
+/**
+ * The packet is larger than the MTU and has to be segmented into TCP (IPv4
+ * or IPv6) or UDP (IPv4) packets that carry `gso_size` bytes of payload
+ * each. The first `hdr_len` bytes are the headers that are repeated in
+ * every segment. Requires UK_NETBUF_F_PARTIAL_CSUM.
+ */
+#define UK_NETBUF_F_GSO_TCPV4		0x0008
+#define UK_NETBUF_F_GSO_TCPV6		0x0010
+#define UK_NETBUF_F_GSO_UDP		0x0020
+#define UK_NETBUF_F_GSO_MASK						\
+	(UK_NETBUF_F_GSO_TCPV4 | UK_NETBUF_F_GSO_TCPV6 | UK_NETBUF_F_GSO_UDP)
+
 /*
  * Iterator helpers for netbuf chains
  */
@@ -523,6 +560,51 @@ static inline int uk_netbuf_header(struct uk_netbuf *head, int16_t len)
 	return 1;
 }
 
+/**
+ * Computes the receive-side scaling (RSS) hash of a packet.
+ * The Toeplitz hash with the well-known default key is computed over the
+ * IPv4 or IPv6 addresses and, for TCP and UDP, the ports of the packet, so
+ * that the result matches the one of RSS-capable network cards. All packets
+ * of a flow get the same hash which can be used to select a queue, e.g.,
+ * `hash % nb_queues`. The headers have to be in the first netbuf of a chain.
+ * The hash is cached in the netbuf (`UK_NETBUF_F_HASH`) and returned by
+ * later calls without looking at the packet again, even if the payload
+ * changed in between. Callers that modify the addresses or ports of a
+ * packet must call uk_netbuf_rss_hash_clear() first.
+ * @param m
+ *   Netbuf that starts with an Ethernet header
+ * @return
+ *   Flow hash, 0 if the packet is not an IP packet or is truncated
+ */
+uint32_t uk_netbuf_rss_hash(struct uk_netbuf *m);
+
+/**
+ * Drops the cached flow hash of a packet, so that the next
+ * uk_netbuf_rss_hash() computes it from the current headers.
+ * @param m
+ *   Netbuf whose addresses or ports were rewritten
+ */
+static inline void uk_netbuf_rss_hash_clear(struct uk_netbuf *m)
+{
+	UK_ASSERT(m);
+
+	m->flags &= ~UK_NETBUF_F_HASH;
+}
+
+#if CONFIG_LIBUKNETDEV_RSS_TEST
+/**
+ * Checks uk_netbuf_rss_hash() against the verification suite of the
+ * Microsoft RSS specification: IPv4 and IPv6 packets, hashed over the
+ * addresses only and over addresses and TCP ports. Prints the result on
+ * the kernel console.
+ *
+ * @return
+ *   - (0): all hashes match
+ *   - (-EIO): at least one hash is wrong
+ */
+int uk_netbuf_rss_test(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
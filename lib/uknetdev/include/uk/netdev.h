@@ -163,7 +163,7 @@ const void *uk_netdev_einfo_get(struct uk_netdev *dev,
 				enum uk_netdev_einfo_type einfo);
 
 /**
- * Configures an Unikraft network device.
+ * Configures an Unikraft network device. No receive offloads are enabled.
  *
  * @param dev
  *   The Unikraft Network Device in unconfigured state.
@@ -177,6 +177,27 @@ const void *uk_netdev_einfo_get(struct uk_netdev *dev,
 int uk_netdev_configure(struct uk_netdev *dev,
 			const struct uk_netdev_conf *dev_conf);
 
+/**
+ * Configures an Unikraft network device like uk_netdev_configure() and
+ * enables receive offloads.
+ *
+ * @param dev
+ *   The Unikraft Network Device in unconfigured state.
+ * @param conf
+ *   The pointer to the configuration data to be used for the Unikraft
+ *   network device.
+ * @param offloads
+ *   Receive offloads to enable (UK_FEATURE_RX_*). They have to be
+ *   reported by uk_netdev_info_get().
+ * @return
+ *   - (0): Success, device is in configured state.
+ *   - (-EINVAL): The device does not support one of the offloads.
+ *   - (<0): Error code returned by the driver.
+ */
+int uk_netdev_configure_offloads(struct uk_netdev *dev,
+				 const struct uk_netdev_conf *dev_conf,
+				 uint32_t offloads);
+
 
 /**
  * Query receive device queue capabilities.
@@ -507,6 +528,91 @@ static inline int uk_netdev_tx_one(struct uk_netdev *dev, uint16_t queue_id,
 	return dev->tx_one(dev, dev->_tx_queue[queue_id], pkt);
 }
 
+/**
+ * Receive a burst of packets and re-program used receive descriptors. This is
+ * the batched version of uk_netdev_rx_one(): the same rules about queue
+ * interrupts and the receive buffer allocator apply. Receive descriptors are
+ * re-programmed and the device is notified once per burst.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the receive queue to receive from.
+ *   The value must be in the range [0, nb_rx_queue - 1] previously supplied
+ *   to uk_netdev_configure().
+ * @param pkts
+ *   Array of at least `*cnt` netbuf pointers that are set to the received
+ *   packets.
+ * @param cnt
+ *   Maximum number of packets to receive (must be greater than 0). It is
+ *   updated with the number of received packets.
+ * @return
+ *   - (>=0): Positive value with status flags
+ *     - UK_NETDEV_STATUS_SUCCESS: At least one packet was received.
+ *     - UK_NETDEV_STATUS_MORE: Indicates that more received packets are
+ *        available on the receive queue. When interrupts are used, they are
+ *        disabled until this flag is unset by a subsequent call.
+ *        This flag may only be set together with UK_NETDEV_STATUS_SUCCESS.
+ *     - UK_NETDEV_STATUS_UNDERRUN: Informs that some available slots of the
+ *        receive queue could not be programmed with a receive buffer.
+ *   - (<0): Negative value with error code from driver, no packet is returned.
+ */
+static inline int uk_netdev_rx_burst(struct uk_netdev *dev, uint16_t queue_id,
+				     struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->rx_burst);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(dev->_data->state == UK_NETDEV_RUNNING);
+	UK_ASSERT(!PTRISERR(dev->_rx_queue[queue_id]));
+	UK_ASSERT(pkts);
+	UK_ASSERT(cnt && *cnt > 0);
+
+	return dev->rx_burst(dev, dev->_rx_queue[queue_id], pkts, cnt);
+}
+
+/**
+ * Transmit a burst of packets. This is the batched version of
+ * uk_netdev_tx_one(): the packets are put on the transmit queue in order and
+ * the device is notified once per burst.
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the transmit queue to send with.
+ *   The value must be in the range [0, nb_tx_queue - 1] previously supplied
+ *   to uk_netdev_configure().
+ * @param pkts
+ *   Array of `*cnt` netbufs to send. Sent packets are free'd by the driver
+ *   after the device finished sending them.
+ * @param cnt
+ *   Number of packets to send (must be greater than 0). It is updated with
+ *   the number of packets that were put to the transmit queue; these are
+ *   the first ones of `pkts`.
+ * @return
+ *   - (>=0): Positive value with status flags
+ *     - UK_NETDEV_STATUS_SUCCESS: At least one packet was put to the
+ *        transmit queue. Whenever this flag is not set, there was no space
+ *        left on the transmit queue.
+ *     - UK_NETDEV_STATUS_MORE: Indicates there is still at least one
+ *         descriptor available for a subsequent transmission.
+ *         This flag may only be set together with UK_NETDEV_STATUS_SUCCESS.
+ *   - (<0): Negative value with error code from driver, no packet was sent.
+ */
+static inline int uk_netdev_tx_burst(struct uk_netdev *dev, uint16_t queue_id,
+				     struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->tx_burst);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(dev->_data->state == UK_NETDEV_RUNNING);
+	UK_ASSERT(!PTRISERR(dev->_tx_queue[queue_id]));
+	UK_ASSERT(pkts);
+	UK_ASSERT(cnt && *cnt > 0);
+
+	return dev->tx_burst(dev, dev->_tx_queue[queue_id], pkts, cnt);
+}
+
 /**
  * Tests for status flags returned by `uk_netdev_rx_one` or `uk_netdev_tx_one`.
  * When the functions returned an error code or one of the selected flags is
@@ -135,6 +135,28 @@ struct uk_hwaddr {
 #define uk_netdev_rxintr_supported(feature)	\
 	(feature & (UK_FEATURE_RXQ_INTR_AVAILABLE))
 
+/**
+ * Offloads of the netdevice. The transmit offloads are requested per packet
+ * with the netbuf flags (UK_NETBUF_F_PARTIAL_CSUM, UK_NETBUF_F_GSO_*).
+ * The receive offloads change the packets handed to the application, so
+ * they have to be enabled with uk_netdev_configure_offloads().
+ */
+#define UK_FEATURE_TX_CSUM_BIT		    2
+#define UK_FEATURE_TX_CSUM_AVAILABLE   (1UL << UK_FEATURE_TX_CSUM_BIT)
+#define UK_FEATURE_RX_CSUM_BIT		    3
+#define UK_FEATURE_RX_CSUM_AVAILABLE   (1UL << UK_FEATURE_RX_CSUM_BIT)
+#define UK_FEATURE_TX_TSO4_BIT		    4
+#define UK_FEATURE_TX_TSO4_AVAILABLE   (1UL << UK_FEATURE_TX_TSO4_BIT)
+#define UK_FEATURE_TX_TSO6_BIT		    5
+#define UK_FEATURE_TX_TSO6_AVAILABLE   (1UL << UK_FEATURE_TX_TSO6_BIT)
+#define UK_FEATURE_TX_UFO_BIT		    6
+#define UK_FEATURE_TX_UFO_AVAILABLE    (1UL << UK_FEATURE_TX_UFO_BIT)
+#define UK_FEATURE_RX_LRO_BIT		    7
+#define UK_FEATURE_RX_LRO_AVAILABLE    (1UL << UK_FEATURE_RX_LRO_BIT)
+
+#define UK_FEATURE_RX_OFFLOADS					\
+	(UK_FEATURE_RX_CSUM_AVAILABLE | UK_FEATURE_RX_LRO_AVAILABLE)
+
 /**
  * A structure used to describe network device capabilities.
  */
@@ -287,9 +309,14 @@ typedef void (*uk_netdev_info_get_t)(struct uk_netdev *dev,
 typedef const void *(*uk_netdev_einfo_get_t)(struct uk_netdev *dev,
 					     enum uk_netdev_einfo_type econf);
 
-/** Driver callback type to configure a network device. */
+/**
+ * Driver callback type to configure a network device. `offloads` are the
+ * receive offloads to enable (UK_FEATURE_RX_*), the API already checked
+ * that the device reports them.
+ */
 typedef int  (*uk_netdev_configure_t)(struct uk_netdev *dev,
-				      const struct uk_netdev_conf *conf);
+				      const struct uk_netdev_conf *conf,
+				      uint32_t offloads);
 
 /** Driver callback type to retrieve RX queue limitations,
  *  used for configuring the RX queue later
@@ -368,6 +395,22 @@ typedef int (*uk_netdev_tx_one_t)(struct uk_netdev *dev,
 				  struct uk_netdev_tx_queue *queue,
 				  struct uk_netbuf *pkt);
 
+/**
+ * Driver callback type to retrieve up to `*cnt` packets from a RX queue.
+ * `*cnt` is updated with the number of received packets.
+ */
+typedef int (*uk_netdev_rx_burst_t)(struct uk_netdev *dev,
+				    struct uk_netdev_rx_queue *queue,
+				    struct uk_netbuf **pkts, uint16_t *cnt);
+
+/**
+ * Driver callback type to submit up to `*cnt` packets to a TX queue.
+ * `*cnt` is updated with the number of submitted packets.
+ */
+typedef int (*uk_netdev_tx_burst_t)(struct uk_netdev *dev,
+				    struct uk_netdev_tx_queue *queue,
+				    struct uk_netbuf **pkts, uint16_t *cnt);
+
 /**
  * A structure containing the functions exported by a driver.
  */
@@ -447,13 +490,17 @@ struct uk_netdev_einfo {
  * registering the netdev. They change during device life time. Packet RX/TX
  * functions are added directly to this structure for performance reasons.
  * It prevents another indirection to ops.
+ * Drivers that do not provide the burst functions get a generic version that
+ * calls tx_one/rx_one for every packet.
  */
 struct uk_netdev {
 	/** Packet transmission. */
 	uk_netdev_tx_one_t          tx_one; /* by driver */
+	uk_netdev_tx_burst_t        tx_burst; /* by driver, optional */
 
 	/** Packet reception. */
 	uk_netdev_rx_one_t          rx_one; /* by driver */
+	uk_netdev_rx_burst_t        rx_burst; /* by driver, optional */
 
 	/** Pointer to API-internal state data. */
 	struct uk_netdev_data       *_data;
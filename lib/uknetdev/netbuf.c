@@ -57,6 +57,12 @@ void uk_netbuf_init_indir(struct uk_netbuf *m,
 
 	uk_refcount_init(&m->refcount, 1);
 
+	m->flags  = 0;
+	m->hash   = 0;
+	m->csum_start  = 0;
+	m->csum_offset = 0;
+	m->gso_size    = 0;
+	m->hdr_len     = 0;
 	m->priv   = priv;
 	m->dtor   = dtor;
 	m->_a     = NULL;
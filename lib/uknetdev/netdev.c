@@ -132,6 +132,77 @@ static struct uk_netdev_einfo *_alloc_einfo(struct uk_alloc *a)
 	return _einfo;
 }
 
+/* Generic receive burst for drivers that only implement rx_one */
+static int _rx_burst_one(struct uk_netdev *dev,
+			 struct uk_netdev_rx_queue *queue,
+			 struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	int status = 0x0;
+	int rc = 0;
+	uint16_t i;
+
+	for (i = 0; i < *cnt; i++) {
+		rc = dev->rx_one(dev, queue, &pkts[i]);
+		if (unlikely(rc < 0)) {
+			if (i == 0) {
+				*cnt = 0;
+				return rc;
+			}
+			/* Report the error with the next call */
+			rc = 0x0;
+			break;
+		}
+		status |= (rc & UK_NETDEV_STATUS_UNDERRUN);
+		if (!(rc & UK_NETDEV_STATUS_SUCCESS))
+			break;
+		if (!(rc & UK_NETDEV_STATUS_MORE)) {
+			i++;
+			break;
+		}
+	}
+
+	*cnt = i;
+	if (i)
+		status |= UK_NETDEV_STATUS_SUCCESS
+			  | (rc & UK_NETDEV_STATUS_MORE);
+	return status;
+}
+
+/* Generic transmit burst for drivers that only implement tx_one */
+static int _tx_burst_one(struct uk_netdev *dev,
+			 struct uk_netdev_tx_queue *queue,
+			 struct uk_netbuf **pkts, uint16_t *cnt)
+{
+	int status = 0x0;
+	int rc = 0;
+	uint16_t i;
+
+	for (i = 0; i < *cnt; i++) {
+		rc = dev->tx_one(dev, queue, pkts[i]);
+		if (unlikely(rc < 0)) {
+			if (i == 0) {
+				*cnt = 0;
+				return rc;
+			}
+			/* Report the error with the next call */
+			rc = 0x0;
+			break;
+		}
+		if (!(rc & UK_NETDEV_STATUS_SUCCESS))
+			break;
+		if (!(rc & UK_NETDEV_STATUS_MORE)) {
+			i++;
+			break;
+		}
+	}
+
+	*cnt = i;
+	if (i)
+		status |= UK_NETDEV_STATUS_SUCCESS
+			  | (rc & UK_NETDEV_STATUS_MORE);
+	return status;
+}
+
 int uk_netdev_drv_register(struct uk_netdev *dev, struct uk_alloc *a,
 			   const char *drv_name)
 {
@@ -155,6 +226,11 @@ int uk_netdev_drv_register(struct uk_netdev *dev, struct uk_alloc *a,
 	UK_ASSERT(dev->rx_one);
 	UK_ASSERT(dev->tx_one);
 
+	if (!dev->rx_burst)
+		dev->rx_burst = _rx_burst_one;
+	if (!dev->tx_burst)
+		dev->tx_burst = _tx_burst_one;
+
 	dev->_data = _alloc_data(a, netdev_count,  drv_name);
 	if (!dev->_data)
 		return -ENOMEM;
@@ -298,8 +374,9 @@ int uk_netdev_txq_info_get(struct uk_netdev *dev, uint16_t queue_id,
 	return dev->ops->txq_info_get(dev, queue_id, queue_info);
 }
 
-int uk_netdev_configure(struct uk_netdev *dev,
-			const struct uk_netdev_conf *dev_conf)
+int uk_netdev_configure_offloads(struct uk_netdev *dev,
+				 const struct uk_netdev_conf *dev_conf,
+				 uint32_t offloads)
 {
 	struct uk_netdev_info dev_info;
 	int ret;
@@ -318,8 +395,10 @@ int uk_netdev_configure(struct uk_netdev *dev,
 		return -EINVAL;
 	if (dev_conf->nb_tx_queues > dev_info.max_tx_queues)
 		return -EINVAL;
+	if (offloads & ~(dev_info.features & UK_FEATURE_RX_OFFLOADS))
+		return -EINVAL;
 
-	ret = dev->ops->configure(dev, dev_conf);
+	ret = dev->ops->configure(dev, dev_conf, offloads);
 	if (ret >= 0) {
 		uk_pr_info("netdev%"PRIu16": Configured interface\n",
 			   dev->_data->id);
@@ -331,6 +410,12 @@ int uk_netdev_configure(struct uk_netdev *dev,
 	return ret;
 }
 
+int uk_netdev_configure(struct uk_netdev *dev,
+			const struct uk_netdev_conf *dev_conf)
+{
+	return uk_netdev_configure_offloads(dev, dev_conf, 0);
+}
+
 #ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
 static void _dispatcher(void *arg)
 {
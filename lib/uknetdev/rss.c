@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <uk/netbuf.h>
+#include <uk/netdev_core.h>
+#include <uk/essentials.h>
+#include <string.h>
+
+#define RSS_ETHTYPE_8021Q	0x8100
+#define RSS_ETHTYPE_IPV4	0x0800
+#define RSS_ETHTYPE_IPV6	0x86dd
+
+#define RSS_PROTO_TCP		6
+#define RSS_PROTO_UDP		17
+
+#define RSS_IPV4_HDR_MINLEN	20
+#define RSS_IPV4_FRAG_MASK	0x3fff /* MF flag and fragment offset */
+#define RSS_IPV6_HDR_LEN	40
+
+/* Largest input: IPv6 source and destination addresses plus ports */
+#define RSS_INPUT_MAXLEN	(2 * 16 + 2 * 2)
+
+/* Default key used by Microsoft RSS and most network card drivers */
+static const uint8_t rss_key[40] = {
+	0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+	0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+	0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+	0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+	0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa,
+};
+
+static inline uint16_t rss_get16(const uint8_t *p)
+{
+	return (uint16_t) ((p[0] << 8) | p[1]);
+}
+
+static uint32_t rss_toeplitz(const uint8_t *input, unsigned int len)
+{
+	uint32_t hash = 0;
+	uint32_t v;
+	unsigned int i;
+	int b;
+
+	UK_ASSERT(len + 4 <= sizeof(rss_key));
+
+	/* Sliding 32-bit window over the key, advanced by one bit per input
+	 * bit
+	 */
+	v = ((uint32_t) rss_key[0] << 24) | ((uint32_t) rss_key[1] << 16)
+	    | ((uint32_t) rss_key[2] << 8) | rss_key[3];
+	for (i = 0; i < len; i++) {
+		for (b = 7; b >= 0; b--) {
+			if (input[i] & (1 << b))
+				hash ^= v;
+			v <<= 1;
+			if (rss_key[i + 4] & (1 << b))
+				v |= 1;
+		}
+	}
+	return hash;
+}
+
+uint32_t uk_netbuf_rss_hash(struct uk_netbuf *m)
+{
+	uint8_t input[RSS_INPUT_MAXLEN];
+	const uint8_t *p, *l4 = NULL;
+	unsigned int ilen, left;
+	uint16_t ethtype;
+	uint8_t proto;
+
+	UK_ASSERT(m);
+
+	if (m->flags & UK_NETBUF_F_HASH)
+		return m->hash;
+
+	p = m->data;
+	left = m->len;
+	if (left < UK_ETH_HDR_UNTAGGED_LEN)
+		return 0;
+	ethtype = rss_get16(p + 2 * UK_ETH_ADDR_LEN);
+	p += UK_ETH_HDR_UNTAGGED_LEN;
+	left -= UK_ETH_HDR_UNTAGGED_LEN;
+	if (ethtype == RSS_ETHTYPE_8021Q) {
+		if (left < UK_ETH_8021Q_LEN)
+			return 0;
+		ethtype = rss_get16(p + 2);
+		p += UK_ETH_8021Q_LEN;
+		left -= UK_ETH_8021Q_LEN;
+	}
+
+	if (ethtype == RSS_ETHTYPE_IPV4) {
+		unsigned int hlen;
+
+		if (left < RSS_IPV4_HDR_MINLEN || (p[0] >> 4) != 4)
+			return 0;
+		hlen = (p[0] & 0xf) * 4;
+		if (hlen < RSS_IPV4_HDR_MINLEN || left < hlen)
+			return 0;
+		proto = p[9];
+		memcpy(input, p + 12, 8);
+		ilen = 8;
+		/* Only the first fragment carries the ports */
+		if (!(rss_get16(p + 6) & RSS_IPV4_FRAG_MASK))
+			l4 = p + hlen;
+		left -= hlen;
+	} else if (ethtype == RSS_ETHTYPE_IPV6) {
+		if (left < RSS_IPV6_HDR_LEN || (p[0] >> 4) != 6)
+			return 0;
+		/* Extension headers are not followed */
+		proto = p[6];
+		memcpy(input, p + 8, 32);
+		ilen = 32;
+		l4 = p + RSS_IPV6_HDR_LEN;
+		left -= RSS_IPV6_HDR_LEN;
+	} else {
+		return 0;
+	}
+
+	if (l4 && left >= 4
+	    && (proto == RSS_PROTO_TCP || proto == RSS_PROTO_UDP)) {
+		memcpy(input + ilen, l4, 4);
+		ilen += 4;
+	}
+
+	m->hash = rss_toeplitz(input, ilen);
+	m->flags |= UK_NETBUF_F_HASH;
+	return m->hash;
+}
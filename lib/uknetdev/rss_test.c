@@ -0,0 +1,176 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uk/essentials.h>
+#include <uk/netbuf.h>
+#include <uk/netdev_core.h>
+#include <uk/print.h>
+
+/*
+ * Verification suite of the Microsoft RSS specification: hashes over the
+ * addresses only and over addresses and ports, with the default key
+ */
+struct rss_vector {
+	uint8_t src[16];
+	uint8_t dst[16];
+	uint16_t sport;
+	uint16_t dport;
+	uint32_t hash_ip;
+	uint32_t hash_tcp;
+};
+
+static const struct rss_vector rss_ipv4_vectors[] = {
+	{ { 66, 9, 149, 187 }, { 161, 142, 100, 80 }, 2794, 1766,
+	  0x323e8fc2, 0x51ccc178 },
+	{ { 199, 92, 111, 2 }, { 65, 69, 140, 83 }, 14230, 4739,
+	  0xd718262a, 0xc626b0ea },
+	{ { 24, 19, 198, 95 }, { 12, 22, 207, 184 }, 12898, 38024,
+	  0xd2d0a5de, 0x5c2b394a },
+	{ { 38, 27, 205, 30 }, { 209, 142, 163, 6 }, 48228, 2217,
+	  0x82989176, 0xafc7327f },
+	{ { 153, 39, 163, 191 }, { 202, 188, 127, 2 }, 44251, 1303,
+	  0x5d1809c5, 0x10e828a2 },
+};
+
+static const struct rss_vector rss_ipv6_vectors[] = {
+	/* 3ffe:2501:200:1fff::7 -> 3ffe:2501:200:3::1 */
+	{ { 0x3f, 0xfe, 0x25, 0x01, 0x02, 0x00, 0x1f, 0xff,
+	    0, 0, 0, 0, 0, 0, 0, 0x07 },
+	  { 0x3f, 0xfe, 0x25, 0x01, 0x02, 0x00, 0x00, 0x03,
+	    0, 0, 0, 0, 0, 0, 0, 0x01 }, 2794, 1766,
+	  0x2cc18cd5, 0x40207d3d },
+	/* 3ffe:501:8::260:97ff:fe40:efab -> ff02::1 */
+	{ { 0x3f, 0xfe, 0x05, 0x01, 0x00, 0x08, 0x00, 0x00,
+	    0x02, 0x60, 0x97, 0xff, 0xfe, 0x40, 0xef, 0xab },
+	  { 0xff, 0x02, 0, 0, 0, 0, 0, 0,
+	    0, 0, 0, 0, 0, 0, 0, 0x01 }, 14230, 4739,
+	  0x0f0c461c, 0xdde51bbf },
+	/* 3ffe:1900:4545:3:200:f8ff:fe21:67cf -> fe80::200:f8ff:fe21:67cf */
+	{ { 0x3f, 0xfe, 0x19, 0x00, 0x45, 0x45, 0x00, 0x03,
+	    0x02, 0x00, 0xf8, 0xff, 0xfe, 0x21, 0x67, 0xcf },
+	  { 0xfe, 0x80, 0, 0, 0, 0, 0, 0,
+	    0x02, 0x00, 0xf8, 0xff, 0xfe, 0x21, 0x67, 0xcf }, 44251, 38024,
+	  0x4b61e985, 0x02d1feef },
+};
+
+/* Any protocol without ports, so that only the addresses are hashed */
+#define RSS_TEST_PROTO_OTHER	1
+#define RSS_TEST_PROTO_TCP	6
+#define RSS_TEST_IPV4_HDR_LEN	20
+#define RSS_TEST_IPV6_HDR_LEN	40
+#define RSS_TEST_TCP_HDR_LEN	20
+#define RSS_TEST_FRAME_LEN	(UK_ETH_HDR_UNTAGGED_LEN \
+				 + RSS_TEST_IPV6_HDR_LEN \
+				 + RSS_TEST_TCP_HDR_LEN)
+
+static void rss_put16(uint8_t *p, uint16_t v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0xff;
+}
+
+/* Builds an Ethernet frame with an IP header followed by the ports */
+static unsigned int rss_test_frame(uint8_t *frame, int ipv6, uint8_t proto,
+				   const struct rss_vector *v)
+{
+	uint8_t *ip = frame + UK_ETH_HDR_UNTAGGED_LEN;
+	uint8_t *l4;
+
+	memset(frame, 0, RSS_TEST_FRAME_LEN);
+	if (ipv6) {
+		rss_put16(frame + 2 * UK_ETH_ADDR_LEN, 0x86dd);
+		ip[0] = 0x60;
+		ip[6] = proto;
+		memcpy(ip + 8, v->src, 16);
+		memcpy(ip + 24, v->dst, 16);
+		l4 = ip + RSS_TEST_IPV6_HDR_LEN;
+	} else {
+		rss_put16(frame + 2 * UK_ETH_ADDR_LEN, 0x0800);
+		ip[0] = 0x45;
+		ip[9] = proto;
+		memcpy(ip + 12, v->src, 4);
+		memcpy(ip + 16, v->dst, 4);
+		l4 = ip + RSS_TEST_IPV4_HDR_LEN;
+	}
+	rss_put16(l4, v->sport);
+	rss_put16(l4 + 2, v->dport);
+	return (unsigned int) (l4 + RSS_TEST_TCP_HDR_LEN - frame);
+}
+
+static int rss_test_one(const struct rss_vector *v, int ipv6, uint8_t proto,
+			uint32_t expected)
+{
+	uint8_t frame[RSS_TEST_FRAME_LEN];
+	struct uk_netbuf m = { 0 };
+	uint32_t hash;
+
+	m.data = frame;
+	m.len = rss_test_frame(frame, ipv6, proto, v);
+	hash = uk_netbuf_rss_hash(&m);
+	if (hash == expected)
+		return 0;
+
+	uk_pr_err("IPv%c %s hash of ports %"__PRIu16" -> %"__PRIu16
+		  ": 0x%08"__PRIx32", expected 0x%08"__PRIx32"\n",
+		  ipv6 ? '6' : '4',
+		  (proto == RSS_TEST_PROTO_TCP) ? "TCP" : "address",
+		  v->sport, v->dport, hash, expected);
+	return -EIO;
+}
+
+int uk_netbuf_rss_test(void)
+{
+	unsigned int i, nb_failed = 0, nb_tests = 0;
+
+	for (i = 0; i < ARRAY_SIZE(rss_ipv4_vectors); i++) {
+		nb_failed += !!rss_test_one(&rss_ipv4_vectors[i], 0,
+					    RSS_TEST_PROTO_OTHER,
+					    rss_ipv4_vectors[i].hash_ip);
+		nb_failed += !!rss_test_one(&rss_ipv4_vectors[i], 0,
+					    RSS_TEST_PROTO_TCP,
+					    rss_ipv4_vectors[i].hash_tcp);
+		nb_tests += 2;
+	}
+	for (i = 0; i < ARRAY_SIZE(rss_ipv6_vectors); i++) {
+		nb_failed += !!rss_test_one(&rss_ipv6_vectors[i], 1,
+					    RSS_TEST_PROTO_OTHER,
+					    rss_ipv6_vectors[i].hash_ip);
+		nb_failed += !!rss_test_one(&rss_ipv6_vectors[i], 1,
+					    RSS_TEST_PROTO_TCP,
+					    rss_ipv6_vectors[i].hash_tcp);
+		nb_tests += 2;
+	}
+
+	uk_pr_info("RSS hash: %u of %u verification vectors passed\n",
+		   nb_tests - nb_failed, nb_tests);
+	return nb_failed ? -EIO : 0;
+}
@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <uk/essentials.h>
+#include <uk/alloc.h>
+#include <uk/ring.h>
+#include <uk/print.h>
+#include <uk/plat/time.h>
+
+#define BENCH_RING_SIZE		1024
+#define BENCH_BURST_MAX		256
+
+/* Objects are sequence numbers starting at 1, so that NULL is never queued */
+#define BENCH_OBJ(i)		((void *) (uintptr_t) ((i) + 1))
+
+static void *bench_objs[BENCH_BURST_MAX];
+static void *bench_out[BENCH_BURST_MAX];
+
+static void bench_report(const char *name, unsigned int count, __nsec start)
+{
+	__nsec elapsed = ukplat_monotonic_clock() - start;
+	__u64 rate;
+
+	rate = (__u64) count * ukarch_time_sec_to_nsec(1)
+	       / MAX(elapsed, (__nsec) 1);
+	uk_pr_info("%s: %u objects in %"__PRInsec" ns: %"__PRIu64
+		   " objects/s\n", name, count, elapsed, rate);
+}
+
+typedef unsigned int (*bench_enqueue_func_t)(struct uk_ring *r,
+					     void * const *objs,
+					     unsigned int n);
+typedef unsigned int (*bench_dequeue_func_t)(struct uk_ring *r, void **objs,
+					     unsigned int n);
+
+/* Enqueues and dequeues `count` objects in rounds of up to `burst` */
+static int bench_multi(const char *name, struct uk_ring *r,
+		       unsigned int count, unsigned int burst,
+		       bench_enqueue_func_t enqueue,
+		       bench_dequeue_func_t dequeue)
+{
+	unsigned int i, j, n;
+	__nsec start;
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < count; i += n) {
+		n = MIN(burst, count - i);
+		for (j = 0; j < n; j++)
+			bench_objs[j] = BENCH_OBJ(i + j);
+		n = enqueue(r, bench_objs, n);
+		if (unlikely(!n || dequeue(r, bench_out, n) != n))
+			return -EIO;
+		for (j = 0; j < n; j++)
+			if (unlikely(bench_out[j] != BENCH_OBJ(i + j)))
+				return -EIO;
+	}
+	bench_report(name, count, start);
+	return 0;
+}
+
+static int bench_run(struct uk_ring *r, unsigned int count,
+		     unsigned int burst)
+{
+	unsigned int i;
+	void *obj;
+	__nsec start;
+	int rc;
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < count; i++) {
+		if (unlikely(uk_ring_enqueue(r, BENCH_OBJ(i))))
+			return -EIO;
+		obj = uk_ring_dequeue_mc(r);
+		if (unlikely(obj != BENCH_OBJ(i)))
+			return -EIO;
+	}
+	bench_report("Single, multi-producer/consumer", count, start);
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < count; i++) {
+		if (unlikely(uk_ring_enqueue(r, BENCH_OBJ(i))))
+			return -EIO;
+		obj = uk_ring_dequeue_sc(r);
+		if (unlikely(obj != BENCH_OBJ(i)))
+			return -EIO;
+	}
+	bench_report("Single, single consumer", count, start);
+
+	rc = bench_multi("Bulk, multi-producer/consumer", r, count, burst,
+			 uk_ring_enqueue_bulk, uk_ring_dequeue_bulk_mc);
+	if (!rc)
+		rc = bench_multi("Bulk, single producer/consumer", r, count,
+				 burst, uk_ring_enqueue_bulk_sp,
+				 uk_ring_dequeue_bulk_sc);
+	if (!rc)
+		rc = bench_multi("Burst, multi-producer/consumer", r, count,
+				 burst, uk_ring_enqueue_burst,
+				 uk_ring_dequeue_burst_mc);
+	if (!rc)
+		rc = bench_multi("Burst, single producer/consumer", r, count,
+				 burst, uk_ring_enqueue_burst_sp,
+				 uk_ring_dequeue_burst_sc);
+	return rc;
+}
+
+int uk_ring_bench(struct uk_alloc *a, unsigned int count, unsigned int burst)
+{
+	struct uk_ring *r;
+	int rc;
+
+	UK_ASSERT(a);
+	UK_ASSERT(count > 0);
+	UK_ASSERT(burst > 0 && burst <= BENCH_BURST_MAX);
+
+	r = uk_ring_alloc(BENCH_RING_SIZE, a
+#ifdef DEBUG_BUFRING
+			  , NULL
+#endif
+		);
+	if (!r)
+		return -ENOMEM;
+
+	uk_pr_info("Ring of %d slots, rounds of %u objects\n",
+		   BENCH_RING_SIZE, burst);
+	rc = bench_run(r, count, burst);
+	if (rc)
+		uk_pr_err("Objects were lost or reordered\n");
+
+	uk_ring_free(r, a);
+	return rc;
+}
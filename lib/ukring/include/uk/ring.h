@@ -52,14 +52,14 @@ struct uk_ring {
 	int               br_prod_size;
 	int               br_prod_mask;
 	uint64_t          br_drops;
-	volatile uint32_t br_cons_head __aligned(CACHE_LINE_SIZE);
+	volatile uint32_t br_cons_head __align(CACHE_LINE_SIZE);
 	volatile uint32_t br_cons_tail;
 	int               br_cons_size;
 	int               br_cons_mask;
 #ifdef DEBUG_BUFRING
 	struct uk_mutex  *br_lock;
 #endif
-	void             *br_ring[0] __aligned(CACHE_LINE_SIZE);
+	void             *br_ring[0] __align(CACHE_LINE_SIZE);
 };
 
 /*
@@ -99,8 +99,8 @@ uk_ring_enqueue(struct uk_ring *br, void *buf)
 			}
 			continue;
 		}
-	} while (!ukarch_compare_exchange_sync((uint32_t *) &br->br_prod_head,
-			prod_head, prod_next));
+	} while (ukarch_compare_exchange_sync((uint32_t *) &br->br_prod_head,
+			prod_head, prod_next) != prod_next);
 
 #ifdef DEBUG_BUFRING
 	if (br->br_ring[prod_head] != NULL)
@@ -139,8 +139,8 @@ uk_ring_dequeue_mc(struct uk_ring *br)
 			critical_exit();
 			return NULL;
 		}
-	} while (!ukarch_compare_exchange_sync((uint32_t *) &br->br_cons_head,
-			cons_head, cons_next));
+	} while (ukarch_compare_exchange_sync((uint32_t *) &br->br_cons_head,
+			cons_head, cons_next) != cons_next);
 
 	buf = br->br_ring[cons_head];
 #ifdef DEBUG_BUFRING
@@ -349,6 +349,191 @@ uk_ring_peek_clear_sc(struct uk_ring *br)
 #endif
 }
 
+/*
+ * Bulk and burst operations
+ *
+ * These move several objects with a single update of the producer or
+ * consumer head, so a whole batch costs one compare-and-swap instead of
+ * one per object. A bulk operation moves either all `n` objects or none of
+ * them, a burst operation moves as many as are possible. Both return the
+ * number of objects that were moved.
+ *
+ * The `_sp` (single-producer) and `_sc` (single-consumer) variants skip the
+ * compare-and-swap and the wait for concurrent operations. Use them only
+ * where enqueues resp. dequeues on the ring are serialized by the caller,
+ * e.g., by a driver's queue lock. Unlike uk_ring_dequeue_mc() and
+ * uk_ring_dequeue_sc(), NULL objects are allowed since emptiness is
+ * reported through the returned count.
+ */
+static __inline unsigned int
+__uk_ring_do_enqueue(struct uk_ring *br, void * const *objs, unsigned int n,
+		     int burst, int single)
+{
+	uint32_t prod_head, prod_next, cons_tail, idx;
+	unsigned int room, cnt, i;
+
+	if (unlikely(n == 0))
+		return 0;
+
+	critical_enter();
+	do {
+		cnt = n;
+		prod_head = br->br_prod_head;
+		cons_tail = ukarch_load_n(&br->br_cons_tail);
+		room = (cons_tail - prod_head - 1) & br->br_prod_mask;
+
+		if (cnt > room) {
+			if (!burst || !room) {
+				br->br_drops++;
+				critical_exit();
+				return 0;
+			}
+			cnt = room;
+		}
+		prod_next = (prod_head + cnt) & br->br_prod_mask;
+
+		if (single) {
+			br->br_prod_head = prod_next;
+			break;
+		}
+	} while (ukarch_compare_exchange_sync((uint32_t *) &br->br_prod_head,
+			prod_head, prod_next) != prod_next);
+
+	idx = prod_head;
+	for (i = 0; i < cnt; i++) {
+#ifdef DEBUG_BUFRING
+		if (br->br_ring[idx] != NULL)
+			UK_CRASH("dangling value in enqueue");
+#endif
+		br->br_ring[idx] = objs[i];
+		idx = (idx + 1) & br->br_prod_mask;
+	}
+
+	/* Publish in reservation order, see uk_ring_enqueue() */
+	if (!single)
+		while (br->br_prod_tail != prod_head)
+			ukarch_spinwait();
+	ukarch_store_n(&br->br_prod_tail, prod_next);
+	critical_exit();
+	return cnt;
+}
+
+static __inline unsigned int
+__uk_ring_do_dequeue(struct uk_ring *br, void **objs, unsigned int n,
+		     int burst, int single)
+{
+	uint32_t cons_head, cons_next, prod_tail, idx;
+	unsigned int avail, cnt, i;
+
+	if (unlikely(n == 0))
+		return 0;
+
+	critical_enter();
+	do {
+		cnt = n;
+		cons_head = br->br_cons_head;
+		prod_tail = ukarch_load_n(&br->br_prod_tail);
+		avail = (prod_tail - cons_head) & br->br_cons_mask;
+
+		if (cnt > avail) {
+			if (!burst || !avail) {
+				critical_exit();
+				return 0;
+			}
+			cnt = avail;
+		}
+		cons_next = (cons_head + cnt) & br->br_cons_mask;
+
+		if (single) {
+			br->br_cons_head = cons_next;
+			break;
+		}
+	} while (ukarch_compare_exchange_sync((uint32_t *) &br->br_cons_head,
+			cons_head, cons_next) != cons_next);
+
+	idx = cons_head;
+	for (i = 0; i < cnt; i++) {
+		objs[i] = br->br_ring[idx];
+#ifdef DEBUG_BUFRING
+		br->br_ring[idx] = NULL;
+#endif
+		idx = (idx + 1) & br->br_cons_mask;
+	}
+
+	if (!single)
+		while (br->br_cons_tail != cons_head)
+			ukarch_spinwait();
+	ukarch_store_n(&br->br_cons_tail, cons_next);
+	critical_exit();
+	return cnt;
+}
+
+/*
+ * multi-producer safe bulk enqueue
+ */
+static __inline unsigned int
+uk_ring_enqueue_bulk(struct uk_ring *br, void * const *objs, unsigned int n)
+{
+	return __uk_ring_do_enqueue(br, objs, n, 0, 0);
+}
+
+static __inline unsigned int
+uk_ring_enqueue_bulk_sp(struct uk_ring *br, void * const *objs,
+			unsigned int n)
+{
+	return __uk_ring_do_enqueue(br, objs, n, 0, 1);
+}
+
+/*
+ * multi-producer safe burst enqueue
+ */
+static __inline unsigned int
+uk_ring_enqueue_burst(struct uk_ring *br, void * const *objs, unsigned int n)
+{
+	return __uk_ring_do_enqueue(br, objs, n, 1, 0);
+}
+
+static __inline unsigned int
+uk_ring_enqueue_burst_sp(struct uk_ring *br, void * const *objs,
+			 unsigned int n)
+{
+	return __uk_ring_do_enqueue(br, objs, n, 1, 1);
+}
+
+/*
+ * multi-consumer safe bulk dequeue
+ */
+static __inline unsigned int
+uk_ring_dequeue_bulk_mc(struct uk_ring *br, void **objs, unsigned int n)
+{
+	return __uk_ring_do_dequeue(br, objs, n, 0, 0);
+}
+
+static __inline unsigned int
+uk_ring_dequeue_bulk_sc(struct uk_ring *br, void **objs, unsigned int n)
+{
+	return __uk_ring_do_dequeue(br, objs, n, 0, 1);
+}
+
+/*
+ * multi-consumer safe burst dequeue
+ */
+static __inline unsigned int
+uk_ring_dequeue_burst_mc(struct uk_ring *br, void **objs, unsigned int n)
+{
+	return __uk_ring_do_dequeue(br, objs, n, 1, 0);
+}
+
+static __inline unsigned int
+uk_ring_dequeue_burst_sc(struct uk_ring *br, void **objs, unsigned int n)
+{
+	return __uk_ring_do_dequeue(br, objs, n, 1, 1);
+}
+
+/* Like uk_ring_enqueue(), dequeues are multi-consumer safe by default */
+#define uk_ring_dequeue_bulk(br, objs, n)  uk_ring_dequeue_bulk_mc(br, objs, n)
+#define uk_ring_dequeue_burst(br, objs, n) uk_ring_dequeue_burst_mc(br, objs, n)
+
 static __inline int
 uk_ring_full(struct uk_ring *br)
 {
@@ -375,5 +560,26 @@ struct uk_ring *uk_ring_alloc(int count, struct uk_alloc *a
 );
 void uk_ring_free(struct uk_ring *br, struct uk_alloc *a);
 
+#if CONFIG_LIBUKRING_BENCH
+/**
+ * Passes `count` objects through a ring of 1024 slots on the calling CPU,
+ * one at a time and with each flavor of bulk and burst enqueue/dequeue in
+ * rounds of `burst` objects. Prints the time per object and the
+ * throughput of each flavor on the kernel console.
+ *
+ * @param a
+ *   Allocator for the ring
+ * @param count
+ *   Number of objects of each run
+ * @param burst
+ *   Number of objects per bulk or burst call, at most 256
+ * @return
+ *   - (0): on success
+ *   - (-ENOMEM): the ring could not be allocated
+ *   - (-EIO): objects were lost or reordered
+ */
+int uk_ring_bench(struct uk_alloc *a, unsigned int count, unsigned int burst);
+#endif
+
 #endif
 
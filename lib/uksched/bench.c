@@ -0,0 +1,222 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <uk/essentials.h>
+#include <uk/alloc.h>
+#include <uk/sched.h>
+#include <uk/sleepq.h>
+#include <uk/thread.h>
+#include <uk/print.h>
+#include <uk/xorshift.h>
+#include <uk/plat/time.h>
+
+static void bench_thread(void *arg __unused)
+{
+}
+
+__u64 uk_sched_bench_create_join(struct uk_sched *sched, unsigned int count)
+{
+	struct uk_thread *thread;
+	__nsec start, elapsed;
+	__u64 rate;
+	unsigned int i;
+
+	UK_ASSERT(sched);
+	UK_ASSERT(count > 0);
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < count; i++) {
+		thread = uk_sched_thread_create(sched, "bench", NULL,
+						bench_thread, NULL);
+		if (!thread) {
+			uk_pr_err("Failed to create benchmark thread %u\n", i);
+			return 0;
+		}
+		uk_thread_wait(thread);
+	}
+	elapsed = ukplat_monotonic_clock() - start;
+
+	rate = (__u64) count * ukarch_time_sec_to_nsec(1) / MAX(elapsed, (__nsec) 1);
+	uk_pr_info("Created and joined %u threads in %"__PRInsec" ns: %"
+		   __PRIu64" threads/s\n", count, elapsed, rate);
+	return rate;
+}
+
+static volatile int bench_stop;
+
+static void bench_sleeper(void *arg __unused)
+{
+	while (!bench_stop)
+		uk_sched_thread_sleep(ukarch_time_sec_to_nsec(3600));
+}
+
+static void bench_yielder(void *arg __unused)
+{
+	while (!bench_stop)
+		uk_sched_yield();
+}
+
+__nsec uk_sched_bench_yield(struct uk_sched *sched, unsigned int nb_sleepers,
+			    unsigned int count)
+{
+	struct uk_thread **sleepers;
+	struct uk_thread *yielder = NULL;
+	__nsec start, elapsed = 0;
+	unsigned int i, nb_created;
+
+	UK_ASSERT(sched);
+	UK_ASSERT(count > 0);
+
+	sleepers = uk_calloc(sched->allocator, MAX(nb_sleepers, 1U),
+			     sizeof(*sleepers));
+	if (!sleepers)
+		return 0;
+
+	bench_stop = 0;
+	for (nb_created = 0; nb_created < nb_sleepers; nb_created++) {
+		sleepers[nb_created] = uk_sched_thread_create(sched, "sleeper",
+							      NULL,
+							      bench_sleeper,
+							      NULL);
+		if (!sleepers[nb_created]) {
+			uk_pr_err("Failed to create sleeping thread %u\n",
+				  nb_created);
+			goto out;
+		}
+	}
+	yielder = uk_sched_thread_create(sched, "yielder", NULL,
+					 bench_yielder, NULL);
+	if (!yielder) {
+		uk_pr_err("Failed to create yielding thread\n");
+		goto out;
+	}
+
+	/* Let all sleepers go to sleep */
+	uk_sched_yield();
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < count; i++)
+		uk_sched_yield();
+	elapsed = (ukplat_monotonic_clock() - start) / count;
+
+	uk_pr_info("Yield round-trip with %u sleeping threads: %"__PRInsec
+		   " ns\n", nb_sleepers, elapsed);
+
+out:
+	bench_stop = 1;
+	if (yielder)
+		uk_thread_wait(yielder);
+	for (i = 0; i < nb_created; i++) {
+		uk_thread_wake(sleepers[i]);
+		uk_thread_wait(sleepers[i]);
+	}
+	uk_free(sched->allocator, sleepers);
+	return elapsed;
+}
+
+/* Pseudo-random sleep durations of up to 1ms */
+static inline __snsec bench_sleep_time(__u32 *state)
+{
+	return (uk_xorshift32(state) % 1000000) + 1;
+}
+
+int uk_sched_bench_sleepq(unsigned int nb_sleepers, unsigned int count)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	struct uk_thread_list list = UK_TAILQ_HEAD_INITIALIZER(list);
+	struct uk_thread *threads, *thread, *next;
+	struct uk_sleepq sq;
+	__nsec start, list_ns, heap_ns;
+	__snsec now;
+	__u32 seed;
+	unsigned int i;
+
+	UK_ASSERT(nb_sleepers > 0);
+	UK_ASSERT(count > 0);
+
+	/* Only the wakeup times and queue links of these threads are used */
+	threads = uk_calloc(a, nb_sleepers, sizeof(*threads));
+	if (!threads)
+		return -ENOMEM;
+	uk_sleepq_init(&sq);
+	if (uk_sleepq_reserve(&sq, a, nb_sleepers)) {
+		uk_free(a, threads);
+		return -ENOMEM;
+	}
+
+	/* List: every wakeup scans all sleepers for the earliest wakeup
+	 * time, like schedcoop did before sleeping threads were kept in
+	 * a heap
+	 */
+	seed = 0x2545f491;
+	for (i = 0; i < nb_sleepers; i++) {
+		threads[i].wakeup_time = bench_sleep_time(&seed);
+		UK_TAILQ_INSERT_TAIL(&list, &threads[i], thread_list);
+	}
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < count; i++) {
+		next = UK_TAILQ_FIRST(&list);
+		UK_TAILQ_FOREACH(thread, &list, thread_list) {
+			if (thread->wakeup_time < next->wakeup_time)
+				next = thread;
+		}
+		/* wake the thread and put it back to sleep */
+		now = next->wakeup_time;
+		next->wakeup_time = now + bench_sleep_time(&seed);
+	}
+	list_ns = (ukplat_monotonic_clock() - start) / count;
+
+	/* Heap: the same wakeups with the sleep queue of the schedulers */
+	seed = 0x2545f491;
+	for (i = 0; i < nb_sleepers; i++) {
+		threads[i].wakeup_time = bench_sleep_time(&seed);
+		uk_sleepq_add(&sq, &threads[i]);
+	}
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < count; i++) {
+		next = uk_sleepq_first(&sq);
+		uk_sleepq_remove(&sq, next);
+		now = next->wakeup_time;
+		next->wakeup_time = now + bench_sleep_time(&seed);
+		uk_sleepq_add(&sq, next);
+	}
+	heap_ns = (ukplat_monotonic_clock() - start) / count;
+
+	while ((thread = uk_sleepq_first(&sq)))
+		uk_sleepq_remove(&sq, thread);
+	uk_sleepq_fini(&sq, a);
+	uk_free(a, threads);
+
+	uk_pr_info("Wakeup with %u sleeping threads: list %"__PRInsec
+		   " ns, heap %"__PRInsec" ns\n",
+		   nb_sleepers, list_ns, heap_ns);
+	return 0;
+}
@@ -0,0 +1,624 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include <uk/fiber.h>
+#include <uk/wait.h>
+#include <uk/plat/config.h>
+#include <uk/plat/lcpu.h>
+#include <uk/plat/spinlock.h>
+#include <uk/plat/time.h>
+#include <uk/assert.h>
+#include <uk/print.h>
+
+/*
+ * Header at the start of each STACK_SIZE-aligned slab. `host` must be the
+ * first member: uk_thread_current() reads it from a fiber's stack.
+ */
+struct uk_fiber_slab {
+	struct uk_thread *host;
+	struct uk_fiber_slab *next;
+	void *chunk; /* allocation to free, set in the first slab of a chunk */
+};
+
+/* Slots of a slab, the first one holds the slab header */
+#define SLAB_SLOTS (STACK_SIZE / UK_FIBER_STACK_SIZE)
+
+/* Slabs are allocated in chunks that fit a power of two with the
+ * alignment overhead of uk_posix_memalign()
+ */
+#define CHUNK_SIZE  (1UL << 20)
+#define CHUNK_SLABS MAX((unsigned long) ((CHUNK_SIZE - __PAGE_SIZE) \
+					  / STACK_SIZE - 1), 1UL)
+
+#define SLEEP_HEAP_MIN_SIZE 64
+
+/* Written to the lowest word of a slot, which a stack overflow hits first */
+#define FIBER_CANARY 0x5ca1ab1ef1be4a11UL
+
+UK_CTASSERT(UK_FIBER_STACK_SIZE % 16 == 0);
+UK_CTASSERT(SLAB_SLOTS >= 2);
+
+/* Defined in arch/<arch>/fiber_ctx.S */
+void *uk_fiber_ctx_init(void *top, struct uk_fiber *fiber);
+void uk_fiber_ctx_switch(void **prev_sp, void *next_sp);
+
+/* The descriptor sits at the top of the slot, right above the stack */
+static inline struct uk_fiber *slot_to_fiber(void *slot)
+{
+	return (struct uk_fiber *) ((__uptr) slot + UK_FIBER_STACK_SIZE
+				    - ALIGN_UP(sizeof(struct uk_fiber), 16));
+}
+
+static inline void *fiber_to_slot(struct uk_fiber *fiber)
+{
+	return (void *) ((__uptr) fiber + ALIGN_UP(sizeof(struct uk_fiber), 16)
+			 - UK_FIBER_STACK_SIZE);
+}
+
+static inline void fiber_check_canary(struct uk_fiber *fiber)
+{
+	if (unlikely(*((unsigned long *) fiber_to_slot(fiber))
+		     != FIBER_CANARY))
+		UK_CRASH("Fiber %p overflowed its stack of %d bytes\n",
+			 fiber, UK_FIBER_STACK_SIZE);
+}
+
+#define heap_parent(idx) (((idx) - 1) / 2)
+#define heap_left(idx)   (2 * (idx) + 1)
+
+static inline void heap_set(struct uk_fiber_sched *fs, unsigned int idx,
+			    struct uk_fiber *fiber)
+{
+	fs->sleep_heap[idx] = fiber;
+	fiber->sleep_idx = idx;
+}
+
+static void heap_sift_up(struct uk_fiber_sched *fs, unsigned int idx)
+{
+	struct uk_fiber *fiber = fs->sleep_heap[idx];
+	struct uk_fiber *parent;
+
+	while (idx > 0) {
+		parent = fs->sleep_heap[heap_parent(idx)];
+		if (parent->wakeup_time <= fiber->wakeup_time)
+			break;
+		heap_set(fs, idx, parent);
+		idx = heap_parent(idx);
+	}
+	heap_set(fs, idx, fiber);
+}
+
+static void heap_sift_down(struct uk_fiber_sched *fs, unsigned int idx)
+{
+	struct uk_fiber *fiber = fs->sleep_heap[idx];
+	unsigned int child;
+
+	while ((child = heap_left(idx)) < fs->nr_sleeping) {
+		if (child + 1 < fs->nr_sleeping &&
+		    fs->sleep_heap[child + 1]->wakeup_time
+		    < fs->sleep_heap[child]->wakeup_time)
+			child++;
+		if (fiber->wakeup_time <= fs->sleep_heap[child]->wakeup_time)
+			break;
+		heap_set(fs, idx, fs->sleep_heap[child]);
+		idx = child;
+	}
+	heap_set(fs, idx, fiber);
+}
+
+static void sleep_add(struct uk_fiber_sched *fs, struct uk_fiber *fiber)
+{
+	UK_ASSERT(fs->nr_sleeping < fs->sleep_heap_size);
+
+	fs->sleep_heap[fs->nr_sleeping] = fiber;
+	heap_sift_up(fs, fs->nr_sleeping++);
+}
+
+static void sleep_remove(struct uk_fiber_sched *fs, struct uk_fiber *fiber)
+{
+	unsigned int idx = fiber->sleep_idx;
+	struct uk_fiber *last;
+
+	UK_ASSERT(idx < fs->nr_sleeping && fs->sleep_heap[idx] == fiber);
+
+	last = fs->sleep_heap[--fs->nr_sleeping];
+	if (idx == fs->nr_sleeping)
+		return;
+
+	heap_set(fs, idx, last);
+	if (idx > 0 &&
+	    fs->sleep_heap[heap_parent(idx)]->wakeup_time > last->wakeup_time)
+		heap_sift_up(fs, idx);
+	else
+		heap_sift_down(fs, idx);
+}
+
+/* Makes a blocked fiber runnable. Must be called with `fs->lock` held */
+static void fiber_make_runnable(struct uk_fiber_sched *fs,
+				struct uk_fiber *fiber)
+{
+	if (fiber->wakeup_time) {
+		sleep_remove(fs, fiber);
+		fiber->wakeup_time = 0;
+	}
+	fiber->flags |= UK_FIBER_RUNNABLE;
+	if (fiber != fs->current)
+		UK_TAILQ_INSERT_TAIL(&fs->runq, fiber, fiber_list);
+}
+
+/* Puts a slot of an exited fiber back. Must be called with `fs->lock`
+ * held
+ */
+static void fiber_release(struct uk_fiber_sched *fs, struct uk_fiber *fiber)
+{
+	void *slot = fiber_to_slot(fiber);
+
+	*((void **) slot) = fs->free_slots;
+	fs->free_slots = slot;
+	fs->nr_fibers--;
+}
+
+/* Releases the fibers that were joined or detached after they exited.
+ * Only the host does this, after it woke up the joiners. Must be called
+ * with `fs->lock` held
+ */
+static void fiber_reap(struct uk_fiber_sched *fs)
+{
+	struct uk_fiber *fiber;
+
+	while ((fiber = UK_TAILQ_FIRST(&fs->reap))) {
+		UK_TAILQ_REMOVE(&fs->reap, fiber, fiber_list);
+		fiber_release(fs, fiber);
+	}
+}
+
+/* Allocates a chunk of slabs and puts their slots on the free list */
+static int slots_grow(struct uk_fiber_sched *fs)
+{
+	struct uk_fiber_slab *slab, *first = NULL, *last = NULL;
+	unsigned long flags;
+	void *chunk, *slot, *free = NULL, *free_last = NULL;
+	unsigned int i, j;
+
+	if (uk_posix_memalign(fs->allocator, &chunk, STACK_SIZE,
+			      CHUNK_SLABS * STACK_SIZE) != 0)
+		return -ENOMEM;
+
+	for (i = 0; i < CHUNK_SLABS; i++) {
+		slab = (struct uk_fiber_slab *) ((__uptr) chunk
+						 + i * STACK_SIZE);
+		slab->chunk = i ? NULL : chunk;
+		slab->next = first;
+		first = slab;
+		if (!last)
+			last = slab;
+		for (j = 1; j < SLAB_SLOTS; j++) {
+			slot = (void *) ((__uptr) slab
+					 + j * UK_FIBER_STACK_SIZE);
+			*((void **) slot) = free;
+			free = slot;
+			if (!free_last)
+				free_last = slot;
+		}
+	}
+
+	flags = ukplat_lcpu_save_irqf();
+	ukarch_spin_lock(&fs->lock);
+	for (slab = first; slab; slab = slab->next)
+		slab->host = fs->host;
+	last->next = fs->slabs;
+	fs->slabs = first;
+	*((void **) free_last) = fs->free_slots;
+	fs->free_slots = free;
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+	return 0;
+}
+
+/* Makes sure that every fiber fits into the sleep heap */
+static int sleep_heap_reserve(struct uk_fiber_sched *fs, unsigned int nr)
+{
+	struct uk_fiber **heap, **old;
+	unsigned long flags;
+	unsigned int size;
+
+	if (likely(nr <= fs->sleep_heap_size))
+		return 0;
+
+	size = MAX(fs->sleep_heap_size, (unsigned int) SLEEP_HEAP_MIN_SIZE);
+	while (size < nr)
+		size *= 2;
+
+	heap = uk_malloc(fs->allocator, size * sizeof(*heap));
+	if (!heap)
+		return -ENOMEM;
+
+	flags = ukplat_lcpu_save_irqf();
+	ukarch_spin_lock(&fs->lock);
+	if (size <= fs->sleep_heap_size) {
+		/* Somebody else grew it meanwhile */
+		old = heap;
+	} else {
+		if (fs->nr_sleeping)
+			memcpy(heap, fs->sleep_heap,
+			       fs->nr_sleeping * sizeof(*heap));
+		old = fs->sleep_heap;
+		fs->sleep_heap = heap;
+		fs->sleep_heap_size = size;
+	}
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+
+	if (old)
+		uk_free(fs->allocator, old);
+	return 0;
+}
+
+void uk_fiber_sched_init(struct uk_fiber_sched *fs, struct uk_alloc *a)
+{
+	UK_ASSERT(fs);
+	UK_ASSERT(a);
+
+	fs->allocator = a;
+	fs->host = NULL;
+	fs->current = NULL;
+	fs->host_sp = NULL;
+	UK_TAILQ_INIT(&fs->runq);
+	UK_TAILQ_INIT(&fs->reap);
+	fs->sleep_heap = NULL;
+	fs->nr_sleeping = 0;
+	fs->sleep_heap_size = 0;
+	fs->nr_fibers = 0;
+	fs->nr_live = 0;
+	fs->idle = false;
+	fs->free_slots = NULL;
+	fs->slabs = NULL;
+	ukarch_spin_lock_init(&fs->lock);
+}
+
+void uk_fiber_sched_fini(struct uk_fiber_sched *fs)
+{
+	struct uk_fiber_slab *slab, *next;
+
+	UK_ASSERT(fs);
+	UK_ASSERT(!fs->host);
+
+	fiber_reap(fs);
+	UK_ASSERT(fs->nr_fibers == 0);
+
+	/* Free chunks only after walking their slabs */
+	for (slab = fs->slabs, next = NULL; slab; slab = slab->next) {
+		if (slab->chunk) {
+			slab->chunk = next;
+			next = slab;
+		}
+	}
+	for (slab = next; slab; slab = next) {
+		next = slab->chunk;
+		uk_free(fs->allocator, slab);
+	}
+	if (fs->sleep_heap)
+		uk_free(fs->allocator, fs->sleep_heap);
+	uk_fiber_sched_init(fs, fs->allocator);
+}
+
+struct uk_fiber *uk_fiber_create(struct uk_fiber_sched *fs,
+				 void (*function)(void *), void *arg)
+{
+	struct uk_fiber *fiber;
+	unsigned long flags;
+	void *slot;
+
+	UK_ASSERT(fs);
+	UK_ASSERT(function);
+
+	/* Every fiber may sleep: make room now so that blocking never
+	 * needs to allocate memory
+	 */
+	if (sleep_heap_reserve(fs, fs->nr_fibers + 1))
+		return NULL;
+
+	for (;;) {
+		flags = ukplat_lcpu_save_irqf();
+		ukarch_spin_lock(&fs->lock);
+		slot = fs->free_slots;
+		if (slot)
+			break;
+		ukarch_spin_unlock(&fs->lock);
+		ukplat_lcpu_restore_irqf(flags);
+		if (slots_grow(fs)) {
+			uk_pr_err("Failed to allocate fiber stacks\n");
+			return NULL;
+		}
+	}
+	fs->free_slots = *((void **) slot);
+	fs->nr_fibers++;
+	fs->nr_live++;
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+
+	/* Overwrites the free list link */
+	*((unsigned long *) slot) = FIBER_CANARY;
+	fiber = slot_to_fiber(slot);
+	fiber->fs = fs;
+	fiber->entry = function;
+	fiber->arg = arg;
+	fiber->flags = 0;
+	fiber->detached = false;
+	fiber->wakeup_time = 0;
+	uk_waitq_init(&fiber->joiners);
+	fiber->sp = uk_fiber_ctx_init(fiber, fiber);
+
+	flags = ukplat_lcpu_save_irqf();
+	ukarch_spin_lock(&fs->lock);
+	fiber_make_runnable(fs, fiber);
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+
+	/* The scheduler may sleep because all of its fibers block */
+	uk_fiber_wake(fiber);
+	return fiber;
+}
+
+void uk_fiber_wait(struct uk_fiber *fiber)
+{
+	struct uk_fiber_sched *fs;
+	unsigned long flags;
+
+	UK_ASSERT(fiber);
+	UK_ASSERT(!fiber->detached);
+
+	fs = fiber->fs;
+	UK_ASSERT(uk_thread_current() != fs->host || fs->current);
+
+	uk_waitq_wait_event(&fiber->joiners,
+			    __atomic_load_n(&fiber->flags, __ATOMIC_ACQUIRE)
+			    & UK_FIBER_EXITED);
+
+	flags = ukplat_lcpu_save_irqf();
+	ukarch_spin_lock(&fs->lock);
+	UK_TAILQ_INSERT_TAIL(&fs->reap, fiber, fiber_list);
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+}
+
+void uk_fiber_detach(struct uk_fiber *fiber)
+{
+	struct uk_fiber_sched *fs;
+	unsigned long flags;
+
+	UK_ASSERT(fiber);
+
+	fs = fiber->fs;
+	flags = ukplat_lcpu_save_irqf();
+	ukarch_spin_lock(&fs->lock);
+	fiber->detached = true;
+	if (fiber->flags & UK_FIBER_EXITED)
+		UK_TAILQ_INSERT_TAIL(&fs->reap, fiber, fiber_list);
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+}
+
+void uk_fiber_exit(void)
+{
+	struct uk_fiber *fiber = uk_fiber_current();
+	struct uk_fiber_sched *fs;
+	unsigned long flags;
+
+	UK_ASSERT(fiber);
+
+	fs = fiber->fs;
+	flags = ukplat_lcpu_save_irqf();
+	ukarch_spin_lock(&fs->lock);
+	fiber->flags &= ~UK_FIBER_RUNNABLE;
+	fiber->flags |= UK_FIBER_EXITING;
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+
+	uk_fiber_ctx_switch(&fiber->sp, fs->host_sp);
+	UK_CRASH("Exited fiber %p was resumed\n", fiber);
+}
+
+/* Entered from uk_fiber_ctx_init()'s frame on the first switch */
+void uk_fiber_main(struct uk_fiber *fiber) __noreturn;
+
+void uk_fiber_main(struct uk_fiber *fiber)
+{
+	fiber->entry(fiber->arg);
+	uk_fiber_exit();
+}
+
+void uk_fiber_yield(void)
+{
+	struct uk_fiber *fiber = uk_fiber_current();
+
+	UK_ASSERT(fiber);
+
+	uk_fiber_ctx_switch(&fiber->sp, fiber->fs->host_sp);
+}
+
+void uk_fiber_block_until(struct uk_fiber *fiber, __snsec until)
+{
+	struct uk_fiber_sched *fs;
+	unsigned long flags;
+
+	UK_ASSERT(fiber);
+
+	fs = fiber->fs;
+	UK_ASSERT(fiber == fs->current);
+
+	flags = ukplat_lcpu_save_irqf();
+	ukarch_spin_lock(&fs->lock);
+	fiber->flags &= ~UK_FIBER_RUNNABLE;
+	if (fiber->wakeup_time)
+		sleep_remove(fs, fiber);
+	fiber->wakeup_time = until;
+	if (until)
+		sleep_add(fs, fiber);
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+}
+
+void uk_fiber_wake(struct uk_fiber *fiber)
+{
+	struct uk_thread *host = NULL;
+	struct uk_fiber_sched *fs;
+	unsigned long flags;
+
+	UK_ASSERT(fiber);
+
+	fs = fiber->fs;
+	flags = ukplat_lcpu_save_irqf();
+	ukarch_spin_lock(&fs->lock);
+	if (!(fiber->flags & (UK_FIBER_RUNNABLE | UK_FIBER_EXITING)))
+		fiber_make_runnable(fs, fiber);
+	if (fs->idle && (fiber->flags & UK_FIBER_RUNNABLE)) {
+		fs->idle = false;
+		host = fs->host;
+	}
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+
+	if (host)
+		uk_thread_wake(host);
+}
+
+void uk_fiber_sleep(__nsec nsec)
+{
+	struct uk_fiber *fiber = uk_fiber_current();
+
+	UK_ASSERT(fiber);
+
+	uk_fiber_block_until(fiber, ukplat_monotonic_clock() + nsec);
+	uk_fiber_yield();
+}
+
+/* Makes fibers whose timeout expired runnable. Must be called with
+ * `fs->lock` held
+ */
+static void wake_expired(struct uk_fiber_sched *fs)
+{
+	__snsec now = ukplat_monotonic_clock();
+	struct uk_fiber *fiber;
+
+	while (fs->nr_sleeping) {
+		fiber = fs->sleep_heap[0];
+		if (fiber->wakeup_time > now)
+			break;
+		fiber_make_runnable(fs, fiber);
+	}
+}
+
+void uk_fiber_sched_run(struct uk_fiber_sched *fs)
+{
+	struct uk_thread *current = uk_thread_current();
+	struct uk_fiber_slab *slab;
+	struct uk_fiber *fiber;
+	unsigned long flags;
+	bool joinable;
+
+	UK_ASSERT(fs);
+	UK_ASSERT(!current->fibers);
+
+	flags = ukplat_lcpu_save_irqf();
+	ukarch_spin_lock(&fs->lock);
+	UK_ASSERT(!fs->host);
+	fs->host = current;
+	for (slab = fs->slabs; slab; slab = slab->next)
+		slab->host = current;
+	current->fibers = fs;
+
+	for (;;) {
+		fiber_reap(fs);
+		if (fs->nr_sleeping)
+			wake_expired(fs);
+
+		fiber = UK_TAILQ_FIRST(&fs->runq);
+		if (fiber) {
+			UK_TAILQ_REMOVE(&fs->runq, fiber, fiber_list);
+			fs->current = fiber;
+			ukarch_spin_unlock(&fs->lock);
+			ukplat_lcpu_restore_irqf(flags);
+
+			uk_fiber_ctx_switch(&fs->host_sp, fiber->sp);
+			fiber_check_canary(fiber);
+
+			flags = ukplat_lcpu_save_irqf();
+			ukarch_spin_lock(&fs->lock);
+			fs->current = NULL;
+			if (fiber->flags & UK_FIBER_RUNNABLE) {
+				UK_TAILQ_INSERT_TAIL(&fs->runq, fiber,
+						     fiber_list);
+			} else if (fiber->flags & UK_FIBER_EXITING) {
+				/* Off its stack now, can be released */
+				fs->nr_live--;
+				__atomic_or_fetch(&fiber->flags,
+						  UK_FIBER_EXITED,
+						  __ATOMIC_RELEASE);
+				joinable = !fiber->detached;
+				if (!joinable)
+					fiber_release(fs, fiber);
+				ukarch_spin_unlock(&fs->lock);
+				ukplat_lcpu_restore_irqf(flags);
+
+				if (joinable)
+					uk_waitq_wake_up(&fiber->joiners);
+
+				flags = ukplat_lcpu_save_irqf();
+				ukarch_spin_lock(&fs->lock);
+			}
+			continue;
+		}
+
+		if (!fs->nr_live)
+			break;
+
+		/* All fibers block: sleep until one is woken up or its
+		 * timeout expires
+		 */
+		fs->idle = true;
+		uk_thread_block_until(current, fs->nr_sleeping
+				      ? fs->sleep_heap[0]->wakeup_time : 0);
+		ukarch_spin_unlock(&fs->lock);
+		ukplat_lcpu_restore_irqf(flags);
+
+		uk_sched_yield();
+
+		flags = ukplat_lcpu_save_irqf();
+		ukarch_spin_lock(&fs->lock);
+		fs->idle = false;
+	}
+
+	current->fibers = NULL;
+	fs->host = NULL;
+	ukarch_spin_unlock(&fs->lock);
+	ukplat_lcpu_restore_irqf(flags);
+}
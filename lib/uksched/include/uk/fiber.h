@@ -0,0 +1,182 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UK_SCHED_FIBER_H__
+#define __UK_SCHED_FIBER_H__
+
+#include <uk/config.h>
+
+#if CONFIG_LIBUKSCHED_FIBER
+#include <stdbool.h>
+#include <uk/alloc.h>
+#include <uk/arch/spinlock.h>
+#include <uk/arch/time.h>
+#include <uk/list.h>
+#include <uk/thread.h>
+#include <uk/wait_types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fibers are lightweight tasks that run on top of a thread, the host of a
+ * fiber scheduler. The fibers of a scheduler never run concurrently; they
+ * switch cooperatively with uk_fiber_yield() or when they wait on a wait
+ * queue with uk_waitq_wait_event() and friends, which block the calling
+ * fiber only.
+ *
+ * A fiber and its descriptor share one small stack slot. Slots are carved
+ * out of STACK_SIZE-aligned slabs whose first word points to the host
+ * thread, so uk_thread_current() returns the host within a fiber. Fibers
+ * therefore share the TLS and the identity of their host. Primitives that
+ * block the current thread block the host with all its fibers, unless
+ * they wait through uk_waitq_entry_block(), like uk_mutex, uk_semaphore
+ * and uk_condvar.
+ *
+ * Slots have no guard page. A canary at the bottom of each slot is checked
+ * whenever a fiber switches back to its host, so that an overflow crashes
+ * there. Large stack frames that skip over the canary are not detected.
+ * Interrupts that arrive while a fiber runs use the fiber stack on
+ * platforms without a separate interrupt stack, which is the case on KVM
+ * x86_64 with a preemptive scheduler (HAVE_PREEMPT). A preemptive thread
+ * switch then also saves the interrupted context on the fiber stack.
+ */
+
+#define UK_FIBER_STACK_SIZE CONFIG_LIBUKSCHED_FIBER_STACK_SIZE
+
+#define UK_FIBER_RUNNABLE 0x01
+#define UK_FIBER_EXITING  0x02 /* returned, still on its stack */
+#define UK_FIBER_EXITED   0x04 /* switched away for good */
+
+struct uk_fiber_sched;
+
+struct uk_fiber {
+	void *sp; /* saved while the fiber is switched out */
+	struct uk_fiber_sched *fs;
+	void (*entry)(void *);
+	void *arg;
+	uint32_t flags;
+	bool detached;
+	__snsec wakeup_time;
+	unsigned int sleep_idx; /* position in the scheduler's sleep heap */
+	struct uk_waitq joiners;
+	UK_TAILQ_ENTRY(struct uk_fiber) fiber_list;
+};
+
+UK_TAILQ_HEAD(uk_fiber_list, struct uk_fiber);
+
+struct uk_fiber_slab;
+
+struct uk_fiber_sched {
+	struct uk_alloc *allocator;
+	struct uk_thread *host;
+	struct uk_fiber *current;
+	void *host_sp;
+	struct uk_fiber_list runq;
+	struct uk_fiber_list reap; /* exited and joined or detached */
+	struct uk_fiber **sleep_heap;
+	unsigned int nr_sleeping;
+	unsigned int sleep_heap_size;
+	unsigned int nr_fibers; /* including exited ones not joined yet */
+	unsigned int nr_live;
+	bool idle; /* host is blocked until a fiber becomes runnable */
+	void *free_slots;
+	struct uk_fiber_slab *slabs;
+	spinlock_t lock; /* protects all of the above, taken with IRQs off */
+};
+
+/**
+ * Initializes a fiber scheduler. It runs when a thread calls
+ * uk_fiber_sched_run().
+ *
+ * @param fs
+ *  Fiber scheduler.
+ * @param a
+ *  Allocator for fiber stacks.
+ */
+void uk_fiber_sched_init(struct uk_fiber_sched *fs, struct uk_alloc *a);
+
+/**
+ * Releases the memory of a fiber scheduler whose fibers were all joined or
+ * detached.
+ */
+void uk_fiber_sched_fini(struct uk_fiber_sched *fs);
+
+/**
+ * Runs the fibers of `fs` on the calling thread until all of them exited.
+ * The thread blocks while all fibers are blocked.
+ */
+void uk_fiber_sched_run(struct uk_fiber_sched *fs);
+
+/**
+ * Creates a runnable fiber. Can be called from any thread or fiber.
+ *
+ * @return
+ *  The new fiber, or NULL if there is not enough memory.
+ */
+struct uk_fiber *uk_fiber_create(struct uk_fiber_sched *fs,
+				 void (*function)(void *), void *arg);
+
+/**
+ * Waits until `fiber` exited. Its slot is released by the host thread,
+ * which may still be waking up the joiners. Must not be called by the
+ * host thread of the fiber's scheduler.
+ */
+void uk_fiber_wait(struct uk_fiber *fiber);
+
+/**
+ * Lets `fiber` be released as soon as it exits.
+ */
+void uk_fiber_detach(struct uk_fiber *fiber);
+
+/* Ends the current fiber, like returning from its function */
+void uk_fiber_exit(void) __noreturn;
+
+void uk_fiber_yield(void);
+void uk_fiber_block_until(struct uk_fiber *fiber, __snsec until);
+void uk_fiber_wake(struct uk_fiber *fiber);
+void uk_fiber_sleep(__nsec nsec);
+
+/* Returns the running fiber, NULL outside of fibers */
+static inline struct uk_fiber *uk_fiber_current(void)
+{
+	struct uk_fiber_sched *fs = uk_thread_current()->fibers;
+
+	return fs ? fs->current : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_LIBUKSCHED_FIBER */
+
+#endif /* __UK_SCHED_FIBER_H__ */
@@ -96,6 +96,15 @@ struct uk_sched {
 	bool threads_started;
 	struct uk_thread idle;
 	struct uk_thread_list exited_threads;
+	spinlock_t exited_lock; /* protects exited_threads */
+	struct uk_thread_list thread_cache; /* released, with stack and TLS */
+	unsigned int thread_cache_len;
+	spinlock_t cache_lock; /* protects thread_cache, not taken from irqs */
+#if CONFIG_LIBUKSCHED_STATS
+	struct uk_thread_list threads; /* all threads, for statistics */
+	spinlock_t threads_lock; /* protects threads */
+	__nsec stats_dumped; /* time of the previous statistics dump */
+#endif
 	struct ukplat_ctx_callbacks plat_ctx_cbs;
 	struct uk_alloc *allocator;
 	struct uk_sched *next;
@@ -124,9 +133,11 @@ static inline int uk_sched_thread_add(struct uk_sched *s,
 	UK_ASSERT(t);
 	if (attr)
 		t->detached = attr->detached;
+	/* The thread may run on another logical CPU as soon as it is added */
+	t->sched = s;
 	rc = s->thread_add(s, t, attr);
-	if (rc == 0)
-		t->sched = s;
+	if (rc)
+		t->sched = NULL;
 	return rc;
 }
 
@@ -207,6 +218,14 @@ struct uk_sched *uk_sched_create(struct uk_alloc *a, size_t prv_size);
 void uk_sched_idle_init(struct uk_sched *sched,
 		void *stack, void (*function)(void *));
 
+/**
+ * Initializes an idle thread that is not the scheduler's default one,
+ * e.g., for a secondary logical CPU. The thread is not added to the
+ * scheduler; it is meant to be started with ukplat_thread_ctx_start().
+ */
+int uk_sched_idle_thread_init(struct uk_sched *sched, struct uk_thread *idle,
+		void *stack, void (*function)(void *), void *arg);
+
 static inline struct uk_thread *uk_sched_get_idle(struct uk_sched *s)
 {
 	UK_ASSERT(s);
@@ -255,11 +274,41 @@ void uk_sched_thread_destroy(struct uk_sched *sched,
 void uk_sched_thread_kill(struct uk_sched *sched,
 		struct uk_thread *thread);
 
+/* Queues an exited thread until it gets destroyed */
+void uk_sched_thread_exited(struct uk_sched *sched,
+		struct uk_thread *thread);
+
+/* Destroys exited, detached threads that are no longer running */
+void uk_sched_thread_destroy_exited(struct uk_sched *sched);
+
+/*
+ * Must be called by `current` right after it got switched to: only then
+ * the context of the thread it was switched from can be reused by another
+ * logical CPU or be released.
+ */
+static inline
+void uk_sched_thread_switch_finish(struct uk_thread *current)
+{
+	struct uk_thread *from = current->switched_from;
+
+	if (from) {
+		current->switched_from = NULL;
+		__atomic_store_n(&from->running, 0, __ATOMIC_RELEASE);
+	}
+}
+
+/*
+ * The scheduler sets `next->running` before the switch; `prev->running`
+ * is cleared by `next` as soon as `prev`'s context has been saved.
+ */
 static inline
 void uk_sched_thread_switch(struct uk_sched *sched,
 		struct uk_thread *prev, struct uk_thread *next)
 {
+	uk_thread_stats_switch(prev, next);
+	next->switched_from = prev;
 	ukplat_thread_ctx_switch(&sched->plat_ctx_cbs, prev->ctx, next->ctx);
+	uk_sched_thread_switch_finish(prev);
 }
 
 /*
@@ -269,6 +318,86 @@ void uk_sched_thread_switch(struct uk_sched *sched,
 void uk_sched_thread_sleep(__nsec nsec);
 void uk_sched_thread_exit(void) __noreturn;
 
+#if CONFIG_LIBUKSCHED_STATS
+void uk_sched_stats_thread_add(struct uk_sched *sched,
+		struct uk_thread *thread);
+void uk_sched_stats_thread_remove(struct uk_sched *sched,
+		struct uk_thread *thread);
+
+/**
+ * Prints a table with the scheduling statistics of all threads of a
+ * scheduler on the kernel console. The CPU usage column covers the time
+ * since the previous dump, or since the scheduler was created. Allocates
+ * a buffer for the table from the allocator of the scheduler, so it must
+ * be called in thread context.
+ *
+ * @param sched
+ *   Scheduler to dump
+ */
+void uk_sched_stats_dump(struct uk_sched *sched);
+#else
+static inline void uk_sched_stats_thread_add(struct uk_sched *sched __unused,
+		struct uk_thread *thread __unused)
+{}
+static inline void uk_sched_stats_thread_remove(
+		struct uk_sched *sched __unused,
+		struct uk_thread *thread __unused)
+{}
+#endif
+
+#if CONFIG_LIBUKSCHED_BENCH
+/**
+ * Creates `count` threads on a scheduler one after the other and joins
+ * each of them before creating the next one. Prints the rate on the
+ * kernel console.
+ *
+ * @param sched
+ *   Scheduler to create the threads on
+ * @param count
+ *   Number of threads to create and join
+ * @return
+ *   - (>0): threads created and joined per second
+ *   - (0): a thread could not be created
+ */
+__u64 uk_sched_bench_create_join(struct uk_sched *sched, unsigned int count);
+
+/**
+ * Puts `nb_sleepers` threads to sleep for an hour and measures the
+ * round-trip of `count` yields between the calling thread and another
+ * runnable thread. Shows how the cost of a context switch depends on the
+ * number of sleeping threads. Prints the result on the kernel console.
+ *
+ * @param sched
+ *   Scheduler of the calling thread
+ * @param nb_sleepers
+ *   Number of sleeping threads to create
+ * @param count
+ *   Number of yields to measure
+ * @return
+ *   - (>0): average yield round-trip in nanoseconds
+ *   - (0): a thread could not be created
+ */
+__nsec uk_sched_bench_yield(struct uk_sched *sched, unsigned int nb_sleepers,
+			    unsigned int count);
+
+/**
+ * Measures `count` wakeups of the earliest of `nb_sleepers` sleeping
+ * threads when the sleepers are kept in a list that is scanned on every
+ * wakeup, and when they are kept in a `struct uk_sleepq`. Each woken
+ * thread is put back to sleep. No scheduler is involved. Prints the
+ * average cost per wakeup of both on the kernel console.
+ *
+ * @param nb_sleepers
+ *   Number of sleeping threads
+ * @param count
+ *   Number of wakeups to measure
+ * @return
+ *   - (0): on success
+ *   - (-ENOMEM): could not allocate the threads or the sleep queue
+ */
+int uk_sched_bench_sleepq(unsigned int nb_sleepers, unsigned int count);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
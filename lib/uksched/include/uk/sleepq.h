@@ -0,0 +1,115 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UK_SCHED_SLEEPQ_H__
+#define __UK_SCHED_SLEEPQ_H__
+
+#include <stdbool.h>
+#include <uk/alloc.h>
+#include <uk/thread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Queue of sleeping threads ordered by `wakeup_time`, to be used by
+ * scheduler implementations. The queue is a binary min-heap: the thread
+ * with the earliest wakeup time is found in O(1), adding and removing
+ * threads costs O(log n). Each queued thread stores its heap position in
+ * `sleepq_idx` so that threads woken before their timeout expires can be
+ * removed without a search.
+ *
+ * Adding and removing threads does not allocate memory, so it can be done
+ * with interrupts disabled. The scheduler has to reserve a slot for every
+ * thread that may sleep beforehand (e.g., when a thread is added).
+ * The caller is responsible for serializing access to the queue.
+ */
+struct uk_sleepq {
+	struct uk_thread **heap;
+	unsigned int count;
+	unsigned int size;
+};
+
+static inline void uk_sleepq_init(struct uk_sleepq *sq)
+{
+	sq->heap  = NULL;
+	sq->count = 0;
+	sq->size  = 0;
+}
+
+/**
+ * Makes sure that the queue can hold at least `nb_threads` threads.
+ *
+ * @param sq
+ *  Sleep queue.
+ * @param a
+ *  Allocator used for the heap array.
+ * @param nb_threads
+ *  Number of threads the queue must be able to hold.
+ * @return
+ *  - (0): On success.
+ *  - (-ENOMEM): Could not grow the queue.
+ */
+int uk_sleepq_reserve(struct uk_sleepq *sq, struct uk_alloc *a,
+		      unsigned int nb_threads);
+
+/**
+ * Releases the memory of a sleep queue.
+ */
+void uk_sleepq_fini(struct uk_sleepq *sq, struct uk_alloc *a);
+
+/**
+ * Adds a thread to the queue, ordered by its `wakeup_time`.
+ * A slot must have been reserved with uk_sleepq_reserve().
+ */
+void uk_sleepq_add(struct uk_sleepq *sq, struct uk_thread *thread);
+
+/**
+ * Removes a queued thread from the queue.
+ */
+void uk_sleepq_remove(struct uk_sleepq *sq, struct uk_thread *thread);
+
+static inline bool uk_sleepq_empty(const struct uk_sleepq *sq)
+{
+	return sq->count == 0;
+}
+
+/* Returns the thread with the earliest wakeup time, NULL if empty */
+static inline struct uk_thread *uk_sleepq_first(const struct uk_sleepq *sq)
+{
+	return sq->count ? sq->heap[0] : NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_SCHED_SLEEPQ_H__ */
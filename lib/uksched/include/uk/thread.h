@@ -35,6 +35,7 @@
 #endif
 #include <uk/alloc.h>
 #include <uk/arch/lcpu.h>
+#include <uk/arch/spinlock.h>
 #include <uk/arch/time.h>
 #include <uk/plat/thread.h>
 #if CONFIG_LIBUKSIGNAL
@@ -51,6 +52,24 @@ extern "C" {
 #endif
 
 struct uk_sched;
+#if CONFIG_LIBUKSCHED_FIBER
+struct uk_fiber_sched;
+#endif
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+struct uk_allocslab_tcache;
+#endif
+
+#if CONFIG_LIBUKSCHED_STATS
+/* Scheduling statistics of a thread, times are in nanoseconds */
+struct uk_thread_stats {
+	__nsec run_time;        /* running on a logical CPU */
+	__nsec wait_time;       /* runnable, waiting for a logical CPU */
+	__nsec block_time;      /* blocked or sleeping */
+	unsigned long switches; /* number of times switched out */
+	__nsec since;           /* start of the current state */
+	__nsec dumped_run_time; /* run_time at the previous dump */
+};
+#endif
 
 struct uk_thread {
 	const char *name;
@@ -59,7 +78,12 @@ struct uk_thread {
 	void *ctx;
 	UK_TAILQ_ENTRY(struct uk_thread) thread_list;
 	uint32_t flags;
+	spinlock_t sched_lock; /* serializes block/wake/scheduling decisions */
+	int running; /* context is in use by a logical CPU */
+	__u8 lcpu; /* logical CPU the thread runs or last ran on */
+	struct uk_thread *switched_from; /* set across a context switch */
 	__snsec wakeup_time;
+	unsigned int sleepq_idx; /* position in scheduler's sleep queue */
 	bool detached;
 	struct uk_waitq waiting_threads;
 	struct uk_sched *sched;
@@ -73,6 +97,25 @@ struct uk_thread {
 	/* TODO: Move to `TLS` and define within uksignal */
 	struct uk_thread_sig signals_container;
 #endif
+#if CONFIG_LIBUKALLOCSLAB_TCACHE
+	/* TODO: Move to `TLS` and define within ukallocslab */
+	struct uk_allocslab_tcache *slab_tcache;
+#endif
+#if CONFIG_LIBUKSCHED_FIBER
+	struct uk_fiber_sched *fibers; /* fiber scheduler run by the thread */
+#endif
+#if CONFIG_LIBUKSCHED_STATS
+	struct uk_thread_stats stats;
+	UK_TAILQ_ENTRY(struct uk_thread) stats_list; /* threads of `sched` */
+#endif
+#if CONFIG_LIBUKSCHEDPRIO
+	/* TODO: Move to scheduler private thread data */
+	prio_t prio;
+	__nsec timeslice;
+	__nsec slice_left; /* rest of a preempted time slice */
+	bool in_sched; /* thread is switching, must not be preempted */
+	unsigned long preempt_count; /* uk_preempt_count while switched out */
+#endif
 };
 
 UK_TAILQ_HEAD(uk_thread_list, struct uk_thread);
@@ -109,6 +152,7 @@ struct uk_thread *uk_thread_current(void)
 #define RUNNABLE_FLAG   0x00000001
 #define EXITED_FLAG     0x00000002
 #define QUEUEABLE_FLAG  0x00000004
+#define QUEUED_FLAG     0x00000008
 
 #define is_runnable(_thread)    ((_thread)->flags &   RUNNABLE_FLAG)
 #define set_runnable(_thread)   ((_thread)->flags |=  RUNNABLE_FLAG)
@@ -121,16 +165,39 @@ struct uk_thread *uk_thread_current(void)
 #define set_queueable(_thread)   ((_thread)->flags |=  QUEUEABLE_FLAG)
 #define clear_queueable(_thread) ((_thread)->flags &= ~QUEUEABLE_FLAG)
 
+#define is_queued(_thread)       ((_thread)->flags &   QUEUED_FLAG)
+#define set_queued(_thread)      ((_thread)->flags |=  QUEUED_FLAG)
+#define clear_queued(_thread)    ((_thread)->flags &= ~QUEUED_FLAG)
+
 int uk_thread_init(struct uk_thread *thread,
 		struct ukplat_ctx_callbacks *cbs, struct uk_alloc *allocator,
 		const char *name, void *stack, void *tls,
 		void (*function)(void *), void *arg);
 void uk_thread_fini(struct uk_thread *thread,
 		struct uk_alloc *allocator);
+void uk_thread_block_until(struct uk_thread *thread, __snsec until);
 void uk_thread_block_timeout(struct uk_thread *thread, __nsec nsec);
 void uk_thread_block(struct uk_thread *thread);
 void uk_thread_wake(struct uk_thread *thread);
 
+#if CONFIG_LIBUKSCHED_STATS
+/* Called by the schedulers on state changes of threads: before switching
+ * from `prev` to `next`, and with the thread's sched_lock held when a
+ * thread blocks or a blocked thread becomes runnable again
+ */
+void uk_thread_stats_switch(struct uk_thread *prev, struct uk_thread *next);
+void uk_thread_stats_blocked(struct uk_thread *thread);
+void uk_thread_stats_woken(struct uk_thread *thread);
+#else
+static inline void uk_thread_stats_switch(struct uk_thread *prev __unused,
+					  struct uk_thread *next __unused)
+{}
+static inline void uk_thread_stats_blocked(struct uk_thread *thread __unused)
+{}
+static inline void uk_thread_stats_woken(struct uk_thread *thread __unused)
+{}
+#endif
+
 /**
  * Registers a thread initialization function that is
  * called during thread creation
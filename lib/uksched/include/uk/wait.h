@@ -27,9 +27,13 @@
 #define __UK_SCHED_WAIT_H__
 
 #include <uk/plat/lcpu.h>
+#include <uk/plat/spinlock.h>
 #include <uk/plat/time.h>
 #include <uk/sched.h>
 #include <uk/wait_types.h>
+#if CONFIG_LIBUKSCHED_FIBER
+#include <uk/fiber.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,7 +42,8 @@ extern "C" {
 static inline
 void uk_waitq_init(struct uk_waitq *wq)
 {
-	UK_STAILQ_INIT(wq);
+	UK_STAILQ_INIT(&wq->list);
+	ukarch_spin_lock_init(&wq->sl);
 }
 
 static inline
@@ -47,30 +52,104 @@ void uk_waitq_entry_init(struct uk_waitq_entry *entry,
 {
 	entry->thread = thread;
 	entry->waiting = 0;
+	entry->flags = 0;
+#if CONFIG_LIBUKSCHED_FIBER
+	entry->fiber = NULL;
+#endif
+}
+
+/* Initializes `entry` for the caller: the running fiber within a fiber,
+ * the current thread otherwise
+ */
+static inline
+void uk_waitq_entry_init_self(struct uk_waitq_entry *entry)
+{
+	uk_waitq_entry_init(entry, uk_thread_current());
+#if CONFIG_LIBUKSCHED_FIBER
+	entry->fiber = uk_fiber_current();
+#endif
+}
+
+/*
+ * A waiter is either a thread or, if the entry was queued from within a
+ * fiber by uk_waitq_wait_event() and friends, a fiber. The following
+ * helpers block, wake and yield whichever of both it is.
+ */
+static inline
+void uk_waitq_entry_block(struct uk_waitq_entry *entry, __snsec until)
+{
+#if CONFIG_LIBUKSCHED_FIBER
+	if (entry->fiber) {
+		uk_fiber_block_until(entry->fiber, until);
+		return;
+	}
+#endif
+	uk_thread_block_until(entry->thread, until);
+}
+
+static inline
+void uk_waitq_entry_wake(struct uk_waitq_entry *entry)
+{
+#if CONFIG_LIBUKSCHED_FIBER
+	if (entry->fiber) {
+		uk_fiber_wake(entry->fiber);
+		return;
+	}
+#endif
+	uk_thread_wake(entry->thread);
+}
+
+static inline
+void uk_waitq_entry_yield(struct uk_waitq_entry *entry __maybe_unused)
+{
+#if CONFIG_LIBUKSCHED_FIBER
+	if (entry->fiber) {
+		uk_fiber_yield();
+		return;
+	}
+#endif
+	uk_sched_yield();
 }
 
 static inline
 int uk_waitq_empty(struct uk_waitq *wq)
 {
-	return UK_STAILQ_EMPTY(wq);
+	return UK_STAILQ_EMPTY(&wq->list);
 }
 
+/* Must be called with `wq->sl` held */
 static inline
 void uk_waitq_add(struct uk_waitq *wq,
 		struct uk_waitq_entry *entry)
 {
 	if (!entry->waiting) {
-		UK_STAILQ_INSERT_TAIL(wq, entry, thread_list);
+		UK_STAILQ_INSERT_TAIL(&wq->list, entry, thread_list);
+		entry->waiting = 1;
+	}
+}
+
+/*
+ * Queues the entry in front of all others, e.g., to give a woken waiter
+ * back its place. Must be called with `wq->sl` held
+ */
+static inline
+void uk_waitq_add_head(struct uk_waitq *wq,
+		struct uk_waitq_entry *entry)
+{
+	if (!entry->waiting) {
+		UK_STAILQ_INSERT_HEAD(&wq->list, entry, thread_list);
 		entry->waiting = 1;
 	}
 }
 
+/* Must be called with `wq->sl` held */
 static inline
 void uk_waitq_remove(struct uk_waitq *wq,
 		struct uk_waitq_entry *entry)
 {
 	if (entry->waiting) {
-		UK_STAILQ_REMOVE(wq, entry, struct uk_waitq_entry, thread_list);
+		UK_STAILQ_REMOVE(&wq->list, entry, struct uk_waitq_entry,
+				 thread_list);
 		entry->waiting = 0;
 	}
 }
@@ -78,65 +157,140 @@ void uk_waitq_remove(struct uk_waitq *wq,
 #define uk_waitq_add_waiter(wq, w) \
 do { \
 	unsigned long flags; \
-	flags = ukplat_lcpu_save_irqf(); \
+	ukplat_spin_lock_irqsave(&(wq)->sl, flags); \
 	uk_waitq_add(wq, w); \
 	uk_thread_block(uk_thread_current()); \
-	ukplat_lcpu_restore_irqf(flags); \
+	ukplat_spin_unlock_irqrestore(&(wq)->sl, flags); \
 } while (0)
 
 #define uk_waitq_remove_waiter(wq, w) \
 do { \
 	unsigned long flags; \
-	flags = ukplat_lcpu_save_irqf(); \
+	ukplat_spin_lock_irqsave(&(wq)->sl, flags); \
 	uk_waitq_remove(wq, w); \
-	ukplat_lcpu_restore_irqf(flags); \
+	ukplat_spin_unlock_irqrestore(&(wq)->sl, flags); \
 } while (0)
 
-#define __wq_wait_event_deadline(wq, condition, deadline, deadline_condition) \
+/*
+ * The waiter is queued and blocked while holding the queue lock, so a
+ * waker that changes `condition` and then calls uk_waitq_wake_up() either
+ * finds the waiter on the queue or has made `condition` visible before
+ * the waiter re-checks it.
+ */
+#if CONFIG_LIBUKSCHED_FIBER
+#define __wq_wait_set_fiber(w) ((w)->fiber = uk_fiber_current())
+#else
+#define __wq_wait_set_fiber(w) do { } while (0)
+#endif
+
+#define __wq_wait_event_deadline(wq, condition, deadline, deadline_condition, \
+				 wflags) \
 do { \
-	struct uk_thread *__current; \
 	unsigned long flags; \
 	DEFINE_WAIT(__wait); \
+	__wait.flags = (wflags); \
 	if (condition) \
 		break; \
+	__wq_wait_set_fiber(&__wait); \
 	for (;;) { \
-		__current = uk_thread_current(); \
 		/* protect the list */ \
-		flags = ukplat_lcpu_save_irqf(); \
+		ukplat_spin_lock_irqsave(&(wq)->sl, flags); \
 		uk_waitq_add(wq, &__wait); \
-		__current->wakeup_time = deadline; \
-		clear_runnable(__current); \
-		uk_sched_thread_blocked(__current->sched, __current); \
-		ukplat_lcpu_restore_irqf(flags); \
+		uk_waitq_entry_block(&__wait, deadline); \
+		ukplat_spin_unlock_irqrestore(&(wq)->sl, flags); \
 		if ((condition) || (deadline_condition)) \
 			break; \
-		uk_sched_yield(); \
+		uk_waitq_entry_yield(&__wait); \
 	} \
-	flags = ukplat_lcpu_save_irqf(); \
+	ukplat_spin_lock_irqsave(&(wq)->sl, flags); \
 	/* need to wake up */ \
-	uk_thread_wake(__current); \
+	uk_waitq_entry_wake(&__wait); \
 	uk_waitq_remove(wq, &__wait); \
-	ukplat_lcpu_restore_irqf(flags); \
+	ukplat_spin_unlock_irqrestore(&(wq)->sl, flags); \
 } while (0)
 
 #define uk_waitq_wait_event(wq, condition) \
-	__wq_wait_event_deadline(wq, (condition), 0, 0)
+	__wq_wait_event_deadline(wq, (condition), 0, 0, 0)
 
 #define uk_waitq_wait_event_deadline(wq, condition, deadline) \
 	__wq_wait_event_deadline(wq, (condition), \
 		(deadline), \
-		(deadline) && ukplat_monotonic_clock() >= (deadline))
+		(deadline) && ukplat_monotonic_clock() >= (deadline), 0)
+
+/*
+ * Like uk_waitq_wait_event(), but the waiter is exclusive: a wake-up
+ * consumes it, so uk_waitq_wake_up_one() lets only one of many such
+ * waiters run. A woken waiter that finds `condition` false again
+ * re-queues itself at the tail.
+ */
+#define uk_waitq_wait_event_exclusive(wq, condition) \
+	__wq_wait_event_deadline(wq, (condition), 0, 0, UK_WAITQ_EXCLUSIVE)
+
+#define uk_waitq_wait_event_deadline_exclusive(wq, condition, deadline) \
+	__wq_wait_event_deadline(wq, (condition), \
+		(deadline), \
+		(deadline) && ukplat_monotonic_clock() >= (deadline), \
+		UK_WAITQ_EXCLUSIVE)
 
+/*
+ * Returns the thread that waits the longest, NULL if the queue is empty.
+ * Must be called with `wq->sl` held
+ */
 static inline
-void uk_waitq_wake_up(struct uk_waitq *wq)
+struct uk_thread *uk_waitq_first(struct uk_waitq *wq)
+{
+	struct uk_waitq_entry *first = UK_STAILQ_FIRST(&wq->list);
+
+	return first ? first->thread : NULL;
+}
+
+/*
+ * Wakes up, in FIFO order, all non-exclusive waiters and at most `nr`
+ * exclusive ones (all of them if `nr` is negative). Woken exclusive
+ * waiters are taken off the queue so that the next wake-up goes to the
+ * following ones. Returns the number of exclusive waiters woken up.
+ * Must be called with `wq->sl` held
+ */
+static inline
+int __uk_waitq_wake_up_nr(struct uk_waitq *wq, int nr)
 {
-	unsigned long flags;
 	struct uk_waitq_entry *curr, *tmp;
+	int woken = 0;
+
+	UK_STAILQ_FOREACH_SAFE(curr, &wq->list, thread_list, tmp) {
+		if (curr->flags & UK_WAITQ_EXCLUSIVE) {
+			if (woken == nr)
+				continue;
+			uk_waitq_remove(wq, curr);
+			woken++;
+		}
+		uk_waitq_entry_wake(curr);
+	}
+	return woken;
+}
+
+static inline
+int uk_waitq_wake_up_nr(struct uk_waitq *wq, int nr)
+{
+	unsigned long flags;
+	int woken;
 
-	flags = ukplat_lcpu_save_irqf();
-	UK_STAILQ_FOREACH_SAFE(curr, wq, thread_list, tmp)
-		uk_thread_wake(curr->thread);
-	ukplat_lcpu_restore_irqf(flags);
+	ukplat_spin_lock_irqsave(&wq->sl, flags);
+	woken = __uk_waitq_wake_up_nr(wq, nr);
+	ukplat_spin_unlock_irqrestore(&wq->sl, flags);
+	return woken;
+}
+
+static inline
+int uk_waitq_wake_up_one(struct uk_waitq *wq)
+{
+	return uk_waitq_wake_up_nr(wq, 1);
+}
+
+static inline
+void uk_waitq_wake_up(struct uk_waitq *wq)
+{
+	uk_waitq_wake_up_nr(wq, -1);
 }
 
 #ifdef __cplusplus
@@ -26,22 +26,43 @@
 #ifndef __UK_SCHED_WAIT_TYPES_H__
 #define __UK_SCHED_WAIT_TYPES_H__
 
+#include <uk/config.h>
 #include <uk/list.h>
+#include <uk/arch/spinlock.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#if CONFIG_LIBUKSCHED_FIBER
+struct uk_fiber;
+#endif
+
+/* Wake-ups stop at the first `nr` exclusive waiters, see uk_waitq_wake_up_nr */
+#define UK_WAITQ_EXCLUSIVE 0x01
+
 struct uk_waitq_entry {
 	int waiting;
+	int flags;
 	struct uk_thread *thread;
+#if CONFIG_LIBUKSCHED_FIBER
+	struct uk_fiber *fiber; /* blocked instead of `thread` if set */
+#endif
 	UK_STAILQ_ENTRY(struct uk_waitq_entry) thread_list;
 };
 
-/* TODO - lock required? */
-UK_STAILQ_HEAD(uk_waitq, struct uk_waitq_entry);
+UK_STAILQ_HEAD(uk_waitq_list, struct uk_waitq_entry);
+
+struct uk_waitq {
+	struct uk_waitq_list list;
+	spinlock_t sl; /* protects the list, taken with IRQs disabled */
+};
 
-#define __WAIT_QUEUE_INITIALIZER(name) UK_STAILQ_HEAD_INITIALIZER(name)
+#define __WAIT_QUEUE_INITIALIZER(name)				\
+	{							\
+		.list = UK_STAILQ_HEAD_INITIALIZER((name).list),	\
+		.sl   = UKARCH_SPINLOCK_INITIALIZER(),		\
+	}
 
 #define DEFINE_WAIT_QUEUE(name) \
 	struct uk_waitq name = __WAIT_QUEUE_INITIALIZER(name)
@@ -49,6 +70,7 @@ UK_STAILQ_HEAD(uk_waitq, struct uk_waitq_entry);
 #define DEFINE_WAIT(name) \
 struct uk_waitq_entry name = { \
 	.waiting      = 0, \
+	.flags        = 0, \
 	.thread       = uk_thread_current(), \
 	.thread_list  = { NULL } \
 }
@@ -34,9 +34,15 @@
 #include <string.h>
 #include <uk/plat/config.h>
 #include <uk/plat/thread.h>
+#include <uk/plat/time.h>
 #include <uk/alloc.h>
 #include <uk/sched.h>
 #include <uk/arch/tls.h>
+#include <uk/plat/spinlock.h>
+#include <uk/preempt.h>
+#if CONFIG_LIBUKSCHEDPRIO
+#include <uk/schedprio.h>
+#endif
 #if CONFIG_LIBUKSCHEDCOOP
 #include <uk/schedcoop.h>
 #endif
@@ -55,7 +61,9 @@ struct uk_sched *uk_sched_default_init(struct uk_alloc *a)
 	uk_proc_sig_init(&uk_proc_sig);
 #endif
 
-#if CONFIG_LIBUKSCHEDCOOP
+#if CONFIG_LIBUKSCHEDPRIO
+	s = uk_schedprio_init(a);
+#elif CONFIG_LIBUKSCHEDCOOP
 	s = uk_schedcoop_init(a);
 #endif
 
@@ -131,6 +139,15 @@ struct uk_sched *uk_sched_create(struct uk_alloc *a, size_t prv_size)
 	sched->threads_started = false;
 	sched->allocator = a;
 	UK_TAILQ_INIT(&sched->exited_threads);
+	ukarch_spin_lock_init(&sched->exited_lock);
+	UK_TAILQ_INIT(&sched->thread_cache);
+	sched->thread_cache_len = 0;
+	ukarch_spin_lock_init(&sched->cache_lock);
+#if CONFIG_LIBUKSCHED_STATS
+	UK_TAILQ_INIT(&sched->threads);
+	ukarch_spin_lock_init(&sched->threads_lock);
+	sched->stats_dumped = ukplat_monotonic_clock();
+#endif
 	sched->prv = (void *) sched + sizeof(struct uk_sched);
 
 	return sched;
@@ -139,6 +156,7 @@ struct uk_sched *uk_sched_create(struct uk_alloc *a, size_t prv_size)
 void uk_sched_start(struct uk_sched *sched)
 {
 	UK_ASSERT(sched != NULL);
+	sched->idle.running = 1;
 	ukplat_thread_ctx_start(&sched->plat_ctx_cbs, sched->idle.ctx);
 }
 
@@ -168,35 +186,112 @@ static void *uk_thread_tls_create(struct uk_alloc *allocator)
 	return tls;
 }
 
-void uk_sched_idle_init(struct uk_sched *sched,
-		void *stack, void (*function)(void *))
+int uk_sched_idle_thread_init(struct uk_sched *sched, struct uk_thread *idle,
+		void *stack, void (*function)(void *), void *arg)
 {
-	struct uk_thread *idle;
 	int rc;
 	void *tls = NULL;
 
 	UK_ASSERT(sched != NULL);
+	UK_ASSERT(idle != NULL);
 
 	if (stack == NULL)
 		stack = create_stack(sched->allocator);
-	UK_ASSERT(stack != NULL);
+	if (stack == NULL)
+		return -ENOMEM;
 	if (have_tls_area() && !(tls = uk_thread_tls_create(sched->allocator)))
-		goto out_crash;
-
-	idle = &sched->idle;
+		return -ENOMEM;
 
 	rc = uk_thread_init(idle,
 			&sched->plat_ctx_cbs, sched->allocator,
-			"Idle", stack, tls, function, NULL);
+			"Idle", stack, tls, function, arg);
 	if (rc)
-		goto out_crash;
+		return rc;
 
 	idle->sched = sched;
-	return;
+	uk_sched_stats_thread_add(sched, idle);
+	return 0;
+}
+
+void uk_sched_idle_init(struct uk_sched *sched,
+		void *stack, void (*function)(void *))
+{
+	UK_ASSERT(sched != NULL);
+
+	if (uk_sched_idle_thread_init(sched, &sched->idle,
+				      stack, function, NULL))
+		UK_CRASH("Failed to initialize `idle` thread\n");
+}
+
+#if CONFIG_LIBUKSCHED_THREAD_CACHE > 0
+/*
+ * The cache is only used from thread context, so its lock does not need to
+ * disable interrupts. This keeps a cache hit cheaper than the allocations
+ * that it saves, which do not disable interrupts on a single CPU either.
+ */
+static inline void thread_cache_lock(struct uk_sched *sched)
+{
+	uk_preempt_disable();
+	ukarch_spin_lock(&sched->cache_lock);
+}
+
+static inline void thread_cache_unlock(struct uk_sched *sched)
+{
+	ukarch_spin_unlock(&sched->cache_lock);
+	uk_preempt_enable();
+}
+
+/*
+ * Takes a released thread from the cache. Its stack and TLS area are
+ * still attached, the TLS area is reset to the initial image.
+ */
+static struct uk_thread *thread_cache_get(struct uk_sched *sched)
+{
+	struct uk_thread *thread = NULL;
+
+	if (UK_TAILQ_EMPTY(&sched->thread_cache))
+		return NULL;
+
+	thread_cache_lock(sched);
+	thread = UK_TAILQ_FIRST(&sched->thread_cache);
+	if (thread) {
+		UK_TAILQ_REMOVE(&sched->thread_cache, thread, thread_list);
+		sched->thread_cache_len--;
+	}
+	thread_cache_unlock(sched);
+
+	if (thread && thread->tls)
+		ukarch_tls_area_copy(thread->tls);
+	return thread;
+}
+
+/* Returns 1 if the thread was kept for reuse, 0 if the cache is full */
+static int thread_cache_put(struct uk_sched *sched, struct uk_thread *thread)
+{
+	int ret = 0;
+
+	thread_cache_lock(sched);
+	if (sched->thread_cache_len < CONFIG_LIBUKSCHED_THREAD_CACHE) {
+		UK_TAILQ_INSERT_HEAD(&sched->thread_cache, thread, thread_list);
+		sched->thread_cache_len++;
+		ret = 1;
+	}
+	thread_cache_unlock(sched);
+	return ret;
+}
+#else
+static inline struct uk_thread *thread_cache_get(
+		struct uk_sched *sched __unused)
+{
+	return NULL;
+}
 
-out_crash:
-	UK_CRASH("Failed to initialize `idle` thread\n");
+static inline int thread_cache_put(struct uk_sched *sched __unused,
+		struct uk_thread *thread __unused)
+{
+	return 0;
 }
+#endif
 
 struct uk_thread *uk_sched_thread_create(struct uk_sched *sched,
 		const char *name, const uk_thread_attr_t *attr,
@@ -207,6 +302,13 @@ struct uk_thread *uk_sched_thread_create(struct uk_sched *sched,
 	int rc;
 	void *tls = NULL;
 
+	thread = thread_cache_get(sched);
+	if (thread) {
+		stack = thread->stack;
+		tls = thread->tls;
+		goto init;
+	}
+
 	thread = uk_malloc(sched->allocator, sizeof(struct uk_thread));
 	if (thread == NULL) {
 		uk_pr_err("Failed to allocate thread\n");
@@ -222,12 +324,15 @@ struct uk_thread *uk_sched_thread_create(struct uk_sched *sched,
 	if (have_tls_area() && !(tls = uk_thread_tls_create(sched->allocator)))
 		goto err;
 
+init:
 	rc = uk_thread_init(thread,
 			&sched->plat_ctx_cbs, sched->allocator,
 			name, stack, tls, function, arg);
 	if (rc)
 		goto err;
 
+	/* Register before the thread can run and exit */
+	uk_sched_stats_thread_add(sched, thread);
 	rc = uk_sched_thread_add(sched, thread, attr);
 	if (rc)
 		goto err_add;
@@ -235,6 +340,7 @@ struct uk_thread *uk_sched_thread_create(struct uk_sched *sched,
 	return thread;
 
 err_add:
+	uk_sched_stats_thread_remove(sched, thread);
 	uk_thread_fini(thread, sched->allocator);
 err:
 	if (tls)
@@ -247,20 +353,37 @@ err:
 	return NULL;
 }
 
+static void thread_release(struct uk_sched *sched, struct uk_thread *thread)
+{
+	uk_sched_stats_thread_remove(sched, thread);
+	uk_thread_fini(thread, sched->allocator);
+	if (thread_cache_put(sched, thread))
+		return;
+	uk_free(sched->allocator, thread->stack);
+	if (thread->tls)
+		uk_free(sched->allocator, thread->tls);
+	uk_free(sched->allocator, thread);
+}
+
 void uk_sched_thread_destroy(struct uk_sched *sched, struct uk_thread *thread)
 {
+	unsigned long flags;
+
 	UK_ASSERT(sched != NULL);
 	UK_ASSERT(thread != NULL);
 	UK_ASSERT(thread->stack != NULL);
 	UK_ASSERT(!have_tls_area() || thread->tls != NULL);
 	UK_ASSERT(is_exited(thread));
 
+	ukplat_spin_lock_irqsave(&sched->exited_lock, flags);
 	UK_TAILQ_REMOVE(&sched->exited_threads, thread, thread_list);
-	uk_thread_fini(thread, sched->allocator);
-	uk_free(sched->allocator, thread->stack);
-	if (thread->tls)
-		uk_free(sched->allocator, thread->tls);
-	uk_free(sched->allocator, thread);
+	ukplat_spin_unlock_irqrestore(&sched->exited_lock, flags);
+
+	/* The thread may still be switching away on another logical CPU */
+	while (__atomic_load_n(&thread->running, __ATOMIC_ACQUIRE))
+		ukarch_spinwait();
+
+	thread_release(sched, thread);
 }
 
 void uk_sched_thread_kill(struct uk_sched *sched, struct uk_thread *thread)
@@ -268,6 +391,46 @@ void uk_sched_thread_kill(struct uk_sched *sched, struct uk_thread *thread)
 	uk_sched_thread_remove(sched, thread);
 }
 
+void uk_sched_thread_exited(struct uk_sched *sched, struct uk_thread *thread)
+{
+	unsigned long flags;
+
+	ukplat_spin_lock_irqsave(&sched->exited_lock, flags);
+	UK_TAILQ_INSERT_HEAD(&sched->exited_threads, thread, thread_list);
+	ukplat_spin_unlock_irqrestore(&sched->exited_lock, flags);
+}
+
+void uk_sched_thread_destroy_exited(struct uk_sched *sched)
+{
+	struct uk_thread_list reap = UK_TAILQ_HEAD_INITIALIZER(reap);
+	struct uk_thread *thread, *tmp;
+	unsigned long flags;
+
+	if (UK_TAILQ_EMPTY(&sched->exited_threads))
+		return;
+
+	ukplat_spin_lock_irqsave(&sched->exited_lock, flags);
+	UK_TAILQ_FOREACH_SAFE(thread, &sched->exited_threads, thread_list,
+			      tmp) {
+		if (!thread->detached)
+			/* someone will eventually wait for it */
+			continue;
+		if (!is_exited(thread))
+			/* still on its way out */
+			continue;
+		if (__atomic_load_n(&thread->running, __ATOMIC_ACQUIRE))
+			/* still switching away */
+			continue;
+		UK_TAILQ_REMOVE(&sched->exited_threads, thread, thread_list);
+		UK_TAILQ_INSERT_TAIL(&reap, thread, thread_list);
+	}
+	ukplat_spin_unlock_irqrestore(&sched->exited_lock, flags);
+
+	/* Free with the lock released, the allocator may take its own lock */
+	UK_TAILQ_FOREACH_SAFE(thread, &reap, thread_list, tmp)
+		thread_release(sched, thread);
+}
+
 void uk_sched_thread_sleep(__nsec nsec)
 {
 	struct uk_thread *thread;
@@ -0,0 +1,160 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uk/plat/lcpu.h>
+#include <uk/sleepq.h>
+#include <uk/assert.h>
+
+#define SLEEPQ_MIN_SIZE 16
+
+#define heap_parent(idx) (((idx) - 1) / 2)
+#define heap_left(idx)   (2 * (idx) + 1)
+
+static inline void heap_set(struct uk_sleepq *sq, unsigned int idx,
+			    struct uk_thread *thread)
+{
+	sq->heap[idx] = thread;
+	thread->sleepq_idx = idx;
+}
+
+static void heap_sift_up(struct uk_sleepq *sq, unsigned int idx)
+{
+	struct uk_thread *thread = sq->heap[idx];
+	struct uk_thread *parent;
+
+	while (idx > 0) {
+		parent = sq->heap[heap_parent(idx)];
+		if (parent->wakeup_time <= thread->wakeup_time)
+			break;
+		heap_set(sq, idx, parent);
+		idx = heap_parent(idx);
+	}
+	heap_set(sq, idx, thread);
+}
+
+static void heap_sift_down(struct uk_sleepq *sq, unsigned int idx)
+{
+	struct uk_thread *thread = sq->heap[idx];
+	unsigned int child;
+
+	while ((child = heap_left(idx)) < sq->count) {
+		if (child + 1 < sq->count &&
+		    sq->heap[child + 1]->wakeup_time
+		    < sq->heap[child]->wakeup_time)
+			child++;
+		if (thread->wakeup_time <= sq->heap[child]->wakeup_time)
+			break;
+		heap_set(sq, idx, sq->heap[child]);
+		idx = child;
+	}
+	heap_set(sq, idx, thread);
+}
+
+int uk_sleepq_reserve(struct uk_sleepq *sq, struct uk_alloc *a,
+		      unsigned int nb_threads)
+{
+	struct uk_thread **heap, **old;
+	unsigned long flags;
+	unsigned int size;
+
+	UK_ASSERT(sq);
+
+	if (likely(nb_threads <= sq->size))
+		return 0;
+
+	size = MAX(sq->size, (unsigned int) SLEEPQ_MIN_SIZE);
+	while (size < nb_threads)
+		size *= 2;
+
+	heap = uk_malloc(a, size * sizeof(*heap));
+	if (!heap)
+		return -ENOMEM;
+
+	/* Threads can be queued and dequeued from interrupt context
+	 * (e.g., when woken up), so swap arrays with interrupts disabled
+	 */
+	flags = ukplat_lcpu_save_irqf();
+	if (sq->count)
+		memcpy(heap, sq->heap, sq->count * sizeof(*heap));
+	old = sq->heap;
+	sq->heap = heap;
+	sq->size = size;
+	ukplat_lcpu_restore_irqf(flags);
+
+	if (old)
+		uk_free(a, old);
+	return 0;
+}
+
+void uk_sleepq_fini(struct uk_sleepq *sq, struct uk_alloc *a)
+{
+	UK_ASSERT(sq);
+	UK_ASSERT(sq->count == 0);
+
+	if (sq->heap)
+		uk_free(a, sq->heap);
+	uk_sleepq_init(sq);
+}
+
+void uk_sleepq_add(struct uk_sleepq *sq, struct uk_thread *thread)
+{
+	UK_ASSERT(sq);
+	UK_ASSERT(thread);
+	UK_ASSERT(sq->count < sq->size);
+
+	sq->heap[sq->count] = thread;
+	heap_sift_up(sq, sq->count++);
+}
+
+void uk_sleepq_remove(struct uk_sleepq *sq, struct uk_thread *thread)
+{
+	unsigned int idx;
+	struct uk_thread *last;
+
+	UK_ASSERT(sq);
+	UK_ASSERT(thread);
+
+	idx = thread->sleepq_idx;
+	UK_ASSERT(idx < sq->count && sq->heap[idx] == thread);
+
+	last = sq->heap[--sq->count];
+	if (idx == sq->count)
+		return;
+
+	/* Move the last element into the gap and restore heap order */
+	heap_set(sq, idx, last);
+	if (idx > 0 &&
+	    sq->heap[heap_parent(idx)]->wakeup_time > last->wakeup_time)
+		heap_sift_up(sq, idx);
+	else
+		heap_sift_down(sq, idx);
+}
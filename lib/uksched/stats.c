@@ -0,0 +1,237 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <uk/alloc.h>
+#include <uk/print.h>
+#include <uk/sched.h>
+#include <uk/thread.h>
+#include <uk/trace.h>
+#include <uk/plat/console.h>
+#include <uk/plat/spinlock.h>
+#include <uk/plat/time.h>
+
+/*
+ * A thread is always in one of three states: running, runnable but waiting
+ * for a logical CPU, or blocked. `stats.since` is the time of the last
+ * state change, the time since then is added to the counter of the state
+ * that is left. The counters of threads that run on other logical CPUs are
+ * read without synchronization, so a dump is a close approximation.
+ */
+
+UK_TRACEPOINT(uk_sched_trace_switch, "0x%lx -> 0x%lx",
+	      unsigned long, unsigned long);
+UK_TRACEPOINT(uk_sched_trace_block, "0x%lx until %ld",
+	      unsigned long, long);
+UK_TRACEPOINT(uk_sched_trace_wake, "0x%lx", unsigned long);
+
+void uk_thread_stats_switch(struct uk_thread *prev, struct uk_thread *next)
+{
+	__nsec now = ukplat_monotonic_clock();
+
+	uk_sched_trace_switch((unsigned long) prev, (unsigned long) next);
+
+	prev->stats.run_time += now - prev->stats.since;
+	prev->stats.since = now;
+	prev->stats.switches++;
+
+	next->stats.wait_time += now - next->stats.since;
+	next->stats.since = now;
+}
+
+void uk_thread_stats_blocked(struct uk_thread *thread)
+{
+	/* The thread keeps running until it switches out */
+	uk_sched_trace_block((unsigned long) thread,
+			     (long) thread->wakeup_time);
+}
+
+void uk_thread_stats_woken(struct uk_thread *thread)
+{
+	__nsec now;
+
+	uk_sched_trace_wake((unsigned long) thread);
+
+	/* Woken up before it switched out: it never stopped running */
+	if (__atomic_load_n(&thread->running, __ATOMIC_ACQUIRE))
+		return;
+
+	now = ukplat_monotonic_clock();
+	thread->stats.block_time += now - thread->stats.since;
+	thread->stats.since = now;
+}
+
+void uk_sched_stats_thread_add(struct uk_sched *sched,
+			       struct uk_thread *thread)
+{
+	unsigned long flags;
+
+	ukplat_spin_lock_irqsave(&sched->threads_lock, flags);
+	UK_TAILQ_INSERT_TAIL(&sched->threads, thread, stats_list);
+	ukplat_spin_unlock_irqrestore(&sched->threads_lock, flags);
+}
+
+void uk_sched_stats_thread_remove(struct uk_sched *sched,
+				  struct uk_thread *thread)
+{
+	unsigned long flags;
+
+	ukplat_spin_lock_irqsave(&sched->threads_lock, flags);
+	UK_TAILQ_REMOVE(&sched->threads, thread, stats_list);
+	ukplat_spin_unlock_irqrestore(&sched->threads_lock, flags);
+}
+
+static void stats_print(const char *fmt, ...) __printf(1, 2);
+static void stats_print(const char *fmt, ...)
+{
+	char buf[128];
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	if (len > 0)
+		ukplat_coutk(buf, MIN((unsigned int) len, sizeof(buf) - 1));
+}
+
+#define NSEC_TO_MSEC_FMT     "%8llu.%03llu"
+#define NSEC_TO_MSEC_ARGS(n)					\
+	(unsigned long long) ((n) / 1000000),			\
+	(unsigned long long) ((n) / 1000 % 1000)
+
+/* Snapshot of the statistics of a thread, printed after dropping the lock */
+struct stats_row {
+	char name[19];
+	char state;
+	unsigned int lcpu;
+	__nsec permille;
+	__nsec run_time;
+	__nsec wait_time;
+	__nsec block_time;
+	unsigned long switches;
+};
+
+static void stats_snapshot(struct uk_thread *t, __nsec now, __nsec interval,
+			   struct stats_row *row)
+{
+	struct uk_thread_stats st = t->stats;
+	__nsec cur = (now > st.since) ? now - st.since : 0;
+
+	/* Include the time spent in the current state */
+	if (__atomic_load_n(&t->running, __ATOMIC_ACQUIRE)) {
+		row->state = 'R';
+		st.run_time += cur;
+	} else if (is_exited(t)) {
+		row->state = 'X';
+	} else if (is_runnable(t)) {
+		row->state = 'Q';
+		st.wait_time += cur;
+	} else {
+		row->state = t->wakeup_time ? 'S' : 'B';
+		st.block_time += cur;
+	}
+
+	row->permille = interval
+		? (st.run_time - st.dumped_run_time) * 1000 / interval
+		: 0;
+	t->stats.dumped_run_time = st.run_time;
+
+	strncpy(row->name, t->name ? t->name : "-", sizeof(row->name) - 1);
+	row->name[sizeof(row->name) - 1] = '\0';
+	row->lcpu = (unsigned int) t->lcpu;
+	row->run_time = st.run_time;
+	row->wait_time = st.wait_time;
+	row->block_time = st.block_time;
+	row->switches = st.switches;
+}
+
+void uk_sched_stats_dump(struct uk_sched *sched)
+{
+	struct stats_row *rows;
+	struct uk_thread *t;
+	unsigned long flags;
+	unsigned int i, nb_rows, nb_threads = 0;
+	__nsec now, interval;
+
+	UK_ASSERT(sched);
+
+	/* Printing to the console is slow, so the statistics are copied
+	 * with the lock held and printed afterwards
+	 */
+	ukplat_spin_lock_irqsave(&sched->threads_lock, flags);
+	UK_TAILQ_FOREACH(t, &sched->threads, stats_list)
+		nb_threads++;
+	ukplat_spin_unlock_irqrestore(&sched->threads_lock, flags);
+
+	nb_rows = MAX(nb_threads, 1U);
+	rows = uk_malloc(sched->allocator, nb_rows * sizeof(*rows));
+	if (unlikely(!rows)) {
+		uk_pr_err("Not enough memory to dump %u threads\n", nb_rows);
+		return;
+	}
+
+	/* Threads created since counting them are left out */
+	nb_threads = 0;
+	ukplat_spin_lock_irqsave(&sched->threads_lock, flags);
+	now = ukplat_monotonic_clock();
+	interval = now - sched->stats_dumped;
+	UK_TAILQ_FOREACH(t, &sched->threads, stats_list) {
+		if (nb_threads < nb_rows)
+			stats_snapshot(t, now, interval, &rows[nb_threads]);
+		nb_threads++;
+	}
+	sched->stats_dumped = now;
+	ukplat_spin_unlock_irqrestore(&sched->threads_lock, flags);
+
+	stats_print("Scheduler %p, %%CPU over the last" NSEC_TO_MSEC_FMT
+		    " ms\n", sched, NSEC_TO_MSEC_ARGS(interval));
+	stats_print("%-18s S CPU  %%CPU       RUN ms      WAIT ms     BLOCK ms"
+		    "   SWITCHES\n", "THREAD");
+	for (i = 0; i < MIN(nb_rows, nb_threads); i++)
+		stats_print("%-18s %c %3u %3llu.%llu "
+			    NSEC_TO_MSEC_FMT " " NSEC_TO_MSEC_FMT " "
+			    NSEC_TO_MSEC_FMT " %10lu\n",
+			    rows[i].name, rows[i].state, rows[i].lcpu,
+			    (unsigned long long) (rows[i].permille / 10),
+			    (unsigned long long) (rows[i].permille % 10),
+			    NSEC_TO_MSEC_ARGS(rows[i].run_time),
+			    NSEC_TO_MSEC_ARGS(rows[i].wait_time),
+			    NSEC_TO_MSEC_ARGS(rows[i].block_time),
+			    rows[i].switches);
+	if (nb_threads > nb_rows)
+		stats_print("(%u more threads not shown)\n",
+			    nb_threads - nb_rows);
+
+	uk_free(sched->allocator, rows);
+}
@@ -40,6 +40,7 @@
 #include <uk/print.h>
 #include <uk/assert.h>
 #include <uk/arch/tls.h>
+#include <uk/plat/spinlock.h>
 
 /* Pushes the specified value onto the stack of the specified thread */
 static void stack_push(unsigned long *sp, unsigned long value)
@@ -48,6 +49,18 @@ static void stack_push(unsigned long *sp, unsigned long value)
 	*((unsigned long *) *sp) = value;
 }
 
+/*
+ * Entry of every new thread: completes the context switch that started it
+ * before the thread function is called
+ */
+static void uk_thread_starter(void *arg)
+{
+	struct uk_thread *thread = (struct uk_thread *) arg;
+
+	uk_sched_thread_switch_finish(thread);
+	thread->entry(thread->arg);
+}
+
 static void init_sp(unsigned long *sp, char *stack,
 		void (*function)(void *), void *data)
 {
@@ -141,11 +154,19 @@ int uk_thread_init(struct uk_thread *thread,
 
 	/* Not runnable, not exited, not sleeping */
 	thread->flags = 0;
+	ukarch_spin_lock_init(&thread->sched_lock);
+	thread->running = 0;
+	thread->lcpu = ukplat_lcpu_id();
+	thread->switched_from = NULL;
 	thread->wakeup_time = 0LL;
 	thread->detached = false;
 	uk_waitq_init(&thread->waiting_threads);
 	thread->sched = NULL;
 	thread->prv = NULL;
+#if CONFIG_LIBUKSCHED_STATS
+	/* A new thread is runnable */
+	thread->stats.since = ukplat_monotonic_clock();
+#endif
 
 	/* TODO: Move newlibc reent initialization to newlib as
 	 *       thread initialization function
@@ -171,7 +192,7 @@ int uk_thread_init(struct uk_thread *thread,
 	 *       function (e.g., encapsulation), we prepare the stack here
 	 *       with the final setup
 	 */
-	init_sp(&sp, stack, thread->entry, thread->arg);
+	init_sp(&sp, stack, uk_thread_starter, thread);
 
 	/* Platform specific context initialization */
 	ukplat_thread_ctx_init(cbs, thread->ctx, sp,
@@ -211,15 +232,16 @@ void uk_thread_fini(struct uk_thread *thread, struct uk_alloc *allocator)
 	thread->ctx = NULL;
 }
 
-static void uk_thread_block_until(struct uk_thread *thread, __snsec until)
+void uk_thread_block_until(struct uk_thread *thread, __snsec until)
 {
 	unsigned long flags;
 
-	flags = ukplat_lcpu_save_irqf();
+	ukplat_spin_lock_irqsave(&thread->sched_lock, flags);
 	thread->wakeup_time = until;
 	clear_runnable(thread);
+	uk_thread_stats_blocked(thread);
 	uk_sched_thread_blocked(thread->sched, thread);
-	ukplat_lcpu_restore_irqf(flags);
+	ukplat_spin_unlock_irqrestore(&thread->sched_lock, flags);
 }
 
 void uk_thread_block_timeout(struct uk_thread *thread, __nsec nsec)
@@ -238,25 +260,35 @@ void uk_thread_wake(struct uk_thread *thread)
 {
 	unsigned long flags;
 
-	flags = ukplat_lcpu_save_irqf();
-	if (!is_runnable(thread)) {
+	ukplat_spin_lock_irqsave(&thread->sched_lock, flags);
+	if (!is_runnable(thread) && !is_exited(thread)) {
 		uk_sched_thread_woken(thread->sched, thread);
 		thread->wakeup_time = 0LL;
 		set_runnable(thread);
+		uk_thread_stats_woken(thread);
 	}
-	ukplat_lcpu_restore_irqf(flags);
+	ukplat_spin_unlock_irqrestore(&thread->sched_lock, flags);
 }
 
 void uk_thread_exit(struct uk_thread *thread)
 {
+	unsigned long flags;
+	bool detached;
+
 	UK_ASSERT(thread);
 
+	uk_pr_debug("Thread \"%s\" exited.\n", thread->name);
+
+	/* A detached thread may be released as soon as it is marked as
+	 * exited, so it must not be touched afterwards
+	 */
+	ukplat_spin_lock_irqsave(&thread->sched_lock, flags);
+	detached = thread->detached;
 	set_exited(thread);
+	ukplat_spin_unlock_irqrestore(&thread->sched_lock, flags);
 
-	if (!thread->detached)
+	if (!detached)
 		uk_waitq_wake_up(&thread->waiting_threads);
-
-	uk_pr_debug("Thread \"%s\" exited.\n", thread->name);
 }
 
 int uk_thread_wait(struct uk_thread *thread)
@@ -270,8 +302,6 @@ int uk_thread_wait(struct uk_thread *thread)
 
 	uk_waitq_wait_event(&thread->waiting_threads, is_exited(thread));
 
-	thread->detached = true;
-
 	uk_sched_thread_destroy(thread->sched, thread);
 
 	return 0;
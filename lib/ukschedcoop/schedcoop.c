@@ -31,95 +31,328 @@
  */
 #include <uk/plat/lcpu.h>
 #include <uk/plat/memory.h>
+#include <uk/plat/spinlock.h>
 #include <uk/plat/time.h>
 #include <uk/sched.h>
+#include <uk/sleepq.h>
 #include <uk/schedcoop.h>
 
+/*
+ * Every logical CPU has its own run queue. A thread is put back on the
+ * queue of the CPU it last ran on; CPUs that run out of work steal threads
+ * from the other queues before they halt. Without SMP support there is a
+ * single queue and the scheduler is a plain round-robin scheduler.
+ *
+ * Lock order: thread->sched_lock, prv->sleep_lock, runq->lock. Code that
+ * already holds one of the latter two locks and needs a thread's lock
+ * only tries to take it and otherwise skips the thread.
+ */
+struct schedcoop_runq {
+	spinlock_t lock;
+	struct uk_thread_list threads;
+	unsigned int count;
+	struct uk_thread *idle;
+} __align(CACHE_LINE_SIZE);
+
 struct schedcoop_private {
-	struct uk_thread_list thread_list;
-	struct uk_thread_list sleeping_threads;
+	struct schedcoop_runq *runq; /* one per logical CPU */
+	spinlock_t sleep_lock; /* protects the sleep queue and nb_threads */
+	struct uk_sleepq sleeping_threads;
+	unsigned int nb_threads;
+	__snsec next_wakeup; /* of the first sleeping thread, 0 if none */
+	unsigned long idle_lcpus; /* bitmap of halted logical CPUs */
 };
 
+UK_CTASSERT(UKPLAT_LCPU_MAXCOUNT <= sizeof(unsigned long) * 8);
+
 #ifdef SCHED_DEBUG
 static void print_runqueue(struct uk_sched *s)
 {
-	struct schedcoop_private *prv = s->private;
+	struct schedcoop_private *prv = s->prv;
 	struct uk_thread *th;
+	unsigned int i;
 
-	UK_TAILQ_FOREACH(th, &prv->thread_list, thread_list) {
-		uk_pr_debug("   Thread \"%s\", runnable=%d\n",
-			    th->name, is_runnable(th));
+	for (i = 0; i < ukplat_lcpu_count(); i++) {
+		UK_TAILQ_FOREACH(th, &prv->runq[i].threads, thread_list) {
+			uk_pr_debug("   Thread \"%s\", lcpu=%u, runnable=%d\n",
+				    th->name, i, is_runnable(th));
+		}
 	}
 }
 #endif
 
+/* Makes an idle logical CPU pick up work that was queued on `lcpu` */
+static void kick_lcpu(struct schedcoop_private *prv __maybe_unused,
+		      __u8 lcpu __maybe_unused)
+{
+#if CONFIG_HAVE_SMP
+	unsigned long idle;
+
+	/* Pairs with the barrier in lcpu_halt() */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	idle = __atomic_load_n(&prv->idle_lcpus, __ATOMIC_RELAXED);
+	if (!idle)
+		return;
+
+	/* Any idle CPU can steal the work if its owner is busy */
+	if (!(idle & (1UL << lcpu)))
+		lcpu = __builtin_ctzl(idle);
+	ukplat_lcpu_wakeup(lcpu);
+#endif
+}
+
+/* Must be called with the thread's sched_lock held */
+static void runq_enqueue(struct schedcoop_private *prv, struct uk_thread *t)
+{
+	struct schedcoop_runq *rq = &prv->runq[t->lcpu];
+
+	ukarch_spin_lock(&rq->lock);
+	UK_TAILQ_INSERT_TAIL(&rq->threads, t, thread_list);
+	rq->count++;
+	ukarch_spin_unlock(&rq->lock);
+	set_queued(t);
+}
+
+/* Must be called with the thread's sched_lock held */
+static void runq_remove(struct schedcoop_private *prv, struct uk_thread *t)
+{
+	struct schedcoop_runq *rq = &prv->runq[t->lcpu];
+
+	ukarch_spin_lock(&rq->lock);
+	UK_TAILQ_REMOVE(&rq->threads, t, thread_list);
+	rq->count--;
+	ukarch_spin_unlock(&rq->lock);
+	clear_queued(t);
+}
+
+/*
+ * Takes the first thread that can run on `lcpu` off the run queue of
+ * `from`. Threads whose context is still in use by another CPU are skipped,
+ * except `prev` which is the context we are running on.
+ */
+static struct uk_thread *runq_pick(struct schedcoop_private *prv,
+				   __u8 from, __u8 lcpu,
+				   struct uk_thread *prev)
+{
+	struct schedcoop_runq *rq = &prv->runq[from];
+	struct uk_thread *t;
+
+	if (!__atomic_load_n(&rq->count, __ATOMIC_RELAXED))
+		return NULL;
+
+	if (from == lcpu)
+		ukarch_spin_lock(&rq->lock);
+	else if (!ukarch_spin_trylock(&rq->lock))
+		return NULL;
+
+	UK_TAILQ_FOREACH(t, &rq->threads, thread_list) {
+		if (t != prev && __atomic_load_n(&t->running, __ATOMIC_ACQUIRE))
+			continue;
+		if (!ukarch_spin_trylock(&t->sched_lock))
+			continue;
+
+		UK_ASSERT(is_runnable(t));
+		UK_ASSERT(!is_exited(t));
+		UK_TAILQ_REMOVE(&rq->threads, t, thread_list);
+		rq->count--;
+		clear_queued(t);
+		t->lcpu = lcpu;
+		t->running = 1;
+		ukarch_spin_unlock(&t->sched_lock);
+		break;
+	}
+	ukarch_spin_unlock(&rq->lock);
+
+	return t;
+}
+
+static struct uk_thread *runq_steal(
+		struct schedcoop_private *prv __maybe_unused,
+		__u8 lcpu __maybe_unused)
+{
+#if CONFIG_HAVE_SMP
+	struct uk_thread *t;
+	__u8 count = ukplat_lcpu_count();
+	__u8 i, from;
+
+	for (i = 1; i < count; i++) {
+		from = (lcpu + i) % count;
+		t = runq_pick(prv, from, lcpu, NULL);
+		if (t)
+			return t;
+	}
+#endif
+	return NULL;
+}
+
+static void update_next_wakeup(struct schedcoop_private *prv)
+{
+	struct uk_thread *first = uk_sleepq_first(&prv->sleeping_threads);
+
+	__atomic_store_n(&prv->next_wakeup, first ? first->wakeup_time : 0,
+			 __ATOMIC_RELAXED);
+}
+
+/* Must be called with the thread's sched_lock held */
+static void sleepq_add(struct schedcoop_private *prv, struct uk_thread *t)
+{
+	__snsec next;
+
+	ukarch_spin_lock(&prv->sleep_lock);
+	next = prv->next_wakeup;
+	uk_sleepq_add(&prv->sleeping_threads, t);
+	update_next_wakeup(prv);
+	ukarch_spin_unlock(&prv->sleep_lock);
+
+	/* Halted CPUs may sleep beyond the new timeout */
+	if (!next || t->wakeup_time < next)
+		kick_lcpu(prv, ukplat_lcpu_id());
+}
+
+/* Must be called with the thread's sched_lock held */
+static void sleepq_remove(struct schedcoop_private *prv, struct uk_thread *t)
+{
+	ukarch_spin_lock(&prv->sleep_lock);
+	uk_sleepq_remove(&prv->sleeping_threads, t);
+	update_next_wakeup(prv);
+	ukarch_spin_unlock(&prv->sleep_lock);
+}
+
+/*
+ * Wakes up expired sleeping threads: they are ordered by wakeup time, so
+ * we stop at the first one that is not due.
+ * Returns the wakeup time of the first thread that is still sleeping,
+ * 0 if there is none.
+ */
+static __snsec wake_expired(struct schedcoop_private *prv, __snsec now)
+{
+	struct uk_thread *thread;
+	__snsec next;
+
+	next = __atomic_load_n(&prv->next_wakeup, __ATOMIC_RELAXED);
+	if (!next || next > now)
+		return next;
+
+	ukarch_spin_lock(&prv->sleep_lock);
+	while ((thread = uk_sleepq_first(&prv->sleeping_threads))) {
+		if (thread->wakeup_time > now)
+			break;
+		if (!ukarch_spin_trylock(&thread->sched_lock))
+			/* It is being woken up or removed right now */
+			break;
+
+		uk_sleepq_remove(&prv->sleeping_threads, thread);
+		thread->wakeup_time = 0LL;
+		set_runnable(thread);
+		uk_thread_stats_woken(thread);
+		if (is_queueable(thread)) {
+			clear_queueable(thread);
+			runq_enqueue(prv, thread);
+			kick_lcpu(prv, thread->lcpu);
+		}
+		ukarch_spin_unlock(&thread->sched_lock);
+	}
+	update_next_wakeup(prv);
+	next = prv->next_wakeup;
+	ukarch_spin_unlock(&prv->sleep_lock);
+
+	return next;
+}
+
+/* Halts the current logical CPU until `until` or until it gets kicked */
+static void lcpu_halt(struct schedcoop_private *prv __maybe_unused,
+		      __u8 lcpu __maybe_unused, __snsec until)
+{
+#if CONFIG_HAVE_SMP
+	unsigned long mask = 1UL << lcpu;
+	__u8 i;
+
+	__atomic_fetch_or(&prv->idle_lcpus, mask, __ATOMIC_SEQ_CST);
+
+	/* Do not miss work that was queued before we were marked as idle:
+	 * its producer may not have seen us in `idle_lcpus`
+	 */
+	for (i = 0; i < ukplat_lcpu_count(); i++)
+		if (__atomic_load_n(&prv->runq[i].count, __ATOMIC_RELAXED))
+			break;
+	if (i == ukplat_lcpu_count()) {
+		ukplat_lcpu_halt_to(until);
+		/* handle pending events if any */
+		ukplat_lcpu_irqs_handle_pending();
+	}
+
+	__atomic_fetch_and(&prv->idle_lcpus, ~mask, __ATOMIC_SEQ_CST);
+#else
+	ukplat_lcpu_halt_to(until);
+	/* handle pending events if any */
+	ukplat_lcpu_irqs_handle_pending();
+#endif
+}
+
 static void schedcoop_schedule(struct uk_sched *s)
 {
 	struct schedcoop_private *prv = s->prv;
-	struct uk_thread *prev, *next, *thread, *tmp;
+	struct uk_thread *prev, *next;
 	unsigned long flags;
+	__u8 lcpu;
 
 	if (ukplat_lcpu_irqs_disabled())
 		UK_CRASH("Must not call %s with IRQs disabled\n", __func__);
 
 	prev = uk_thread_current();
 	flags = ukplat_lcpu_save_irqf();
+	lcpu = ukplat_lcpu_id();
 
 #if 0 //TODO
 	if (in_callback)
 		UK_CRASH("Must not call %s from a callback\n", __func__);
 #endif
 
+	/* Put previous thread on the end of the list, or park it until it
+	 * gets woken up
+	 */
+	ukarch_spin_lock(&prev->sched_lock);
+	if (is_runnable(prev) && !is_exited(prev))
+		runq_enqueue(prv, prev);
+	else
+		set_queueable(prev);
+	ukarch_spin_unlock(&prev->sched_lock);
+
 	do {
-		/* Examine all threads.
-		 * Find a runnable thread, but also wake up expired ones and
-		 * find the time when the next timeout expires, else use
-		 * 10 seconds.
+		/* Find a runnable thread, but also wake up expired ones and
+		 * find the time when the next timeout expires, if any.
 		 */
 		__snsec now = ukplat_monotonic_clock();
-		__snsec min_wakeup_time = now + ukarch_time_sec_to_nsec(10);
-
-		/* wake some sleeping threads */
-		UK_TAILQ_FOREACH_SAFE(thread, &prv->sleeping_threads,
-				      thread_list, tmp) {
+		__snsec next_wakeup;
 
-			if (thread->wakeup_time && thread->wakeup_time <= now)
-				uk_thread_wake(thread);
+		next_wakeup = wake_expired(prv, now);
 
-			else if (thread->wakeup_time < min_wakeup_time)
-				min_wakeup_time = thread->wakeup_time;
-		}
-
-		next = UK_TAILQ_FIRST(&prv->thread_list);
-		if (next) {
-			UK_ASSERT(next != prev);
-			UK_ASSERT(is_runnable(next));
-			UK_ASSERT(!is_exited(next));
-			UK_TAILQ_REMOVE(&prv->thread_list, next,
-					thread_list);
-			/* Put previous thread on the end of the list */
-			if (is_runnable(prev))
-				UK_TAILQ_INSERT_TAIL(&prv->thread_list, prev,
-						thread_list);
-			else
-				set_queueable(prev);
-			clear_queueable(next);
-			ukplat_stack_set_current_thread(next);
+		next = runq_pick(prv, lcpu, lcpu, prev);
+		if (!next)
+			next = runq_steal(prv, lcpu);
+		if (next)
 			break;
-		} else if (is_runnable(prev)) {
-			next = prev;
+
+		/* An exited thread must not stay on the CPU while it halts:
+		 * the thread that reaps it waits until its context is no
+		 * longer in use
+		 */
+		if (is_exited(prev)) {
+			next = prv->runq[lcpu].idle;
+			next->running = 1;
 			break;
 		}
 
-		/* block until the next timeout expires, or for 10 secs,
-		 * whichever comes first
+		/* block until the next timeout expires or until an
+		 * interrupt arrives; without timeouts there is no reason to
+		 * wake up periodically
 		 */
-		ukplat_lcpu_halt_to(min_wakeup_time);
-		/* handle pending events if any */
-		ukplat_lcpu_irqs_handle_pending();
-
+		lcpu_halt(prv, lcpu, next_wakeup ? next_wakeup : __SNSEC_MAX);
 	} while (1);
 
+	if (prev != next)
+		ukplat_stack_set_current_thread(next);
+
 	ukplat_lcpu_restore_irqf(flags);
 
 	/* Interrupting the switch is equivalent to having the next thread
@@ -128,14 +361,20 @@ static void schedcoop_schedule(struct uk_sched *s)
 	if (prev != next)
 		uk_sched_thread_switch(s, prev, next);
 
-	UK_TAILQ_FOREACH_SAFE(thread, &s->exited_threads, thread_list, tmp) {
-		if (!thread->detached)
-			/* someone will eventually wait for it */
-			continue;
+	uk_sched_thread_destroy_exited(s);
+}
 
-		if (thread != prev)
-			uk_sched_thread_destroy(s, thread);
-	}
+/* New threads go to an idle logical CPU if there is one */
+static __u8 pick_lcpu(struct schedcoop_private *prv __maybe_unused)
+{
+#if CONFIG_HAVE_SMP
+	unsigned long idle;
+
+	idle = __atomic_load_n(&prv->idle_lcpus, __ATOMIC_RELAXED);
+	if (idle)
+		return __builtin_ctzl(idle);
+#endif
+	return ukplat_lcpu_id();
 }
 
 static int schedcoop_thread_add(struct uk_sched *s, struct uk_thread *t,
@@ -143,12 +382,27 @@ static int schedcoop_thread_add(struct uk_sched *s, struct uk_thread *t,
 {
 	unsigned long flags;
 	struct schedcoop_private *prv = s->prv;
+	int rc;
 
+	/* Every thread may go to sleep: make room in the sleep queue now
+	 * so that blocking never needs to allocate memory
+	 */
+	ukplat_spin_lock_irqsave(&prv->sleep_lock, flags);
+	rc = uk_sleepq_reserve(&prv->sleeping_threads, s->allocator,
+			       prv->nb_threads + 1);
+	if (rc == 0)
+		prv->nb_threads++;
+	ukplat_spin_unlock_irqrestore(&prv->sleep_lock, flags);
+	if (rc)
+		return rc;
+
+	ukplat_spin_lock_irqsave(&t->sched_lock, flags);
 	set_runnable(t);
+	t->lcpu = pick_lcpu(prv);
+	runq_enqueue(prv, t);
+	ukplat_spin_unlock_irqrestore(&t->sched_lock, flags);
 
-	flags = ukplat_lcpu_save_irqf();
-	UK_TAILQ_INSERT_TAIL(&prv->thread_list, t, thread_list);
-	ukplat_lcpu_restore_irqf(flags);
+	kick_lcpu(prv, t->lcpu);
 
 	return 0;
 }
@@ -160,15 +414,24 @@ static void schedcoop_thread_remove(struct uk_sched *s, struct uk_thread *t)
 
 	flags = ukplat_lcpu_save_irqf();
 
-	/* Remove from the thread list */
-	if (t != uk_thread_current())
-		UK_TAILQ_REMOVE(&prv->thread_list, t, thread_list);
+	/* Remove from the sleep queue or the run queue */
+	ukarch_spin_lock(&t->sched_lock);
+	if (!is_runnable(t) && t->wakeup_time > 0)
+		sleepq_remove(prv, t);
+	else if (is_queued(t))
+		runq_remove(prv, t);
 	clear_runnable(t);
+	clear_queueable(t);
+	ukarch_spin_unlock(&t->sched_lock);
 
-	uk_thread_exit(t);
+	ukarch_spin_lock(&prv->sleep_lock);
+	prv->nb_threads--;
+	ukarch_spin_unlock(&prv->sleep_lock);
 
 	/* Put onto exited list */
-	UK_TAILQ_INSERT_HEAD(&s->exited_threads, t, thread_list);
+	uk_sched_thread_exited(s, t);
+
+	uk_thread_exit(t);
 
 	ukplat_lcpu_restore_irqf(flags);
 
@@ -179,18 +442,25 @@ static void schedcoop_thread_remove(struct uk_sched *s, struct uk_thread *t)
 	}
 }
 
+/* Called with the thread's sched_lock held */
 static void schedcoop_thread_blocked(struct uk_sched *s, struct uk_thread *t)
 {
 	struct schedcoop_private *prv = s->prv;
 
 	UK_ASSERT(ukplat_lcpu_irqs_disabled());
 
-	if (t != uk_thread_current())
-		UK_TAILQ_REMOVE(&prv->thread_list, t, thread_list);
+	/* A thread that is not running is parked right away, a running one
+	 * when it calls into the scheduler
+	 */
+	if (is_queued(t)) {
+		runq_remove(prv, t);
+		set_queueable(t);
+	}
 	if (t->wakeup_time > 0)
-		UK_TAILQ_INSERT_TAIL(&prv->sleeping_threads, t, thread_list);
+		sleepq_add(prv, t);
 }
 
+/* Called with the thread's sched_lock held */
 static void schedcoop_thread_woken(struct uk_sched *s, struct uk_thread *t)
 {
 	struct schedcoop_private *prv = s->prv;
@@ -198,18 +468,76 @@ static void schedcoop_thread_woken(struct uk_sched *s, struct uk_thread *t)
 	UK_ASSERT(ukplat_lcpu_irqs_disabled());
 
 	if (t->wakeup_time > 0)
-		UK_TAILQ_REMOVE(&prv->sleeping_threads, t, thread_list);
-	if (t != uk_thread_current() || is_queueable(t)) {
-		UK_TAILQ_INSERT_TAIL(&prv->thread_list, t, thread_list);
+		sleepq_remove(prv, t);
+	if (is_queueable(t)) {
 		clear_queueable(t);
+		runq_enqueue(prv, t);
+		kick_lcpu(prv, t->lcpu);
 	}
 }
 
+static void idle_thread_fn(void *unused __unused);
+
+#if CONFIG_HAVE_SMP
+/* Runs on a fresh logical CPU with interrupts disabled */
+static void lcpu_entry(void *arg)
+{
+	struct uk_thread *idle = (struct uk_thread *) arg;
+
+	idle->running = 1;
+	ukplat_stack_set_current_thread(idle);
+	ukplat_thread_ctx_start(&idle->sched->plat_ctx_cbs, idle->ctx);
+}
+
+static void start_lcpus(struct uk_sched *s)
+{
+	struct schedcoop_private *prv = s->prv;
+	__u8 i;
+	int rc;
+
+	for (i = 1; i < ukplat_lcpu_count(); i++) {
+		rc = ukplat_lcpu_start(i, lcpu_entry, prv->runq[i].idle);
+		if (rc) {
+			uk_pr_err("Failed to start logical CPU %u: %d\n",
+				  i, rc);
+			break;
+		}
+	}
+}
+
+static int init_lcpus(struct uk_sched *s)
+{
+	struct schedcoop_private *prv = s->prv;
+	struct uk_thread *idle;
+	__u8 i;
+	int rc;
+
+	for (i = 1; i < ukplat_lcpu_count(); i++) {
+		idle = uk_malloc(s->allocator, sizeof(*idle));
+		if (!idle)
+			return -ENOMEM;
+		rc = uk_sched_idle_thread_init(s, idle, NULL,
+					       idle_thread_fn, NULL);
+		if (rc) {
+			uk_free(s->allocator, idle);
+			return rc;
+		}
+		idle->lcpu = i;
+		prv->runq[i].idle = idle;
+	}
+	return 0;
+}
+#endif /* CONFIG_HAVE_SMP */
+
 static void idle_thread_fn(void *unused __unused)
 {
 	struct uk_thread *current = uk_thread_current();
 	struct uk_sched *s = current->sched;
 
+#if CONFIG_HAVE_SMP
+	if (ukplat_lcpu_id() == 0)
+		start_lcpus(s);
+#endif
 	s->threads_started = true;
 	ukplat_lcpu_enable_irq();
 
@@ -228,6 +556,7 @@ struct uk_sched *uk_schedcoop_init(struct uk_alloc *a)
 {
 	struct schedcoop_private *prv = NULL;
 	struct uk_sched *sched = NULL;
+	unsigned int i;
 
 	uk_pr_info("Initializing cooperative scheduler\n");
 
@@ -238,10 +567,28 @@ struct uk_sched *uk_schedcoop_init(struct uk_alloc *a)
 	ukplat_ctx_callbacks_init(&sched->plat_ctx_cbs, ukplat_ctx_sw);
 
 	prv = sched->prv;
-	UK_TAILQ_INIT(&prv->thread_list);
-	UK_TAILQ_INIT(&prv->sleeping_threads);
+	prv->runq = uk_memalign(a, __alignof__(*prv->runq),
+				sizeof(*prv->runq) * ukplat_lcpu_count());
+	if (prv->runq == NULL)
+		goto err_free_sched;
+	for (i = 0; i < ukplat_lcpu_count(); i++) {
+		ukarch_spin_lock_init(&prv->runq[i].lock);
+		UK_TAILQ_INIT(&prv->runq[i].threads);
+		prv->runq[i].count = 0;
+		prv->runq[i].idle = NULL;
+	}
+	ukarch_spin_lock_init(&prv->sleep_lock);
+	uk_sleepq_init(&prv->sleeping_threads);
+	prv->nb_threads = 0;
+	prv->next_wakeup = 0;
+	prv->idle_lcpus = 0;
 
 	uk_sched_idle_init(sched, NULL, idle_thread_fn);
+	prv->runq[0].idle = &sched->idle;
+#if CONFIG_HAVE_SMP
+	if (init_lcpus(sched))
+		UK_CRASH("Failed to initialize idle threads\n");
+#endif
 
 	uk_sched_init(sched,
 			schedcoop_yield,
@@ -252,4 +599,8 @@ struct uk_sched *uk_schedcoop_init(struct uk_alloc *a)
 			NULL, NULL, NULL, NULL);
 
 	return sched;
+
+err_free_sched:
+	uk_free(a, sched);
+	return NULL;
 }
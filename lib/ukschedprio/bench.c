@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <errno.h>
+#include <uk/essentials.h>
+#include <uk/alloc.h>
+#include <uk/sched.h>
+#include <uk/thread.h>
+#include <uk/print.h>
+#include <uk/plat/time.h>
+#include <uk/schedprio.h>
+
+/* Sleep period of the thread that measures the wakeup latency */
+#define BENCH_PROBE_PERIOD	ukarch_time_msec_to_nsec(1)
+
+struct bench_worker {
+	volatile __u64 progress;
+	__nsec end;
+};
+
+struct bench_prober {
+	__nsec end;
+	__nsec latency_sum;
+	__nsec latency_max;
+	unsigned int nb_wakeups;
+};
+
+/* Counts loop iterations until the end of the benchmark: the count is
+ * proportional to the CPU time the worker got
+ */
+static void bench_worker(void *arg)
+{
+	struct bench_worker *w = arg;
+
+	while (ukplat_monotonic_clock() < w->end)
+		w->progress++;
+}
+
+/* Measures how late a high priority thread runs after its wakeup time
+ * while the workers keep the CPU busy
+ */
+static void bench_prober(void *arg)
+{
+	struct bench_prober *p = arg;
+	__nsec expected, now, latency;
+
+	do {
+		expected = ukplat_monotonic_clock() + BENCH_PROBE_PERIOD;
+		uk_sched_thread_sleep(BENCH_PROBE_PERIOD);
+		now = ukplat_monotonic_clock();
+
+		latency = (now > expected) ? now - expected : 0;
+		p->latency_sum += latency;
+		p->latency_max = MAX(p->latency_max, latency);
+		p->nb_wakeups++;
+	} while (now < p->end);
+}
+
+int uk_schedprio_bench(struct uk_sched *sched, unsigned int nb_workers,
+		       __nsec duration)
+{
+	struct bench_worker *workers;
+	struct bench_prober prober = { 0 };
+	struct uk_thread **threads;
+	struct uk_thread *prober_thread;
+	uk_thread_attr_t attr;
+	__u64 total = 0, share, share_min = ~0ULL, share_max = 0;
+	__u64 share_sum = 0, share_sq_sum = 0, fairness;
+	unsigned int i, nb_created;
+	__nsec end;
+	int rc = 0;
+
+	UK_ASSERT(sched);
+	UK_ASSERT(nb_workers > 0);
+
+	workers = uk_calloc(sched->allocator, nb_workers, sizeof(*workers));
+	threads = uk_calloc(sched->allocator, nb_workers, sizeof(*threads));
+	if (!workers || !threads) {
+		rc = -ENOMEM;
+		goto out_free;
+	}
+
+	/* The workers stop on their own: without preemption, the first
+	 * one keeps the CPU until the end
+	 */
+	end = ukplat_monotonic_clock() + duration;
+	for (nb_created = 0; nb_created < nb_workers; nb_created++) {
+		workers[nb_created].end = end;
+		threads[nb_created] = uk_sched_thread_create(sched, "worker",
+							     NULL,
+							     bench_worker,
+							     &workers[nb_created]);
+		if (!threads[nb_created]) {
+			uk_pr_err("Failed to create worker thread %u\n",
+				  nb_created);
+			rc = -ENOMEM;
+			goto out_wait;
+		}
+	}
+
+	prober.end = end;
+	uk_thread_attr_init(&attr);
+	uk_thread_attr_set_prio(&attr, UK_THREAD_ATTR_PRIO_MAX);
+	prober_thread = uk_sched_thread_create(sched, "prober", &attr,
+					       bench_prober, &prober);
+	uk_thread_attr_fini(&attr);
+	if (!prober_thread) {
+		uk_pr_err("Failed to create prober thread\n");
+		rc = -ENOMEM;
+		goto out_wait;
+	}
+	uk_thread_wait(prober_thread);
+
+out_wait:
+	for (i = 0; i < nb_created; i++)
+		uk_thread_wait(threads[i]);
+	if (rc)
+		goto out_free;
+
+	/* Jain's fairness index of the CPU shares (in ppm) of the workers:
+	 * 1000 means equal shares, 1000 / nb_workers means that one worker
+	 * got all CPU time
+	 */
+	for (i = 0; i < nb_workers; i++)
+		total += workers[i].progress;
+	for (i = 0; i < nb_workers; i++) {
+		share = workers[i].progress * 1000000 / MAX(total, 1ULL);
+		share_min = MIN(share_min, share);
+		share_max = MAX(share_max, share);
+		share_sum += share;
+		share_sq_sum += share * share;
+	}
+	fairness = share_sum * share_sum * 1000
+		   / MAX((__u64) nb_workers * share_sq_sum, 1ULL);
+
+	uk_pr_info("Wakeup latency with %u busy threads: avg %"__PRInsec
+		   " ns, max %"__PRInsec" ns (%u wakeups)\n",
+		   nb_workers,
+		   prober.latency_sum / MAX(prober.nb_wakeups, 1U),
+		   prober.latency_max, prober.nb_wakeups);
+	uk_pr_info("CPU shares of %u busy threads: min %"__PRIu64
+		   " ppm, max %"__PRIu64" ppm, fairness index %"__PRIu64
+		   "/1000\n", nb_workers, share_min, share_max, fairness);
+
+out_free:
+	uk_free(sched->allocator, threads);
+	uk_free(sched->allocator, workers);
+	return rc;
+}
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Preemptive priority scheduler with round-robin time slicing among
+ * threads of equal priority.
+ */
+
+#ifndef __UK_SCHEDPRIO_H__
+#define __UK_SCHEDPRIO_H__
+
+#include <uk/sched.h>
+#include <uk/alloc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct uk_sched *uk_schedprio_init(struct uk_alloc *a);
+
+#if CONFIG_LIBUKSCHEDPRIO_BENCH
+/**
+ * Runs `nb_workers` CPU-bound threads of default priority for `duration`
+ * nanoseconds next to a thread of the highest priority that sleeps for 1ms
+ * in a loop. Prints the wakeup latency of the high priority thread and the
+ * CPU shares of the workers together with Jain's fairness index on the
+ * kernel console.
+ *
+ * @param sched
+ *   Preemptive priority scheduler of the calling thread
+ * @param nb_workers
+ *   Number of CPU-bound threads
+ * @param duration
+ *   Run time of the benchmark in nanoseconds
+ * @return
+ *   - (0): on success
+ *   - (-ENOMEM): a thread could not be created
+ */
+int uk_schedprio_bench(struct uk_sched *sched, unsigned int nb_workers,
+		       __nsec duration);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_SCHEDPRIO_H__ */
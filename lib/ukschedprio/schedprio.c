@@ -0,0 +1,567 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+/*
+ * Preemptive priority scheduler.
+ *
+ * Runnable threads are kept in one FIFO run queue per priority. A bitmap
+ * of non-empty run queues lets us pick the highest priority runnable thread
+ * in constant time. Threads of equal priority are scheduled round-robin:
+ * a thread runs until it blocks, yields, or its time slice expires.
+ *
+ * Preemption happens at the end of an interrupt (see
+ * ukplat_irq_set_exit_handler()): when the time slice of the interrupted
+ * thread expired or a thread with a higher priority was woken up, the
+ * interrupted thread is put back to its run queue and we switch away on
+ * its stack. It resumes in the interrupt exit path later. The platform
+ * timer is armed for the earlier of the end of the current time slice and
+ * the next sleeping thread's wakeup time.
+ */
+
+#include <uk/plat/lcpu.h>
+#include <uk/plat/irq.h>
+#include <uk/plat/memory.h>
+#include <uk/plat/time.h>
+#include <uk/preempt.h>
+#include <uk/bitops.h>
+#include <uk/sched.h>
+#include <uk/sleepq.h>
+#include <uk/schedprio.h>
+
+#define SCHEDPRIO_NB_PRIO		(UK_THREAD_ATTR_PRIO_MAX + 1)
+#define SCHEDPRIO_BITMAP_LEN		UK_BITS_TO_LONGS(SCHEDPRIO_NB_PRIO)
+#define SCHEDPRIO_TIMESLICE_DEFAULT					\
+	ukarch_time_msec_to_nsec(CONFIG_LIBUKSCHEDPRIO_TIMESLICE)
+
+struct schedprio_private {
+	struct uk_thread_list runq[SCHEDPRIO_NB_PRIO];
+	unsigned long runq_bitmap[SCHEDPRIO_BITMAP_LEN];
+	struct uk_sleepq sleeping_threads;
+	unsigned int nb_threads;
+
+	__snsec slice_end;	/* end of the current thread's time slice */
+	bool need_resched;	/* higher priority thread became runnable */
+};
+
+/* Preemption is deferred while this counter is non-zero (see uk/preempt.h).
+ * It belongs to the running thread and is swapped on every thread switch.
+ */
+unsigned long uk_preempt_count;
+int uk_preempt_pending;
+
+/* Scheduler instance that is driven by the interrupt exit handler */
+static struct uk_sched *schedprio;
+
+static inline void runq_add(struct schedprio_private *prv,
+			    struct uk_thread *t)
+{
+	UK_TAILQ_INSERT_TAIL(&prv->runq[t->prio], t, thread_list);
+	prv->runq_bitmap[UK_BIT_WORD(t->prio)] |= UK_BIT_MASK(t->prio);
+}
+
+static inline void runq_add_head(struct schedprio_private *prv,
+				 struct uk_thread *t)
+{
+	UK_TAILQ_INSERT_HEAD(&prv->runq[t->prio], t, thread_list);
+	prv->runq_bitmap[UK_BIT_WORD(t->prio)] |= UK_BIT_MASK(t->prio);
+}
+
+static inline void runq_remove(struct schedprio_private *prv,
+			       struct uk_thread *t)
+{
+	UK_TAILQ_REMOVE(&prv->runq[t->prio], t, thread_list);
+	if (UK_TAILQ_EMPTY(&prv->runq[t->prio]))
+		prv->runq_bitmap[UK_BIT_WORD(t->prio)] &=
+			~UK_BIT_MASK(t->prio);
+}
+
+/* Returns the highest priority with a runnable thread, -1 if none */
+static inline int runq_highest_prio(struct schedprio_private *prv)
+{
+	int i;
+
+	for (i = SCHEDPRIO_BITMAP_LEN - 1; i >= 0; i--) {
+		if (prv->runq_bitmap[i])
+			return i * UK_BITS_PER_LONG
+				+ ukarch_flsl(prv->runq_bitmap[i]);
+	}
+	return -1;
+}
+
+/* Wakes up expired sleeping threads and returns the next wakeup time,
+ * or `max` if no thread wakes up before
+ */
+static __snsec wake_sleeping_threads(struct schedprio_private *prv,
+				     __snsec now, __snsec max)
+{
+	struct uk_thread *thread;
+
+	while ((thread = uk_sleepq_first(&prv->sleeping_threads))) {
+		if (thread->wakeup_time > now)
+			return MIN(thread->wakeup_time, max);
+		uk_thread_wake(thread);
+	}
+	return max;
+}
+
+/* A thread with a higher priority than the current one became runnable */
+static inline void request_resched(struct schedprio_private *prv)
+{
+	prv->need_resched = true;
+	uk_preempt_pending = 1;
+}
+
+/* Takes the highest priority thread from the run queues. A runnable `prev`
+ * is queued first so that it competes with the other threads; it
+ * continues if it still has the highest priority. A thread that is
+ * preempted before its time slice expired is queued at the head, so it
+ * is the next to run on its priority and finishes its time slice.
+ * Returns NULL if there is no runnable thread.
+ */
+static struct uk_thread *pick_next(struct schedprio_private *prv,
+				   struct uk_thread *prev, bool preempted)
+{
+	struct uk_thread *next;
+	int prio;
+
+	if (is_runnable(prev)) {
+		if (preempted)
+			runq_add_head(prv, prev);
+		else
+			runq_add(prv, prev);
+	}
+
+	prio = runq_highest_prio(prv);
+	if (prio < 0)
+		return NULL;
+
+	next = UK_TAILQ_FIRST(&prv->runq[prio]);
+	UK_ASSERT(is_runnable(next));
+	UK_ASSERT(!is_exited(next));
+	runq_remove(prv, next);
+	return next;
+}
+
+/* Starts the time slice of `next` and arms the timer */
+static void start_slice(struct schedprio_private *prv,
+			struct uk_thread *next, __snsec now,
+			__snsec next_wakeup)
+{
+	if (next->slice_left) {
+		prv->slice_end = now + next->slice_left;
+		next->slice_left = 0;
+	} else {
+		prv->slice_end = now + next->timeslice;
+	}
+	prv->need_resched = false;
+	uk_preempt_pending = 0;
+	ukplat_time_set_deadline(MIN(prv->slice_end, next_wakeup));
+}
+
+/* Switches from `prev` to `next` and restores the interrupt state of `prev`
+ * when it is scheduled again. Interrupts are enabled for the switch: this
+ * way, threads that run for the first time start with interrupts enabled.
+ */
+static void schedprio_switch(struct uk_sched *s, struct uk_thread *prev,
+			     struct uk_thread *next, unsigned long flags)
+{
+	if (prev != next) {
+		if (!is_runnable(prev))
+			set_queueable(prev);
+		clear_queueable(next);
+		next->running = 1;
+		ukplat_stack_set_current_thread(next);
+
+		/* A thread that blocks with preemption disabled keeps it
+		 * disabled for itself only
+		 */
+		prev->preempt_count = uk_preempt_count;
+		uk_preempt_count = next->preempt_count;
+
+		ukplat_lcpu_enable_irq();
+		uk_sched_thread_switch(s, prev, next);
+	}
+
+	/* We are `prev` again */
+	ukplat_lcpu_restore_irqf(flags);
+	prev->in_sched = false;
+}
+
+static void schedprio_schedule(struct uk_sched *s)
+{
+	struct schedprio_private *prv = s->prv;
+	struct uk_thread *prev, *next;
+	unsigned long flags;
+	__snsec now, next_wakeup;
+
+	if (ukplat_lcpu_irqs_disabled())
+		UK_CRASH("Must not call %s with IRQs disabled\n", __func__);
+
+	prev = uk_thread_current();
+	flags = ukplat_lcpu_save_irqf();
+	prev->in_sched = true;
+
+	do {
+		/* Wake up expired threads and find the time when the next
+		 * timeout expires, if any.
+		 */
+		now = ukplat_monotonic_clock();
+		next_wakeup = wake_sleeping_threads(prv, now, __SNSEC_MAX);
+
+		next = pick_next(prv, prev, false);
+		if (next)
+			break;
+
+		/* block until the next timeout expires or until an
+		 * interrupt arrives
+		 */
+		ukplat_lcpu_halt_to(next_wakeup);
+		/* handle pending events if any */
+		ukplat_lcpu_irqs_handle_pending();
+
+	} while (1);
+
+	start_slice(prv, next, now, next_wakeup);
+	schedprio_switch(s, prev, next, flags);
+
+	uk_sched_thread_destroy_exited(s);
+}
+
+/* Switches away from the running thread `current` with interrupts disabled,
+ * `flags` is the interrupt state to restore when it continues
+ */
+static void schedprio_preempt(struct uk_sched *s, struct uk_thread *current,
+			      __snsec now, unsigned long flags)
+{
+	struct schedprio_private *prv = s->prv;
+	struct uk_thread *next;
+
+	current->in_sched = true;
+
+	if (now < prv->slice_end)
+		current->slice_left = prv->slice_end - now;
+	next = pick_next(prv, current, current->slice_left != 0);
+	UK_ASSERT(next); /* at least `current` is runnable */
+
+	start_slice(prv, next, now,
+		    wake_sleeping_threads(prv, now, now + next->timeslice));
+	schedprio_switch(s, current, next, flags);
+}
+
+/* Called by uk_preempt_enable() when the reschedule that was deferred while
+ * preemption was disabled can be done
+ */
+void uk_preempt_schedule(void)
+{
+	struct uk_sched *s = schedprio;
+	struct schedprio_private *prv;
+	struct uk_thread *current;
+	unsigned long flags;
+	__snsec now;
+
+	/* Interrupt handlers reschedule on their exit */
+	if (!s || !uk_sched_started(s) || ukplat_lcpu_irqs_disabled())
+		return;
+
+	current = uk_thread_current();
+	if (current->sched != s || current->in_sched || !is_runnable(current))
+		return;
+
+	prv = s->prv;
+	flags = ukplat_lcpu_save_irqf();
+	uk_preempt_pending = 0;
+	now = ukplat_monotonic_clock();
+	if (uk_preempt_disabled()
+	    || (!prv->need_resched && now < prv->slice_end)) {
+		ukplat_lcpu_restore_irqf(flags);
+		return;
+	}
+	schedprio_preempt(s, current, now, flags);
+}
+
+/* Called at the end of each interrupt, with interrupts disabled */
+static void schedprio_irq_exit(void)
+{
+	struct uk_sched *s = schedprio;
+	struct schedprio_private *prv;
+	struct uk_thread *current;
+	unsigned long flags;
+	__snsec now, next_wakeup;
+
+	if (!s || !uk_sched_started(s))
+		return;
+
+	/* Do not interfere with threads that are switching or that are
+	 * about to block: they enter the scheduler on their own
+	 */
+	current = uk_thread_current();
+	if (current->sched != s || current->in_sched || !is_runnable(current))
+		return;
+
+	prv = s->prv;
+	now = ukplat_monotonic_clock();
+	next_wakeup = wake_sleeping_threads(prv, now, prv->slice_end);
+
+	if (!prv->need_resched && now < prv->slice_end) {
+		ukplat_time_set_deadline(next_wakeup);
+		return;
+	}
+
+	if (uk_preempt_disabled()) {
+		/* uk_preempt_enable() switches threads, the next tick is
+		 * the fallback if it is called with interrupts disabled
+		 */
+		uk_preempt_pending = 1;
+		ukplat_time_set_deadline(now + UKPLAT_TIME_TICK_NSEC);
+		return;
+	}
+
+	flags = ukplat_lcpu_save_irqf();
+	schedprio_preempt(s, current, now, flags);
+}
+
+static int schedprio_thread_add(struct uk_sched *s, struct uk_thread *t,
+	const uk_thread_attr_t *attr)
+{
+	unsigned long flags;
+	struct schedprio_private *prv = s->prv;
+	int rc;
+
+	/* Every thread may go to sleep: make room in the sleep queue now
+	 * so that blocking never needs to allocate memory
+	 */
+	rc = uk_sleepq_reserve(&prv->sleeping_threads, s->allocator,
+			       prv->nb_threads + 1);
+	if (rc)
+		return rc;
+
+	t->prio = UK_THREAD_ATTR_PRIO_DEFAULT;
+	t->timeslice = SCHEDPRIO_TIMESLICE_DEFAULT;
+	if (attr) {
+		if (attr->prio != UK_THREAD_ATTR_PRIO_INVALID)
+			t->prio = attr->prio;
+		if (attr->timeslice != UK_THREAD_ATTR_TIMESLICE_NIL)
+			t->timeslice = attr->timeslice;
+	}
+	t->slice_left = 0;
+	t->in_sched = false;
+	t->preempt_count = 0;
+
+	set_runnable(t);
+
+	flags = ukplat_lcpu_save_irqf();
+	prv->nb_threads++;
+	runq_add(prv, t);
+	if (uk_sched_started(s) && t->prio > uk_thread_current()->prio)
+		request_resched(prv);
+	ukplat_lcpu_restore_irqf(flags);
+
+	return 0;
+}
+
+static void schedprio_thread_remove(struct uk_sched *s, struct uk_thread *t)
+{
+	unsigned long flags;
+	struct schedprio_private *prv = s->prv;
+
+	flags = ukplat_lcpu_save_irqf();
+
+	/* Remove from the sleep queue or the run queue */
+	if (!is_runnable(t) && t->wakeup_time > 0)
+		uk_sleepq_remove(&prv->sleeping_threads, t);
+	else if (t != uk_thread_current() && is_runnable(t))
+		runq_remove(prv, t);
+	clear_runnable(t);
+	prv->nb_threads--;
+
+	uk_thread_exit(t);
+
+	/* Put onto exited list */
+	uk_sched_thread_exited(s, t);
+
+	ukplat_lcpu_restore_irqf(flags);
+
+	/* Schedule only if current thread is exiting */
+	if (t == uk_thread_current()) {
+		schedprio_schedule(s);
+		uk_pr_warn("schedule() returned! Trying again\n");
+	}
+}
+
+static void schedprio_thread_blocked(struct uk_sched *s, struct uk_thread *t)
+{
+	struct schedprio_private *prv = s->prv;
+
+	UK_ASSERT(ukplat_lcpu_irqs_disabled());
+
+	if (t != uk_thread_current())
+		runq_remove(prv, t);
+	if (t->wakeup_time > 0)
+		uk_sleepq_add(&prv->sleeping_threads, t);
+}
+
+static void schedprio_thread_woken(struct uk_sched *s, struct uk_thread *t)
+{
+	struct schedprio_private *prv = s->prv;
+	struct uk_thread *current = uk_thread_current();
+
+	UK_ASSERT(ukplat_lcpu_irqs_disabled());
+
+	if (t->wakeup_time > 0)
+		uk_sleepq_remove(&prv->sleeping_threads, t);
+	if (t != current || is_queueable(t)) {
+		runq_add(prv, t);
+		clear_queueable(t);
+
+		/* Preempt the current thread at the end of the interrupt */
+		if (t->prio > current->prio)
+			request_resched(prv);
+	}
+}
+
+static int schedprio_thread_set_prio(struct uk_sched *s, struct uk_thread *t,
+				     prio_t prio)
+{
+	struct schedprio_private *prv = s->prv;
+	struct uk_thread *current = uk_thread_current();
+	unsigned long flags;
+	bool queued;
+
+	if (prio < UK_THREAD_ATTR_PRIO_MIN || prio > UK_THREAD_ATTR_PRIO_MAX)
+		return -EINVAL;
+
+	flags = ukplat_lcpu_save_irqf();
+	queued = (t != current && is_runnable(t));
+	if (queued)
+		runq_remove(prv, t);
+	t->prio = prio;
+	if (queued)
+		runq_add(prv, t);
+
+	if (runq_highest_prio(prv) > current->prio)
+		request_resched(prv);
+	ukplat_lcpu_restore_irqf(flags);
+
+	return 0;
+}
+
+static int schedprio_thread_get_prio(struct uk_sched *s __unused,
+				     const struct uk_thread *t, prio_t *prio)
+{
+	*prio = t->prio;
+	return 0;
+}
+
+static int schedprio_thread_set_tslice(struct uk_sched *s __unused,
+				       struct uk_thread *t, int tslice)
+{
+	/* Time slices are given in nanoseconds, like the time slice
+	 * thread attribute
+	 */
+	if (tslice < 0 || (__nsec) tslice < UKPLAT_TIME_TICK_NSEC)
+		return -EINVAL;
+
+	/* Takes effect with the next time slice of the thread */
+	t->timeslice = (__nsec) tslice;
+	return 0;
+}
+
+static int schedprio_thread_get_tslice(struct uk_sched *s __unused,
+				       const struct uk_thread *t, int *tslice)
+{
+	*tslice = (int) MIN(t->timeslice, (__nsec) __INT_MAX__);
+	return 0;
+}
+
+static void idle_thread_fn(void *unused __unused)
+{
+	struct uk_thread *current = uk_thread_current();
+	struct uk_sched *s = current->sched;
+
+	s->threads_started = true;
+	ukplat_lcpu_enable_irq();
+
+	while (1) {
+		uk_thread_block(current);
+		schedprio_schedule(s);
+	}
+}
+
+static void schedprio_yield(struct uk_sched *s)
+{
+	schedprio_schedule(s);
+}
+
+struct uk_sched *uk_schedprio_init(struct uk_alloc *a)
+{
+	struct schedprio_private *prv = NULL;
+	struct uk_sched *sched = NULL;
+	int i, rc;
+
+	uk_pr_info("Initializing priority scheduler\n");
+
+	sched = uk_sched_create(a, sizeof(struct schedprio_private));
+	if (sched == NULL)
+		return NULL;
+
+	ukplat_ctx_callbacks_init(&sched->plat_ctx_cbs, ukplat_ctx_sw);
+
+	prv = sched->prv;
+	for (i = 0; i < SCHEDPRIO_NB_PRIO; i++)
+		UK_TAILQ_INIT(&prv->runq[i]);
+	for (i = 0; i < (int) SCHEDPRIO_BITMAP_LEN; i++)
+		prv->runq_bitmap[i] = 0;
+	uk_sleepq_init(&prv->sleeping_threads);
+	prv->nb_threads = 0;
+	prv->slice_end = 0;
+	prv->need_resched = false;
+
+	uk_sched_idle_init(sched, NULL, idle_thread_fn);
+
+	uk_sched_init(sched,
+			schedprio_yield,
+			schedprio_thread_add,
+			schedprio_thread_remove,
+			schedprio_thread_blocked,
+			schedprio_thread_woken,
+			schedprio_thread_set_prio,
+			schedprio_thread_get_prio,
+			schedprio_thread_set_tslice,
+			schedprio_thread_get_tslice);
+
+	/* Only one instance can be driven by the interrupt exit handler */
+	if (!schedprio) {
+		schedprio = sched;
+		rc = ukplat_irq_set_exit_handler(schedprio_irq_exit);
+		if (rc < 0)
+			uk_pr_warn("Platform does not support preemption, scheduling cooperatively\n");
+	}
+
+	return sched;
+}
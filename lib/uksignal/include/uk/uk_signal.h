@@ -113,6 +113,13 @@ int uk_proc_sig_init(struct uk_proc_sig *sig);
 
 /* TODO: replace sched thread_kill? */
 int uk_sig_thread_kill(struct uk_thread *tid, int sig);
+
+/*
+ * Sends a filled in siginfo to process pid, so that senders like timers
+ * can pass their own si_code and si_value.
+ * Returns 0 on success or a negative errno value.
+ */
+int uk_sig_proc_queue(pid_t pid, siginfo_t *siginfo);
 int uk_thread_sigmask(int how, const sigset_t *set, sigset_t *oldset);
 
 /* internal use */
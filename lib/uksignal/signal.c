@@ -45,6 +45,9 @@
 #include <uk/process.h>
 #include <unistd.h>
 #include <uk/syscall.h>
+#if CONFIG_LIBUKTIME_TIMER
+#include <sys/time.h>
+#endif
 
 /*
  * Tries to deliver a pending signal to the current thread
@@ -310,6 +313,30 @@ int sigwait(const sigset_t *set, int *sig)
  * If all of the threads have the signal blocked, add it to process
  * pending signals
  */
+int uk_sig_proc_queue(pid_t pid, siginfo_t *siginfo)
+{
+	struct uk_list_head *i;
+	struct uk_thread_sig *th_sig;
+
+	if (pid != 1 && pid != 0 && pid != -1)
+		return -ESRCH;
+
+	if (!uk_sig_is_valid(siginfo->si_signo))
+		return -EINVAL;
+
+	uk_list_for_each(i, &uk_proc_sig.thread_sig_list) {
+		th_sig = uk_list_entry(i, struct uk_thread_sig, list_node);
+
+		if (uk_deliver_proc_signal(th_sig, siginfo) > 0)
+			return 0;
+	}
+
+	/* didn't find any thread that could accept this signal */
+	uk_add_proc_signal(siginfo);
+
+	return 0;
+}
+
 int kill(pid_t pid, int sig)
 {
 	/*
@@ -323,33 +350,17 @@ int kill(pid_t pid, int sig)
 	 */
 
 	siginfo_t siginfo;
-	struct uk_list_head *i;
-	struct uk_thread_sig *th_sig;
-
-
-	if (pid != 1 && pid != 0 && pid != -1) {
-		errno = ESRCH;
-		return -1;
-	}
-
-	if (!uk_sig_is_valid(sig)) {
-		errno = EINVAL;
-		return -1;
-	}
+	int rc;
 
 	/* setup siginfo */
 	uk_sig_init_siginfo(&siginfo, sig);
 
-	uk_list_for_each(i, &uk_proc_sig.thread_sig_list) {
-		th_sig = uk_list_entry(i, struct uk_thread_sig, list_node);
-
-		if (uk_deliver_proc_signal(th_sig, &siginfo) > 0)
-			return 0;
+	rc = uk_sig_proc_queue(pid, &siginfo);
+	if (rc < 0) {
+		errno = -rc;
+		return -1;
 	}
 
-	/* didn't find any thread that could accept this signal */
-	uk_add_proc_signal(&siginfo);
-
 	return 0;
 }
 
@@ -372,10 +383,27 @@ int raise(int sig)
  * Stubbing the function support from requiring signal.
  * Stubs taken from newlib
  */
+#if CONFIG_LIBUKTIME_TIMER
+UK_SYSCALL_R_DEFINE(unsigned int, alarm, unsigned int, seconds)
+{
+	struct itimerval it = { .it_value.tv_sec = seconds };
+	struct itimerval old;
+
+	if (setitimer(ITIMER_REAL, &it, &old))
+		return 0;
+
+	/* Round to the nearest second, but never report 0 if still armed */
+	if (old.it_value.tv_usec >= 500000
+	    || (!old.it_value.tv_sec && old.it_value.tv_usec))
+		old.it_value.tv_sec++;
+	return old.it_value.tv_sec;
+}
+#else
 UK_SYSCALL_R_DEFINE(unsigned int, alarm, unsigned int, seconds)
 {
 	return 0;
 }
+#endif
 
 int siginterrupt(int sig __unused, int flag __unused)
 {
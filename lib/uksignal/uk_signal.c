@@ -341,9 +341,10 @@ void uk_sig_init_siginfo(siginfo_t *siginfo, int sig)
 {
 	siginfo->si_signo = sig;
 
-	/* TODO: add codes; get pid from getpid() */
-	siginfo->si_code = 0;
+	/* TODO: get pid from getpid() */
+	siginfo->si_code = SI_USER;
 	siginfo->si_pid = 1;
+	siginfo->si_value.sival_ptr = NULL;
 }
 
 /* returns the uk_signal for sig if it is pending on thread */
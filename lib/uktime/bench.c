@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <uk/essentials.h>
+#include <uk/alloc.h>
+#include <uk/arch/atomic.h>
+#include <uk/print.h>
+#include <uk/sched.h>
+#include <uk/plat/time.h>
+#include <uk/timer.h>
+
+#define TICK_NSEC	((__nsec) CONFIG_LIBUKTIME_TIMER_TICK_US * 1000UL)
+
+/* Window over which the timers of the expiry run are spread */
+#define BENCH_EXPIRE_WINDOW	ukarch_time_msec_to_nsec(100)
+/* Time the expiry run may take beyond its window before giving up */
+#define BENCH_EXPIRE_SLACK	ukarch_time_sec_to_nsec(5)
+
+struct bench_timer {
+	struct uk_timer timer;
+	__nsec fired;
+	unsigned int nb_runs;
+};
+
+static unsigned int bench_nb_fired;
+
+static void bench_timer_fire(struct uk_timer *t, void *arg __unused)
+{
+	struct bench_timer *bt = __containerof(t, struct bench_timer, timer);
+
+	bt->fired = ukplat_monotonic_clock();
+	bt->nb_runs++;
+	ukarch_inc(&bench_nb_fired);
+}
+
+static __nsec bench_per_op(__nsec start, unsigned int count)
+{
+	return (ukplat_monotonic_clock() - start) / count;
+}
+
+int uk_timer_bench(unsigned int nb_timers)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	struct bench_timer *timers;
+	__nsec start, base, lateness, lateness_sum = 0, lateness_max = 0;
+	__nsec arm, rearm, cancel;
+	unsigned int i, nb_cancelled = 0;
+	int rc = 0;
+
+	UK_ASSERT(nb_timers > 0);
+
+	timers = uk_calloc(a, nb_timers, sizeof(*timers));
+	if (!timers)
+		return -ENOMEM;
+
+	for (i = 0; i < nb_timers; i++)
+		uk_timer_init(&timers[i].timer, bench_timer_fire, NULL);
+
+	/* Arm, move and cancel timers that are far enough in the future to
+	 * never expire, spread over several levels of the wheel
+	 */
+	base = ukplat_monotonic_clock() + ukarch_time_sec_to_nsec(60);
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < nb_timers; i++) {
+		rc = uk_timer_arm(&timers[i].timer,
+				  base + (__nsec) (i % 4096) * (i % 4096)
+					 * TICK_NSEC, 0);
+		if (unlikely(rc))
+			goto out_cancel;
+	}
+	arm = bench_per_op(start, nb_timers);
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < nb_timers; i++)
+		uk_timer_arm(&timers[i].timer,
+			     base + (__nsec) (i % 64) * TICK_NSEC, 0);
+	rearm = bench_per_op(start, nb_timers);
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < nb_timers; i++)
+		nb_cancelled += uk_timer_cancel(&timers[i].timer);
+	cancel = bench_per_op(start, nb_timers);
+
+	uk_pr_info("%u timers: arm %"__PRInsec" ns, re-arm %"__PRInsec
+		   " ns, cancel %"__PRInsec" ns per timer\n",
+		   nb_timers, arm, rearm, cancel);
+	if (nb_cancelled != nb_timers || bench_nb_fired) {
+		uk_pr_err("%u of %u timers were pending at cancellation, "
+			  "%u ran\n", nb_cancelled, nb_timers, bench_nb_fired);
+		rc = -EIO;
+		goto out_free;
+	}
+
+	/* Let all timers expire within the window and check that every
+	 * timer ran exactly once and never before its expiry
+	 */
+	base = ukplat_monotonic_clock();
+	for (i = 0; i < nb_timers; i++) {
+		rc = uk_timer_arm(&timers[i].timer,
+				  base + BENCH_EXPIRE_WINDOW * i / nb_timers, 0);
+		if (unlikely(rc))
+			goto out_cancel;
+	}
+
+	while (ukarch_load_n(&bench_nb_fired) < nb_timers
+	       && ukplat_monotonic_clock() < base + BENCH_EXPIRE_WINDOW
+					     + BENCH_EXPIRE_SLACK)
+		uk_sched_thread_sleep(TICK_NSEC);
+
+	for (i = 0; i < nb_timers; i++) {
+		if (timers[i].nb_runs != 1) {
+			uk_pr_err("Timer %u ran %u times\n",
+				  i, timers[i].nb_runs);
+			rc = (timers[i].nb_runs) ? -EIO : -ETIMEDOUT;
+			goto out_cancel;
+		}
+		if (timers[i].fired < timers[i].timer.expires) {
+			uk_pr_err("Timer %u ran %"__PRInsec" ns early\n",
+				  i, timers[i].timer.expires - timers[i].fired);
+			rc = -EIO;
+			goto out_cancel;
+		}
+
+		lateness = timers[i].fired - timers[i].timer.expires;
+		lateness_sum += lateness;
+		lateness_max = MAX(lateness_max, lateness);
+	}
+
+	uk_pr_info("%u timers expired within %"__PRInsec" ns: lateness avg %"
+		   __PRInsec" ns, max %"__PRInsec" ns\n",
+		   nb_timers, BENCH_EXPIRE_WINDOW, lateness_sum / nb_timers,
+		   lateness_max);
+
+out_cancel:
+	for (i = 0; i < nb_timers; i++)
+		uk_timer_cancel_sync(&timers[i].timer);
+out_free:
+	uk_free(a, timers);
+	bench_nb_fired = 0;
+	return rc;
+}
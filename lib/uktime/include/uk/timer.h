@@ -0,0 +1,147 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UK_TIMER_H__
+#define __UK_TIMER_H__
+
+#include <uk/config.h>
+
+#if CONFIG_LIBUKTIME_TIMER
+#include <stdbool.h>
+#include <uk/arch/time.h>
+#include <uk/list.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Kernel timers are kept in a hierarchical timing wheel with
+ * CONFIG_LIBUKTIME_TIMER_TICK_US granularity, so arming and cancelling a
+ * timer takes constant time regardless of how many timers are pending.
+ * Expired timers run in a dedicated timer thread that sleeps until the
+ * next expiry, so there is no periodic tick. Callbacks may block, but
+ * a slow callback delays all timers behind it.
+ */
+
+struct uk_timer;
+
+typedef void (*uk_timer_func_t)(struct uk_timer *timer, void *arg);
+
+struct uk_timer {
+	struct uk_hlist_node entry;
+	__nsec expires;  /* absolute, monotonic clock */
+	__nsec period;   /* 0 for one-shot timers */
+	unsigned int idx; /* wheel bucket */
+	unsigned long overrun; /* expiries missed before the last run */
+	uk_timer_func_t func;
+	void *arg;
+};
+
+/**
+ * Initializes an unarmed timer.
+ *
+ * @param timer
+ *  Timer to initialize.
+ * @param func
+ *  Function called in the timer thread each time the timer expires.
+ * @param arg
+ *  Argument passed to `func`.
+ */
+void uk_timer_init(struct uk_timer *timer, uk_timer_func_t func, void *arg);
+
+/**
+ * (Re)arms a timer. An already pending timer is moved to its new expiry.
+ * The first call creates the timer thread and must happen in thread
+ * context. Calls that race with it wait until the timer thread exists.
+ *
+ * @param timer
+ *  Initialized timer.
+ * @param expires
+ *  Absolute expiry on the monotonic clock. Timers that expire in the past
+ *  run as soon as possible.
+ * @param period
+ *  Interval of a periodic timer, or 0 for a one-shot timer.
+ * @return
+ *  0 on success, or a negative errno value if the timer thread could not
+ *  be created.
+ */
+int uk_timer_arm(struct uk_timer *timer, __nsec expires, __nsec period);
+
+/**
+ * Disarms a timer. The callback may still be running in the timer thread
+ * when this function returns.
+ *
+ * @return
+ *  True if the timer was pending.
+ */
+bool uk_timer_cancel(struct uk_timer *timer);
+
+/**
+ * Disarms a timer and waits until its callback finished running. Can be
+ * called from the callback of `timer` itself, but must not be called
+ * while holding a lock the callback takes.
+ *
+ * @return
+ *  True if the timer was pending.
+ */
+bool uk_timer_cancel_sync(struct uk_timer *timer);
+
+/* True while the timer is armed and has not expired yet */
+static inline bool uk_timer_pending(const struct uk_timer *timer)
+{
+	return !uk_hlist_unhashed(&timer->entry);
+}
+
+#if CONFIG_LIBUKTIME_TIMER_BENCH
+/**
+ * Arms, moves and cancels `nb_timers` timers and then lets all of them
+ * expire within 100ms. Prints the cost per operation and how late the
+ * timers ran on the kernel console. Must be called in thread context
+ * while no other timers are in use.
+ *
+ * @param nb_timers
+ *   Number of timers
+ * @return
+ *   - (0): on success
+ *   - (-ENOMEM): the timers could not be allocated
+ *   - (-EIO): a timer ran early, more than once or while cancelled
+ *   - (-ETIMEDOUT): a timer did not expire
+ */
+int uk_timer_bench(unsigned int nb_timers);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_LIBUKTIME_TIMER */
+
+#endif /* __UK_TIMER_H__ */
@@ -190,10 +190,3 @@ UK_SYSCALL_R_DEFINE(int, times, struct tm *, buf)
 {
 	return -ENOTSUP;
 }
-
-int setitimer(int which __unused, const struct itimerval *new_value __unused,
-		struct itimerval *old_value __unused)
-{
-	UK_WARN_STUBBED();
-	return 0;
-}
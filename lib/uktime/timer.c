@@ -31,10 +31,339 @@
  */
 
 #include <errno.h>
+#include <limits.h>
 #include <time.h>
+#include <sys/time.h>
+#include <uk/config.h>
 #include <uk/essentials.h>
 #include <uk/print.h>
+#if CONFIG_LIBUKTIME_TIMER
+#include <signal.h>
+#include <uk/alloc.h>
+#include <uk/arch/time.h>
+#include <uk/plat/time.h>
+#include <uk/timer.h>
+#if CONFIG_LIBUKSIGNAL
+#include <unistd.h>
+#include <uk/uk_signal.h>
+#endif
+#endif
 
+#if CONFIG_LIBUKTIME_TIMER
+#ifndef SIGEV_SIGNAL
+#define SIGEV_SIGNAL 0
+#define SIGEV_NONE   1
+#define SIGEV_THREAD 2
+#endif
+
+struct posix_timer {
+	struct uk_timer timer;
+	clockid_t clockid;
+	struct sigevent sev;
+#if CONFIG_LIBUKSIGNAL
+	/* Process that created the timer and receives its signals */
+	pid_t pid;
+#endif
+};
+
+static struct uk_timer itimer_real;
+static int itimer_real_init;
+#if CONFIG_LIBUKSIGNAL
+/* Process that armed ITIMER_REAL and receives SIGALRM */
+static pid_t itimer_real_pid;
+#endif
+
+static inline int timespec_valid(const struct timespec *ts)
+{
+	return ts->tv_sec >= 0 && ts->tv_nsec >= 0
+	       && ts->tv_nsec < (long) UKARCH_NSEC_PER_SEC;
+}
+
+static inline __nsec timespec_to_nsec(const struct timespec *ts)
+{
+	return ukarch_time_sec_to_nsec((__nsec) ts->tv_sec) + ts->tv_nsec;
+}
+
+static inline void nsec_to_timespec(__nsec nsec, struct timespec *ts)
+{
+	ts->tv_sec = ukarch_time_nsec_to_sec(nsec);
+	ts->tv_nsec = ukarch_time_subsec(nsec);
+}
+
+/* Time left until a timer expires, 0 if it is not armed */
+static __nsec timer_remaining(struct uk_timer *t)
+{
+	__nsec now;
+
+	if (!uk_timer_pending(t))
+		return 0;
+
+	/* An expired timer whose callback has not run yet is still armed */
+	now = ukplat_monotonic_clock();
+	return (t->expires > now) ? t->expires - now : 1;
+}
+
+static void posix_timer_fire(struct uk_timer *t, void *arg __unused)
+{
+	struct posix_timer *pt = __containerof(t, struct posix_timer, timer);
+#if CONFIG_LIBUKSIGNAL
+	siginfo_t siginfo;
+#endif
+
+	switch (pt->sev.sigev_notify) {
+#if CONFIG_LIBUKSIGNAL
+	case SIGEV_SIGNAL:
+		uk_sig_init_siginfo(&siginfo, pt->sev.sigev_signo);
+		siginfo.si_code = SI_TIMER;
+		siginfo.si_value = pt->sev.sigev_value;
+		uk_sig_proc_queue(pt->pid, &siginfo);
+		break;
+#endif
+#ifdef sigev_notify_function
+	case SIGEV_THREAD:
+		pt->sev.sigev_notify_function(pt->sev.sigev_value);
+		break;
+#endif
+	default:
+		break;
+	}
+}
+
+static int sigevent_check(const struct sigevent *sev)
+{
+	switch (sev->sigev_notify) {
+	case SIGEV_NONE:
+		return 0;
+	case SIGEV_SIGNAL:
+#if CONFIG_LIBUKSIGNAL
+		return uk_sig_is_valid(sev->sigev_signo) ? 0 : EINVAL;
+#else
+		return ENOTSUP;
+#endif
+#ifdef sigev_notify_function
+	/* Runs in the timer thread instead of a thread of its own */
+	case SIGEV_THREAD:
+		return sev->sigev_notify_function ? 0 : EINVAL;
+#endif
+	default:
+		return EINVAL;
+	}
+}
+
+int timer_create(clockid_t clockid, struct sigevent *__restrict sevp,
+		 timer_t *__restrict timerid)
+{
+	struct posix_timer *pt;
+	int error;
+
+	if (!timerid) {
+		error = EINVAL;
+		goto out_error;
+	}
+
+	if (clockid != CLOCK_MONOTONIC && clockid != CLOCK_REALTIME) {
+		error = EINVAL;
+		goto out_error;
+	}
+
+	if (sevp) {
+		error = sigevent_check(sevp);
+		if (error)
+			goto out_error;
+	}
+
+	pt = uk_calloc(uk_alloc_get_default(), 1, sizeof(*pt));
+	if (!pt) {
+		error = EAGAIN;
+		goto out_error;
+	}
+
+	uk_timer_init(&pt->timer, posix_timer_fire, NULL);
+	pt->clockid = clockid;
+#if CONFIG_LIBUKSIGNAL
+	pt->pid = getpid();
+#endif
+	if (sevp) {
+		pt->sev = *sevp;
+	} else {
+		pt->sev.sigev_notify = SIGEV_SIGNAL;
+		pt->sev.sigev_signo = SIGALRM;
+		pt->sev.sigev_value.sival_ptr = pt;
+		error = sigevent_check(&pt->sev);
+		if (error) {
+			uk_free(uk_alloc_get_default(), pt);
+			goto out_error;
+		}
+	}
+
+	*timerid = (timer_t) pt;
+	return 0;
+
+out_error:
+	errno = error;
+	return -1;
+}
+
+int timer_delete(timer_t timerid)
+{
+	struct posix_timer *pt = (struct posix_timer *) timerid;
+
+	if (!pt) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	uk_timer_cancel_sync(&pt->timer);
+	uk_free(uk_alloc_get_default(), pt);
+	return 0;
+}
+
+int timer_gettime(timer_t timerid, struct itimerspec *curr_value)
+{
+	struct posix_timer *pt = (struct posix_timer *) timerid;
+
+	if (!pt || !curr_value) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	nsec_to_timespec(timer_remaining(&pt->timer), &curr_value->it_value);
+	nsec_to_timespec(pt->timer.period, &curr_value->it_interval);
+	return 0;
+}
+
+int timer_settime(timer_t timerid, int flags,
+		  const struct itimerspec *__restrict new_value,
+		  struct itimerspec *__restrict old_value)
+{
+	struct posix_timer *pt = (struct posix_timer *) timerid;
+	__nsec value, now, wall;
+	int rc;
+
+	if (!pt || !new_value || !timespec_valid(&new_value->it_value)
+	    || !timespec_valid(&new_value->it_interval)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (old_value)
+		timer_gettime(timerid, old_value);
+
+	value = timespec_to_nsec(&new_value->it_value);
+	if (!value) {
+		uk_timer_cancel(&pt->timer);
+		return 0;
+	}
+
+	now = ukplat_monotonic_clock();
+	if (!(flags & TIMER_ABSTIME)) {
+		value += now;
+	} else if (pt->clockid == CLOCK_REALTIME) {
+		/* Wall clock deadlines are mapped to the monotonic clock */
+		wall = ukplat_wall_clock();
+		value = (value > wall) ? now + (value - wall) : now;
+	}
+
+	rc = uk_timer_arm(&pt->timer, value,
+			  timespec_to_nsec(&new_value->it_interval));
+	if (unlikely(rc)) {
+		errno = -rc;
+		return -1;
+	}
+	return 0;
+}
+
+int timer_getoverrun(timer_t timerid)
+{
+	struct posix_timer *pt = (struct posix_timer *) timerid;
+
+	if (!pt) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return (int) MIN(pt->timer.overrun, (unsigned long) INT_MAX);
+}
+
+static void itimer_real_fire(struct uk_timer *t __unused, void *arg __unused)
+{
+#if CONFIG_LIBUKSIGNAL
+	siginfo_t siginfo;
+
+	uk_sig_init_siginfo(&siginfo, SIGALRM);
+	siginfo.si_code = SI_TIMER;
+	uk_sig_proc_queue(itimer_real_pid, &siginfo);
+#endif
+}
+
+int getitimer(int which, struct itimerval *curr_value)
+{
+	__nsec remaining;
+
+	if (which != ITIMER_REAL || !curr_value) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	remaining = itimer_real_init ? timer_remaining(&itimer_real) : 0;
+	curr_value->it_value.tv_sec = ukarch_time_nsec_to_sec(remaining);
+	curr_value->it_value.tv_usec =
+		ukarch_time_nsec_to_usec(ukarch_time_subsec(remaining));
+	remaining = itimer_real_init ? itimer_real.period : 0;
+	curr_value->it_interval.tv_sec = ukarch_time_nsec_to_sec(remaining);
+	curr_value->it_interval.tv_usec =
+		ukarch_time_nsec_to_usec(ukarch_time_subsec(remaining));
+	return 0;
+}
+
+int setitimer(int which, const struct itimerval *new_value,
+	      struct itimerval *old_value)
+{
+	__nsec value, interval;
+	int rc;
+
+	if (which != ITIMER_REAL || !new_value
+	    || new_value->it_value.tv_sec < 0
+	    || new_value->it_value.tv_usec < 0
+	    || new_value->it_value.tv_usec >= 1000000
+	    || new_value->it_interval.tv_sec < 0
+	    || new_value->it_interval.tv_usec < 0
+	    || new_value->it_interval.tv_usec >= 1000000) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (!itimer_real_init) {
+		uk_timer_init(&itimer_real, itimer_real_fire, NULL);
+		itimer_real_init = 1;
+	}
+#if CONFIG_LIBUKSIGNAL
+	itimer_real_pid = getpid();
+#endif
+
+	if (old_value)
+		getitimer(which, old_value);
+
+	value = ukarch_time_sec_to_nsec((__nsec) new_value->it_value.tv_sec)
+		+ ukarch_time_usec_to_nsec(new_value->it_value.tv_usec);
+	interval = ukarch_time_sec_to_nsec(
+			(__nsec) new_value->it_interval.tv_sec)
+		   + ukarch_time_usec_to_nsec(new_value->it_interval.tv_usec);
+	if (!value) {
+		uk_timer_cancel(&itimer_real);
+		return 0;
+	}
+
+	rc = uk_timer_arm(&itimer_real, ukplat_monotonic_clock() + value,
+			  interval);
+	if (unlikely(rc)) {
+		errno = -rc;
+		return -1;
+	}
+	return 0;
+}
+
+#else /* !CONFIG_LIBUKTIME_TIMER */
 
 int timer_create(clockid_t clockid __unused,
 		struct sigevent *__restrict sevp __unused,
@@ -76,3 +405,18 @@ int timer_getoverrun(timer_t timerid __unused)
 	errno = ENOTSUP;
 	return -1;
 }
+
+int getitimer(int which __unused, struct itimerval *curr_value __unused)
+{
+	UK_WARN_STUBBED();
+	errno = ENOTSUP;
+	return -1;
+}
+
+int setitimer(int which __unused, const struct itimerval *new_value __unused,
+		struct itimerval *old_value __unused)
+{
+	UK_WARN_STUBBED();
+	return 0;
+}
+#endif /* !CONFIG_LIBUKTIME_TIMER */
@@ -0,0 +1,409 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <uk/arch/atomic.h>
+#include <uk/assert.h>
+#include <uk/essentials.h>
+#include <uk/plat/spinlock.h>
+#include <uk/plat/time.h>
+#include <uk/print.h>
+#include <uk/sched.h>
+#include <uk/thread.h>
+#include <uk/thread_attr.h>
+#include <uk/timer.h>
+#if CONFIG_LIBUKSIGNAL
+#include <signal.h>
+#include <uk/uk_signal.h>
+#endif
+
+/*
+ * The wheel has LVL_DEPTH levels of LVL_SIZE buckets each. A bucket on
+ * level n covers 8^n ticks, so the levels span roughly 63 ticks, 504
+ * ticks, 4032 ticks and so on. A timer is put into the bucket of the
+ * finest level that reaches its expiry. When a bucket of a coarser level
+ * comes due, its timers that are not due yet move down to a finer level,
+ * at most once per level. Most timers are cancelled long before that, so
+ * arming and cancelling stay cheap while timers still expire on their
+ * tick. Timers beyond the last level are parked in its farthest bucket.
+ * Expiries are rounded up to whole ticks, so no timer ever runs early.
+ */
+#define TICK_NSEC       ((__nsec) CONFIG_LIBUKTIME_TIMER_TICK_US * 1000UL)
+
+#define LVL_CLK_SHIFT   3
+#define LVL_CLK_DIV     (1UL << LVL_CLK_SHIFT)
+#define LVL_CLK_MASK    (LVL_CLK_DIV - 1)
+#define LVL_SHIFT(n)    ((n) * LVL_CLK_SHIFT)
+#define LVL_GRAN(n)     (1UL << LVL_SHIFT(n))
+#define LVL_BITS        6
+#define LVL_SIZE        (1UL << LVL_BITS)
+#define LVL_MASK        (LVL_SIZE - 1)
+#define LVL_DEPTH       8
+#define LVL_START(n)    ((LVL_SIZE - 1) << (((n) - 1) * LVL_CLK_SHIFT))
+
+#define WHEEL_SIZE      (LVL_SIZE * LVL_DEPTH)
+#define WHEEL_TIMEOUT_MAX \
+	(LVL_START(LVL_DEPTH) - LVL_GRAN(LVL_DEPTH - 1))
+
+#define IDX_NONE        (~0U) /* not in the wheel */
+#define TICK_NONE       (~0ULL)
+
+enum {
+	TIMER_THREAD_NONE = 0,
+	TIMER_THREAD_STARTING,
+	TIMER_THREAD_RUNNING,
+};
+
+static struct {
+	spinlock_t lock;
+	__u64 clk; /* next tick to process, all earlier ones are done */
+	__u64 pending[LVL_DEPTH]; /* non-empty buckets */
+	struct uk_hlist_head buckets[WHEEL_SIZE];
+	struct uk_hlist_head expired; /* collected, callback not run yet */
+	struct uk_timer *running; /* callback in progress */
+	struct uk_thread *thread;
+	__nsec sleep_until; /* wakeup of the idle timer thread, 0 if none */
+	bool idle; /* timer thread waits for the next expiry */
+	int state;
+} wheel = {
+	.lock = UKARCH_SPINLOCK_INITIALIZER(),
+};
+
+static inline __u64 nsec_to_tick(__nsec nsec)
+{
+	return (nsec + TICK_NSEC - 1) / TICK_NSEC;
+}
+
+static unsigned int calc_index(__u64 expires, unsigned int lvl)
+{
+	expires >>= LVL_SHIFT(lvl);
+	return lvl * LVL_SIZE + (expires & LVL_MASK);
+}
+
+static unsigned int calc_wheel_index(__u64 expires, __u64 clk)
+{
+	__u64 delta;
+	unsigned int lvl;
+
+	if (expires <= clk)
+		return clk & LVL_MASK;
+
+	delta = expires - clk;
+	for (lvl = 0; lvl < LVL_DEPTH - 1; lvl++)
+		if (delta < LVL_START(lvl + 1))
+			return calc_index(expires, lvl);
+
+	if (delta >= WHEEL_TIMEOUT_MAX)
+		expires = clk + WHEEL_TIMEOUT_MAX;
+	return calc_index(expires, LVL_DEPTH - 1);
+}
+
+static void enqueue_timer(struct uk_timer *t)
+{
+	unsigned int idx;
+
+	idx = calc_wheel_index(nsec_to_tick(t->expires), wheel.clk);
+	uk_hlist_add_head(&t->entry, &wheel.buckets[idx]);
+	wheel.pending[idx / LVL_SIZE] |= 1ULL << (idx & LVL_MASK);
+	t->idx = idx;
+}
+
+static void detach_timer(struct uk_timer *t)
+{
+	unsigned int idx = t->idx;
+
+	uk_hlist_del_init(&t->entry);
+	t->idx = IDX_NONE;
+	if (idx != IDX_NONE && uk_hlist_empty(&wheel.buckets[idx]))
+		wheel.pending[idx / LVL_SIZE] &= ~(1ULL << (idx & LVL_MASK));
+}
+
+/* Earliest tick with a non-empty bucket, TICK_NONE if the wheel is empty */
+static __u64 next_pending_tick(void)
+{
+	__u64 next = TICK_NONE;
+	__u64 base, bits, tick;
+	unsigned int lvl, pos;
+
+	for (lvl = 0; lvl < LVL_DEPTH; lvl++) {
+		if (!wheel.pending[lvl])
+			continue;
+
+		/* Scan the buckets from the current position of the level */
+		base = (wheel.clk + LVL_GRAN(lvl) - 1) >> LVL_SHIFT(lvl);
+		pos = base & LVL_MASK;
+		bits = wheel.pending[lvl];
+		if (pos)
+			bits = (bits >> pos) | (bits << (LVL_SIZE - pos));
+		tick = (base + __builtin_ctzll(bits)) << LVL_SHIFT(lvl);
+		if (tick < next)
+			next = tick;
+	}
+	return next;
+}
+
+/* Moves the buckets due at `clk` to the expired list */
+static void collect_expired(__u64 clk)
+{
+	struct uk_hlist_node *n;
+	struct uk_timer *t;
+	unsigned int lvl, idx;
+
+	for (lvl = 0; lvl < LVL_DEPTH; lvl++) {
+		idx = lvl * LVL_SIZE + (clk & LVL_MASK);
+		while ((n = wheel.buckets[idx].first)) {
+			t = uk_hlist_entry(n, struct uk_timer, entry);
+			detach_timer(t);
+
+			/* Move down to a finer level */
+			if (nsec_to_tick(t->expires) > wheel.clk) {
+				enqueue_timer(t);
+				continue;
+			}
+			uk_hlist_add_head(&t->entry, &wheel.expired);
+		}
+
+		/* Higher levels are due only on their granularity */
+		if (clk & LVL_CLK_MASK)
+			break;
+		clk >>= LVL_CLK_SHIFT;
+	}
+}
+
+static void run_wheel(__u64 now)
+{
+	__u64 next;
+
+	while (wheel.clk <= now) {
+		next = next_pending_tick();
+		if (next > now)
+			break;
+		wheel.clk = next;
+		collect_expired(next);
+		wheel.clk = next + 1;
+	}
+	wheel.clk = now + 1;
+}
+
+/* Keeps the finest levels usable after the timer thread was idle */
+static void forward_wheel(__u64 now)
+{
+	__u64 next;
+
+	if (wheel.clk >= now)
+		return;
+
+	next = next_pending_tick();
+	wheel.clk = MIN(now, next);
+}
+
+static void timer_thread(void *arg __unused)
+{
+	struct uk_thread *self = uk_thread_current();
+	struct uk_timer *t;
+	unsigned long flags;
+	__nsec now;
+	__u64 next;
+#if CONFIG_LIBUKSIGNAL
+	sigset_t all;
+
+	/* Process signals sent by timers must go to a thread that can
+	 * handle them, never to the timer thread itself
+	 */
+	sigfillset(&all);
+	uk_thread_sigmask(SIG_BLOCK, &all, NULL);
+#endif
+
+	ukplat_spin_lock_irqsave(&wheel.lock, flags);
+	wheel.thread = self;
+	for (;;) {
+		now = ukplat_monotonic_clock();
+		run_wheel(now / TICK_NSEC);
+
+		while (wheel.expired.first) {
+			t = uk_hlist_entry(wheel.expired.first,
+					   struct uk_timer, entry);
+			uk_hlist_del_init(&t->entry);
+
+			/* Periodic timers are requeued before the callback
+			 * runs, so the callback may cancel or re-arm them
+			 */
+			t->overrun = 0;
+			if (t->period) {
+				if (now > t->expires)
+					t->overrun = (now - t->expires)
+						     / t->period;
+				t->expires += (t->overrun + 1) * t->period;
+				enqueue_timer(t);
+			}
+
+			wheel.running = t;
+			ukplat_spin_unlock_irqrestore(&wheel.lock, flags);
+			t->func(t, t->arg);
+			ukplat_spin_lock_irqsave(&wheel.lock, flags);
+			wheel.running = NULL;
+			now = ukplat_monotonic_clock();
+		}
+
+		next = next_pending_tick();
+		if (next <= now / TICK_NSEC)
+			continue;
+
+		wheel.sleep_until = (next == TICK_NONE) ? 0 : next * TICK_NSEC;
+		wheel.idle = true;
+		uk_thread_block_until(self, (__snsec) wheel.sleep_until);
+		ukplat_spin_unlock_irqrestore(&wheel.lock, flags);
+		uk_sched_yield();
+		ukplat_spin_lock_irqsave(&wheel.lock, flags);
+		wheel.idle = false;
+	}
+}
+
+static int timer_thread_start(void)
+{
+	struct uk_thread *thread;
+	uk_thread_attr_t attr;
+	int state;
+
+	for (;;) {
+		state = ukarch_load_n(&wheel.state);
+		if (likely(state == TIMER_THREAD_RUNNING))
+			return 0;
+
+		if (state == TIMER_THREAD_STARTING) {
+			/* Someone else is starting it. Wait for the outcome:
+			 * if that fails, we try ourselves, so that no timer
+			 * is armed without a thread to run it
+			 */
+			uk_sched_yield();
+			continue;
+		}
+
+		if (ukarch_compare_exchange_sync(&wheel.state,
+						 TIMER_THREAD_NONE,
+						 TIMER_THREAD_STARTING)
+		    == TIMER_THREAD_STARTING)
+			break;
+	}
+
+	uk_thread_attr_init(&attr);
+	uk_thread_attr_set_prio(&attr, UK_THREAD_ATTR_PRIO_MAX);
+	thread = uk_sched_thread_create(uk_sched_get_default(), "timer",
+					&attr, timer_thread, NULL);
+	if (!thread) {
+		uk_pr_err("Could not create timer thread\n");
+		ukarch_store_n(&wheel.state, TIMER_THREAD_NONE);
+		return -ENOMEM;
+	}
+	ukarch_store_n(&wheel.state, TIMER_THREAD_RUNNING);
+	return 0;
+}
+
+void uk_timer_init(struct uk_timer *timer, uk_timer_func_t func, void *arg)
+{
+	UK_ASSERT(timer);
+	UK_ASSERT(func);
+
+	UK_INIT_HLIST_NODE(&timer->entry);
+	timer->expires = 0;
+	timer->period = 0;
+	timer->idx = IDX_NONE;
+	timer->overrun = 0;
+	timer->func = func;
+	timer->arg = arg;
+}
+
+int uk_timer_arm(struct uk_timer *timer, __nsec expires, __nsec period)
+{
+	struct uk_thread *wake = NULL;
+	unsigned long flags;
+	int rc;
+
+	UK_ASSERT(timer);
+
+	rc = timer_thread_start();
+	if (unlikely(rc))
+		return rc;
+
+	ukplat_spin_lock_irqsave(&wheel.lock, flags);
+	if (uk_timer_pending(timer))
+		detach_timer(timer);
+
+	forward_wheel(ukplat_monotonic_clock() / TICK_NSEC);
+	timer->expires = expires;
+	timer->period = period;
+	enqueue_timer(timer);
+
+	/* Wake the timer thread if it sleeps past the new expiry. It is
+	 * never woken while a callback blocks
+	 */
+	if (wheel.idle && (!wheel.sleep_until ||
+			   expires < wheel.sleep_until)) {
+		wheel.idle = false;
+		wake = wheel.thread;
+	}
+	ukplat_spin_unlock_irqrestore(&wheel.lock, flags);
+
+	if (wake)
+		uk_thread_wake(wake);
+	return 0;
+}
+
+bool uk_timer_cancel(struct uk_timer *timer)
+{
+	unsigned long flags;
+	bool pending;
+
+	UK_ASSERT(timer);
+
+	ukplat_spin_lock_irqsave(&wheel.lock, flags);
+	pending = uk_timer_pending(timer);
+	if (pending)
+		detach_timer(timer);
+	ukplat_spin_unlock_irqrestore(&wheel.lock, flags);
+
+	return pending;
+}
+
+bool uk_timer_cancel_sync(struct uk_timer *timer)
+{
+	bool pending = uk_timer_cancel(timer);
+
+	if (uk_thread_current() == wheel.thread)
+		return pending;
+
+	/* A periodic callback may re-arm the timer while we wait */
+	while (ukarch_load_n(&wheel.running) == timer) {
+		uk_sched_yield();
+		pending |= uk_timer_cancel(timer);
+	}
+	return pending;
+}
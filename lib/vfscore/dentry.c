@@ -39,13 +39,20 @@
 #include <vfscore/dentry.h>
 #include <vfscore/vnode.h>
 #include <uk/mutex.h>
+#include <uk/rwlock.h>
+#include <uk/arch/atomic.h>
 #include "vfs.h"
 
 #define DENTRY_BUCKETS 32
 
 static struct uk_hlist_head dentry_hash_table[DENTRY_BUCKETS];
 static UK_HLIST_HEAD(fake);
-static struct uk_mutex dentry_hash_lock = UK_MUTEX_INITIALIZER(dentry_hash_lock);
+/*
+ * Lookups and new references only read the hash table and bump d_refcnt
+ * atomically, so they take dentry_hash_lock shared. Anything that changes
+ * the table or drops the last reference takes it exclusively.
+ */
+static struct uk_rwlock dentry_hash_lock = UK_RWLOCK_INITIALIZER(dentry_hash_lock);
 
 /*
  * Get the hash value from the mount point and path name.
@@ -100,10 +107,10 @@ dentry_alloc(struct dentry *parent_dp, struct vnode *vp, const char *path)
 
 	vn_add_name(vp, dp);
 
-	uk_mutex_lock(&dentry_hash_lock);
+	uk_rwlock_wlock(&dentry_hash_lock);
 	uk_hlist_add_head(&dp->d_link,
 			  &dentry_hash_table[dentry_hash(mp, path)]);
-	uk_mutex_unlock(&dentry_hash_lock);
+	uk_rwlock_wunlock(&dentry_hash_lock);
 	return dp;
 };
 
@@ -112,15 +119,15 @@ dentry_lookup(struct mount *mp, char *path)
 {
 	struct dentry *dp;
 
-	uk_mutex_lock(&dentry_hash_lock);
+	uk_rwlock_rlock(&dentry_hash_lock);
 	uk_hlist_for_each_entry(dp, &dentry_hash_table[dentry_hash(mp, path)], d_link) {
 		if (dp->d_mount == mp && !strncmp(dp->d_path, path, PATH_MAX)) {
-			dp->d_refcnt++;
-			uk_mutex_unlock(&dentry_hash_lock);
+			ukarch_inc(&dp->d_refcnt);
+			uk_rwlock_runlock(&dentry_hash_lock);
 			return dp;
 		}
 	}
-	uk_mutex_unlock(&dentry_hash_lock);
+	uk_rwlock_runlock(&dentry_hash_lock);
 	return NULL;                /* not found */
 }
 
@@ -166,7 +173,7 @@ dentry_move(struct dentry *dp, struct dentry *parent_dp, char *path)
 		uk_mutex_unlock(&parent_dp->d_lock);
 	}
 
-	uk_mutex_lock(&dentry_hash_lock);
+	uk_rwlock_wlock(&dentry_hash_lock);
 	// Remove all dp's child dentries from the hashtable.
 	dentry_children_remove(dp);
 	// Remove dp with outdated hash info from the hashtable.
@@ -178,7 +185,7 @@ dentry_move(struct dentry *dp, struct dentry *parent_dp, char *path)
 	// Insert dp updated hash info into the hashtable.
 	uk_hlist_add_head(&dp->d_link,
 			  &dentry_hash_table[dentry_hash(dp->d_mount, path)]);
-	uk_mutex_unlock(&dentry_hash_lock);
+	uk_rwlock_wunlock(&dentry_hash_lock);
 
 	if (old_pdp) {
 		drele(old_pdp);
@@ -191,11 +198,11 @@ dentry_move(struct dentry *dp, struct dentry *parent_dp, char *path)
 void
 dentry_remove(struct dentry *dp)
 {
-	uk_mutex_lock(&dentry_hash_lock);
+	uk_rwlock_wlock(&dentry_hash_lock);
 	uk_hlist_del(&dp->d_link);
 	/* put it on a fake list for drele() to work*/
 	uk_hlist_add_head(&dp->d_link, &fake);
-	uk_mutex_unlock(&dentry_hash_lock);
+	uk_rwlock_wunlock(&dentry_hash_lock);
 }
 
 void
@@ -204,26 +211,42 @@ dref(struct dentry *dp)
 	UK_ASSERT(dp);
 	UK_ASSERT(dp->d_refcnt > 0);
 
-	uk_mutex_lock(&dentry_hash_lock);
-	dp->d_refcnt++;
-	uk_mutex_unlock(&dentry_hash_lock);
+	uk_rwlock_rlock(&dentry_hash_lock);
+	ukarch_inc(&dp->d_refcnt);
+	uk_rwlock_runlock(&dentry_hash_lock);
 }
 
 void
 drele(struct dentry *dp)
 {
+	int refcnt;
+
 	UK_ASSERT(dp);
 	UK_ASSERT(dp->d_refcnt > 0);
 
-	uk_mutex_lock(&dentry_hash_lock);
-	if (--dp->d_refcnt) {
-		uk_mutex_unlock(&dentry_hash_lock);
+	/* References other than the last one are dropped without the lock.
+	 * The last one is dropped under the lock: otherwise, a lookup could
+	 * find the dentry in the hash table and take a new reference while
+	 * we free it.
+	 */
+	refcnt = ukarch_load_n(&dp->d_refcnt);
+	while (refcnt > 1) {
+		if (ukarch_compare_exchange_sync(&dp->d_refcnt, refcnt,
+						 refcnt - 1) == refcnt - 1)
+			return;
+		refcnt = ukarch_load_n(&dp->d_refcnt);
+	}
+
+	uk_rwlock_wlock(&dentry_hash_lock);
+	if (ukarch_dec(&dp->d_refcnt) != 1) {
+		/* A lookup took a new reference in the meantime */
+		uk_rwlock_wunlock(&dentry_hash_lock);
 		return;
 	}
 	uk_hlist_del(&dp->d_link);
 	vn_del_name(dp->d_vnode, dp);
 
-	uk_mutex_unlock(&dentry_hash_lock);
+	uk_rwlock_wunlock(&dentry_hash_lock);
 
 	if (dp->d_parent) {
 		uk_mutex_lock(&dp->d_parent->d_lock);
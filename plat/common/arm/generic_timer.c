@@ -31,6 +31,7 @@
  */
 #include <stdlib.h>
 #include <uk/assert.h>
+#include <uk/essentials.h>
 #include <uk/plat/time.h>
 #include <uk/plat/lcpu.h>
 #include <uk/plat/irq.h>
@@ -38,6 +39,7 @@
 #include <uk/plat/common/cpu.h>
 #include <ofw/gic_fdt.h>
 #include <uk/plat/common/irq.h>
+#include <uk/plat/common/_time.h>
 #include <gic/gic-v2.h>
 #include <arm/time.h>
 
@@ -199,6 +201,25 @@ static inline uint64_t generic_timer_epochoffset(void)
 	return 0;
 }
 
+/*
+ * Requests a timer interrupt at `until_ns`. The compare value is absolute,
+ * so passed deadlines fire immediately.
+ */
+void generic_timer_set_deadline(uint64_t until_ns)
+{
+	uint64_t now_ns, until_ticks;
+
+	now_ns = ukplat_monotonic_clock();
+	until_ticks = generic_timer_get_ticks();
+	if (now_ns < until_ns)
+		until_ticks += ns_to_ticks(MIN(until_ns - now_ns,
+					       __MAX_CONVERT_NS));
+
+	generic_timer_update_compare(until_ticks);
+	generic_timer_enable();
+	generic_timer_unmask_irq();
+}
+
 /*
  * Returns early if any interrupts are serviced, or if the requested delay is
  * too short. Must be called with interrupts disabled, will enable interrupts
@@ -216,12 +237,12 @@ void generic_timer_cpu_block_until(uint64_t until_ns)
 
 	UK_ASSERT(ukplat_lcpu_irqs_disabled());
 
-	/* Record current ns and until_ticks for timer */
 	now_ns = ukplat_monotonic_clock();
-	until_ticks = generic_timer_get_ticks()
-				+ ns_to_ticks(until_ns - now_ns);
-
 	if (now_ns < until_ns) {
+		/* Deadlines beyond the conversion range wake up early */
+		until_ticks = generic_timer_get_ticks()
+			+ ns_to_ticks(MIN(until_ns - now_ns,
+					  __MAX_CONVERT_NS));
 		generic_timer_update_compare(until_ticks);
 		generic_timer_enable();
 		generic_timer_unmask_irq();
@@ -272,6 +293,7 @@ int generic_timer_irq_handler(void *arg __unused)
 	 * generic_timer_cpu_block_until, and then unmask the IRQ.
 	 */
 	generic_timer_mask_irq();
+	time_irq_count_inc();
 
 	/* Yes, we handled the irq. */
 	return 1;
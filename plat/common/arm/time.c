@@ -92,6 +92,11 @@ uint32_t generic_timer_get_frequency(int fdt_timer)
 	return fdt32_to_cpu(fdt_freq[0]);
 }
 
+void ukplat_time_set_deadline(__nsec deadline)
+{
+	generic_timer_set_deadline(deadline);
+}
+
 unsigned long sched_have_pending_events;
 
 void time_block_until(__snsec until)
@@ -20,6 +20,7 @@ uint32_t generic_timer_get_frequency(int fdt_timer);
 int generic_timer_init(int fdt_timer);
 int generic_timer_irq_handler(void *arg __unused);
 void generic_timer_cpu_block_until(uint64_t until_ns);
+void generic_timer_set_deadline(uint64_t until_ns);
 void generic_timer_update_boot_ticks(void);
 
 #endif /* __ARM_ARM_TIME_H */
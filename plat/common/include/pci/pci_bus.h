@@ -69,6 +69,7 @@
 #include <uk/bus.h>
 #include <uk/alloc.h>
 #include <uk/ctors.h>
+#include <uk/plat/irq.h>
 
 /**
  * A structure describing an ID for a PCI driver. Each driver provides a
@@ -152,8 +153,79 @@ struct pci_device {
 
 	uint16_t base;
 	unsigned long irq;
+
+	/* MSI-X state, set up by pci_msix_enable() */
+	uint8_t msix_cap;            /**< Capability offset, 0 if unused */
+	uint16_t msix_size;          /**< Number of table entries */
+	volatile uint32_t *msix_table;
+	struct pci_msix_vector *msix_vectors; /**< One per table entry */
+};
+
+/* Platform irq behind an MSI-X table entry */
+struct pci_msix_vector {
+	unsigned long irq;
+	irq_handler_func_t func;     /**< NULL if the entry is not set up */
+	void *arg;
 };
 
+/* Standard PCI capability identifiers */
+#define PCI_CAP_ID_MSIX             (0x11)
+#define PCI_CAP_ID_VNDR             (0x09)
+
+/**
+ * Accesses the configuration space of a PCI device. `reg` has to be
+ * naturally aligned to the access size.
+ */
+uint8_t pci_conf_read8(struct pci_device *dev, uint8_t reg);
+uint16_t pci_conf_read16(struct pci_device *dev, uint8_t reg);
+uint32_t pci_conf_read32(struct pci_device *dev, uint8_t reg);
+void pci_conf_write8(struct pci_device *dev, uint8_t reg, uint8_t val);
+void pci_conf_write16(struct pci_device *dev, uint8_t reg, uint16_t val);
+void pci_conf_write32(struct pci_device *dev, uint8_t reg, uint32_t val);
+
+/**
+ * Walks the capability list of a PCI device.
+ * @param dev Reference to the PCI device
+ * @param id Capability identifier to look for
+ * @param prev Offset of the capability to continue after, 0 to start at
+ *        the beginning of the list
+ * @return Offset of the capability in the configuration space, 0 if there
+ *         is no (further) capability with this identifier
+ */
+uint8_t pci_find_cap(struct pci_device *dev, uint8_t id, uint8_t prev);
+
+/**
+ * Returns the address of a memory BAR and enables the memory space
+ * decoding of the device. Returns NULL for I/O BARs, unassigned BARs and
+ * BARs that the platform does not map uncached.
+ */
+void *pci_bar_map(struct pci_device *dev, unsigned int bar);
+
+/** Allows the device to issue DMA requests and message interrupts */
+void pci_set_master(struct pci_device *dev);
+
+/**
+ * Enables MSI-X on a PCI device, with all of its vectors masked. This also
+ * disables the legacy INTx interrupt of the device.
+ * @return Number of MSI-X vectors of the device or a negative error code
+ */
+int pci_msix_enable(struct pci_device *dev);
+
+/**
+ * Routes an MSI-X vector to a newly allocated platform irq, registers
+ * `func` as its handler and unmasks the vector.
+ * @return 0 on success, -EBUSY if the vector is already set up, or a
+ *         negative error code
+ */
+int pci_msix_vector_setup(struct pci_device *dev, uint16_t entry,
+			  irq_handler_func_t func, void *arg);
+
+/**
+ * Masks all vectors, releases their platform irqs and handlers, and
+ * switches the device back to INTx interrupts
+ */
+void pci_msix_disable(struct pci_device *dev);
+
 
 #define PCI_REGISTER_DRIVER(b)                  \
 	_PCI_REGISTER_DRIVER(__LIBNAME__, b)
@@ -37,4 +37,12 @@
 
 void time_block_until(__snsec until);
 
+extern __u64 time_irq_count;
+
+/* Has to be called by every timer interrupt, see ukplat_time_irq_count() */
+static inline void time_irq_count_inc(void)
+{
+	__atomic_fetch_add(&time_irq_count, 1, __ATOMIC_RELAXED);
+}
+
 #endif /* __PLAT_CMN_TIME_H__ */
@@ -33,6 +33,7 @@
 #ifndef __PLAT_CMN_IRQ_H__
 #define __PLAT_CMN_IRQ_H__
 
+#include <uk/arch/types.h>
 #include <uk/plat/irq.h>
 
 #if defined(__X86_64__)
@@ -59,4 +60,33 @@ enum uk_irq_polarity {
 	UK_IRQ_POLARITY_MAX
 };
 
+/**
+ * Allocates a message signaled interrupt that is delivered to the calling
+ * CPU. Handlers are registered with ukplat_irq_register() like for any
+ * other irq.
+ * @param irq Set to the allocated irq number
+ * @param addr Set to the message address that the device has to write to
+ * @param data Set to the message data that the device has to write
+ * @return 0 on success, -ENOTSUP if the platform cannot deliver message
+ *         signaled interrupts, -ENOSPC if all of them are in use
+ */
+int ukplat_irq_msi_alloc(unsigned long *irq, __u64 *addr, __u32 *data);
+
+/**
+ * Returns a message signaled interrupt allocated by ukplat_irq_msi_alloc().
+ * Its handlers have to be unregistered before.
+ * @param irq Interrupt number
+ */
+void ukplat_irq_msi_free(unsigned long irq);
+
+/**
+ * Removes a handler that was registered with ukplat_irq_register()
+ * @param irq Interrupt number
+ * @param func Interrupt function
+ * @param arg Argument the function was registered with
+ * @return 0 on success, -ENOENT if no such handler is registered
+ */
+int ukplat_irq_unregister(unsigned long irq, irq_handler_func_t func,
+			  void *arg);
+
 #endif /* __PLAT_CMN_IRQ_H__ */
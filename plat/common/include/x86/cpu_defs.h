@@ -54,6 +54,7 @@
 /*
  * Basic CPU control in CR0
  */
+#define X86_CR0_PE              (1 << 0)    /* Protected Mode Enable */
 #define X86_CR0_MP              (1 << 1)    /* Monitor Coprocessor */
 #define X86_CR0_EM              (1 << 2)    /* Emulation */
 #define X86_CR0_TS              (1 << 3)    /* Task Switched */
@@ -77,6 +78,8 @@
 #define X86_EFER_LME            (1 << 8)    /* Long mode enable (R/W) */
 
 /* CPUID feature bits in ECX and EDX when EAX=1 */
+#define X86_CPUID1_ECX_X2APIC   (1 << 21)
+#define X86_CPUID1_ECX_TSC_DEADLINE (1 << 24)
 #define X86_CPUID1_ECX_XSAVE    (1 << 26)
 #define X86_CPUID1_ECX_OSXSAVE  (1 << 27)
 #define X86_CPUID1_ECX_AVX      (1 << 28)
@@ -104,6 +107,9 @@
  * Model-specific register addresses
  */
 #define X86_MSR_FS_BASE         0xc0000100
+#define X86_MSR_GS_BASE         0xc0000101
+/* local APIC timer deadline in TSC-deadline mode */
+#define X86_MSR_TSC_DEADLINE    0x6e0
 /* extended feature register */
 #define X86_MSR_EFER		0xc0000080
 /* legacy mode SYSCALL target */
@@ -84,6 +84,9 @@ static inline int irqs_disabled(void)
 #define local_irq_disable()      __cli()
 #define local_irq_enable()       __sti()
 
-#define __MAX_IRQ	16
+/* The i8259 IRQs 0..15 are followed by message signaled interrupts */
+#define __MSI_IRQ_BASE	16
+#define __MSI_IRQ_COUNT	32
+#define __MAX_IRQ	(__MSI_IRQ_BASE + __MSI_IRQ_COUNT)
 
 #endif /* __PLAT_CMN_X86_IRQ_H__ */
@@ -56,3 +56,10 @@ void ukplat_lcpu_halt_to(__snsec until)
 	time_block_until(until);
 	ukplat_lcpu_restore_irqf(flags);
 }
+
+__u64 time_irq_count;
+
+__u64 ukplat_time_irq_count(void)
+{
+	return __atomic_load_n(&time_irq_count, __ATOMIC_RELAXED);
+}
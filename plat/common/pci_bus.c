@@ -52,8 +52,10 @@
  */
 
 #include <string.h>
+#include <errno.h>
 #include <uk/print.h>
 #include <uk/plat/common/cpu.h>
+#include <uk/plat/common/irq.h>
 #include <pci/pci_bus.h>
 
 struct pci_bus_handler {
@@ -121,6 +123,45 @@ static struct pci_bus_handler ph;
 #define PCI_CONF_IOBAR_SHFT         (0x0)
 #define PCI_CONF_IOBAR_MASK         (~0x3)
 
+#define PCI_CONF_COMMAND            (0x04)
+#define PCI_COMMAND_MEMORY          (0x0002)
+#define PCI_COMMAND_MASTER          (0x0004)
+#define PCI_COMMAND_INTX_DISABLE    (0x0400)
+
+#define PCI_CONF_STATUS             (0x06)
+#define PCI_STATUS_CAP_LIST         (0x0010)
+
+#define PCI_CONF_BAR(n)             (0x10 + 4 * (n))
+#define PCI_MAX_BARS                (6)
+#define PCI_BAR_IO                  (0x1)
+#define PCI_BAR_MEM_TYPE_MASK       (0x6)
+#define PCI_BAR_MEM_TYPE_64         (0x4)
+#define PCI_BAR_MEM_MASK            (~0xFU)
+
+#define PCI_CONF_CAP_PTR            (0x34)
+#define PCI_CAP_NEXT                (1)
+
+#define PCI_MSIX_CTRL               (2)
+#define PCI_MSIX_CTRL_SIZE_MASK     (0x07FF)
+#define PCI_MSIX_CTRL_MASKALL       (0x4000)
+#define PCI_MSIX_CTRL_ENABLE        (0x8000)
+#define PCI_MSIX_TABLE              (4)
+#define PCI_MSIX_TABLE_BIR_MASK     (0x7)
+
+/* Layout of an MSI-X table entry, in 32-bit words */
+#define PCI_MSIX_ENTRY_WORDS        (4)
+#define PCI_MSIX_ENTRY_ADDR_LO      (0)
+#define PCI_MSIX_ENTRY_ADDR_HI      (1)
+#define PCI_MSIX_ENTRY_DATA         (2)
+#define PCI_MSIX_ENTRY_CTRL         (3)
+#define PCI_MSIX_ENTRY_CTRL_MASKED  (0x1)
+
+/* Memory BARs are only accessible if they lie in the identity mapped
+ * region that the boot page tables map uncached outside of RAM
+ */
+#define PCI_BAR_MEM_BASE            (0x40000000ULL)
+#define PCI_BAR_MEM_LIMIT           (0x100000000ULL)
+
 #define PCI_CONF_READ(type, ret, a, s)					\
 	do {								\
 		uint32_t _conf_data;					\
@@ -217,7 +258,8 @@ static inline int pci_driver_add_device(struct pci_driver *drv,
 
 	config_addr = (PCI_ENABLE_BIT)
 			| (addr->bus << PCI_BUS_SHIFT)
-			| (addr->devid << PCI_DEVICE_SHIFT);
+			| (addr->devid << PCI_DEVICE_SHIFT)
+			| (addr->function << PCI_FUNCTION_SHIFT);
 	PCI_CONF_READ(uint16_t, &dev->base, config_addr, IOBAR);
 	PCI_CONF_READ(uint8_t, &dev->irq, config_addr, IRQ);
 
@@ -232,6 +274,248 @@ static inline int pci_driver_add_device(struct pci_driver *drv,
 	return 0;
 }
 
+static inline uint16_t pci_conf_select(struct pci_device *dev, uint8_t reg)
+{
+	outl(PCI_CONFIG_ADDR, (PCI_ENABLE_BIT)
+	     | (dev->addr.bus << PCI_BUS_SHIFT)
+	     | (dev->addr.devid << PCI_DEVICE_SHIFT)
+	     | (dev->addr.function << PCI_FUNCTION_SHIFT)
+	     | (reg & ~0x3));
+	return PCI_CONFIG_DATA + (reg & 0x3);
+}
+
+uint8_t pci_conf_read8(struct pci_device *dev, uint8_t reg)
+{
+	return inb(pci_conf_select(dev, reg));
+}
+
+uint16_t pci_conf_read16(struct pci_device *dev, uint8_t reg)
+{
+	UK_ASSERT(!(reg & 0x1));
+	return inw(pci_conf_select(dev, reg));
+}
+
+uint32_t pci_conf_read32(struct pci_device *dev, uint8_t reg)
+{
+	UK_ASSERT(!(reg & 0x3));
+	return inl(pci_conf_select(dev, reg));
+}
+
+void pci_conf_write8(struct pci_device *dev, uint8_t reg, uint8_t val)
+{
+	outb(pci_conf_select(dev, reg), val);
+}
+
+void pci_conf_write16(struct pci_device *dev, uint8_t reg, uint16_t val)
+{
+	UK_ASSERT(!(reg & 0x1));
+	outw(pci_conf_select(dev, reg), val);
+}
+
+void pci_conf_write32(struct pci_device *dev, uint8_t reg, uint32_t val)
+{
+	UK_ASSERT(!(reg & 0x3));
+	outl(pci_conf_select(dev, reg), val);
+}
+
+uint8_t pci_find_cap(struct pci_device *dev, uint8_t id, uint8_t prev)
+{
+	uint8_t pos;
+	int ttl = 48; /* a 256-byte config space fits at most 48 capabilities */
+
+	UK_ASSERT(dev);
+
+	if (prev) {
+		pos = pci_conf_read8(dev, prev + PCI_CAP_NEXT);
+	} else {
+		if (!(pci_conf_read16(dev, PCI_CONF_STATUS)
+		      & PCI_STATUS_CAP_LIST))
+			return 0;
+		pos = pci_conf_read8(dev, PCI_CONF_CAP_PTR);
+	}
+
+	while (pos && ttl--) {
+		pos &= ~0x3;
+		if (pci_conf_read8(dev, pos) == id)
+			return pos;
+		pos = pci_conf_read8(dev, pos + PCI_CAP_NEXT);
+	}
+	return 0;
+}
+
+void *pci_bar_map(struct pci_device *dev, unsigned int bar)
+{
+	uint64_t addr;
+	uint32_t lo;
+
+	UK_ASSERT(dev);
+
+	if (bar >= PCI_MAX_BARS)
+		return NULL;
+
+	lo = pci_conf_read32(dev, PCI_CONF_BAR(bar));
+	if (lo & PCI_BAR_IO)
+		return NULL;
+
+	addr = lo & PCI_BAR_MEM_MASK;
+	if ((lo & PCI_BAR_MEM_TYPE_MASK) == PCI_BAR_MEM_TYPE_64) {
+		if (bar + 1 >= PCI_MAX_BARS)
+			return NULL;
+		addr |= (uint64_t) pci_conf_read32(dev, PCI_CONF_BAR(bar + 1))
+			<< 32;
+	}
+
+	if (addr < PCI_BAR_MEM_BASE || addr >= PCI_BAR_MEM_LIMIT) {
+		uk_pr_err("PCI %02x:%02x.%02x: BAR%u at 0x%llx is not accessible\n",
+			  (int) dev->addr.bus, (int) dev->addr.devid,
+			  (int) dev->addr.function, bar,
+			  (unsigned long long) addr);
+		return NULL;
+	}
+
+	pci_conf_write16(dev, PCI_CONF_COMMAND,
+			 pci_conf_read16(dev, PCI_CONF_COMMAND)
+			 | PCI_COMMAND_MEMORY);
+	return (void *)(uintptr_t) addr;
+}
+
+void pci_set_master(struct pci_device *dev)
+{
+	UK_ASSERT(dev);
+
+	pci_conf_write16(dev, PCI_CONF_COMMAND,
+			 pci_conf_read16(dev, PCI_CONF_COMMAND)
+			 | PCI_COMMAND_MASTER);
+}
+
+int pci_msix_enable(struct pci_device *dev)
+{
+	uint32_t table;
+	uint16_t ctrl, i;
+	uint8_t *bar;
+	uint8_t cap;
+
+	UK_ASSERT(dev);
+
+	if (dev->msix_cap)
+		return dev->msix_size;
+
+	cap = pci_find_cap(dev, PCI_CAP_ID_MSIX, 0);
+	if (!cap)
+		return -ENOTSUP;
+
+	table = pci_conf_read32(dev, cap + PCI_MSIX_TABLE);
+	bar = pci_bar_map(dev, table & PCI_MSIX_TABLE_BIR_MASK);
+	if (!bar)
+		return -ENOTSUP;
+
+	ctrl = pci_conf_read16(dev, cap + PCI_MSIX_CTRL);
+	dev->msix_size = (ctrl & PCI_MSIX_CTRL_SIZE_MASK) + 1;
+	dev->msix_vectors = uk_calloc(ph.a, dev->msix_size,
+				      sizeof(*dev->msix_vectors));
+	if (!dev->msix_vectors)
+		return -ENOMEM;
+	dev->msix_table = (volatile uint32_t *)
+			  (bar + (table & ~PCI_MSIX_TABLE_BIR_MASK));
+
+	/* Keep the whole function masked while the table is set up */
+	pci_conf_write16(dev, cap + PCI_MSIX_CTRL,
+			 ctrl | PCI_MSIX_CTRL_MASKALL | PCI_MSIX_CTRL_ENABLE);
+	for (i = 0; i < dev->msix_size; i++)
+		dev->msix_table[i * PCI_MSIX_ENTRY_WORDS
+				+ PCI_MSIX_ENTRY_CTRL] =
+				PCI_MSIX_ENTRY_CTRL_MASKED;
+
+	pci_conf_write16(dev, PCI_CONF_COMMAND,
+			 pci_conf_read16(dev, PCI_CONF_COMMAND)
+			 | PCI_COMMAND_INTX_DISABLE);
+	pci_conf_write16(dev, cap + PCI_MSIX_CTRL,
+			 (ctrl & ~PCI_MSIX_CTRL_MASKALL)
+			 | PCI_MSIX_CTRL_ENABLE);
+	dev->msix_cap = cap;
+
+	uk_pr_debug("PCI %02x:%02x.%02x: Enabled MSI-X with %u vectors\n",
+		    (int) dev->addr.bus, (int) dev->addr.devid,
+		    (int) dev->addr.function, dev->msix_size);
+	return dev->msix_size;
+}
+
+int pci_msix_vector_setup(struct pci_device *dev, uint16_t entry,
+			  irq_handler_func_t func, void *arg)
+{
+	volatile uint32_t *e;
+	unsigned long irq;
+	__u64 addr;
+	__u32 data;
+	int rc;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(func);
+
+	if (!dev->msix_cap)
+		return -EINVAL;
+	if (entry >= dev->msix_size)
+		return -ERANGE;
+	if (dev->msix_vectors[entry].func)
+		return -EBUSY;
+
+	rc = ukplat_irq_msi_alloc(&irq, &addr, &data);
+	if (rc < 0)
+		return rc;
+
+	rc = ukplat_irq_register(irq, func, arg);
+	if (rc < 0) {
+		ukplat_irq_msi_free(irq);
+		return rc;
+	}
+	dev->msix_vectors[entry].irq = irq;
+	dev->msix_vectors[entry].func = func;
+	dev->msix_vectors[entry].arg = arg;
+
+	e = &dev->msix_table[entry * PCI_MSIX_ENTRY_WORDS];
+	e[PCI_MSIX_ENTRY_CTRL] = PCI_MSIX_ENTRY_CTRL_MASKED;
+	e[PCI_MSIX_ENTRY_ADDR_LO] = (uint32_t) addr;
+	e[PCI_MSIX_ENTRY_ADDR_HI] = (uint32_t) (addr >> 32);
+	e[PCI_MSIX_ENTRY_DATA] = data;
+	e[PCI_MSIX_ENTRY_CTRL] = 0;
+	return 0;
+}
+
+void pci_msix_disable(struct pci_device *dev)
+{
+	struct pci_msix_vector *v;
+	uint16_t ctrl, i;
+
+	UK_ASSERT(dev);
+
+	if (!dev->msix_cap)
+		return;
+
+	for (i = 0; i < dev->msix_size; i++)
+		dev->msix_table[i * PCI_MSIX_ENTRY_WORDS
+				+ PCI_MSIX_ENTRY_CTRL] =
+				PCI_MSIX_ENTRY_CTRL_MASKED;
+
+	ctrl = pci_conf_read16(dev, dev->msix_cap + PCI_MSIX_CTRL);
+	pci_conf_write16(dev, dev->msix_cap + PCI_MSIX_CTRL,
+			 ctrl & ~PCI_MSIX_CTRL_ENABLE);
+	pci_conf_write16(dev, PCI_CONF_COMMAND,
+			 pci_conf_read16(dev, PCI_CONF_COMMAND)
+			 & ~PCI_COMMAND_INTX_DISABLE);
+
+	/* The vectors are masked, their irqs can be reused */
+	for (i = 0; i < dev->msix_size; i++) {
+		v = &dev->msix_vectors[i];
+		if (!v->func)
+			continue;
+		ukplat_irq_unregister(v->irq, v->func, v->arg);
+		ukplat_irq_msi_free(v->irq);
+	}
+	uk_free(ph.a, dev->msix_vectors);
+	dev->msix_vectors = NULL;
+	dev->msix_cap = 0;
+}
+
 static void probe_bus(uint32_t);
 
 /* Probe a function. Return 1 if the function does not exist in the device, 0
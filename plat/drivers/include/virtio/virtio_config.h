@@ -46,11 +46,15 @@ extern "C" {
 #define VIRTIO_CONFIG_STATUS_ACK           0x1  /* recognize device as virtio */
 #define VIRTIO_CONFIG_STATUS_DRIVER        0x2  /* driver for the device found*/
 #define VIRTIO_CONFIG_STATUS_DRIVER_OK     0x4  /* initialization is complete */
+#define VIRTIO_CONFIG_STATUS_FEATURES_OK   0x8  /* feature negotiation done */
 #define VIRTIO_CONFIG_STATUS_NEEDS_RESET   0x40 /* device needs reset */
 #define VIRTIO_CONFIG_STATUS_FAIL          0x80 /* device something's wrong*/
 
 #define VIRTIO_TRANSPORT_F_START    28
-#define VIRTIO_TRANSPORT_F_END      32
+#define VIRTIO_TRANSPORT_F_END      41
+
+/* Compliance with the virtio 1.0 specification, set by modern transports */
+#define VIRTIO_F_VERSION_1          32
 
 #ifdef __X86_64__
 static inline void _virtio_cwrite_bytes(const void *addr, const __u8 offset,
@@ -81,6 +81,32 @@ extern "C" {
 /* Arbitrary descriptor layouts. */
 #define VIRTIO_F_ANY_LAYOUT       27
 
+/* Support for the packed virtqueue layout */
+#define VIRTIO_F_RING_PACKED      34
+
+/*
+ * Mark a descriptor as available or used in a packed ring. The driver makes
+ * a descriptor available by setting AVAIL to its wrap counter and USED to the
+ * inverse of it. The device marks it as used by setting both to the wrap
+ * counter of the device.
+ */
+#define VRING_PACKED_DESC_F_AVAIL	7
+#define VRING_PACKED_DESC_F_USED	15
+
+/* Enable events */
+#define VRING_PACKED_EVENT_FLAG_ENABLE	0x0
+/* Disable events */
+#define VRING_PACKED_EVENT_FLAG_DISABLE	0x1
+/*
+ * Enable events for a specific descriptor (as specified by Descriptor Ring
+ * Change Event Offset/Wrap Counter). Only valid if VIRTIO_F_EVENT_IDX has
+ * been negotiated.
+ */
+#define VRING_PACKED_EVENT_FLAG_DESC	0x2
+
+/* Wrap counter bit shift in event suppression structure of packed ring. */
+#define VRING_PACKED_EVENT_F_WRAP_CTR	15
+
 /**
  * Virtqueue descriptors: 16 bytes.
  * These can chain together via "next".
@@ -126,6 +152,39 @@ struct vring {
 	struct vring_used *used;
 };
 
+/**
+ * Packed virtqueue descriptors: 16 bytes.
+ */
+struct vring_packed_desc {
+	/* Buffer address (guest-physical). */
+	__virtio_le64 addr;
+	/* Buffer length. */
+	__virtio_le32 len;
+	/* Buffer ID. */
+	__virtio_le16 id;
+	/* The flags depending on descriptor type. */
+	__virtio_le16 flags;
+};
+
+/**
+ * Packed virtqueue event suppression structure. The driver and the device
+ * each publish one of them.
+ */
+struct vring_packed_desc_event {
+	/* Descriptor Ring Change Event Offset/Wrap Counter. */
+	__virtio_le16 off_wrap;
+	/* Descriptor Ring Change Event Flags. */
+	__virtio_le16 flags;
+};
+
+struct vring_packed {
+	unsigned int num;
+
+	struct vring_packed_desc *desc;
+	struct vring_packed_desc_event *driver;
+	struct vring_packed_desc_event *device;
+};
+
 /* The standard layout for the ring is a continuous chunk of memory which
  * looks like this.  We assume num is a power of 2.
  *
@@ -157,7 +216,9 @@ struct vring {
  * versa. They are at the end for backwards compatibility.
  */
 #define vring_used_event(vr) ((vr)->avail->ring[(vr)->num])
-#define vring_avail_event(vr) (*(__virtio16 *)&(vr)->used->ring[(vr)->num])
+#define vring_avail_event(vr)					\
+	(*(__virtio_le16 *)((__u8 *)(vr)->used->ring +			\
+			    (vr)->num * sizeof(struct vring_used_elem)))
 
 static inline void vring_init(struct vring *vr, unsigned int num, uint8_t *p,
 			      unsigned long align)
@@ -186,7 +247,26 @@ static inline unsigned int vring_size(unsigned int num, unsigned long align)
 static inline int vring_need_event(__u16 event_idx, __u16 new_idx,
 				   __u16 old_idx)
 {
-	return (new_idx - event_idx - 1) < (new_idx - old_idx);
+	return (__u16) (new_idx - event_idx - 1) < (__u16) (new_idx - old_idx);
+}
+
+/* The packed layout is the descriptor ring followed by the driver and
+ * the device event suppression structures.
+ */
+static inline void vring_packed_init(struct vring_packed *vr, unsigned int num,
+				     uint8_t *p)
+{
+	vr->num = num;
+	vr->desc = (struct vring_packed_desc *) p;
+	vr->driver = (struct vring_packed_desc_event *) (p +
+			num * sizeof(struct vring_packed_desc));
+	vr->device = vr->driver + 1;
+}
+
+static inline unsigned int vring_packed_size(unsigned int num)
+{
+	return num * sizeof(struct vring_packed_desc) +
+		2 * sizeof(struct vring_packed_desc_event);
 }
 
 #ifdef __cplusplus
@@ -60,6 +60,8 @@ struct virtqueue {
 	struct virtio_dev *vdev;
 	/* Virtqueue identifier */
 	__u16 queue_id;
+	/* The virtqueue uses the packed ring layout */
+	__u8 packed;
 	/* Notify to the host */
 	virtqueue_notify_host_t vq_notify_host;
 	/* Callback from the virtqueue */
@@ -80,6 +82,30 @@ struct virtqueue {
  */
 __phys_addr virtqueue_physaddr(struct virtqueue *vq);
 
+/**
+ * Fetch the physical address of the driver area, which is the available
+ * ring of a split virtqueue or the driver event suppression structure of
+ * a packed one.
+ * @param vq
+ *	Reference to the virtqueue.
+ *
+ * @return
+ *	Return the guest physical address of the driver area.
+ */
+__phys_addr virtqueue_driver_area_physaddr(struct virtqueue *vq);
+
+/**
+ * Fetch the physical address of the device area, which is the used ring
+ * of a split virtqueue or the device event suppression structure of a
+ * packed one.
+ * @param vq
+ *	Reference to the virtqueue.
+ *
+ * @return
+ *	Return the guest physical address of the device area.
+ */
+__phys_addr virtqueue_device_area_physaddr(struct virtqueue *vq);
+
 /**
  * Ring interrupt handler. This function is invoked from the interrupt handler
  * in the virtio device for interrupt specific to the ring.
@@ -104,7 +130,9 @@ int virtqueue_ring_interrupt(void *obj);
 __u64 virtqueue_feature_negotiate(__u64 feature_set);
 
 /**
- * Check if host notification is enabled.
+ * Check if host notification is enabled. When VIRTIO_F_EVENT_IDX was
+ * negotiated, this tells if the host asked to be notified about the
+ * descriptors that were made available since the last notification.
  *
  * @param vq
  *	Reference to the virtqueue.
@@ -114,6 +142,21 @@ __u64 virtqueue_feature_negotiate(__u64 feature_set);
  */
 int virtqueue_notify_enabled(struct virtqueue *vq);
 
+/**
+ * Prepare a deferred notification of the host. Drivers can enqueue any
+ * number of buffers and call this function once afterwards; it remembers
+ * the current available index as notified.
+ * virtqueue_notify() must be called when this function returned 1, which
+ * can happen outside of the driver's queue lock.
+ *
+ * @param vq
+ *	Reference to the virtqueue.
+ * @return
+ *	Returns 1, host needs notification on new descriptors.
+ *		0, there is nothing new or the host suppressed notifications.
+ */
+int virtqueue_kick_prepare(struct virtqueue *vq);
+
 /**
  * Remove the user buffer from the virtqueue.
  *
@@ -160,7 +203,8 @@ int virtqueue_buffer_enqueue(struct virtqueue *vq, void *cookie,
 			     __u16 write_bufs);
 
 /**
- * Allocate a virtqueue.
+ * Allocate a virtqueue. A packed ring is used when VIRTIO_F_RING_PACKED was
+ * negotiated with the device, a split ring otherwise.
  * @param queue_id
  *	The virtqueue hw id.
  * @param nr_descs
@@ -233,27 +277,38 @@ void virtqueue_intr_disable(struct virtqueue *vq);
 int virtqueue_intr_enable(struct virtqueue *vq);
 
 /**
- * Notify the host of an event.
+ * Unconditionally notify the host of new descriptors.
  * @param vq
  *      Reference to the virtual queue.
  */
-static inline void virtqueue_host_notify(struct virtqueue *vq)
+static inline void virtqueue_notify(struct virtqueue *vq)
 {
 	UK_ASSERT(vq);
 
-	/*
-	 * Before notifying the virtio backend on the host we should make sure
-	 * that the virtqueue index update operation happened. Note that this
-	 * function is declared as inline.
-	 */
-	mb();
-
-	if (vq->vq_notify_host && virtqueue_notify_enabled(vq)) {
+	if (vq->vq_notify_host) {
 		uk_pr_debug("notify queue %d\n", vq->queue_id);
 		vq->vq_notify_host(vq->vdev, vq->queue_id);
 	}
 }
 
+/**
+ * Notify the host of an event, unless it suppressed notifications.
+ * @param vq
+ *      Reference to the virtual queue.
+ */
+static inline void virtqueue_host_notify(struct virtqueue *vq)
+{
+	UK_ASSERT(vq);
+
+	/*
+	 * virtqueue_kick_prepare() makes sure that the virtqueue index update
+	 * operation happened before it checks if the host wants to be
+	 * notified.
+	 */
+	if (virtqueue_kick_prepare(vq))
+		virtqueue_notify(vq);
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -49,13 +49,17 @@
  *	Multi-queue,
  *	Maximum size of a segment for requests,
  *	Maximum number of segments per request,
- *	Flush
+ *	Flush,
+ *	Event index based notification suppression,
+ *	Packed virtqueues
  **/
 #define VIRTIO_BLK_DRV_FEATURES(features) \
 	(VIRTIO_FEATURES_UPDATE(features, VIRTIO_BLK_F_RO | \
 	VIRTIO_BLK_F_BLK_SIZE | VIRTIO_BLK_F_MQ | \
 	VIRTIO_BLK_F_SEG_MAX | VIRTIO_BLK_F_SIZE_MAX | \
-	VIRTIO_BLK_F_CONFIG_WCE | VIRTIO_BLK_F_FLUSH))
+	VIRTIO_BLK_F_CONFIG_WCE | VIRTIO_BLK_F_FLUSH), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_F_EVENT_IDX), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_F_RING_PACKED))
 
 static struct uk_alloc *a;
 static const char *drv_name = DRIVER_NAME;
@@ -298,43 +302,58 @@ out:
 	return rc;
 }
 
-static int virtio_blkdev_submit_request(struct uk_blkdev *dev,
+static int virtio_blkdev_submit_requests(struct uk_blkdev *dev,
 		struct uk_blkdev_queue *queue,
-		struct uk_blkreq *req)
+		struct uk_blkreq **reqs, __u16 *cnt)
 {
-	int rc = 0;
 	int status = 0x0;
+	int rc = 0;
+	__u16 i;
 
-	UK_ASSERT(req);
+	UK_ASSERT(reqs && cnt);
 	UK_ASSERT(queue);
 	UK_ASSERT(dev);
 
-	rc = virtio_blkdev_queue_enqueue(queue, req);
-	if (likely(rc >= 0)) {
-		uk_pr_debug("Success and more descriptors available\n");
+	for (i = 0; i < *cnt; i++) {
+		rc = virtio_blkdev_queue_enqueue(queue, reqs[i]);
+		if (unlikely(rc < 0))
+			break;
+	}
+	*cnt = i;
+
+	if (likely(i > 0)) {
 		status |= UK_BLKDEV_STATUS_SUCCESS;
 		/**
-		 * Notify the host the new buffer.
+		 * Notify the host once about all new requests, unless it
+		 * suppressed notifications.
 		 */
-		virtqueue_host_notify(queue->vq);
+		if (virtqueue_kick_prepare(queue->vq))
+			virtqueue_notify(queue->vq);
 		/**
 		 * When there is further space available in the ring
-		 * return UK_BLKDEV_STATUS_MORE.
+		 * return UK_BLKDEV_STATUS_MORE. A failed request is
+		 * reported by the next call.
 		 */
 		status |= likely(rc > 0) ? UK_BLKDEV_STATUS_MORE : 0x0;
 	} else if (rc == -ENOSPC) {
 		uk_pr_debug("No more descriptors available\n");
-		goto err;
+		return rc;
 	} else {
 		uk_pr_err("Failed to enqueue descriptors into the ring: %d\n",
 			  rc);
-		goto err;
+		return rc;
 	}
 
 	return status;
+}
 
-err:
-	return rc;
+static int virtio_blkdev_submit_request(struct uk_blkdev *dev,
+		struct uk_blkdev_queue *queue,
+		struct uk_blkreq *req)
+{
+	__u16 cnt = 1;
+
+	return virtio_blkdev_submit_requests(dev, queue, &req, &cnt);
 }
 
 static int virtio_blkdev_queue_dequeue(struct uk_blkdev_queue *queue,
@@ -884,6 +903,7 @@ static int virtio_blk_add_dev(struct virtio_dev *vdev)
 	vbdev->vdev = vdev;
 	vbdev->blkdev.finish_reqs = virtio_blkdev_complete_reqs;
 	vbdev->blkdev.submit_one = virtio_blkdev_submit_request;
+	vbdev->blkdev.submit = virtio_blkdev_submit_requests;
 	vbdev->blkdev.dev_ops = &virtio_blkdev_ops;
 
 	rc = uk_blkdev_drv_register(&vbdev->blkdev, a, drv_name);
@@ -37,6 +37,7 @@
 #include <uk/netdev.h>
 #include <uk/netdev_core.h>
 #include <uk/netdev_driver.h>
+#include <uk/plat/time.h>
 #include <virtio/virtio_bus.h>
 #include <virtio/virtqueue.h>
 #include <virtio/virtio_net.h>
@@ -50,8 +51,16 @@
 #define VIRTIO_PKT_BUFFER_LEN ((UK_ETH_PAYLOAD_MAXLEN) \
 			       + (UK_ETH_HDR_UNTAGGED_LEN) \
 			       + (VIRTIO_HDR_LEN))
+/**
+ * A GSO packet carries an IP packet of up to 64 KiB.
+ */
+#define VIRTIO_GSO_BUFFER_LEN ((__U16_MAX) \
+			       + (UK_ETH_HDR_8021Q_LEN) \
+			       + (VIRTIO_HDR_LEN))
 
 #define DRIVER_NAME           "virtio-net"
+/* Time the device gets to complete a command on the control virtqueue */
+#define VTNET_CTRL_TIMEOUT    ukarch_time_sec_to_nsec(1)
 
 
 #define  VTNET_RX_HEADER_PAD (4)
@@ -61,15 +70,26 @@
 #define  VTNET_INTR_USR_EN_MASK   (2)
 
 /**
- * Define max possible fragments for the network packets.
+ * Define max possible fragments for the network packets. A GSO packet can be
+ * a chain of netbufs that hold one TCP segment of payload each, plus the
+ * virtio header and the packet headers.
  */
-#define NET_MAX_FRAGMENTS    ((__U16_MAX >> __PAGE_SHIFT) + 2)
+#define NET_MAX_FRAGMENTS    ((__U16_MAX / (UK_ETH_PAYLOAD_MAXLEN - 40)) + 3)
 
 #define to_virtionetdev(ndev) \
 	__containerof(ndev, struct virtio_net_device, netdev)
 
 #define VIRTIO_NET_DRV_FEATURES(features)           \
-	(VIRTIO_FEATURES_UPDATE(features, VIRTIO_NET_F_MAC))
+	(VIRTIO_FEATURES_UPDATE(features, VIRTIO_NET_F_MAC), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_NET_F_CSUM), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_NET_F_GUEST_CSUM), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_NET_F_HOST_TSO4), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_NET_F_HOST_TSO6), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_NET_F_HOST_UFO), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_NET_F_CTRL_VQ), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_NET_F_MQ), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_F_EVENT_IDX), \
+	 VIRTIO_FEATURES_UPDATE(features, VIRTIO_F_RING_PACKED))
 
 typedef enum {
 	VNET_RX,
@@ -80,7 +100,8 @@ typedef enum {
  * When mergeable buffers are not negotiated, the virtio_net_hdr_padded struct
  * below is placed at the beginning of the netbuf data. Use 4 bytes of pad to
  * both keep the VirtIO header and the data non-contiguous and to keep the
- * frame's payload 4 byte aligned.
+ * frame's payload 4 byte aligned. The pad also has room for the num_buffers
+ * field that the header has with VIRTIO_F_VERSION_1.
  */
 struct virtio_net_hdr_padded {
 	struct virtio_net_hdr vhdr;
@@ -103,6 +124,10 @@ struct uk_netdev_tx_queue {
 	uint16_t nb_desc;
 	/* The flag to interrupt on the transmit queue */
 	uint8_t intr_enabled;
+	/* The size of the virtio-net header */
+	uint8_t vhdr_len;
+	/* The netbuf offload flags handled by the device */
+	uint16_t offload_flags;
 	/* Reference to the uk_netdev */
 	struct uk_netdev *ndev;
 	/* The scatter list and its associated fragements */
@@ -126,6 +151,8 @@ struct uk_netdev_rx_queue {
 	uint16_t nb_desc;
 	/* The flag to interrupt on the transmit queue */
 	uint8_t intr_enabled;
+	/* The size of the virtio-net header */
+	uint8_t vhdr_len;
 	/* User-provided receive buffer allocation function */
 	uk_netdev_alloc_rxpkts alloc_rxpkts;
 	void *alloc_rxpkts_argp;
@@ -136,6 +163,15 @@ struct uk_netdev_rx_queue {
 	struct uk_sglist_seg sgsegs[NET_MAX_FRAGMENTS];
 };
 
+/**
+ * @internal buffers of a command on the control virtqueue.
+ */
+struct virtio_net_ctrl {
+	struct virtio_net_ctrl_hdr hdr;
+	__u8 data[8];
+	virtio_net_ctrl_ack ack;
+};
+
 struct virtio_net_device {
 	/* Virtio Device */
 	struct virtio_dev *vdev;
@@ -144,6 +180,15 @@ struct virtio_net_device {
 	struct uk_netdev netdev;
 	/* Count of the number of the virtqueues */
 	__u16 max_vqueue_pairs;
+	/* Count of the queue pairs in use */
+	__u16 nb_vqueue_pairs;
+	/* Offloads offered by the device (UK_FEATURE_*) */
+	__u32 offloads;
+	/* The control virtqueue, if VIRTIO_NET_F_CTRL_VQ was negotiated */
+	struct virtqueue *ctrl_vq;
+	struct virtio_net_ctrl ctrl;
+	/* A timed out command still owns `ctrl` */
+	__u8 ctrl_pending;
 	/* List of the Rx/Tx queue */
 	__u16    rx_vqueue_cnt;
 	struct   uk_netdev_rx_queue *rxqs;
@@ -171,11 +216,14 @@ static int virtio_net_add_dev(struct virtio_dev *vdev);
 static void virtio_net_info_get(struct uk_netdev *dev,
 				struct uk_netdev_info *dev_info);
 static inline void virtio_netdev_feature_set(struct virtio_net_device *vndev);
+static __u32 virtio_netdev_offloads(__u64 features);
 static int virtio_netdev_configure(struct uk_netdev *n,
-				   const struct uk_netdev_conf *conf);
+				   const struct uk_netdev_conf *conf,
+				   __u32 offloads);
 static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 				    const struct uk_netdev_conf *conf);
-static int virtio_netdev_feature_negotiate(struct virtio_net_device *vndev);
+static int virtio_netdev_feature_negotiate(struct virtio_net_device *vndev,
+					   __u32 offloads);
 static struct uk_netdev_tx_queue *virtio_netdev_tx_queue_setup(
 					struct uk_netdev *n, uint16_t queue_id,
 					uint16_t nb_desc,
@@ -196,9 +244,15 @@ static void virtio_netdev_xmit_free(struct uk_netdev_tx_queue *txq);
 static int virtio_netdev_xmit(struct uk_netdev *dev,
 			      struct uk_netdev_tx_queue *queue,
 			      struct uk_netbuf *pkt);
+static int virtio_netdev_xmit_burst(struct uk_netdev *dev,
+				    struct uk_netdev_tx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt);
 static int virtio_netdev_recv(struct uk_netdev *dev,
 			      struct uk_netdev_rx_queue *queue,
 			      struct uk_netbuf **pkt);
+static int virtio_netdev_recv_burst(struct uk_netdev *dev,
+				    struct uk_netdev_rx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt);
 static const struct uk_hwaddr *virtio_net_mac_get(struct uk_netdev *n);
 static __u16 virtio_net_mtu_get(struct uk_netdev *n);
 static unsigned virtio_net_promisc_get(struct uk_netdev *n);
@@ -331,31 +385,25 @@ out:
 	return status;
 }
 
-static int virtio_netdev_xmit(struct uk_netdev *dev,
-			      struct uk_netdev_tx_queue *queue,
-			      struct uk_netbuf *pkt)
+/**
+ * Puts one packet on the transmit virtqueue without notifying the host.
+ * Returns the number of free descriptors left, -ENOSPC when the packet
+ * does not fit on the virtqueue, or another negative error code.
+ */
+static int virtio_netdev_xmit_enqueue(struct uk_netdev_tx_queue *queue,
+				      struct uk_netbuf *pkt)
 {
-	struct virtio_net_device *vndev __unused;
 	struct virtio_net_hdr *vhdr;
 	struct virtio_net_hdr_padded *padded_hdr;
 	int16_t header_sz = sizeof(*padded_hdr);
 	int rc = 0;
-	int status = 0x0;
 	size_t total_len = 0;
+	size_t max_len;
 	__u8  *buf_start;
 	size_t buf_len;
 
-	UK_ASSERT(dev);
 	UK_ASSERT(pkt && queue);
 
-	vndev = to_virtionetdev(dev);
-	/**
-	 * We are reclaiming the free descriptors from buffers. The function is
-	 * not protected by means of locks. We need to be careful if there are
-	 * multiple context through which we free the tx descriptors.
-	 */
-	virtio_netdev_xmit_free(queue);
-
 	buf_start = pkt->data;
 	buf_len = pkt->len;
 	/**
@@ -364,8 +412,8 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	rc = uk_netbuf_header(pkt, header_sz);
 	if (unlikely(rc != 1)) {
 		uk_pr_err("Failed to prepend virtio header\n");
-		rc = -ENOSPC;
-		goto err_exit;
+		/* Not enough headroom, unlike a full virtqueue this is fatal */
+		return -EINVAL;
 	}
 	vhdr = pkt->data;
 
@@ -373,8 +421,34 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 * Fill the virtio-net-header with the necessary information.
 	 * Zero explicitly set.
 	 */
-	memset(vhdr, 0, sizeof(*vhdr));
+	memset(vhdr, 0, queue->vhdr_len);
 	vhdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
+	max_len = VIRTIO_PKT_BUFFER_LEN;
+	if (pkt->flags & (UK_NETBUF_F_PARTIAL_CSUM | UK_NETBUF_F_GSO_MASK)) {
+		if (unlikely((pkt->flags & ~queue->offload_flags)
+			     & (UK_NETBUF_F_PARTIAL_CSUM
+				| UK_NETBUF_F_GSO_MASK))) {
+			uk_pr_err("Offload not supported: 0x%"__PRIx16"\n",
+				  pkt->flags);
+			rc = -ENOTSUP;
+			goto err_remove_vhdr;
+		}
+		vhdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		vhdr->csum_start = pkt->csum_start;
+		vhdr->csum_offset = pkt->csum_offset;
+
+		if (pkt->flags & UK_NETBUF_F_GSO_TCPV4)
+			vhdr->gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+		else if (pkt->flags & UK_NETBUF_F_GSO_TCPV6)
+			vhdr->gso_type = VIRTIO_NET_HDR_GSO_TCPV6;
+		else if (pkt->flags & UK_NETBUF_F_GSO_UDP)
+			vhdr->gso_type = VIRTIO_NET_HDR_GSO_UDP;
+		if (vhdr->gso_type != VIRTIO_NET_HDR_GSO_NONE) {
+			vhdr->hdr_len = pkt->hdr_len;
+			vhdr->gso_size = pkt->gso_size;
+			max_len = VIRTIO_GSO_BUFFER_LEN;
+		}
+	}
 
 	/**
 	 * Prepare the sglist and enqueue the buffer to the virtio-ring.
@@ -389,7 +463,7 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 * 1 for the virtio header and the other for the actual network packet.
 	 */
 	/* Appending the data to the list. */
-	rc = uk_sglist_append(&queue->sg, vhdr, sizeof(*vhdr));
+	rc = uk_sglist_append(&queue->sg, vhdr, queue->vhdr_len);
 	if (unlikely(rc != 0)) {
 		uk_pr_err("Failed to append to the sg list\n");
 		goto err_remove_vhdr;
@@ -408,9 +482,9 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	}
 
 	total_len = uk_sglist_length(&queue->sg);
-	if (unlikely(total_len > VIRTIO_PKT_BUFFER_LEN)) {
-		uk_pr_err("Packet size too big: %lu, max:%u\n",
-			  total_len, VIRTIO_PKT_BUFFER_LEN);
+	if (unlikely(total_len > max_len)) {
+		uk_pr_err("Packet size too big: %lu, max:%lu\n",
+			  total_len, max_len);
 		rc = -ENOTSUP;
 		goto err_remove_vhdr;
 	}
@@ -420,35 +494,74 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 */
 	rc = virtqueue_buffer_enqueue(queue->vq, pkt, &queue->sg,
 				      queue->sg.sg_nseg, 0);
-	if (likely(rc >= 0)) {
+	if (likely(rc >= 0))
+		return rc;
+
+	if (rc == -ENOSPC)
+		uk_pr_debug("No more descriptor available\n");
+	else
+		uk_pr_err("Failed to enqueue descriptors into the ring: %d\n",
+			  rc);
+
+err_remove_vhdr:
+	/**
+	 * Remove header before exiting because we could not send
+	 */
+	uk_netbuf_header(pkt, -header_sz);
+	UK_ASSERT(rc < 0);
+	return rc;
+}
+
+static int virtio_netdev_xmit_burst(struct uk_netdev *dev,
+				    struct uk_netdev_tx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt)
+{
+	int status = 0x0;
+	int rc = 0;
+	__u16 i;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(queue && pkts && cnt);
+
+	/**
+	 * We are reclaiming the free descriptors from buffers. The function is
+	 * not protected by means of locks. We need to be careful if there are
+	 * multiple context through which we free the tx descriptors.
+	 */
+	virtio_netdev_xmit_free(queue);
+
+	for (i = 0; i < *cnt; i++) {
+		rc = virtio_netdev_xmit_enqueue(queue, pkts[i]);
+		if (unlikely(rc < 0))
+			break;
+	}
+	*cnt = i;
+
+	if (likely(i > 0)) {
 		status |= UK_NETDEV_STATUS_SUCCESS;
 		/**
-		 * Notify the host the new buffer.
+		 * Notify the host once about all new buffers.
 		 */
 		virtqueue_host_notify(queue->vq);
 		/**
 		 * When there is further space available in the ring
-		 * return UK_NETDEV_STATUS_MORE.
+		 * return UK_NETDEV_STATUS_MORE. A failed packet is
+		 * reported by the next call.
 		 */
 		status |= likely(rc > 0) ? UK_NETDEV_STATUS_MORE : 0x0;
-	} else if (rc == -ENOSPC) {
-		uk_pr_debug("No more descriptor available\n");
-		/**
-		 * Remove header before exiting because we could not send
-		 */
-		uk_netbuf_header(pkt, -header_sz);
-	} else {
-		uk_pr_err("Failed to enqueue descriptors into the ring: %d\n",
-			  rc);
-		goto err_remove_vhdr;
+	} else if (rc != -ENOSPC) {
+		return rc;
 	}
 	return status;
+}
 
-err_remove_vhdr:
-	uk_netbuf_header(pkt, -header_sz);
-err_exit:
-	UK_ASSERT(rc < 0);
-	return rc;
+static int virtio_netdev_xmit(struct uk_netdev *dev,
+			      struct uk_netdev_tx_queue *queue,
+			      struct uk_netbuf *pkt)
+{
+	__u16 cnt = 1;
+
+	return virtio_netdev_xmit_burst(dev, queue, &pkt, &cnt);
 }
 
 static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
@@ -486,7 +599,7 @@ static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 	uk_sglist_reset(sg);
 
 	/* Appending the header buffer to the sglist */
-	uk_sglist_append(sg, rxhdr, sizeof(struct virtio_net_hdr));
+	uk_sglist_append(sg, rxhdr, rxq->vhdr_len);
 
 	/* Appending the data buffer to the sglist */
 	uk_sglist_append(sg, buf_start, buf_len);
@@ -501,6 +614,7 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 	int ret;
 	int rc = 0;
 	struct uk_netbuf *buf = NULL;
+	struct virtio_net_hdr *rxhdr;
 	__u32 len;
 
 	UK_ASSERT(netbuf);
@@ -519,11 +633,22 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 
 	/**
 	 * Removing the virtio header from the buffer and adjusting length.
-	 * We pad "VTNET_RX_HEADER_PAD" to the rx buffer while enqueuing for
-	 * alignment of the packet data. We compensate for this, by adding the
-	 *  padding to the length on dequeue.
+	 * We pad the header to "struct virtio_net_hdr_padded" in the rx buffer
+	 * while enqueuing for alignment of the packet data. We compensate for
+	 * this, by adding the padding to the length on dequeue.
 	 */
-	buf->len = len + VTNET_RX_HEADER_PAD;
+	buf->len = len + sizeof(struct virtio_net_hdr_padded) - rxq->vhdr_len;
+
+	/* Meta data of a previous use of the netbuf is stale */
+	rxhdr = buf->data;
+	buf->flags = 0;
+	if (rxhdr->flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
+		buf->flags |= UK_NETBUF_F_PARTIAL_CSUM;
+		buf->csum_start = rxhdr->csum_start;
+		buf->csum_offset = rxhdr->csum_offset;
+	} else if (rxhdr->flags & VIRTIO_NET_HDR_F_DATA_VALID) {
+		buf->flags |= UK_NETBUF_F_DATA_VALID;
+	}
 	rc = uk_netbuf_header(buf,
 			      -((int16_t)sizeof(struct virtio_net_hdr_padded)));
 	UK_ASSERT(rc == 1);
@@ -532,70 +657,90 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 	return ret;
 }
 
-static int virtio_netdev_recv(struct uk_netdev *dev,
-			      struct uk_netdev_rx_queue *queue,
-			      struct uk_netbuf **pkt)
+static int virtio_netdev_recv_burst(struct uk_netdev *dev,
+				    struct uk_netdev_rx_queue *queue,
+				    struct uk_netbuf **pkts, __u16 *cnt)
 {
 	int status = 0x0;
 	int rc = 0;
+	int used;
+	__u16 nb_pkts = 0;
 
 	UK_ASSERT(dev && queue);
-	UK_ASSERT(pkt);
+	UK_ASSERT(pkts && cnt);
 
 	/* Queue interrupts have to be off when calling receive */
 	UK_ASSERT(!(queue->intr_enabled & VTNET_INTR_EN));
 
-	rc = virtio_netdev_rxq_dequeue(queue, pkt);
-	if (unlikely(rc < 0)) {
-		uk_pr_err("Failed to dequeue the packet: %d\n", rc);
-		goto err_exit;
-	}
-	status |= (*pkt) ? UK_NETDEV_STATUS_SUCCESS : 0x0;
-	status |= virtio_netdev_rx_fillup(queue, (queue->nb_desc - rc), 1);
-
-	/* Enable interrupt only when user had previously enabled it */
-	if (queue->intr_enabled & VTNET_INTR_USR_EN_MASK) {
-		/* Need to enable the interrupt on the last packet */
-		rc = virtqueue_intr_enable(queue->vq);
-		if (rc == 1 && !(*pkt)) {
-			/**
-			 * Packet arrive after reading the queue and before
-			 * enabling the interrupt
-			 */
-			rc = virtio_netdev_rxq_dequeue(queue, pkt);
+	for (;;) {
+		/* Number of descriptors in use, nothing to refill if empty */
+		used = queue->nb_desc;
+		while (nb_pkts < *cnt) {
+			rc = virtio_netdev_rxq_dequeue(queue, &pkts[nb_pkts]);
 			if (unlikely(rc < 0)) {
 				uk_pr_err("Failed to dequeue the packet: %d\n",
 					  rc);
-				goto err_exit;
+				if (nb_pkts == 0)
+					goto err_exit;
+				/* Deliver what we have got so far */
+				break;
 			}
-			status |= UK_NETDEV_STATUS_SUCCESS;
-
-			/*
-			 * Since we received something, we need to fillup
-			 * and notify
-			 */
-			status |= virtio_netdev_rx_fillup(queue,
-							  (queue->nb_desc - rc),
-							  1);
-
-			/* Need to enable the interrupt on the last packet */
-			rc = virtqueue_intr_enable(queue->vq);
-			status |= (rc == 1) ? UK_NETDEV_STATUS_MORE : 0x0;
-		} else if (*pkt) {
-			/* When we originally got a packet and there is more */
-			status |= (rc == 1) ? UK_NETDEV_STATUS_MORE : 0x0;
+			if (!pkts[nb_pkts])
+				break;
+			used = rc;
+			nb_pkts++;
 		}
-	} else if (*pkt) {
+
+		/* Fill up and notify once for the whole burst */
+		status |= virtio_netdev_rx_fillup(queue,
+						  (queue->nb_desc - used), 1);
+
 		/**
-		 * For polling case, we report always there are further
-		 * packets unless the queue is empty.
+		 * For polling case, we report further packets unless we
+		 * emptied the queue.
+		 */
+		if (!(queue->intr_enabled & VTNET_INTR_USR_EN_MASK)) {
+			if (nb_pkts == *cnt)
+				status |= UK_NETDEV_STATUS_MORE;
+			break;
+		}
+
+		/* Enable interrupt only when user had previously enabled it.
+		 * This fails if there are more packets on the queue.
+		 */
+		rc = virtqueue_intr_enable(queue->vq);
+		if (rc != 1)
+			break;
+		if (nb_pkts == *cnt) {
+			status |= UK_NETDEV_STATUS_MORE;
+			break;
+		}
+		/**
+		 * Packets arrived after reading the queue and before
+		 * enabling the interrupt
 		 */
-		status |= UK_NETDEV_STATUS_MORE;
 	}
+
+	*cnt = nb_pkts;
+	status |= nb_pkts ? UK_NETDEV_STATUS_SUCCESS : 0x0;
 	return status;
 
 err_exit:
 	UK_ASSERT(rc < 0);
+	*cnt = 0;
+	return rc;
+}
+
+static int virtio_netdev_recv(struct uk_netdev *dev,
+			      struct uk_netdev_rx_queue *queue,
+			      struct uk_netbuf **pkt)
+{
+	__u16 cnt = 1;
+	int rc;
+
+	rc = virtio_netdev_recv_burst(dev, queue, pkt, &cnt);
+	if (rc >= 0 && cnt == 0)
+		*pkt = NULL;
 	return rc;
 }
 
@@ -613,7 +758,7 @@ static struct uk_netdev_rx_queue *virtio_netdev_rx_queue_setup(
 	UK_ASSERT(conf->alloc_rxpkts);
 
 	vndev = to_virtionetdev(n);
-	if (queue_id >= vndev->max_vqueue_pairs) {
+	if (queue_id >= vndev->nb_vqueue_pairs) {
 		uk_pr_err("Invalid virtqueue identifier: %"__PRIu16"\n",
 			  queue_id);
 		rc = -EINVAL;
@@ -663,15 +808,24 @@ static int virtio_netdev_vqueue_setup(struct virtio_net_device *vndev,
 	int id = 0;
 	virtqueue_callback_t callback;
 	uint16_t max_desc, hwvq_id;
+	uint8_t vhdr_len;
+	__u32 offloads;
 	struct virtqueue *vq;
 
+	/* The queues are set up in any order, each of them only once */
+	id = queue_id;
+
+	/* Virtio 1.0 devices always use the header with num_buffers */
+	if (virtio_has_features(vndev->vdev->features, VIRTIO_F_VERSION_1))
+		vhdr_len = sizeof(struct virtio_net_hdr_mrg_rxbuf);
+	else
+		vhdr_len = sizeof(struct virtio_net_hdr);
+
 	if (queue_type == VNET_RX) {
-		id = vndev->rx_vqueue_cnt;
 		callback = virtio_netdev_recv_done;
 		max_desc = vndev->rxqs[id].max_nb_desc;
 		hwvq_id = vndev->rxqs[id].hwvq_id;
 	} else {
-		id = vndev->tx_vqueue_cnt;
 		/* We don't support the callback from the txqueue yet */
 		callback = NULL;
 		max_desc = vndev->txqs[id].max_nb_desc;
@@ -706,9 +860,21 @@ static int virtio_netdev_vqueue_setup(struct virtio_net_device *vndev,
 		vndev->rxqs[id].vq = vq;
 		vndev->rxqs[id].nb_desc = nr_desc;
 		vndev->rxqs[id].lqueue_id = queue_id;
+		vndev->rxqs[id].vhdr_len = vhdr_len;
 		vndev->rx_vqueue_cnt++;
 	} else {
+		offloads = virtio_netdev_offloads(vndev->vdev->features);
+		vndev->txqs[id].offload_flags =
+			((offloads & UK_FEATURE_TX_CSUM_AVAILABLE)
+			 ? UK_NETBUF_F_PARTIAL_CSUM : 0)
+			| ((offloads & UK_FEATURE_TX_TSO4_AVAILABLE)
+			   ? UK_NETBUF_F_GSO_TCPV4 : 0)
+			| ((offloads & UK_FEATURE_TX_TSO6_AVAILABLE)
+			   ? UK_NETBUF_F_GSO_TCPV6 : 0)
+			| ((offloads & UK_FEATURE_TX_UFO_AVAILABLE)
+			   ? UK_NETBUF_F_GSO_UDP : 0);
 		vndev->txqs[id].vq = vq;
+		vndev->txqs[id].vhdr_len = vhdr_len;
 		vndev->txqs[id].ndev = &vndev->netdev;
 		vndev->txqs[id].nb_desc = nr_desc;
 		vndev->txqs[id].lqueue_id = queue_id;
@@ -728,7 +894,7 @@ static struct uk_netdev_tx_queue *virtio_netdev_tx_queue_setup(
 
 	UK_ASSERT(n);
 	vndev = to_virtionetdev(n);
-	if (queue_id >= vndev->max_vqueue_pairs) {
+	if (queue_id >= vndev->nb_vqueue_pairs) {
 		uk_pr_err("Invalid virtqueue identifier: %"__PRIu16"\n",
 			  queue_id);
 		rc = -EINVAL;
@@ -762,7 +928,7 @@ static int virtio_netdev_rxq_info_get(struct uk_netdev *dev,
 	UK_ASSERT(dev);
 	UK_ASSERT(qinfo);
 	vndev = to_virtionetdev(dev);
-	if (unlikely(queue_id >= vndev->max_vqueue_pairs)) {
+	if (unlikely(queue_id >= vndev->nb_vqueue_pairs)) {
 		uk_pr_err("Invalid virtqueue id: %"__PRIu16"\n", queue_id);
 		rc = -EINVAL;
 		goto exit;
@@ -789,7 +955,7 @@ static int virtio_netdev_txq_info_get(struct uk_netdev *dev,
 	UK_ASSERT(qinfo);
 
 	vndev = to_virtionetdev(dev);
-	if (unlikely(queue_id >= vndev->max_vqueue_pairs)) {
+	if (unlikely(queue_id >= vndev->nb_vqueue_pairs)) {
 		uk_pr_err("Invalid queue_id %"__PRIu16"\n", queue_id);
 		rc = -EINVAL;
 		goto exit;
@@ -830,7 +996,8 @@ static __u16 virtio_net_mtu_get(struct uk_netdev *n)
 	return d->mtu;
 }
 
-static int virtio_netdev_feature_negotiate(struct virtio_net_device *vndev)
+static int virtio_netdev_feature_negotiate(struct virtio_net_device *vndev,
+					   __u32 offloads)
 {
 	__u64 host_features = 0;
 	__u16 hw_len;
@@ -878,6 +1045,19 @@ static int virtio_netdev_feature_negotiate(struct virtio_net_device *vndev)
 	 * Mask out features supported by both driver and device.
 	 */
 	vndev->vdev->features &= host_features;
+
+	/**
+	 * With VIRTIO_NET_F_GUEST_CSUM the device may hand over packets with
+	 * a partial checksum, which only an application asking for receive
+	 * checksum offload can handle.
+	 */
+	if (!(offloads & UK_FEATURE_RX_CSUM_AVAILABLE))
+		vndev->vdev->features &= ~(1ULL << VIRTIO_NET_F_GUEST_CSUM);
+	/* Segmentation offloads depend on checksum offload */
+	if (!virtio_has_features(vndev->vdev->features, VIRTIO_NET_F_CSUM))
+		vndev->vdev->features &= ~((1ULL << VIRTIO_NET_F_HOST_TSO4)
+					   | (1ULL << VIRTIO_NET_F_HOST_TSO6)
+					   | (1ULL << VIRTIO_NET_F_HOST_UFO));
 	virtio_feature_set(vndev->vdev, vndev->vdev->features);
 exit:
 	return rc;
@@ -889,16 +1069,26 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 	int rc = 0;
 	int i = 0;
 	int vq_avail = 0;
-	int total_vqs = conf->nb_rx_queues + conf->nb_tx_queues;
-	__u16 qdesc_size[total_vqs];
+	/* The control virtqueue follows the last queue pair of the device */
+	int total_vqs = 2 * vndev->max_vqueue_pairs + 1;
+	__u16 *qdesc_size;
 
-	if (conf->nb_rx_queues != 1 || conf->nb_tx_queues != 1) {
+	/**
+	 * The device delivers the packets of a flow to the receive queue
+	 * that pairs with the transmit queue the flow was last sent on, so
+	 * both halves of each pair have to be used.
+	 */
+	if (conf->nb_rx_queues != conf->nb_tx_queues
+	    || conf->nb_rx_queues == 0
+	    || conf->nb_rx_queues > vndev->max_vqueue_pairs) {
 		uk_pr_err("Queue combination not supported: %"__PRIu16"/%"__PRIu16" rx/tx\n",
 			  conf->nb_rx_queues, conf->nb_tx_queues);
 
 		return -ENOTSUP;
 	}
 
+	vndev->nb_vqueue_pairs = conf->nb_rx_queues;
+
 	/**
 	 * TODO:
 	 * The virtio device management data structure are allocated using the
@@ -906,14 +1096,20 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 	 * wiser to move it to the allocator of each individual queue. This
 	 * would better considering NUMA support.
 	 */
-	vndev->rxqs = uk_malloc(a, sizeof(*vndev->rxqs) * conf->nb_rx_queues);
-	vndev->txqs = uk_malloc(a, sizeof(*vndev->txqs) * conf->nb_tx_queues);
-	if (unlikely(!vndev->rxqs || !vndev->txqs)) {
+	vndev->rxqs = uk_calloc(a, vndev->nb_vqueue_pairs,
+				sizeof(*vndev->rxqs));
+	vndev->txqs = uk_calloc(a, vndev->nb_vqueue_pairs,
+				sizeof(*vndev->txqs));
+	qdesc_size = uk_malloc(a, sizeof(*qdesc_size) * total_vqs);
+	if (unlikely(!vndev->rxqs || !vndev->txqs || !qdesc_size)) {
 		uk_pr_err("Failed to allocate memory for queue management\n");
 		rc = -ENOMEM;
 		goto err_free_txrx;
 	}
 
+	if (!virtio_has_features(vndev->vdev->features,
+				 VIRTIO_NET_F_CTRL_VQ))
+		total_vqs--;
 	vq_avail = virtio_find_vqs(vndev->vdev, total_vqs, qdesc_size);
 	if (unlikely(vq_avail != total_vqs)) {
 		uk_pr_err("Expected: %d queues, Found: %d queues\n",
@@ -931,7 +1127,7 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 	 * ...
 	 * Virtqueue-ctrlq
 	 */
-	for (i = 0; i < vndev->max_vqueue_pairs; i++) {
+	for (i = 0; i < vndev->nb_vqueue_pairs; i++) {
 		/**
 		 * Initialize the received queue with the information received
 		 * from the device.
@@ -954,19 +1150,97 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 				sizeof(vndev->txqs[i].sgsegs[0])),
 			       &vndev->txqs[i].sgsegs[0]);
 	}
+
+	if (virtio_has_features(vndev->vdev->features,
+				VIRTIO_NET_F_CTRL_VQ)) {
+		vndev->ctrl_vq = virtio_vqueue_setup(vndev->vdev,
+						     total_vqs - 1,
+						     qdesc_size[total_vqs - 1],
+						     NULL, a);
+		if (unlikely(PTRISERR(vndev->ctrl_vq))) {
+			uk_pr_err("Failed to set up the control virtqueue\n");
+			rc = PTR2ERR(vndev->ctrl_vq);
+			vndev->ctrl_vq = NULL;
+			goto err_free_txrx;
+		}
+		/* Commands are completed by polling */
+		virtqueue_intr_disable(vndev->ctrl_vq);
+	}
+	uk_free(a, qdesc_size);
 exit:
 	return rc;
 
 err_free_txrx:
-	if (!vndev->rxqs)
-		uk_free(a, vndev->rxqs);
-	if (!vndev->txqs)
-		uk_free(a, vndev->txqs);
+	uk_free(a, qdesc_size);
+	uk_free(a, vndev->rxqs);
+	uk_free(a, vndev->txqs);
+	vndev->rxqs = NULL;
+	vndev->txqs = NULL;
 	goto exit;
 }
 
+/**
+ * Sends a command on the control virtqueue and waits for the device to
+ * complete it. Returns -ETIMEDOUT if the device does not complete it
+ * within VTNET_CTRL_TIMEOUT, and -EBUSY for further commands as long as
+ * that one is not completed.
+ */
+static int virtio_netdev_ctrl_send(struct virtio_net_device *vndev,
+				   __u8 class, __u8 cmd,
+				   const void *data, __u16 len)
+{
+	struct virtio_net_ctrl *ctrl = &vndev->ctrl;
+	struct uk_sglist_seg segs[3];
+	struct uk_sglist sg;
+	void *cookie;
+	__u32 used_len;
+	__nsec deadline;
+	int rc;
+
+	UK_ASSERT(vndev->ctrl_vq);
+	UK_ASSERT(len <= sizeof(ctrl->data));
+
+	if (unlikely(vndev->ctrl_pending)) {
+		if (virtqueue_buffer_dequeue(vndev->ctrl_vq, &cookie,
+					     &used_len) < 0)
+			return -EBUSY;
+		vndev->ctrl_pending = 0;
+	}
+
+	ctrl->hdr.class = class;
+	ctrl->hdr.cmd = cmd;
+	memcpy(ctrl->data, data, len);
+	ctrl->ack = VIRTIO_NET_ERR;
+
+	uk_sglist_init(&sg, ARRAY_SIZE(segs), segs);
+	uk_sglist_append(&sg, &ctrl->hdr, sizeof(ctrl->hdr));
+	uk_sglist_append(&sg, ctrl->data, len);
+	uk_sglist_append(&sg, &ctrl->ack, sizeof(ctrl->ack));
+
+	rc = virtqueue_buffer_enqueue(vndev->ctrl_vq, ctrl, &sg,
+				      sg.sg_nseg - 1, 1);
+	if (unlikely(rc < 0))
+		return rc;
+	virtqueue_host_notify(vndev->ctrl_vq);
+
+	/* The device processes the commands right away */
+	deadline = ukplat_monotonic_clock() + VTNET_CTRL_TIMEOUT;
+	while (virtqueue_buffer_dequeue(vndev->ctrl_vq, &cookie,
+					&used_len) < 0) {
+		if (unlikely(ukplat_monotonic_clock() >= deadline)) {
+			vndev->ctrl_pending = 1;
+			return -ETIMEDOUT;
+		}
+		ukarch_spinwait();
+	}
+	UK_ASSERT(cookie == ctrl);
+
+	return (ctrl->ack == VIRTIO_NET_OK) ? 0 : -EIO;
+}
+
 static int virtio_netdev_configure(struct uk_netdev *n,
-				   const struct uk_netdev_conf *conf)
+				   const struct uk_netdev_conf *conf,
+				   __u32 offloads)
 {
 	int rc = 0;
 	struct virtio_net_device *vndev;
@@ -975,7 +1249,7 @@ static int virtio_netdev_configure(struct uk_netdev *n,
 	UK_ASSERT(conf);
 	vndev = to_virtionetdev(n);
 
-	rc = virtio_netdev_feature_negotiate(vndev);
+	rc = virtio_netdev_feature_negotiate(vndev, offloads);
 	if (rc != 0) {
 		uk_pr_err("Failed to negotiate the device feature %d\n", rc);
 		goto err_negotiate_feature;
@@ -991,8 +1265,9 @@ static int virtio_netdev_configure(struct uk_netdev *n,
 	vndev->rx_vqueue_cnt = 0;
 	vndev->tx_vqueue_cnt = 0;
 
-	uk_pr_info("Configured: features=0x%lx max_virtqueue_pairs=%"__PRIu16"\n",
-		   vndev->vdev->features, vndev->max_vqueue_pairs);
+	uk_pr_info("Configured: features=0x%lx virtqueue_pairs=%"__PRIu16"/%"
+		   __PRIu16"\n", vndev->vdev->features,
+		   vndev->nb_vqueue_pairs, vndev->max_vqueue_pairs);
 exit:
 	return rc;
 
@@ -1052,13 +1327,14 @@ static void virtio_net_info_get(struct uk_netdev *dev,
 	dev_info->nb_encap_tx = sizeof(struct virtio_net_hdr_padded);
 	dev_info->nb_encap_rx = sizeof(struct virtio_net_hdr_padded);
 	dev_info->ioalign = sizeof(void *); /* word size alignment */
-	dev_info->features = UK_FEATURE_RXQ_INTR_AVAILABLE;
+	dev_info->features = UK_FEATURE_RXQ_INTR_AVAILABLE | vndev->offloads;
 }
 
 static int virtio_net_start(struct uk_netdev *n)
 {
 	struct virtio_net_device *d;
 	int i = 0;
+	int rc;
 
 	UK_ASSERT(n != NULL);
 	d = to_virtionetdev(n);
@@ -1082,21 +1358,89 @@ static int virtio_net_start(struct uk_netdev *n)
 	 * Set the DRIVER_OK status bit. At this point the device is "live".
 	 */
 	virtio_dev_drv_up(d->vdev);
+
+	/*
+	 * A multi-queue device only uses the first pair until it is told
+	 * otherwise through the control queue.
+	 */
+	if (d->ctrl_vq && d->nb_vqueue_pairs > 1
+	    && virtio_has_features(d->vdev->features, VIRTIO_NET_F_MQ)) {
+		struct virtio_net_ctrl_mq mq;
+
+		mq.virtqueue_pairs = d->nb_vqueue_pairs;
+		rc = virtio_netdev_ctrl_send(d, VIRTIO_NET_CTRL_MQ,
+					     VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET,
+					     &mq, sizeof(mq));
+		if (rc < 0) {
+			uk_pr_err(DRIVER_NAME": %"__PRIu16" failed to enable %"
+				  __PRIu16" queue pairs: %d\n",
+				  d->uid, d->nb_vqueue_pairs, rc);
+			return rc;
+		}
+	}
 	uk_pr_info(DRIVER_NAME": %"__PRIu16" started\n", d->uid);
 
 	return 0;
 }
 
+/**
+ * Translates virtio-net feature bits to the uknetdev offload features.
+ */
+static __u32 virtio_netdev_offloads(__u64 features)
+{
+	__u32 offloads = 0;
+
+	if (!virtio_has_features(features, VIRTIO_NET_F_CSUM))
+		goto rx;
+	offloads |= UK_FEATURE_TX_CSUM_AVAILABLE;
+	if (virtio_has_features(features, VIRTIO_NET_F_HOST_TSO4))
+		offloads |= UK_FEATURE_TX_TSO4_AVAILABLE;
+	if (virtio_has_features(features, VIRTIO_NET_F_HOST_TSO6))
+		offloads |= UK_FEATURE_TX_TSO6_AVAILABLE;
+	if (virtio_has_features(features, VIRTIO_NET_F_HOST_UFO))
+		offloads |= UK_FEATURE_TX_UFO_AVAILABLE;
+rx:
+	if (virtio_has_features(features, VIRTIO_NET_F_GUEST_CSUM))
+		offloads |= UK_FEATURE_RX_CSUM_AVAILABLE;
+	return offloads;
+}
+
 static inline void virtio_netdev_feature_set(struct virtio_net_device *vndev)
 {
+	__u64 host_features;
+	__u16 pairs;
+	int rc;
+
 	vndev->vdev->features = 0;
 	/* Setting the feature the driver support */
 	VIRTIO_NET_DRV_FEATURES(vndev->vdev->features);
+
 	/**
-	 * TODO:
-	 * Adding multiqueue support for the virtio net driver.
+	 * The number of queue pairs has to be known before the device is
+	 * configured because it is reported by info_get.
 	 */
 	vndev->max_vqueue_pairs = 1;
+	host_features = virtio_feature_get(vndev->vdev);
+	vndev->offloads = virtio_netdev_offloads(vndev->vdev->features
+						 & host_features);
+	if (!virtio_has_features(host_features, VIRTIO_NET_F_MQ)
+	    || !virtio_has_features(host_features, VIRTIO_NET_F_CTRL_VQ))
+		return;
+
+	rc = virtio_config_get(vndev->vdev,
+			       __offsetof(struct virtio_net_config,
+					  max_virtqueue_pairs),
+			       &pairs, sizeof(pairs), 1);
+	if (rc != sizeof(pairs)) {
+		uk_pr_warn("Failed to read the number of queue pairs %d\n",
+			   rc);
+		return;
+	}
+	if (pairs < VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MIN)
+		pairs = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MIN;
+	else if (pairs > VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MAX)
+		pairs = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MAX;
+	vndev->max_vqueue_pairs = pairs;
 }
 
 static const struct uk_netdev_ops virtio_netdev_ops = {
@@ -1130,6 +1474,8 @@ static int virtio_net_add_dev(struct virtio_dev *vdev)
 	/* register netdev */
 	vndev->netdev.rx_one = virtio_netdev_recv;
 	vndev->netdev.tx_one = virtio_netdev_xmit;
+	vndev->netdev.rx_burst = virtio_netdev_recv_burst;
+	vndev->netdev.tx_burst = virtio_netdev_xmit_burst;
 	vndev->netdev.ops = &virtio_netdev_ops;
 
 	rc = uk_netdev_drv_register(&vndev->netdev, a, drv_name);
@@ -48,6 +48,16 @@
 
 static struct uk_alloc *a;
 
+/**
+ * Per-queue state of the modern interface.
+ */
+struct virtio_pci_queue {
+	/* The virtqueue, NULL while the queue is not set up */
+	struct virtqueue *vq;
+	/* Address that notifies the device about new buffers */
+	volatile __u16 *notify;
+};
+
 /**
  * The structure declares a pci device.
  */
@@ -60,6 +70,18 @@ struct virtio_pci_dev {
 	__u16 pci_isr_addr;
 	/* Pci device information */
 	struct pci_device *pdev;
+
+	/* Memory mapped structures of the modern interface */
+	__u8 *common_cfg;
+	__u8 *notify_base;
+	__u32 notify_off_mult;
+	__u8 *isr_cfg;
+	__u8 *dev_cfg;
+	/* Queues found by the modern interface */
+	struct virtio_pci_queue *queues;
+	__u16 nb_queues;
+	/* Non-zero if every queue interrupts through its own MSI-X vector */
+	__u8 msix_enabled;
 };
 
 /**
@@ -96,6 +118,29 @@ static int virtio_pci_handle(void *arg);
 static int vpci_legacy_notify(struct virtio_dev *vdev, __u16 queue_id);
 static int virtio_pci_legacy_add_dev(struct pci_device *pci_dev,
 				     struct virtio_pci_dev *vpci_dev);
+#if CONFIG_VIRTIO_PCI_MODERN
+static void vpci_modern_pci_dev_reset(struct virtio_dev *vdev);
+static int vpci_modern_pci_config_set(struct virtio_dev *vdev, __u16 offset,
+				      const void *buf, __u32 len);
+static int vpci_modern_pci_config_get(struct virtio_dev *vdev, __u16 offset,
+				      void *buf, __u32 len, __u8 type_len);
+static __u64 vpci_modern_pci_features_get(struct virtio_dev *vdev);
+static void vpci_modern_pci_features_set(struct virtio_dev *vdev,
+					 __u64 features);
+static int vpci_modern_pci_vq_find(struct virtio_dev *vdev, __u16 num_vq,
+				   __u16 *qdesc_size);
+static void vpci_modern_pci_status_set(struct virtio_dev *vdev, __u8 status);
+static __u8 vpci_modern_pci_status_get(struct virtio_dev *vdev);
+static struct virtqueue *vpci_modern_vq_setup(struct virtio_dev *vdev,
+					      __u16 queue_id,
+					      __u16 num_desc,
+					      virtqueue_callback_t callback,
+					      struct uk_alloc *a);
+static void vpci_modern_vq_release(struct virtio_dev *vdev,
+		struct virtqueue *vq, struct uk_alloc *a);
+static int virtio_pci_modern_add_dev(struct pci_device *pci_dev,
+				     struct virtio_pci_dev *vpci_dev);
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
 
 /**
  * Configuration operations legacy PCI device.
@@ -113,6 +158,24 @@ static struct virtio_config_ops vpci_legacy_ops = {
 	.vq_release   = vpci_legacy_vq_release,
 };
 
+#if CONFIG_VIRTIO_PCI_MODERN
+/**
+ * Configuration operations of modern (virtio 1.0) PCI devices.
+ */
+static struct virtio_config_ops vpci_modern_ops = {
+	.device_reset = vpci_modern_pci_dev_reset,
+	.config_get   = vpci_modern_pci_config_get,
+	.config_set   = vpci_modern_pci_config_set,
+	.features_get = vpci_modern_pci_features_get,
+	.features_set = vpci_modern_pci_features_set,
+	.status_get   = vpci_modern_pci_status_get,
+	.status_set   = vpci_modern_pci_status_set,
+	.vqs_find     = vpci_modern_pci_vq_find,
+	.vq_setup     = vpci_modern_vq_setup,
+	.vq_release   = vpci_modern_vq_release,
+};
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
+
 static int vpci_legacy_notify(struct virtio_dev *vdev, __u16 queue_id)
 {
 	struct virtio_pci_dev *vpdev;
@@ -135,7 +198,11 @@ static int virtio_pci_handle(void *arg)
 	UK_ASSERT(arg);
 
 	/* Reading the isr status is used to acknowledge the interrupt */
-	isr_status = virtio_cread8((void *)(unsigned long)d->pci_isr_addr, 0);
+	if (d->isr_cfg)
+		isr_status = *(volatile __u8 *) d->isr_cfg;
+	else
+		isr_status = virtio_cread8((void *)(unsigned long)
+					   d->pci_isr_addr, 0);
 	/* We don't support configuration interrupt on the device */
 	if (isr_status & VIRTIO_PCI_ISR_CONFIG) {
 		uk_pr_warn("Unsupported config change interrupt received on virtio-pci device %p\n",
@@ -381,6 +448,490 @@ static int virtio_pci_legacy_add_dev(struct pci_device *pci_dev,
 	return 0;
 }
 
+#if CONFIG_VIRTIO_PCI_MODERN
+/*
+ * The structures of the modern interface are memory mapped. Fields wider
+ * than 32 bits are accessed as two 32-bit halves, low half first.
+ */
+static inline __u8 vpci_mmio_read8(const __u8 *base, __u16 off)
+{
+	return *(volatile __u8 *)(base + off);
+}
+
+static inline __u16 vpci_mmio_read16(const __u8 *base, __u16 off)
+{
+	return *(volatile __u16 *)(base + off);
+}
+
+static inline __u32 vpci_mmio_read32(const __u8 *base, __u16 off)
+{
+	return *(volatile __u32 *)(base + off);
+}
+
+static inline void vpci_mmio_write8(__u8 *base, __u16 off, __u8 val)
+{
+	*(volatile __u8 *)(base + off) = val;
+}
+
+static inline void vpci_mmio_write16(__u8 *base, __u16 off, __u16 val)
+{
+	*(volatile __u16 *)(base + off) = val;
+}
+
+static inline void vpci_mmio_write32(__u8 *base, __u16 off, __u32 val)
+{
+	*(volatile __u32 *)(base + off) = val;
+}
+
+static inline void vpci_mmio_write64(__u8 *base, __u16 off, __u64 val)
+{
+	vpci_mmio_write32(base, off, (__u32) val);
+	vpci_mmio_write32(base, off + 4, (__u32) (val >> 32));
+}
+
+static int vpci_modern_notify(struct virtio_dev *vdev, __u16 queue_id)
+{
+	struct virtio_pci_dev *vpdev;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	UK_ASSERT(queue_id < vpdev->nb_queues);
+
+	*vpdev->queues[queue_id].notify = queue_id;
+	return 0;
+}
+
+/*
+ * MSI-X handler of a single virtqueue. The vector is not shared, so the
+ * interrupt is always ours even if the queue was drained by polling.
+ */
+static int virtio_pci_vq_handle(void *arg)
+{
+	struct virtio_pci_queue *q = (struct virtio_pci_queue *) arg;
+
+	UK_ASSERT(q);
+
+	if (likely(q->vq))
+		virtqueue_ring_interrupt(q->vq);
+	return 1;
+}
+
+static struct virtqueue *vpci_modern_vq_setup(struct virtio_dev *vdev,
+					      __u16 queue_id,
+					      __u16 num_desc,
+					      virtqueue_callback_t callback,
+					      struct uk_alloc *a)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	struct virtqueue *vq;
+	__u16 vector;
+	long flags;
+
+	UK_ASSERT(vdev != NULL);
+
+	vpdev = to_virtiopcidev(vdev);
+	if (unlikely(queue_id >= vpdev->nb_queues)) {
+		uk_pr_err("Virtqueue %"__PRIu16" not available\n", queue_id);
+		return ERR2PTR(-EINVAL);
+	}
+
+	vq = virtqueue_create(queue_id, num_desc, VIRTIO_PCI_VRING_ALIGN,
+			      callback, vpci_modern_notify, vdev, a);
+	if (PTRISERR(vq)) {
+		uk_pr_err("Failed to create the virtqueue: %d\n",
+			  PTR2ERR(vq));
+		return vq;
+	}
+
+	/* The modern interface accepts queues smaller than the maximum */
+	vpci_mmio_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_SELECT,
+			  queue_id);
+	vpci_mmio_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_SIZE,
+			  num_desc);
+	vpci_mmio_write64(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_DESCLO,
+			  virtqueue_physaddr(vq));
+	vpci_mmio_write64(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_AVAILLO,
+			  virtqueue_driver_area_physaddr(vq));
+	vpci_mmio_write64(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_USEDLO,
+			  virtqueue_device_area_physaddr(vq));
+
+	if (vpdev->msix_enabled) {
+		vpci_mmio_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_MSIX,
+				  queue_id);
+		vector = vpci_mmio_read16(vpdev->common_cfg,
+					  VIRTIO_PCI_COMMON_Q_MSIX);
+		if (unlikely(vector != queue_id)) {
+			uk_pr_err("Failed to assign MSI-X vector to virtqueue %"__PRIu16"\n",
+				  queue_id);
+			virtqueue_destroy(vq, a);
+			return ERR2PTR(-EIO);
+		}
+	}
+
+	flags = ukplat_lcpu_save_irqf();
+	vpdev->queues[queue_id].vq = vq;
+	UK_TAILQ_INSERT_TAIL(&vpdev->vdev.vqs, vq, next);
+	ukplat_lcpu_restore_irqf(flags);
+
+	vpci_mmio_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_ENABLE, 1);
+	return vq;
+}
+
+static void vpci_modern_vq_release(struct virtio_dev *vdev,
+		struct virtqueue *vq, struct uk_alloc *a)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	long flags;
+
+	UK_ASSERT(vq != NULL);
+	UK_ASSERT(a != NULL);
+	vpdev = to_virtiopcidev(vdev);
+
+	/*
+	 * Enabled queues can only be taken away from the device with a reset.
+	 * Until then, at least stop its interrupts.
+	 */
+	vpci_mmio_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_SELECT,
+			  vq->queue_id);
+	vpci_mmio_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_Q_MSIX,
+			  VIRTIO_MSI_NO_VECTOR);
+
+	flags = ukplat_lcpu_save_irqf();
+	vpdev->queues[vq->queue_id].vq = NULL;
+	UK_TAILQ_REMOVE(&vpdev->vdev.vqs, vq, next);
+	ukplat_lcpu_restore_irqf(flags);
+
+	virtqueue_destroy(vq, a);
+}
+
+/*
+ * Routes the interrupts of every queue to an MSI-X vector of its own.
+ * Returns a negative value if the device or the platform cannot do this.
+ */
+static int vpci_modern_msix_setup(struct virtio_pci_dev *vpdev)
+{
+	int rc;
+	__u16 i;
+
+	rc = pci_msix_enable(vpdev->pdev);
+	if (rc < 0)
+		return rc;
+	if (rc < vpdev->nb_queues) {
+		rc = -ENOSPC;
+		goto err_disable;
+	}
+
+	for (i = 0; i < vpdev->nb_queues; i++) {
+		rc = pci_msix_vector_setup(vpdev->pdev, i,
+					   virtio_pci_vq_handle,
+					   &vpdev->queues[i]);
+		if (rc < 0)
+			goto err_disable;
+	}
+
+	/* We don't support configuration interrupts */
+	vpci_mmio_write16(vpdev->common_cfg, VIRTIO_PCI_COMMON_MSIX,
+			  VIRTIO_MSI_NO_VECTOR);
+	vpdev->msix_enabled = 1;
+	return 0;
+
+err_disable:
+	pci_msix_disable(vpdev->pdev);
+	return rc;
+}
+
+static int vpci_modern_pci_vq_find(struct virtio_dev *vdev, __u16 num_vqs,
+				   __u16 *qdesc_size)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	int vq_cnt = 0, i = 0, rc = 0;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+
+	if (!(vpci_modern_pci_status_get(vdev)
+	      & VIRTIO_CONFIG_STATUS_FEATURES_OK)) {
+		uk_pr_err("Features were not accepted by the device\n");
+		return -EIO;
+	}
+
+	if (!vpdev->queues) {
+		vpdev->nb_queues = vpci_mmio_read16(vpdev->common_cfg,
+						    VIRTIO_PCI_COMMON_NUMQ);
+		vpdev->queues = uk_calloc(a, vpdev->nb_queues,
+					  sizeof(*vpdev->queues));
+		if (!vpdev->queues)
+			return -ENOMEM;
+
+		for (i = 0; i < vpdev->nb_queues; i++) {
+			vpci_mmio_write16(vpdev->common_cfg,
+					  VIRTIO_PCI_COMMON_Q_SELECT, i);
+			vpdev->queues[i].notify = (volatile __u16 *)
+				(vpdev->notify_base + vpdev->notify_off_mult
+				 * vpci_mmio_read16(vpdev->common_cfg,
+						    VIRTIO_PCI_COMMON_Q_NOFF));
+		}
+
+		/* Fall back to the shared INTx line without enough vectors */
+		rc = vpci_modern_msix_setup(vpdev);
+		if (rc < 0) {
+			uk_pr_info("virtio-pci device %p: No MSI-X (%d), using INTx\n",
+				   vpdev, rc);
+			rc = ukplat_irq_register(vpdev->pdev->irq,
+						 virtio_pci_handle, vpdev);
+			if (rc != 0) {
+				uk_pr_err("Failed to register the interrupt\n");
+				return rc;
+			}
+		}
+	}
+
+	for (i = 0; i < num_vqs; i++) {
+		qdesc_size[i] = 0;
+		if (i < vpdev->nb_queues) {
+			vpci_mmio_write16(vpdev->common_cfg,
+					  VIRTIO_PCI_COMMON_Q_SELECT, i);
+			qdesc_size[i] = vpci_mmio_read16(vpdev->common_cfg,
+						VIRTIO_PCI_COMMON_Q_SIZE);
+		}
+		if (unlikely(!qdesc_size[i])) {
+			uk_pr_err("Virtqueue %d not available\n", i);
+			continue;
+		}
+		vq_cnt++;
+	}
+	return vq_cnt;
+}
+
+static int vpci_modern_pci_config_set(struct virtio_dev *vdev, __u16 offset,
+				      const void *buf, __u32 len)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u32 i;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+
+	for (i = 0; i < len; i++)
+		vpci_mmio_write8(vpdev->dev_cfg, offset + i,
+				 ((const __u8 *) buf)[i]);
+	return 0;
+}
+
+static int vpci_modern_pci_config_get(struct virtio_dev *vdev, __u16 offset,
+				      void *buf, __u32 len, __u8 type_len)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u8 generation;
+	__u32 i;
+
+	UK_ASSERT(vdev);
+	UK_ASSERT(type_len == 1 || type_len == 2 || type_len == 4
+		  || type_len == 8);
+	vpdev = to_virtiopcidev(vdev);
+
+	/* The generation changes if the device updated the configuration
+	 * while we were reading it
+	 */
+	do {
+		generation = vpci_mmio_read8(vpdev->common_cfg,
+					     VIRTIO_PCI_COMMON_CFGGENERATION);
+		for (i = 0; i + type_len <= len; i += type_len) {
+			switch (type_len) {
+			case 1:
+				((__u8 *) buf)[i] =
+					vpci_mmio_read8(vpdev->dev_cfg,
+							offset + i);
+				break;
+			case 2:
+				*(__u16 *)((__u8 *) buf + i) =
+					vpci_mmio_read16(vpdev->dev_cfg,
+							 offset + i);
+				break;
+			case 4:
+				*(__u32 *)((__u8 *) buf + i) =
+					vpci_mmio_read32(vpdev->dev_cfg,
+							 offset + i);
+				break;
+			default:
+				*(__u32 *)((__u8 *) buf + i) =
+					vpci_mmio_read32(vpdev->dev_cfg,
+							 offset + i);
+				*(__u32 *)((__u8 *) buf + i + 4) =
+					vpci_mmio_read32(vpdev->dev_cfg,
+							 offset + i + 4);
+				break;
+			}
+		}
+	} while (generation != vpci_mmio_read8(vpdev->common_cfg,
+					VIRTIO_PCI_COMMON_CFGGENERATION));
+
+	/* Same return values as the legacy interface */
+	if (type_len == len && type_len <= 4)
+		return 0;
+	return len;
+}
+
+static __u8 vpci_modern_pci_status_get(struct virtio_dev *vdev)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	return vpci_mmio_read8(vpdev->common_cfg, VIRTIO_PCI_COMMON_STATUS);
+}
+
+static void vpci_modern_pci_status_set(struct virtio_dev *vdev, __u8 status)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	/* Reset should be performed using the reset interface */
+	UK_ASSERT(vdev || status != VIRTIO_CONFIG_STATUS_RESET);
+
+	vpdev = to_virtiopcidev(vdev);
+	status |= vpci_modern_pci_status_get(vdev);
+	vpci_mmio_write8(vpdev->common_cfg, VIRTIO_PCI_COMMON_STATUS, status);
+}
+
+static void vpci_modern_pci_dev_reset(struct virtio_dev *vdev)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	UK_ASSERT(vdev);
+
+	vpdev = to_virtiopcidev(vdev);
+	vpci_mmio_write8(vpdev->common_cfg, VIRTIO_PCI_COMMON_STATUS,
+			 VIRTIO_CONFIG_STATUS_RESET);
+	/* The reset is complete once the device reads back 0 */
+	while (vpci_mmio_read8(vpdev->common_cfg, VIRTIO_PCI_COMMON_STATUS)
+	       != VIRTIO_CONFIG_STATUS_RESET)
+		;
+}
+
+static __u64 vpci_modern_pci_features_get(struct virtio_dev *vdev)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u64 features;
+
+	UK_ASSERT(vdev);
+
+	vpdev = to_virtiopcidev(vdev);
+	vpci_mmio_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_DFSELECT, 0);
+	features = vpci_mmio_read32(vpdev->common_cfg, VIRTIO_PCI_COMMON_DF);
+	vpci_mmio_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_DFSELECT, 1);
+	features |= (__u64) vpci_mmio_read32(vpdev->common_cfg,
+					     VIRTIO_PCI_COMMON_DF) << 32;
+	return features;
+}
+
+static void vpci_modern_pci_features_set(struct virtio_dev *vdev,
+					 __u64 features)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+
+	/* Mask out features not supported by the virtqueue driver. The
+	 * modern interface cannot be used without VIRTIO_F_VERSION_1; the
+	 * drivers find it in the negotiated features.
+	 */
+	features = virtqueue_feature_negotiate(features);
+	features |= (1ULL << VIRTIO_F_VERSION_1);
+	vdev->features |= (1ULL << VIRTIO_F_VERSION_1);
+
+	vpci_mmio_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_GFSELECT, 0);
+	vpci_mmio_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_GF,
+			  (__u32) features);
+	vpci_mmio_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_GFSELECT, 1);
+	vpci_mmio_write32(vpdev->common_cfg, VIRTIO_PCI_COMMON_GF,
+			  (__u32) (features >> 32));
+
+	/* The device may refuse the subset of features */
+	vpci_modern_pci_status_set(vdev, VIRTIO_CONFIG_STATUS_FEATURES_OK);
+	if (!(vpci_modern_pci_status_get(vdev)
+	      & VIRTIO_CONFIG_STATUS_FEATURES_OK))
+		uk_pr_err("virtio-pci device %p refused features 0x%llx\n",
+			  vpdev, (unsigned long long) features);
+}
+
+/*
+ * Looks up the structure that a virtio capability describes. Returns NULL
+ * if the device does not have a capability of this type.
+ */
+static __u8 *vpci_modern_find_cfg(struct pci_device *pdev, __u8 cfg_type,
+				  __u8 *cap_pos)
+{
+	__u8 pos = 0, bar;
+	__u8 *base;
+
+	while ((pos = pci_find_cap(pdev, PCI_CAP_ID_VNDR, pos))) {
+		if (pci_conf_read8(pdev, pos + VIRTIO_PCI_CAP_CFG_TYPE)
+		    != cfg_type)
+			continue;
+
+		bar = pci_conf_read8(pdev, pos + VIRTIO_PCI_CAP_BAR);
+		base = pci_bar_map(pdev, bar);
+		if (!base)
+			continue;
+
+		if (cap_pos)
+			*cap_pos = pos;
+		return base + pci_conf_read32(pdev, pos + VIRTIO_PCI_CAP_OFFSET);
+	}
+	return NULL;
+}
+
+static int virtio_pci_modern_add_dev(struct pci_device *pci_dev,
+				     struct virtio_pci_dev *vpci_dev)
+{
+	__u8 notify_cap;
+
+	vpci_dev->common_cfg = vpci_modern_find_cfg(pci_dev,
+						VIRTIO_PCI_CAP_COMMON_CFG,
+						NULL);
+	vpci_dev->notify_base = vpci_modern_find_cfg(pci_dev,
+						VIRTIO_PCI_CAP_NOTIFY_CFG,
+						&notify_cap);
+	vpci_dev->isr_cfg = vpci_modern_find_cfg(pci_dev,
+						 VIRTIO_PCI_CAP_ISR_CFG,
+						 NULL);
+	/* Devices without configuration do not need this structure */
+	vpci_dev->dev_cfg = vpci_modern_find_cfg(pci_dev,
+						 VIRTIO_PCI_CAP_DEVICE_CFG,
+						 NULL);
+	if (!vpci_dev->common_cfg || !vpci_dev->notify_base
+	    || !vpci_dev->isr_cfg) {
+		vpci_dev->common_cfg = NULL;
+		vpci_dev->notify_base = NULL;
+		vpci_dev->isr_cfg = NULL;
+		vpci_dev->dev_cfg = NULL;
+		return -ENOTSUP;
+	}
+	vpci_dev->notify_off_mult = pci_conf_read32(pci_dev,
+					notify_cap + VIRTIO_PCI_NOTIFY_CAP_MULT);
+
+	/* The device accesses the rings in memory on its own */
+	pci_set_master(pci_dev);
+
+	/* Setting the configuration operation */
+	vpci_dev->vdev.cops = &vpci_modern_ops;
+
+	uk_pr_info("Added virtio-pci device %04x (modern)\n",
+		   pci_dev->id.device_id);
+
+	/* Mapping the virtio device identifier. Transitional devices have it
+	 * in their subsystem identifier like legacy devices.
+	 */
+	if (pci_dev->id.device_id >= VIRTIO_PCI_MODERN_DEVICEID_START)
+		vpci_dev->vdev.id.virtio_device_id = pci_dev->id.device_id
+			- VIRTIO_PCI_MODERN_DEVICEID_START;
+	else
+		vpci_dev->vdev.id.virtio_device_id =
+			pci_dev->id.subsystem_device_id;
+	return 0;
+}
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
 
 static int virtio_pci_add_dev(struct pci_device *pci_dev)
 {
@@ -389,7 +940,7 @@ static int virtio_pci_add_dev(struct pci_device *pci_dev)
 
 	UK_ASSERT(pci_dev != NULL);
 
-	vpci_dev = uk_malloc(a, sizeof(*vpci_dev));
+	vpci_dev = uk_calloc(a, 1, sizeof(*vpci_dev));
 	if (!vpci_dev) {
 		uk_pr_err("Failed to allocate virtio-pci device\n");
 		return -ENOMEM;
@@ -399,10 +950,19 @@ static int virtio_pci_add_dev(struct pci_device *pci_dev)
 	vpci_dev->pdev = pci_dev;
 	vpci_dev->pci_base_addr = pci_dev->base;
 
+#if CONFIG_VIRTIO_PCI_MODERN
+	/**
+	 * Prefer the modern interface. Transitional devices offer both, we
+	 * fall back to the legacy one if the modern structures are missing or
+	 * not accessible.
+	 */
+	rc = virtio_pci_modern_add_dev(pci_dev, vpci_dev);
+	if (rc == 0)
+		goto register_dev;
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
+
 	/**
-	 * Probing for the legacy virtio device. We separate the legacy probing
-	 * with the possibility of supporting the modern PCI device in the
-	 * future.
+	 * Probing for the legacy virtio device.
 	 */
 	rc = virtio_pci_legacy_add_dev(pci_dev, vpci_dev);
 	if (rc != 0) {
@@ -410,6 +970,9 @@ static int virtio_pci_add_dev(struct pci_device *pci_dev)
 		goto free_pci_dev;
 	}
 
+#if CONFIG_VIRTIO_PCI_MODERN
+register_dev:
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
 	rc = virtio_bus_register_device(&vpci_dev->vdev);
 	if (rc != 0) {
 		uk_pr_err("Failed to register the virtio device: %d\n", rc);
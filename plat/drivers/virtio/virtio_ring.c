@@ -43,6 +43,7 @@
 #include <uk/plat/io.h>
 #include <virtio/virtio_ring.h>
 #include <virtio/virtqueue.h>
+#include <virtio/virtio_bus.h>
 
 #define VIRTQUEUE_MAX_SIZE  32768
 #define to_virtqueue_vring(vq)			\
@@ -65,6 +66,10 @@ struct virtqueue_vring {
 	__u16 head_free_desc;
 	/* Index of the last used descriptor by the host */
 	__u16 last_used_desc_idx;
+	/* Available index at the time of the last host notification */
+	__u16 last_kick_avail_idx;
+	/* VIRTIO_F_EVENT_IDX was negotiated with the device */
+	__u8 event_idx;
 	/* Cookie to identify driver buffer */
 	struct virtqueue_desc_info vq_info[];
 };
@@ -85,6 +90,269 @@ static inline int virtqueue_buffer_enqueue_segments(
 static void virtqueue_vring_init(struct virtqueue_vring *vrq, __u16 nr_desc,
 				 __u16 align);
 
+/**
+ * Packed ring implementation
+ */
+#define to_virtqueue_packed(vq)			\
+	__containerof(vq, struct virtqueue_packed, vq)
+
+#define VRING_PACKED_F_AVAIL	(1 << VRING_PACKED_DESC_F_AVAIL)
+#define VRING_PACKED_F_USED	(1 << VRING_PACKED_DESC_F_USED)
+
+struct virtqueue_packed_desc_info {
+	void *cookie;
+	__u16 desc_count;
+	/* Next free buffer id */
+	__u16 next;
+};
+
+struct virtqueue_packed {
+	struct virtqueue vq;
+	/* Descriptor ring and event suppression structures */
+	struct vring_packed vring;
+	/* Reference to the vring */
+	void   *vring_mem;
+	/* Keep track of available descriptors */
+	__u16 desc_avail;
+	/* Index of the next available slot */
+	__u16 next_avail_idx;
+	/* AVAIL/USED flags of descriptors that we make available */
+	__u16 avail_used_flags;
+	/* Index of the next descriptor that the host will use */
+	__u16 last_used_idx;
+	/* Head of the free buffer id list */
+	__u16 free_head;
+	/* Descriptors made available since the last host notification */
+	__u16 num_added;
+	__u8 avail_wrap_counter;
+	__u8 used_wrap_counter;
+	/* VIRTIO_F_EVENT_IDX was negotiated with the device */
+	__u8 event_idx;
+	/* Cookie to identify driver buffer, indexed by buffer id */
+	struct virtqueue_packed_desc_info vq_info[];
+};
+
+static inline int vpacked_hasdata(struct virtqueue_packed *vpq)
+{
+	__u16 flags = vpq->vring.desc[vpq->last_used_idx].flags;
+	int avail = !!(flags & VRING_PACKED_F_AVAIL);
+	int used = !!(flags & VRING_PACKED_F_USED);
+
+	return (avail == used && used == vpq->used_wrap_counter);
+}
+
+static inline void vpacked_intr_disable(struct virtqueue_packed *vpq)
+{
+	vpq->vring.driver->flags = VRING_PACKED_EVENT_FLAG_DISABLE;
+}
+
+static int vpacked_intr_enable(struct virtqueue_packed *vpq)
+{
+	if (vpacked_hasdata(vpq))
+		return 1;
+
+	vpq->vring.driver->flags = VRING_PACKED_EVENT_FLAG_ENABLE;
+	/**
+	 * Check again after enabling the interrupt so that we do not miss a
+	 * descriptor that was used in the meantime.
+	 */
+	mb();
+	if (vpacked_hasdata(vpq)) {
+		vpacked_intr_disable(vpq);
+		return 1;
+	}
+	return 0;
+}
+
+static int vpacked_notify_enabled(struct virtqueue_packed *vpq)
+{
+	__u16 flags, off_wrap, event_idx, new_idx, old_idx;
+
+	flags = vpq->vring.device->flags;
+	if (!vpq->event_idx || flags != VRING_PACKED_EVENT_FLAG_DESC)
+		return (flags != VRING_PACKED_EVENT_FLAG_DISABLE);
+
+	off_wrap = vpq->vring.device->off_wrap;
+	event_idx = off_wrap & ~(1 << VRING_PACKED_EVENT_F_WRAP_CTR);
+	/* Events in the previous lap are one ring size behind */
+	if ((off_wrap >> VRING_PACKED_EVENT_F_WRAP_CTR)
+	    != vpq->avail_wrap_counter)
+		event_idx -= vpq->vring.num;
+	new_idx = vpq->next_avail_idx;
+	old_idx = new_idx - vpq->num_added;
+	return vring_need_event(event_idx, new_idx, old_idx);
+}
+
+static int vpacked_kick_prepare(struct virtqueue_packed *vpq)
+{
+	int rc;
+
+	if (!vpq->num_added)
+		return 0;
+
+	/**
+	 * The descriptors have to be visible to the host before we look at
+	 * the notification suppression it published.
+	 */
+	mb();
+	rc = vpacked_notify_enabled(vpq);
+	vpq->num_added = 0;
+	return rc;
+}
+
+static int vpacked_buffer_dequeue(struct virtqueue_packed *vpq,
+				  void **cookie, __u32 *len)
+{
+	struct vring_packed_desc *desc;
+	struct virtqueue_packed_desc_info *vq_info;
+	__u16 id;
+
+	/* No new descriptor since last dequeue operation */
+	if (!vpacked_hasdata(vpq))
+		return -ENOMSG;
+	/**
+	 * We are reading from the used descriptor information updated by the
+	 * host.
+	 */
+	rmb();
+	desc = &vpq->vring.desc[vpq->last_used_idx];
+	id = desc->id;
+	UK_ASSERT(id < vpq->vring.num);
+	vq_info = &vpq->vq_info[id];
+	if (len)
+		*len = desc->len;
+	*cookie = vq_info->cookie;
+
+	/* The device writes a single used descriptor for the whole chain */
+	vpq->last_used_idx += vq_info->desc_count;
+	if (vpq->last_used_idx >= vpq->vring.num) {
+		vpq->last_used_idx -= vpq->vring.num;
+		vpq->used_wrap_counter ^= 1;
+	}
+
+	vpq->desc_avail += vq_info->desc_count;
+	vq_info->cookie = NULL;
+	vq_info->desc_count = 0;
+	vq_info->next = vpq->free_head;
+	vpq->free_head = id;
+	return (vpq->vring.num - vpq->desc_avail);
+}
+
+static int vpacked_buffer_enqueue(struct virtqueue_packed *vpq, void *cookie,
+				  struct uk_sglist *sg, __u16 read_bufs,
+				  __u16 write_bufs)
+{
+	struct vring_packed_desc *desc;
+	struct uk_sglist_seg *segs;
+	__u16 total_desc, head_idx, idx, id;
+	__u16 head_flags = 0, flags;
+	int i;
+
+	total_desc = read_bufs + write_bufs;
+	if (unlikely(total_desc < 1 || total_desc > vpq->vring.num)) {
+		uk_pr_err("%"__PRIu16" invalid number of descriptor\n",
+			  total_desc);
+		return -EINVAL;
+	} else if (vpq->desc_avail < total_desc) {
+		uk_pr_err("Available descriptor:%"__PRIu16", Requested descriptor:%"__PRIu16"\n",
+			  vpq->desc_avail, total_desc);
+		return -ENOSPC;
+	}
+	UK_ASSERT(cookie);
+
+	/* Every buffer takes an id, there are never more buffers than slots */
+	id = vpq->free_head;
+	UK_ASSERT(id < vpq->vring.num);
+	vpq->free_head = vpq->vq_info[id].next;
+	vpq->vq_info[id].cookie = cookie;
+	vpq->vq_info[id].desc_count = total_desc;
+
+	head_idx = idx = vpq->next_avail_idx;
+	for (i = 0; i < total_desc; i++) {
+		segs = &sg->sg_segs[i];
+		desc = &vpq->vring.desc[idx];
+		desc->addr = segs->ss_paddr;
+		desc->len = segs->ss_len;
+		desc->id = id;
+
+		flags = vpq->avail_used_flags;
+		if (i >= read_bufs)
+			flags |= VRING_DESC_F_WRITE;
+		if (i < total_desc - 1)
+			flags |= VRING_DESC_F_NEXT;
+		/**
+		 * The head descriptor is made available last, so that the
+		 * host never sees a partial chain.
+		 */
+		if (i == 0)
+			head_flags = flags;
+		else
+			desc->flags = flags;
+
+		if (++idx >= vpq->vring.num) {
+			idx = 0;
+			vpq->avail_wrap_counter ^= 1;
+			vpq->avail_used_flags ^= (VRING_PACKED_F_AVAIL
+						  | VRING_PACKED_F_USED);
+		}
+	}
+	/* Metadata maintenance for the virtqueue */
+	vpq->next_avail_idx = idx;
+	vpq->desc_avail -= total_desc;
+	vpq->num_added += total_desc;
+
+	/**
+	 * Write barrier to make sure that the chain is complete before the
+	 * head descriptor is made available.
+	 */
+	wmb();
+	vpq->vring.desc[head_idx].flags = head_flags;
+
+	return vpq->desc_avail;
+}
+
+static struct virtqueue *vpacked_create(__u16 nr_descs, int event_idx,
+					struct uk_alloc *a)
+{
+	struct virtqueue_packed *vpq;
+	size_t ring_size;
+	int i;
+
+	vpq = uk_malloc(a, sizeof(*vpq) +
+			nr_descs * sizeof(struct virtqueue_packed_desc_info));
+	if (!vpq) {
+		uk_pr_err("Allocation of virtqueue failed\n");
+		return ERR2PTR(-ENOMEM);
+	}
+	vpq->vring_mem = NULL;
+
+	ring_size = vring_packed_size(nr_descs);
+	if (uk_posix_memalign(a, &vpq->vring_mem,
+			      __PAGE_SIZE, ring_size) != 0) {
+		uk_pr_err("Allocation of vring failed\n");
+		uk_free(a, vpq);
+		return ERR2PTR(-ENOMEM);
+	}
+	memset(vpq->vring_mem, 0, ring_size);
+	vring_packed_init(&vpq->vring, nr_descs, vpq->vring_mem);
+
+	vpq->desc_avail = nr_descs;
+	vpq->next_avail_idx = 0;
+	vpq->last_used_idx = 0;
+	vpq->num_added = 0;
+	vpq->avail_wrap_counter = 1;
+	vpq->used_wrap_counter = 1;
+	vpq->avail_used_flags = VRING_PACKED_F_AVAIL;
+	vpq->event_idx = event_idx;
+	vpq->free_head = 0;
+	for (i = 0; i < nr_descs; i++) {
+		vpq->vq_info[i].cookie = NULL;
+		vpq->vq_info[i].desc_count = 0;
+		vpq->vq_info[i].next = i + 1;
+	}
+	return &vpq->vq;
+}
+
 /**
  * Driver implementation
  */
@@ -94,8 +362,22 @@ void virtqueue_intr_disable(struct virtqueue *vq)
 
 	UK_ASSERT(vq);
 
+	if (vq->packed) {
+		vpacked_intr_disable(to_virtqueue_packed(vq));
+		return;
+	}
+
 	vrq = to_virtqueue_vring(vq);
-	vrq->vring.avail->flags |= (VRING_AVAIL_F_NO_INTERRUPT);
+	if (vrq->event_idx) {
+		/**
+		 * The flags must stay 0 with event indexes. Instead we put
+		 * the used event just behind the last consumed entry: the
+		 * device does not interrupt before its used index wrapped.
+		 */
+		vring_used_event(&vrq->vring) = vrq->last_used_desc_idx - 1;
+	} else {
+		vrq->vring.avail->flags |= (VRING_AVAIL_F_NO_INTERRUPT);
+	}
 }
 
 int virtqueue_intr_enable(struct virtqueue *vq)
@@ -105,10 +387,22 @@ int virtqueue_intr_enable(struct virtqueue *vq)
 
 	UK_ASSERT(vq);
 
+	if (vq->packed)
+		return vpacked_intr_enable(to_virtqueue_packed(vq));
+
 	vrq = to_virtqueue_vring(vq);
 	/* Check if there are no more packets enabled */
 	if (!virtqueue_hasdata(vq)) {
-		if (vrq->vring.avail->flags | VRING_AVAIL_F_NO_INTERRUPT) {
+		if (vrq->event_idx) {
+			/* Interrupt on the next entry that the host uses */
+			vring_used_event(&vrq->vring) = vrq->last_used_desc_idx;
+			mb();
+			if (virtqueue_hasdata(vq)) {
+				virtqueue_intr_disable(vq);
+				rc = 1;
+			}
+		} else if (vrq->vring.avail->flags
+			   & VRING_AVAIL_F_NO_INTERRUPT) {
 			vrq->vring.avail->flags &=
 				(~VRING_AVAIL_F_NO_INTERRUPT);
 			/**
@@ -182,11 +476,43 @@ int virtqueue_notify_enabled(struct virtqueue *vq)
 	struct virtqueue_vring *vrq;
 
 	UK_ASSERT(vq);
-	vrq = to_virtqueue_vring(vq);
 
+	if (vq->packed)
+		return vpacked_notify_enabled(to_virtqueue_packed(vq));
+
+	vrq = to_virtqueue_vring(vq);
+	if (vrq->event_idx)
+		return vring_need_event(vring_avail_event(&vrq->vring),
+					vrq->vring.avail->idx,
+					vrq->last_kick_avail_idx);
 	return ((vrq->vring.used->flags & VRING_USED_F_NO_NOTIFY) == 0);
 }
 
+int virtqueue_kick_prepare(struct virtqueue *vq)
+{
+	struct virtqueue_vring *vrq;
+	int rc;
+
+	UK_ASSERT(vq);
+
+	if (vq->packed)
+		return vpacked_kick_prepare(to_virtqueue_packed(vq));
+
+	vrq = to_virtqueue_vring(vq);
+	/* Nothing was added since the last notification */
+	if (vrq->vring.avail->idx == vrq->last_kick_avail_idx)
+		return 0;
+
+	/**
+	 * The available index has to be visible to the host before we look at
+	 * the notification suppression it published.
+	 */
+	mb();
+	rc = virtqueue_notify_enabled(vq);
+	vrq->last_kick_avail_idx = vrq->vring.avail->idx;
+	return rc;
+}
+
 static inline int virtqueue_buffer_enqueue_segments(
 		struct virtqueue_vring *vrq,
 		__u16 head, struct uk_sglist *sg, __u16 read_bufs,
@@ -219,6 +545,9 @@ int virtqueue_hasdata(struct virtqueue *vq)
 
 	UK_ASSERT(vq);
 
+	if (vq->packed)
+		return vpacked_hasdata(to_virtqueue_packed(vq));
+
 	vring = to_virtqueue_vring(vq);
 	return (vring->last_used_desc_idx != vring->vring.used->idx);
 }
@@ -228,9 +557,12 @@ __u64 virtqueue_feature_negotiate(__u64 feature_set)
 	__u64 feature = (1ULL << VIRTIO_TRANSPORT_F_START) - 1;
 
 	/**
-	 * Currently out vring driver does not support any ring feature. We will
-	 * add support to transport feature in the future.
+	 * Besides the device-specific bits, we keep the ring features that
+	 * our vring driver supports.
 	 */
+	feature |= ~((1ULL << VIRTIO_TRANSPORT_F_END) - 1);
+	feature |= (1ULL << VIRTIO_F_EVENT_IDX);
+	feature |= (1ULL << VIRTIO_F_RING_PACKED);
 	feature &= feature_set;
 	return feature;
 }
@@ -256,10 +588,41 @@ __phys_addr virtqueue_physaddr(struct virtqueue *vq)
 
 	UK_ASSERT(vq);
 
+	if (vq->packed)
+		return ukplat_virt_to_phys(to_virtqueue_packed(vq)->vring_mem);
+
 	vrq = to_virtqueue_vring(vq);
 	return ukplat_virt_to_phys(vrq->vring_mem);
 }
 
+__phys_addr virtqueue_driver_area_physaddr(struct virtqueue *vq)
+{
+	struct virtqueue_vring *vrq = NULL;
+
+	UK_ASSERT(vq);
+
+	if (vq->packed)
+		return ukplat_virt_to_phys(
+				to_virtqueue_packed(vq)->vring.driver);
+
+	vrq = to_virtqueue_vring(vq);
+	return ukplat_virt_to_phys(vrq->vring.avail);
+}
+
+__phys_addr virtqueue_device_area_physaddr(struct virtqueue *vq)
+{
+	struct virtqueue_vring *vrq = NULL;
+
+	UK_ASSERT(vq);
+
+	if (vq->packed)
+		return ukplat_virt_to_phys(
+				to_virtqueue_packed(vq)->vring.device);
+
+	vrq = to_virtqueue_vring(vq);
+	return ukplat_virt_to_phys(vrq->vring.used);
+}
+
 int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
 {
 	struct virtqueue_vring *vrq = NULL;
@@ -268,6 +631,11 @@ int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
 
 	UK_ASSERT(vq);
 	UK_ASSERT(cookie);
+
+	if (vq->packed)
+		return vpacked_buffer_dequeue(to_virtqueue_packed(vq),
+					      cookie, len);
+
 	vrq = to_virtqueue_vring(vq);
 
 	/* No new descriptor since last dequeue operation */
@@ -299,6 +667,10 @@ int virtqueue_buffer_enqueue(struct virtqueue *vq, void *cookie,
 
 	UK_ASSERT(vq);
 
+	if (vq->packed)
+		return vpacked_buffer_enqueue(to_virtqueue_packed(vq), cookie,
+					      sg, read_bufs, write_bufs);
+
 	vrq = to_virtqueue_vring(vq);
 	total_desc = read_bufs + write_bufs;
 	if (unlikely(total_desc < 1 || total_desc > vrq->vring.num)) {
@@ -361,9 +733,21 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 	struct virtqueue *vq;
 	int rc;
 	size_t ring_size = 0;
+	int event_idx;
 
 	UK_ASSERT(a);
 
+	event_idx = vdev && virtio_has_features(vdev->features,
+						VIRTIO_F_EVENT_IDX);
+	if (vdev && virtio_has_features(vdev->features,
+					VIRTIO_F_RING_PACKED)) {
+		vq = vpacked_create(nr_descs, event_idx, a);
+		if (PTRISERR(vq))
+			return vq;
+		vq->packed = 1;
+		goto init_vq;
+	}
+
 	vrq = uk_malloc(a, sizeof(*vrq) +
 			nr_descs * sizeof(struct virtqueue_desc_info));
 	if (!vrq) {
@@ -388,7 +772,12 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 	memset(vrq->vring_mem, 0, ring_size);
 	virtqueue_vring_init(vrq, nr_descs, align);
 
+	vrq->last_kick_avail_idx = 0;
+	vrq->event_idx = event_idx;
+
 	vq = &vrq->vq;
+	vq->packed = 0;
+init_vq:
 	vq->queue_id = queue_id;
 	vq->vdev = vdev;
 	vq->vq_callback = callback;
@@ -407,6 +796,12 @@ void virtqueue_destroy(struct virtqueue *vq, struct uk_alloc *a)
 
 	UK_ASSERT(vq);
 
+	if (vq->packed) {
+		uk_free(a, to_virtqueue_packed(vq)->vring_mem);
+		uk_free(a, to_virtqueue_packed(vq));
+		return;
+	}
+
 	vrq = to_virtqueue_vring(vq);
 
 	/* Free the ring */
@@ -422,6 +817,9 @@ int virtqueue_is_full(struct virtqueue *vq)
 
 	UK_ASSERT(vq);
 
+	if (vq->packed)
+		return (to_virtqueue_packed(vq)->desc_avail == 0);
+
 	vrq = to_virtqueue_vring(vq);
 	return (vrq->desc_avail == 0);
 }
@@ -31,7 +31,21 @@
  */
 
 #include <uk/essentials.h>
+#include <uk/plat/memory.h>
+#include <arm/cpu_defs.h>
 
 void ukplat_stack_set_current_thread(void *thread_addr __unused)
 {
 }
+
+__sz ukplat_mem_hugepage_size(void)
+{
+	/*
+	 * pagetable64.S maps RAM with 2MB (L2) and 1GB (L1) blocks. Only
+	 * the image, which starts at the beginning of RAM, is mapped with
+	 * 4KB pages up to the next 2MB boundary. The heap starts behind the
+	 * image and its page tables, so every 2MB aligned chunk of the heap
+	 * is covered by a block mapping.
+	 */
+	return L2_SIZE;
+}
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __PLAT_KVM_X86_LAPIC_H__
+#define __PLAT_KVM_X86_LAPIC_H__
+
+/* x2APIC registers, accessed as MSRs */
+#define APIC_MSR_BASE           0x01b
+#define X2APIC_MSR_ID           0x802
+#define X2APIC_MSR_EOI          0x80b
+#define X2APIC_MSR_SVR          0x80f
+#define X2APIC_MSR_ICR          0x830
+#define X2APIC_MSR_LVT_TIMER    0x832
+#define X2APIC_MSR_LVT_LINT0    0x835
+#define X2APIC_MSR_LVT_LINT1    0x836
+#define X2APIC_MSR_TIMER_INIT   0x838
+#define X2APIC_MSR_TIMER_CUR    0x839
+#define X2APIC_MSR_TIMER_DIV    0x83e
+
+/* Interrupt vectors of the local APIC, above the i8259 IRQs (32..47) */
+#define LAPIC_WAKEUP_VECTOR     48
+#define LAPIC_TIMER_VECTOR      49
+#define LAPIC_SPURIOUS_VECTOR   63
+/* Message signaled interrupts use the vectors 64 onwards */
+#define LAPIC_MSI_VECTOR_BASE   64
+
+#ifndef __ASSEMBLY__
+#include <uk/arch/types.h>
+#include <uk/arch/time.h>
+
+/*
+ * Switches the local APIC of the calling logical CPU to x2APIC mode.
+ * Returns -ENOTSUP if the CPU does not support x2APIC.
+ */
+int lapic_init(void);
+
+void lapic_send_ipi(__u32 apic_id, __u32 icr);
+
+/*
+ * Sets up the local APIC timer of the boot CPU in TSC-deadline mode or,
+ * if the CPU does not support it, in one-shot mode after measuring its
+ * frequency against the TSC clock. Returns a negative value if there is no
+ * usable local APIC; the i8254 has to be used instead.
+ */
+int lapic_timer_init(void);
+
+/* Non-zero once lapic_timer_init() succeeded */
+int lapic_timer_enabled(void);
+
+/* Requests a timer interrupt at `until` on the calling logical CPU */
+void lapic_timer_arm(__snsec until);
+
+/*
+ * Halts the calling logical CPU until an interrupt arrives or until the
+ * local APIC timer expires at `until`. Must be called with interrupts
+ * disabled.
+ */
+void lapic_block_until(__snsec until);
+#endif /* !__ASSEMBLY__ */
+
+#endif /* __PLAT_KVM_X86_LAPIC_H__ */
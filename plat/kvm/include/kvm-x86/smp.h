@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __PLAT_KVM_X86_SMP_H__
+#define __PLAT_KVM_X86_SMP_H__
+
+#include <kvm-x86/lapic.h>
+
+/* Physical address where the real-mode startup code is copied to */
+#define LCPU_TRAMPOLINE_ADDR    0x8000
+
+#ifndef __ASSEMBLY__
+#include <uk/arch/types.h>
+#include <uk/essentials.h>
+#include <uk/plat/lcpu.h>
+
+struct lcpu {
+	/* Has to be the first member: it is read via %gs:0 */
+	struct lcpu *self;
+	__u8 id;
+	__u32 apic_id;
+	int online;
+	ukplat_lcpu_entry_t entry;
+	void *arg;
+	/* Bottom of the interrupt, trap and NMI stacks (IST1 - IST3) */
+	char *intr_stack;
+	char *trap_stack;
+	char *nmi_stack;
+};
+
+/*
+ * The GS base of every logical CPU points to its struct lcpu. The read has
+ * to be volatile since a thread may migrate to another logical CPU in
+ * between two calls.
+ */
+static inline struct lcpu *lcpu_current(void)
+{
+	struct lcpu *lcpu;
+
+	__asm__ __volatile__("movq %%gs:0, %0" : "=r"(lcpu));
+	return lcpu;
+}
+
+/* Sets up the per-CPU data of the boot CPU; has to be called first */
+void lcpu_init_bsp(void);
+
+/* Discovers the application processors and enables the local APIC */
+void smp_init(void);
+#endif /* !__ASSEMBLY__ */
+
+#endif /* __PLAT_KVM_X86_SMP_H__ */
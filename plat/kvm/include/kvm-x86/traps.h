@@ -42,4 +42,21 @@
 #define GDT_DESC_DATA_VAL       0x00cf93000000ffff
 
 
-#define IDT_NUM_ENTRIES         48
+/* Exceptions, i8259 IRQs, local APIC vectors and message signaled irqs */
+#define IDT_NUM_ENTRIES         96
+
+#define NMI_STACK_SIZE          4096
+
+#ifndef __ASSEMBLY__
+#include <uk/config.h>
+#include <uk/arch/types.h>
+
+#if CONFIG_HAVE_SMP
+/*
+ * Loads the shared IDT and a GDT and TSS of its own on a secondary logical
+ * CPU. The stacks have the sizes STACK_SIZE, STACK_SIZE and NMI_STACK_SIZE.
+ */
+void traps_lcpu_init(__u8 lcpu, char *intr_stack, char *trap_stack,
+		     char *nmi_stack);
+#endif /* CONFIG_HAVE_SMP */
+#endif /* !__ASSEMBLY__ */
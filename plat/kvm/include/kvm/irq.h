@@ -38,4 +38,10 @@
 
 void _ukplat_irq_handle(unsigned long irq);
 
+/*
+ * Has to be called at the end of interrupts that are not dispatched by
+ * _ukplat_irq_handle(), e.g., local timer interrupts
+ */
+void _ukplat_irq_exit(void);
+
 #endif /* __KVM_IRQ_H_ */
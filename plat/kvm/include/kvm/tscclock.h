@@ -36,5 +36,7 @@
 int tscclock_init(void);
 __u64 tscclock_monotonic(void);
 __u64 tscclock_epochoffset(void);
+__u64 tscclock_nsec_to_tsc(__u64 nsec);
+void tscclock_set_deadline(__u64 until);
 
 #endif /* __KVM_TSCCLOCK_H__ */
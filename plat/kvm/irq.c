@@ -48,6 +48,7 @@ struct irq_handler {
 
 UK_SLIST_HEAD(irq_handler_head, struct irq_handler);
 static struct irq_handler_head irq_handlers[__MAX_IRQ];
+static irq_exit_func_t irq_exit_handler;
 
 int ukplat_irq_register(unsigned long irq, irq_handler_func_t func, void *arg)
 {
@@ -72,6 +73,36 @@ int ukplat_irq_register(unsigned long irq, irq_handler_func_t func, void *arg)
 	return 0;
 }
 
+int ukplat_irq_unregister(unsigned long irq, irq_handler_func_t func,
+			  void *arg)
+{
+	struct irq_handler *h;
+	unsigned long flags;
+
+	UK_ASSERT(irq < __MAX_IRQ);
+
+	flags = ukplat_lcpu_save_irqf();
+	UK_SLIST_FOREACH(h, &irq_handlers[irq], entries) {
+		if (h->func == func && h->arg == arg)
+			break;
+	}
+	if (h)
+		UK_SLIST_REMOVE(&irq_handlers[irq], h, struct irq_handler,
+				entries);
+	ukplat_lcpu_restore_irqf(flags);
+
+	if (!h)
+		return -ENOENT;
+	uk_free(allocator, h);
+	return 0;
+}
+
+int ukplat_irq_set_exit_handler(irq_exit_func_t func)
+{
+	irq_exit_handler = func;
+	return 0;
+}
+
 /*
  * TODO: This is a temporary solution used to identify non TSC clock
  * interrupts in order to stop waiting for interrupts with deadline.
@@ -110,6 +141,14 @@ void _ukplat_irq_handle(unsigned long irq)
 
 exit_ack:
 	intctrl_ack_irq(irq);
+
+	_ukplat_irq_exit();
+}
+
+void _ukplat_irq_exit(void)
+{
+	if (irq_exit_handler)
+		irq_exit_handler();
 }
 
 int ukplat_irq_init(struct uk_alloc *a)
@@ -24,7 +24,9 @@
 
 #include <stdint.h>
 #include <x86/cpu.h>
+#include <x86/irq.h>
 #include <kvm/intctrl.h>
+#include <kvm-x86/lapic.h>
 
 #define PIC1             0x20    /* IO base address for master PIC */
 #define PIC2             0xA0    /* IO base address for slave PIC */
@@ -32,6 +34,7 @@
 #define PIC1_DATA        (PIC1 + 1)
 #define PIC2_COMMAND     PIC2
 #define PIC2_DATA        (PIC2 + 1)
+#define IRQ_IS_MSI(n)    ((n) >= __MSI_IRQ_BASE)
 #define IRQ_ON_MASTER(n) ((n) < 8)
 #define IRQ_PORT(n)      (IRQ_ON_MASTER(n) ? PIC1_DATA : PIC2_DATA)
 #define IRQ_OFFSET(n)    (IRQ_ON_MASTER(n) ? (n) : ((n) - 8))
@@ -88,6 +91,11 @@ void intctrl_init(void)
 
 void intctrl_ack_irq(unsigned int irq)
 {
+	if (IRQ_IS_MSI(irq)) {
+		wrmsrl(X2APIC_MSR_EOI, 0);
+		return;
+	}
+
 	if (!IRQ_ON_MASTER(irq))
 		outb(PIC2_COMMAND, PIC_EOI);
 
@@ -98,6 +106,10 @@ void intctrl_mask_irq(unsigned int irq)
 {
 	__u16 port;
 
+	/* Message signaled interrupts are masked at the device */
+	if (IRQ_IS_MSI(irq))
+		return;
+
 	port = IRQ_PORT(irq);
 	outb(port, inb(port) | (1 << IRQ_OFFSET(irq)));
 }
@@ -106,6 +118,9 @@ void intctrl_clear_irq(unsigned int irq)
 {
 	__u16 port;
 
+	if (IRQ_IS_MSI(irq))
+		return;
+
 	port = IRQ_PORT(irq);
 	outb(port, inb(port) & ~(1 << IRQ_OFFSET(irq)));
 }
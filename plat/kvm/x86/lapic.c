@@ -0,0 +1,277 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <uk/assert.h>
+#include <uk/bitops.h>
+#include <uk/print.h>
+#include <uk/plat/lcpu.h>
+#include <uk/plat/time.h>
+#include <uk/plat/common/_time.h>
+#include <uk/plat/common/irq.h>
+#include <x86/cpu.h>
+#include <kvm/irq.h>
+#include <kvm/tscclock.h>
+#include <kvm-x86/lapic.h>
+
+#define APIC_BASE_EN            (1UL << 11)
+#define APIC_BASE_EXTD          (1UL << 10)
+
+#define APIC_SVR_ENABLE         (1 << 8)
+#define APIC_LVT_MASKED         (1 << 16)
+#define APIC_LVT_NMI            (4 << 8)
+#define APIC_LVT_EXTINT         (7 << 8)
+#define APIC_LVT_TSC_DEADLINE   (2 << 17)
+#define APIC_TIMER_DIV_16       0x3
+
+/* Message address of interrupts delivered to a local APIC (fixed mode) */
+#define APIC_MSI_ADDR_BASE      0xfee00000UL
+#define APIC_MSI_ADDR_DEST_SHFT 12
+#define APIC_MSI_ADDR_DEST_MAX  0xff
+
+/* Measurement period for the local APIC timer frequency */
+#define LAPIC_CALIBRATE_PERIOD  ukarch_time_msec_to_nsec(10)
+
+/*
+ * Longest delay programmed at once. Later deadlines, including "never",
+ * cost one extra interrupt per period.
+ */
+#define LAPIC_TIMER_MAX_DELTA   ukarch_time_sec_to_nsec(3600)
+
+enum lapic_timer_mode {
+	LAPIC_TIMER_NONE = 0,
+	LAPIC_TIMER_ONESHOT,
+	LAPIC_TIMER_TSC_DEADLINE,
+};
+
+static enum lapic_timer_mode timer_mode;
+
+/* Multiplier for converting nsecs to local APIC timer ticks. (0.32) */
+static __u32 lapic_mult;
+
+/* Programs the timer vector; the timer stays idle until it is armed */
+static void lapic_timer_setup(void)
+{
+	if (timer_mode == LAPIC_TIMER_TSC_DEADLINE) {
+		wrmsrl(X86_MSR_TSC_DEADLINE, 0);
+		wrmsrl(X2APIC_MSR_LVT_TIMER,
+		       APIC_LVT_TSC_DEADLINE | LAPIC_TIMER_VECTOR);
+		/* The mode switch has to complete before the first deadline
+		 * is written
+		 */
+		__asm__ __volatile__("mfence" ::: "memory");
+	} else if (timer_mode == LAPIC_TIMER_ONESHOT) {
+		wrmsrl(X2APIC_MSR_TIMER_INIT, 0);
+		wrmsrl(X2APIC_MSR_LVT_TIMER, LAPIC_TIMER_VECTOR);
+	} else {
+		wrmsrl(X2APIC_MSR_LVT_TIMER,
+		       APIC_LVT_MASKED | LAPIC_TIMER_VECTOR);
+	}
+}
+
+int lapic_init(void)
+{
+	__u32 eax, ebx, ecx, edx;
+	__u64 base;
+
+	cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+	if (!(ecx & X86_CPUID1_ECX_X2APIC))
+		return -ENOTSUP;
+
+	/*
+	 * The boot CPU usually gets the legacy PIC interrupts through LINT0
+	 * (virtual wire mode) already. Set it up ourselves if the firmware
+	 * left the local APIC disabled.
+	 */
+	base = rdmsrl(APIC_MSR_BASE);
+	wrmsrl(APIC_MSR_BASE, base | APIC_BASE_EN | APIC_BASE_EXTD);
+	if (!(base & APIC_BASE_EN) && ukplat_lcpu_id() == 0) {
+		wrmsrl(X2APIC_MSR_LVT_LINT0, APIC_LVT_EXTINT);
+		wrmsrl(X2APIC_MSR_LVT_LINT1, APIC_LVT_NMI);
+	}
+
+	wrmsrl(X2APIC_MSR_SVR, (rdmsrl(X2APIC_MSR_SVR) & ~0xffUL)
+	       | APIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+	wrmsrl(X2APIC_MSR_TIMER_DIV, APIC_TIMER_DIV_16);
+	lapic_timer_setup();
+	return 0;
+}
+
+void lapic_send_ipi(__u32 apic_id, __u32 icr)
+{
+	wrmsr(X2APIC_MSR_ICR, icr, apic_id);
+}
+
+/* Allocated message signaled interrupts, bit 0 is __MSI_IRQ_BASE */
+static unsigned long msi_used[UK_BITS_TO_LONGS(__MSI_IRQ_COUNT)];
+
+int ukplat_irq_msi_alloc(unsigned long *irq, __u64 *addr, __u32 *data)
+{
+	unsigned long bit;
+	__u64 apic_id;
+
+	UK_ASSERT(irq && addr && data);
+
+	/* The local APIC has to be in x2APIC mode; without interrupt
+	 * remapping, messages can only address APIC IDs up to 255
+	 */
+	if (!(rdmsrl(APIC_MSR_BASE) & APIC_BASE_EXTD))
+		return -ENOTSUP;
+	apic_id = rdmsrl(X2APIC_MSR_ID);
+	if (apic_id > APIC_MSI_ADDR_DEST_MAX)
+		return -ENOTSUP;
+
+	do {
+		bit = uk_find_first_zero_bit(msi_used, __MSI_IRQ_COUNT);
+		if (bit >= __MSI_IRQ_COUNT)
+			return -ENOSPC;
+	} while (uk_test_and_set_bit(bit, msi_used));
+	*irq = __MSI_IRQ_BASE + bit;
+
+	*addr = APIC_MSI_ADDR_BASE | (apic_id << APIC_MSI_ADDR_DEST_SHFT);
+	*data = LAPIC_MSI_VECTOR_BASE + (*irq - __MSI_IRQ_BASE);
+	return 0;
+}
+
+void ukplat_irq_msi_free(unsigned long irq)
+{
+	UK_ASSERT(irq >= __MSI_IRQ_BASE && irq < __MAX_IRQ);
+	UK_ASSERT(uk_test_bit(irq - __MSI_IRQ_BASE, msi_used));
+
+	uk_clear_bit(irq - __MSI_IRQ_BASE, msi_used);
+}
+
+/* Measures the local APIC timer frequency against the TSC clock */
+static void lapic_timer_calibrate(void)
+{
+	__nsec start, end;
+	__u64 ticks;
+
+	wrmsrl(X2APIC_MSR_LVT_TIMER, APIC_LVT_MASKED | LAPIC_TIMER_VECTOR);
+	wrmsrl(X2APIC_MSR_TIMER_INIT, 0xffffffff);
+	start = ukplat_monotonic_clock();
+	do {
+		end = ukplat_monotonic_clock();
+	} while (end - start < LAPIC_CALIBRATE_PERIOD);
+	ticks = 0xffffffff - rdmsrl(X2APIC_MSR_TIMER_CUR);
+	wrmsrl(X2APIC_MSR_TIMER_INIT, 0);
+
+	lapic_mult = (ticks << 32) / (end - start);
+	uk_pr_info("Local APIC timer frequency estimate is %llu Hz\n",
+		   (unsigned long long) ticks * UKARCH_NSEC_PER_SEC
+		   / (end - start));
+}
+
+int lapic_timer_init(void)
+{
+	__u32 eax, ebx, ecx, edx;
+	int rc;
+
+	rc = lapic_init();
+	if (rc < 0)
+		return rc;
+
+	cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+	if (ecx & X86_CPUID1_ECX_TSC_DEADLINE) {
+		timer_mode = LAPIC_TIMER_TSC_DEADLINE;
+		uk_pr_info("Timer: local APIC in TSC-deadline mode\n");
+	} else {
+		lapic_timer_calibrate();
+		timer_mode = LAPIC_TIMER_ONESHOT;
+		uk_pr_info("Timer: local APIC in one-shot mode\n");
+	}
+	lapic_timer_setup();
+	return 0;
+}
+
+int lapic_timer_enabled(void)
+{
+	return timer_mode != LAPIC_TIMER_NONE;
+}
+
+static void lapic_timer_program(__snsec until, __snsec now)
+{
+	__u64 delta = 0, ticks;
+
+	if (until > now)
+		delta = until - now;
+	if (delta > LAPIC_TIMER_MAX_DELTA)
+		delta = LAPIC_TIMER_MAX_DELTA;
+
+	if (timer_mode == LAPIC_TIMER_TSC_DEADLINE) {
+		/* Passed deadlines fire immediately */
+		wrmsrl(X86_MSR_TSC_DEADLINE, tscclock_nsec_to_tsc(now + delta));
+		return;
+	}
+
+	ticks = mul64_32(delta, lapic_mult);
+	if (ticks == 0)
+		ticks = 1;
+	else if (ticks > 0xffffffff)
+		ticks = 0xffffffff;
+	wrmsrl(X2APIC_MSR_TIMER_INIT, ticks);
+}
+
+void lapic_timer_arm(__snsec until)
+{
+	UK_ASSERT(timer_mode != LAPIC_TIMER_NONE);
+
+	lapic_timer_program(until, ukplat_monotonic_clock());
+}
+
+void lapic_block_until(__snsec until)
+{
+	__snsec now = ukplat_monotonic_clock();
+
+	UK_ASSERT(ukplat_lcpu_irqs_disabled());
+	UK_ASSERT(timer_mode != LAPIC_TIMER_NONE);
+
+	if (until <= now)
+		return;
+
+	/* The timer stays armed after other interrupts ended the halt. It
+	 * fires at most once more at the same deadline, which the caller
+	 * waits for anyway, unless it programs a new one.
+	 */
+	lapic_timer_program(until, now);
+	__asm__ __volatile__("sti; hlt; cli" ::: "memory");
+}
+
+/* Called from cpu_lapic_timer with interrupts disabled. Only the caller-saved
+ * general purpose registers are saved at this point, so everything called
+ * from here must be built with the `isr` variant: the interrupt exit
+ * handler and the clock and timer code that it uses.
+ */
+void lapic_timer_handle(void)
+{
+	time_irq_count_inc();
+	wrmsrl(X2APIC_MSR_EOI, 0);
+	_ukplat_irq_exit();
+}
@@ -30,8 +30,14 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <uk/config.h>
 #include <uk/plat/memory.h>
+#if CONFIG_HAVE_SMP
+#include <kvm-x86/smp.h>
+#endif
 
+/* Size of the large pages set up by pagetable.S */
+#define X86_HUGEPAGE_SIZE 0x200000UL
 
 extern char cpu_intr_stack[];
 extern char cpu_trap_stack[];
@@ -48,8 +54,27 @@ void ukplat_stack_set_current_thread(void *thread_addr)
 	 * thread will be saved on some global variable, accessible from
 	 * both thread and exception contexts.
 	 */
+#if CONFIG_HAVE_SMP
+	struct lcpu *lcpu = lcpu_current();
+
+	*((unsigned long *) lcpu->intr_stack) =
+		(unsigned long) thread_addr;
+	*((unsigned long *) lcpu->trap_stack) =
+		(unsigned long) thread_addr;
+#else
 	*((unsigned long *) cpu_intr_stack) =
 		(unsigned long) thread_addr;
 	*((unsigned long *) cpu_trap_stack) =
 		(unsigned long) thread_addr;
+#endif /* CONFIG_HAVE_SMP */
+}
+
+__sz ukplat_mem_hugepage_size(void)
+{
+	/*
+	 * pagetable.S maps the whole usable memory area with 2MB pages,
+	 * except the first 2MB which never contains allocatable memory
+	 * that is aligned to 2MB.
+	 */
+	return X86_HUGEPAGE_SIZE;
 }
@@ -41,9 +41,17 @@
 #include <uk/assert.h>
 #include <uk/essentials.h>
 #include <x86/acpi/acpi.h>
+#ifdef CONFIG_HAVE_SMP
+#include <kvm-x86/smp.h>
+#endif /* CONFIG_HAVE_SMP */
 
 #define PLATFORM_MEM_START 0x100000
-#define PLATFORM_MAX_MEM_ADDR 0x40000000
+#define PLATFORM_MAX_MEM_ADDR 0xC0000000
+/* Page directories of pagetable.S that may cover non-RAM */
+#define PLATFORM_PD1_ADDR 0x40000000
+#define PLATFORM_PD_ENTRIES 512
+#define PLATFORM_LARGEPAGE_SIZE 0x200000
+#define PLATFORM_PTE_UNCACHED 0x18 /* PWT | PCD */
 
 #define MAX_CMDLINE_SIZE 8192
 static char cmdline[MAX_CMDLINE_SIZE];
@@ -74,6 +82,59 @@ static inline void _mb_get_cmdline(struct multiboot_info *mi)
 	cmdline[(sizeof(cmdline) - 1)] = '\0';
 }
 
+/*
+ * Returns 1 if the memory map reports the whole range [start, end) as RAM
+ * (including the ACPI areas).
+ */
+static int _mb_is_ram(struct multiboot_info *mi, __u64 start, __u64 end)
+{
+	multiboot_memory_map_t *m;
+	size_t offset;
+	int found;
+
+	do {
+		found = 0;
+		for (offset = 0; offset < mi->mmap_length;
+		     offset += m->size + sizeof(m->size)) {
+			m = (void *)(__uptr)(mi->mmap_addr + offset);
+			if (m->type != MULTIBOOT_MEMORY_AVAILABLE
+			    && m->type != MULTIBOOT_MEMORY_ACPI_RECLAIMABLE
+			    && m->type != MULTIBOOT_MEMORY_NVS)
+				continue;
+			if (m->addr <= start && start < m->addr + m->len) {
+				start = m->addr + m->len;
+				found = 1;
+			}
+		}
+	} while (found && start < end);
+
+	return start >= end;
+}
+
+/*
+ * pagetable.S maps 1-3GB with cacheable 2MB pages. Depending on the machine
+ * type, the PCI hole (MMCONFIG, 32-bit memory BARs) already starts in this
+ * range, so every page that is not entirely RAM is switched to uncached.
+ */
+extern __u64 cpu_pd1[], cpu_pd2[];
+
+static inline void _mb_init_pagetable(struct multiboot_info *mi)
+{
+	__u64 *pds[] = { cpu_pd1, cpu_pd2 };
+	__u64 addr = PLATFORM_PD1_ADDR;
+	unsigned int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(pds); i++) {
+		for (j = 0; j < PLATFORM_PD_ENTRIES;
+		     j++, addr += PLATFORM_LARGEPAGE_SIZE) {
+			if (_mb_is_ram(mi, addr, addr + PLATFORM_LARGEPAGE_SIZE))
+				continue;
+			pds[i][j] |= PLATFORM_PTE_UNCACHED;
+			invlpg(addr);
+		}
+	}
+}
+
 static inline void _mb_init_mem(struct multiboot_info *mi)
 {
 	multiboot_memory_map_t *m;
@@ -261,6 +322,9 @@ void _libkvmplat_entry(void *arg)
 {
 	struct multiboot_info *mi = (struct multiboot_info *)arg;
 
+#ifdef CONFIG_HAVE_SMP
+	lcpu_init_bsp();
+#endif /* CONFIG_HAVE_SMP */
 	_init_cpufeatures();
 	_libkvmplat_init_console();
 	traps_init();
@@ -274,6 +338,7 @@ void _libkvmplat_entry(void *arg)
 	 * everything necessary before we initialise memory allocation.
 	 */
 	_mb_get_cmdline(mi);
+	_mb_init_pagetable(mi);
 	_mb_init_mem(mi);
 	_mb_init_initrd(mi);
 
@@ -290,6 +355,7 @@ void _libkvmplat_entry(void *arg)
 
 #ifdef CONFIG_HAVE_SMP
 	acpi_init();
+	smp_init();
 #endif /* CONFIG_HAVE_SMP */
 
 #ifdef CONFIG_HAVE_SYSCALL
@@ -0,0 +1,302 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uk/config.h>
+#include <uk/alloc.h>
+#include <uk/assert.h>
+#include <uk/essentials.h>
+#include <uk/print.h>
+#include <uk/plat/config.h>
+#include <uk/plat/lcpu.h>
+#include <uk/plat/time.h>
+#include <x86/cpu.h>
+#include <x86/acpi/acpi.h>
+#include <kvm-x86/delay.h>
+#include <kvm-x86/traps.h>
+#include <kvm-x86/lapic.h>
+#include <kvm-x86/smp.h>
+
+#define APIC_ICR_INIT           (5 << 8)
+#define APIC_ICR_STARTUP        (6 << 8)
+#define APIC_ICR_ASSERT         (1 << 14)
+
+#define MADT_TYPE_LAPIC         0
+#define MADT_TYPE_X2APIC        9
+#define MADT_LAPIC_ENABLED      (1 << 0)
+
+#define LCPU_BOOT_STACK_SIZE    4096
+/* How long the boot CPU waits for another CPU to come up */
+#define LCPU_START_TIMEOUT      ukarch_time_msec_to_nsec(1000)
+
+/* Layout of the trampoline data in smp_start.S */
+struct lcpu_tramp_data {
+	__u32 cr0;
+	__u32 cr3;
+	__u32 cr4;
+	__u32 efer;
+	__u64 stack;
+	__u64 lcpu;
+} __packed;
+
+extern char _lcpu_tramp_start[];
+extern char _lcpu_tramp_data[];
+extern char _lcpu_tramp_end[];
+
+void _lcpu_entry64(struct lcpu *lcpu) __noreturn;
+
+static struct lcpu lcpus[UKPLAT_LCPU_MAXCOUNT];
+static __u8 lcpu_count = 1;
+
+static char lcpu_boot_stacks[UKPLAT_LCPU_MAXCOUNT][LCPU_BOOT_STACK_SIZE]
+	__align(16);
+
+static __u64 bsp_xcr0;
+static int tramp_ready;
+
+static inline unsigned long read_cr(int n)
+{
+	unsigned long val;
+
+	switch (n) {
+	case 0:
+		__asm__ __volatile__("movq %%cr0, %0" : "=r"(val));
+		break;
+	case 3:
+		__asm__ __volatile__("movq %%cr3, %0" : "=r"(val));
+		break;
+	default:
+		__asm__ __volatile__("movq %%cr4, %0" : "=r"(val));
+		break;
+	}
+	return val;
+}
+
+static inline __u64 xgetbv(void)
+{
+	__u32 lo, hi;
+
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((__u64) hi << 32) | lo;
+}
+
+static inline void xsetbv(__u64 val)
+{
+	__asm__ __volatile__("xsetbv"
+			     :: "a"((__u32) val), "d"((__u32) (val >> 32)),
+				"c"(0));
+}
+
+void lcpu_init_bsp(void)
+{
+	struct lcpu *bsp = &lcpus[0];
+	extern char cpu_intr_stack[];
+	extern char cpu_trap_stack[];
+
+	bsp->self = bsp;
+	bsp->id = 0;
+	bsp->online = 1;
+	bsp->intr_stack = cpu_intr_stack;
+	bsp->trap_stack = cpu_trap_stack;
+	wrmsrl(X86_MSR_GS_BASE, (__u64) bsp);
+}
+
+void smp_init(void)
+{
+	struct MADT *madt;
+	struct MADTEntryHeader *h;
+	struct MADTType0Entry *lapic;
+	struct MADTType9Entry *x2apic;
+	__u32 apic_id;
+	__sz off, len;
+
+	if (!acpi_get_version()) {
+		uk_pr_warn("No ACPI tables, using only the boot CPU\n");
+		return;
+	}
+	if (lapic_init() < 0) {
+		uk_pr_warn("No x2APIC support, using only the boot CPU\n");
+		return;
+	}
+
+	lcpus[0].apic_id = rdmsrl(X2APIC_MSR_ID);
+
+	madt = acpi_get_madt();
+	len = madt->h.Length - sizeof(*madt);
+	for (off = 0; off < len; off += h->Length) {
+		h = (struct MADTEntryHeader *) &madt->Entries[off];
+		if (h->Type == MADT_TYPE_LAPIC) {
+			lapic = (struct MADTType0Entry *) h;
+			if (!(lapic->Flags & MADT_LAPIC_ENABLED))
+				continue;
+			apic_id = lapic->APICID;
+		} else if (h->Type == MADT_TYPE_X2APIC) {
+			x2apic = (struct MADTType9Entry *) h;
+			if (!(x2apic->Flags & MADT_LAPIC_ENABLED))
+				continue;
+			apic_id = x2apic->X2APICID;
+		} else {
+			continue;
+		}
+
+		if (apic_id == lcpus[0].apic_id)
+			continue;
+		if (lcpu_count == UKPLAT_LCPU_MAXCOUNT) {
+			uk_pr_warn("Ignoring CPUs beyond %u\n",
+				   UKPLAT_LCPU_MAXCOUNT);
+			break;
+		}
+		lcpus[lcpu_count++].apic_id = apic_id;
+	}
+
+	uk_pr_info("Found %u logical CPUs\n", lcpu_count);
+}
+
+__u8 ukplat_lcpu_id(void)
+{
+	return lcpu_current()->id;
+}
+
+__u8 ukplat_lcpu_count(void)
+{
+	return lcpu_count;
+}
+
+void _lcpu_entry64(struct lcpu *lcpu)
+{
+	wrmsrl(X86_MSR_GS_BASE, (__u64) lcpu);
+	if (read_cr(4) & X86_CR4_OSXSAVE)
+		xsetbv(bsp_xcr0);
+
+	traps_lcpu_init(lcpu->id, lcpu->intr_stack, lcpu->trap_stack,
+			lcpu->nmi_stack);
+#ifdef CONFIG_HAVE_SYSCALL
+	_init_syscall();
+#endif /* CONFIG_HAVE_SYSCALL */
+	lapic_init();
+
+	__atomic_store_n(&lcpu->online, 1, __ATOMIC_RELEASE);
+	lcpu->entry(lcpu->arg);
+	UK_CRASH("LCPU %u returned from its entry\n", lcpu->id);
+}
+
+static int lcpu_alloc_stacks(struct lcpu *lcpu)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+
+	/* The current thread is found at the bottom of these stacks */
+	lcpu->intr_stack = uk_memalign(a, STACK_SIZE, STACK_SIZE);
+	lcpu->trap_stack = uk_memalign(a, STACK_SIZE, STACK_SIZE);
+	lcpu->nmi_stack = uk_malloc(a, NMI_STACK_SIZE);
+	if (!lcpu->intr_stack || !lcpu->trap_stack || !lcpu->nmi_stack) {
+		uk_free(a, lcpu->intr_stack);
+		uk_free(a, lcpu->trap_stack);
+		uk_free(a, lcpu->nmi_stack);
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+int ukplat_lcpu_start(__u8 id, ukplat_lcpu_entry_t entry, void *arg)
+{
+	struct lcpu_tramp_data *data;
+	struct lcpu *lcpu;
+	__nsec deadline;
+	int rc;
+
+	if (id == 0 || id >= lcpu_count)
+		return -EINVAL;
+
+	lcpu = &lcpus[id];
+	if (lcpu->online)
+		return -EBUSY;
+
+	/* The boot CPU prepares the shared startup code once */
+	if (!tramp_ready) {
+		memcpy((void *) LCPU_TRAMPOLINE_ADDR, _lcpu_tramp_start,
+		       _lcpu_tramp_end - _lcpu_tramp_start);
+		if (read_cr(4) & X86_CR4_OSXSAVE)
+			bsp_xcr0 = xgetbv();
+		tramp_ready = 1;
+	}
+
+	rc = lcpu_alloc_stacks(lcpu);
+	if (rc)
+		return rc;
+
+	lcpu->self = lcpu;
+	lcpu->id = id;
+	lcpu->entry = entry;
+	lcpu->arg = arg;
+
+	data = (struct lcpu_tramp_data *) (LCPU_TRAMPOLINE_ADDR
+		+ (_lcpu_tramp_data - _lcpu_tramp_start));
+	data->cr0 = read_cr(0);
+	data->cr3 = read_cr(3);
+	data->cr4 = read_cr(4);
+	data->efer = rdmsrl(X86_MSR_EFER)
+		     & (X86_EFER_SCE | X86_EFER_LME | X86_EFER_NXE);
+	data->stack = (__u64) &lcpu_boot_stacks[id][LCPU_BOOT_STACK_SIZE];
+	data->lcpu = (__u64) lcpu;
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+	/* INIT-SIPI-SIPI sequence */
+	lapic_send_ipi(lcpu->apic_id, APIC_ICR_INIT | APIC_ICR_ASSERT);
+	mdelay(10);
+	lapic_send_ipi(lcpu->apic_id, APIC_ICR_STARTUP
+			| (LCPU_TRAMPOLINE_ADDR >> 12));
+	udelay(200);
+	lapic_send_ipi(lcpu->apic_id, APIC_ICR_STARTUP
+			| (LCPU_TRAMPOLINE_ADDR >> 12));
+
+	deadline = ukplat_monotonic_clock() + LCPU_START_TIMEOUT;
+	while (!__atomic_load_n(&lcpu->online, __ATOMIC_ACQUIRE)) {
+		if (ukplat_monotonic_clock() > deadline) {
+			uk_pr_err("LCPU %u (APIC ID %u) did not come up\n",
+				  id, lcpu->apic_id);
+			return -ETIMEDOUT;
+		}
+		ukarch_spinwait();
+	}
+
+	uk_pr_info("Started LCPU %u (APIC ID %u)\n", id, lcpu->apic_id);
+	return 0;
+}
+
+void ukplat_lcpu_wakeup(__u8 id)
+{
+	UK_ASSERT(id < lcpu_count);
+
+	if (!__atomic_load_n(&lcpus[id].online, __ATOMIC_ACQUIRE))
+		return;
+
+	lapic_send_ipi(lcpus[id].apic_id, LAPIC_WAKEUP_VECTOR);
+}
@@ -41,8 +41,11 @@
 #include <stdlib.h>
 #include <uk/plat/time.h>
 #include <uk/plat/irq.h>
+#include <uk/plat/common/_time.h>
 #include <kvm/tscclock.h>
+#include <kvm-x86/lapic.h>
 #include <uk/assert.h>
+#include <uk/print.h>
 
 /* return ns since time_init() */
 __nsec ukplat_monotonic_clock(void)
@@ -56,12 +59,18 @@ __nsec ukplat_wall_clock(void)
 	return tscclock_monotonic() + tscclock_epochoffset();
 }
 
-/* NB: If this ever does more than an immediate return, it will need to be
- * compiled with NO_X86_EXTREGS_FLAGS to prevent potential clobbering of
- * registers that are not saved on interrupt handling.
+void ukplat_time_set_deadline(__nsec deadline)
+{
+	tscclock_set_deadline(deadline);
+}
+
+/* NB: Like everything that runs before the extended registers are saved,
+ * this file is built with the `isr` variant (see Makefile.uk).
  */
 static int timer_handler(void *arg __unused)
 {
+	time_irq_count_inc();
+
 	/* Yes, we handled the irq. */
 	return 1;
 }
@@ -78,6 +87,12 @@ void ukplat_time_init(void)
 	rc = tscclock_init();
 	if (rc < 0)
 		UK_CRASH("Failed to initialize TSCCLOCK\n");
+
+	/* Prefer the local APIC timer: the i8254 can only be programmed
+	 * for up to 55ms at once
+	 */
+	if (lapic_timer_init() < 0)
+		uk_pr_info("Timer: i8254\n");
 }
 
 void ukplat_time_fini(void)
@@ -28,10 +28,14 @@
 #include <uk/essentials.h>
 #include <uk/arch/lcpu.h>
 #include <uk/plat/config.h>
+#include <uk/plat/lcpu.h>
 #include <x86/desc.h>
+#include <x86/irq.h>
 #include <kvm-x86/traps.h>
+#include <kvm-x86/lapic.h>
 
-static struct seg_desc32 cpu_gdt64[GDT_NUM_ENTRIES] __align64b;
+static struct seg_desc32 cpu_gdt64[UKPLAT_LCPU_MAXCOUNT][GDT_NUM_ENTRIES]
+	__align64b;
 
 /*
  * The monitor (ukvm) or bootloader + bootstrap (virtio) starts us up with a
@@ -41,16 +45,17 @@ static struct seg_desc32 cpu_gdt64[GDT_NUM_ENTRIES] __align64b;
  * This is done primarily since we need to do LTR later in a predictable
  * fashion.
  */
-static void gdt_init(void)
+static void gdt_init(__u8 lcpu)
 {
 	volatile struct desc_table_ptr64 gdtptr;
+	struct seg_desc32 *gdt = cpu_gdt64[lcpu];
 
-	memset(cpu_gdt64, 0, sizeof(cpu_gdt64));
-	cpu_gdt64[GDT_DESC_CODE].raw = GDT_DESC_CODE_VAL;
-	cpu_gdt64[GDT_DESC_DATA].raw = GDT_DESC_DATA_VAL;
+	memset(gdt, 0, sizeof(cpu_gdt64[0]));
+	gdt[GDT_DESC_CODE].raw = GDT_DESC_CODE_VAL;
+	gdt[GDT_DESC_DATA].raw = GDT_DESC_DATA_VAL;
 
-	gdtptr.limit = sizeof(cpu_gdt64) - 1;
-	gdtptr.base = (__u64) &cpu_gdt64;
+	gdtptr.limit = sizeof(cpu_gdt64[0]) - 1;
+	gdtptr.base = (__u64) gdt;
 	__asm__ __volatile__("lgdt (%0)" ::"r"(&gdtptr));
 	/*
 	 * TODO: Technically we should reload all segment registers here, in
@@ -59,31 +64,34 @@ static void gdt_init(void)
 	 */
 }
 
-static struct tss64 cpu_tss;
+static struct tss64 cpu_tss[UKPLAT_LCPU_MAXCOUNT];
 
+/* Stacks of the boot CPU, the other logical CPUs allocate theirs */
 __section(".intrstack")  __align(STACK_SIZE)
 char cpu_intr_stack[STACK_SIZE];  /* IST1 */
 __section(".intrstack")  __align(STACK_SIZE)
 char cpu_trap_stack[STACK_SIZE];  /* IST2 */
-static char cpu_nmi_stack[4096];  /* IST3 */
+static char cpu_nmi_stack[NMI_STACK_SIZE];  /* IST3 */
 
-static void tss_init(void)
+static void tss_init(__u8 lcpu, char *intr_stack, char *trap_stack,
+		     char *nmi_stack)
 {
-	struct seg_desc64 *td = (void *) &cpu_gdt64[GDT_DESC_TSS_LO];
+	struct seg_desc64 *td = (void *) &cpu_gdt64[lcpu][GDT_DESC_TSS_LO];
+	struct tss64 *tss = &cpu_tss[lcpu];
 
-	cpu_tss.ist[0] = (__u64) &cpu_intr_stack[sizeof(cpu_intr_stack)];
-	cpu_tss.ist[1] = (__u64) &cpu_trap_stack[sizeof(cpu_trap_stack)];
-	cpu_tss.ist[2] = (__u64) &cpu_nmi_stack[sizeof(cpu_nmi_stack)];
+	tss->ist[0] = (__u64) &intr_stack[STACK_SIZE];
+	tss->ist[1] = (__u64) &trap_stack[STACK_SIZE];
+	tss->ist[2] = (__u64) &nmi_stack[NMI_STACK_SIZE];
 
-	td->limit_lo = sizeof(cpu_tss);
-	td->base_lo = (__u64) &cpu_tss;
+	td->limit_lo = sizeof(*tss);
+	td->base_lo = (__u64) tss;
 	td->type = 0x9;
 	td->zero = 0;
 	td->dpl = 0;
 	td->p = 1;
 	td->limit_hi = 0;
 	td->gran = 0;
-	td->base_hi = (__u64) &cpu_tss >> 24;
+	td->base_hi = (__u64) tss >> 24;
 	td->zero1 = 0;
 
 	barrier();
@@ -121,8 +129,12 @@ static void idt_fillgate(unsigned int num, void *fun, unsigned int ist)
 
 volatile struct desc_table_ptr64 idtptr;
 
+static void idt_load(void);
+
 static void idt_init(void)
 {
+	int i;
+
 	/*
 	 * Load trap vectors. All traps run on IST2 (cpu_trap_stack), except for
 	 * the exceptions.
@@ -152,10 +164,17 @@ static void idt_init(void)
 	FILL_TRAP_GATE(virt_error,      2);
 
 	/*
-	 * Load irq vectors. All irqs run on IST1 (cpu_intr_stack).
+	 * Load irq vectors. All irqs run on IST1 (cpu_intr_stack). With
+	 * preemption, the scheduler may switch threads at the end of an
+	 * interrupt, so irqs must stay on the stack of the interrupted thread.
 	 */
+#if CONFIG_HAVE_PREEMPT
+#define FILL_IRQ_GATE_VEC(vec, fn, ist) idt_fillgate(vec, fn, 0)
+#else
+#define FILL_IRQ_GATE_VEC(vec, fn, ist) idt_fillgate(vec, fn, ist)
+#endif /* CONFIG_HAVE_PREEMPT */
 #define FILL_IRQ_GATE(num, ist) extern void cpu_irq_##num(void); \
-	idt_fillgate(32 + num, cpu_irq_##num, ist)
+	FILL_IRQ_GATE_VEC(32 + num, cpu_irq_##num, ist)
 	FILL_IRQ_GATE(0, 1);
 	FILL_IRQ_GATE(1, 1);
 	FILL_IRQ_GATE(2, 1);
@@ -173,18 +192,52 @@ static void idt_init(void)
 	FILL_IRQ_GATE(14, 1);
 	FILL_IRQ_GATE(15, 1);
 
+	extern void (*cpu_msi_irqs[__MSI_IRQ_COUNT])(void);
+
+	for (i = 0; i < __MSI_IRQ_COUNT; i++)
+		FILL_IRQ_GATE_VEC(LAPIC_MSI_VECTOR_BASE + i, cpu_msi_irqs[i], 1);
+
+	/* The local APIC timer behaves like an irq */
+	extern void cpu_lapic_timer(void);
+	extern void cpu_lapic_spurious(void);
+
+	FILL_IRQ_GATE_VEC(LAPIC_TIMER_VECTOR, cpu_lapic_timer, 1);
+	idt_fillgate(LAPIC_SPURIOUS_VECTOR, cpu_lapic_spurious, 1);
+
+#if CONFIG_HAVE_SMP
+	/* The wakeup IPI only makes a halted CPU return to the scheduler */
+	extern void cpu_lapic_wakeup(void);
+
+	idt_fillgate(LAPIC_WAKEUP_VECTOR, cpu_lapic_wakeup, 1);
+#endif /* CONFIG_HAVE_SMP */
+
 	idtptr.limit = sizeof(cpu_idt) - 1;
 	idtptr.base = (__u64) &cpu_idt;
+	idt_load();
+}
+
+static void idt_load(void)
+{
 	__asm__ __volatile__("lidt (%0)" :: "r" (&idtptr));
 }
 
 void traps_init(void)
 {
-	gdt_init();
-	tss_init();
+	gdt_init(0);
+	tss_init(0, cpu_intr_stack, cpu_trap_stack, cpu_nmi_stack);
 	idt_init();
 }
 
+#if CONFIG_HAVE_SMP
+void traps_lcpu_init(__u8 lcpu, char *intr_stack, char *trap_stack,
+		     char *nmi_stack)
+{
+	gdt_init(lcpu);
+	tss_init(lcpu, intr_stack, trap_stack, nmi_stack);
+	idt_load();
+}
+#endif /* CONFIG_HAVE_SMP */
+
 void traps_fini(void)
 {
 }
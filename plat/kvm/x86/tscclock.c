@@ -59,6 +59,7 @@
 #include <uk/print.h>
 #include <uk/assert.h>
 #include <uk/bitops.h>
+#include <kvm-x86/lapic.h>
 
 #define TIMER_CNTR           0x40
 #define TIMER_MODE           0x43
@@ -98,13 +99,16 @@ static __u64 rtc_epochoffset;
  * TSC clock specific.
  */
 
-/* Base time values at the last call to tscclock_monotonic(). */
-static __u64 time_base;
+/* TSC value at which monotonic time begins */
 static __u64 tsc_base;
 
 /* Multiplier for converting TSC ticks to nsecs. (0.32) fixed point. */
 static __u32 tsc_mult;
 
+/* Multiplier for converting nsecs to TSC ticks, integer and (0.32) part */
+static __u32 tsc_nsec_mult;
+static __u32 tsc_nsec_frac;
+
 /*
  * Multiplier for converting nsecs to PIT ticks. (1.32) fixed point.
  *
@@ -195,20 +199,13 @@ static __u64 rtc_gettimeofday(void)
 
 /*
  * Return monotonic time using TSC clock.
+ *
+ * The clock does not keep any state so that it can be read concurrently by
+ * all logical CPUs.
  */
 __u64 tscclock_monotonic(void)
 {
-	__u64 tsc_now, tsc_delta;
-
-	/*
-	 * Update time_base (monotonic time) and tsc_base (TSC time).
-	 */
-	tsc_now = rdtsc();
-	tsc_delta = tsc_now - tsc_base;
-	time_base += mul64_32(tsc_delta, tsc_mult);
-	tsc_base = tsc_now;
-
-	return time_base;
+	return mul64_32(rdtsc() - tsc_base, tsc_mult);
 }
 
 /*
@@ -261,30 +258,23 @@ int tscclock_init(void)
 	 *
 	 * (0.32) tsc_mult = UKARCH_NSEC_PER_SEC (32.32) / tsc_freq (32.0)
 	 *
-	 * Warning, do not print anything between TSC calibration and the
-	 * setting of tsc_mult: if CONFIG_LIBUKDEBUG_PRINT_TIME is enabled
-	 * this will trigger a reset of tsc_base via tscclock_monotonic
-	 * and delay the clock starting point.
-	 *
 	 * FIXME: this will overflow with small TSC frequencies. We should
 	 * probably calculate the TSC shift dynamically like solo5/hvt does.
 	 */
 	tsc_mult = (UKARCH_NSEC_PER_SEC << 32) / tsc_freq;
+	tsc_nsec_mult = tsc_freq / UKARCH_NSEC_PER_SEC;
+	tsc_nsec_frac = ((tsc_freq % UKARCH_NSEC_PER_SEC) << 32)
+			/ UKARCH_NSEC_PER_SEC;
 
 	uk_pr_info("Clock source: TSC, frequency estimate is %llu Hz\n",
 		   (unsigned long long) tsc_freq);
 
 	/*
 	 * Monotonic time begins at tsc_base (first read of TSC before
-	 * calibration).
-	 */
-	tscclock_monotonic();
-
-	/*
-	 * Compute RTC epoch offset by subtracting monotonic time_base from RTC
-	 * time at boot.
+	 * calibration). Compute RTC epoch offset by subtracting the current
+	 * monotonic time from RTC time at boot.
 	 */
-	rtc_epochoffset = rtc_boot - time_base;
+	rtc_epochoffset = rtc_boot - tscclock_monotonic();
 
 	/*
 	 * Initialise i8254 timer channel 0 to mode 4 (one shot).
@@ -294,6 +284,14 @@ int tscclock_init(void)
 	return 0;
 }
 
+/*
+ * Return the TSC value at monotonic time `nsec`.
+ */
+__u64 tscclock_nsec_to_tsc(__u64 nsec)
+{
+	return tsc_base + nsec * tsc_nsec_mult + mul64_32(nsec, tsc_nsec_frac);
+}
+
 /*
  * Return epoch offset (wall time offset to monotonic clock start).
  */
@@ -308,6 +306,50 @@ __u64 tscclock_epochoffset(void)
  */
 #define PIT_MIN_DELTA	16
 
+/*
+ * Programs the i8254 to interrupt the CPU after `delta_ticks` PIT ticks.
+ * Maximum timer delay is 65535 ticks, longer delays fire early.
+ */
+static void pit_arm(__u64 delta_ticks)
+{
+	unsigned int ticks;
+
+	if (delta_ticks > 65535)
+		ticks = 65535;
+	else
+		ticks = delta_ticks;
+
+	/*
+	 * Note that according to the Intel 82C54 datasheet, p12 the
+	 * interrupt is actually delivered in N + 1 ticks.
+	 */
+	ticks -= 1;
+	outb(TIMER_CNTR, ticks & 0xff);
+	outb(TIMER_CNTR, ticks >> 8);
+}
+
+/*
+ * Requests a timer interrupt at `until`. Deadlines that are too close (or
+ * already passed) are served after the minimum safe amount of ticks.
+ */
+void tscclock_set_deadline(__u64 until)
+{
+	__u64 now, delta_ticks = 0;
+
+	if (lapic_timer_enabled()) {
+		lapic_timer_arm(until);
+		return;
+	}
+
+	now = ukplat_monotonic_clock();
+	if (until > now)
+		delta_ticks = mul64_32(until - now, pit_mult);
+	if (delta_ticks < PIT_MIN_DELTA)
+		delta_ticks = PIT_MIN_DELTA;
+
+	pit_arm(delta_ticks);
+}
+
 /*
  * Returns early if any interrupts are serviced, or if the requested delay is
  * too short. Must be called with interrupts disabled, will enable interrupts
@@ -323,7 +365,6 @@ static void tscclock_cpu_block(__u64 until)
 {
 	__u64 now, delta_ns;
 	__u64 delta_ticks;
-	unsigned int ticks;
 
 	UK_ASSERT(ukplat_lcpu_irqs_disabled());
 
@@ -350,20 +391,8 @@ static void tscclock_cpu_block(__u64 until)
 
 	/*
 	 * Program the timer to interrupt the CPU after the delay has expired.
-	 * Maximum timer delay is 65535 ticks.
 	 */
-	if (delta_ticks > 65535)
-		ticks = 65535;
-	else
-		ticks = delta_ticks;
-
-	/*
-	 * Note that according to the Intel 82C54 datasheet, p12 the
-	 * interrupt is actually delivered in N + 1 ticks.
-	 */
-	ticks -= 1;
-	outb(TIMER_CNTR, ticks & 0xff);
-	outb(TIMER_CNTR, ticks >> 8);
+	pit_arm(delta_ticks);
 
 	/*
 	 * Wait for any interrupt. If we got an interrupt then just
@@ -374,16 +403,26 @@ static void tscclock_cpu_block(__u64 until)
 	 * TODO: It would be more efficient for longer sleeps to be
 	 * able to distinguish if the interrupt was the PIT interrupt
 	 * and no other, but this will do for now.
+	 *
+	 * `sti; hlt` has to be a single sequence: an interrupt that arrives
+	 * between the two instructions would otherwise only be noticed once
+	 * the timer expires.
 	 */
-	ukplat_lcpu_halt_irq();
+	__asm__ __volatile__("sti; hlt; cli" ::: "memory");
 }
 
 unsigned long sched_have_pending_events;
 
 void time_block_until(__snsec until)
 {
+	/* The i8254 only interrupts the boot CPU, so secondary CPUs always
+	 * have a local APIC timer
+	 */
 	while ((__snsec) ukplat_monotonic_clock() < until) {
-		tscclock_cpu_block(until);
+		if (lapic_timer_enabled())
+			lapic_block_until(until);
+		else
+			tscclock_cpu_block(until);
 
 		if (__uk_test_and_clear_bit(0, &sched_have_pending_events))
 			break;
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __LINUXU_SMP_H__
+#define __LINUXU_SMP_H__
+
+#include <uk/config.h>
+#include <uk/arch/types.h>
+#include <uk/essentials.h>
+#include <uk/plat/lcpu.h>
+
+/* Signal used to kick a logical CPU out of its halt */
+#define LINUXU_SIGWAKEUP 34
+
+#if CONFIG_LINUXU_SMP
+struct linuxu_lcpu {
+	/* Has to be the first member: it is read via %gs:0 */
+	struct linuxu_lcpu *self;
+	__u8 id;
+	int tid;
+	unsigned long irq_enabled;
+	ukplat_lcpu_entry_t entry;
+	void *arg;
+	int online;
+};
+
+/*
+ * Logical CPUs are Linux threads of the same process; each one points its
+ * GS base to its own struct linuxu_lcpu. The read has to be volatile since
+ * a Unikraft thread may migrate to another logical CPU in between.
+ */
+static inline struct linuxu_lcpu *linuxu_lcpu_current(void)
+{
+	struct linuxu_lcpu *lcpu;
+
+	__asm__ __volatile__("movq %%gs:0, %0" : "=r"(lcpu));
+	return lcpu;
+}
+
+void _liblinuxuplat_init_lcpu(void);
+#endif /* CONFIG_LINUXU_SMP */
+
+#endif /* __LINUXU_SMP_H__ */
@@ -43,6 +43,10 @@
 #define __SC_MMAP     192 /* use mmap2() since mmap() is obsolete */
 #define __SC_MUNMAP    91
 #define __SC_EXIT       1
+#define __SC_GETPID    20
+#define __SC_CLONE    120
+#define __SC_EXIT_GROUP 248
+#define __SC_TGKILL   268
 #define __SC_IOCTL     54
 #define __SC_FSTAT    108
 #define __SC_RT_SIGPROCMASK   126
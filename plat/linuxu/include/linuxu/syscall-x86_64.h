@@ -46,6 +46,8 @@
 #define __SC_RT_SIGACTION   13
 #define __SC_RT_SIGPROCMASK 14
 #define __SC_IOCTL  16
+#define __SC_GETPID 39
+#define __SC_CLONE  56
 #define __SC_EXIT   60
 #define __SC_ARCH_PRCTL       158
 #define __SC_TIMER_CREATE     222
@@ -54,6 +56,8 @@
 #define __SC_TIMER_GETOVERRUN 225
 #define __SC_TIMER_DELETE     226
 #define __SC_CLOCK_GETTIME    228
+#define __SC_EXIT_GROUP       231
+#define __SC_TGKILL           234
 #define __SC_PSELECT6 270
 
 /* NOTE: from linux-4.6.3 (arch/x86/entry/entry_64.S):
@@ -92,6 +92,25 @@ static inline int sys_exit(int status)
 			      (long) (status));
 }
 
+static inline int sys_exit_group(int status)
+{
+	return (int) syscall1(__SC_EXIT_GROUP,
+			      (long) (status));
+}
+
+static inline int sys_getpid(void)
+{
+	return (int) syscall0(__SC_GETPID);
+}
+
+static inline int sys_tgkill(int tgid, int tid, int sig)
+{
+	return (int) syscall3(__SC_TGKILL,
+			      (long) tgid,
+			      (long) tid,
+			      (long) sig);
+}
+
 static inline int sys_clock_gettime(k_clockid_t clk_id, struct k_timespec *tp)
 {
 	return (int) syscall2(__SC_CLOCK_GETTIME,
@@ -146,6 +165,7 @@ static inline int sys_sigprocmask(int how,
 			      sizeof(k_sigset_t));
 }
 
+#define ARCH_SET_GS 0x1001
 #define ARCH_SET_FS 0x1002
 static inline int sys_arch_prctl(int code, unsigned long addr)
 {
@@ -37,6 +37,9 @@
 #include <uk/assert.h>
 #include <linuxu/syscall.h>
 #include <linuxu/signal.h>
+#if CONFIG_LINUXU_SMP
+#include <linuxu/smp.h>
+#endif
 
 #define IRQS_NUM    16
 
@@ -55,15 +58,28 @@ static struct irq_handler_head irq_handlers[IRQS_NUM];
 
 static struct uk_alloc *allocator;
 static k_sigset_t handled_signals_set;
+#if CONFIG_LINUXU_SMP
+/* Interrupt flag of the current logical CPU */
+#define irq_enabled (linuxu_lcpu_current()->irq_enabled)
+
+/* Signals are only unblocked on the boot CPU, see smp.c */
+#define lcpu_handles_signals() (ukplat_lcpu_id() == 0)
+#else
 static unsigned long irq_enabled;
 
+#define lcpu_handles_signals() (1)
+#endif
+static irq_exit_func_t irq_exit_handler;
+
 void ukplat_lcpu_enable_irq(void)
 {
 	int rc;
 
-	rc = sys_sigprocmask(SIG_UNBLOCK, &handled_signals_set, NULL);
-	if (unlikely(rc != 0))
-		UK_CRASH("Failed to unblock signals (%d)\n", rc);
+	if (lcpu_handles_signals()) {
+		rc = sys_sigprocmask(SIG_UNBLOCK, &handled_signals_set, NULL);
+		if (unlikely(rc != 0))
+			UK_CRASH("Failed to unblock signals (%d)\n", rc);
+	}
 
 	irq_enabled = 1;
 }
@@ -72,9 +88,11 @@ void ukplat_lcpu_disable_irq(void)
 {
 	int rc;
 
-	rc = sys_sigprocmask(SIG_BLOCK, &handled_signals_set, NULL);
-	if (unlikely(rc != 0))
-		UK_CRASH("Failed to block signals (%d)\n", rc);
+	if (lcpu_handles_signals()) {
+		rc = sys_sigprocmask(SIG_BLOCK, &handled_signals_set, NULL);
+		if (unlikely(rc != 0))
+			UK_CRASH("Failed to block signals (%d)\n", rc);
+	}
 
 	irq_enabled = 0;
 }
@@ -111,9 +129,9 @@ void ukplat_lcpu_irqs_handle_pending(void)
 
 void __restorer(void);
 #if defined __X86_64__
-asm("__restorer:mov $15,%rax\nsyscall");
+asm(".globl __restorer\n__restorer:mov $15,%rax\nsyscall");
 #elif defined __ARM_32__
-asm("__restorer:mov r7, #0x77\nsvc 0x0");
+asm(".globl __restorer\n__restorer:mov r7, #0x77\nsvc 0x0");
 #else
 #error "Unsupported architecture"
 #endif
@@ -126,7 +144,7 @@ static void _irq_handle(int irq)
 
 	UK_SLIST_FOREACH(h, &irq_handlers[irq], entries) {
 		if (h->func(h->arg) == 1)
-			return;
+			goto exit;
 	}
 	/*
 	 * Just warn about unhandled interrupts. We do this to
@@ -135,6 +153,16 @@ static void _irq_handle(int irq)
 	 * one interrupt line that would then stay disabled.
 	 */
 	uk_pr_crit("Unhandled irq=%d\n", irq);
+
+exit:
+	if (irq_exit_handler)
+		irq_exit_handler();
+}
+
+int ukplat_irq_set_exit_handler(irq_exit_func_t func)
+{
+	irq_exit_handler = func;
+	return 0;
 }
 
 int ukplat_irq_register(unsigned long irq, irq_handler_func_t func, void *arg)
@@ -170,12 +198,14 @@ int ukplat_irq_register(unsigned long irq, irq_handler_func_t func, void *arg)
 	ukplat_lcpu_restore_irqf(flags);
 
 	/* Unblock the signal */
-	k_sigemptyset(&set);
-	k_sigaddset(&set, irq);
+	if (lcpu_handles_signals()) {
+		k_sigemptyset(&set);
+		k_sigaddset(&set, irq);
 
-	rc = sys_sigprocmask(SIG_UNBLOCK, &set, NULL);
-	if (unlikely(rc != 0))
-		UK_CRASH("Failed to unblock signals: %d\n", rc);
+		rc = sys_sigprocmask(SIG_UNBLOCK, &set, NULL);
+		if (unlikely(rc != 0))
+			UK_CRASH("Failed to unblock signals: %d\n", rc);
+	}
 
 	/* Add to our handled signals set */
 	k_sigaddset(&handled_signals_set, irq);
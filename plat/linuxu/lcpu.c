@@ -37,6 +37,10 @@
 #include <linuxu/time.h>
 #include <linuxu/syscall.h>
 #include <uk/print.h>
+#if CONFIG_LINUXU_SMP
+#include <linuxu/signal.h>
+#include <linuxu/smp.h>
+#endif
 
 static void do_pselect(struct k_timespec *timeout)
 {
@@ -45,8 +49,22 @@ static void do_pselect(struct k_timespec *timeout)
 	k_fd_set *readfds = NULL;
 	k_fd_set *writefds = NULL;
 	k_fd_set *exceptfds = NULL;
+#if CONFIG_LINUXU_SMP
+	k_sigset_t set;
+	struct {
+		const k_sigset_t *ss;
+		unsigned long ss_len;
+	} sigmask = { &set, sizeof(set) };
 
+	/* Let ukplat_lcpu_wakeup() interrupt the sleep */
+	sys_sigprocmask(SIG_BLOCK, NULL, &set);
+	k_sigdelset(&set, LINUXU_SIGWAKEUP);
+
+	ret = sys_pselect6(nfds, readfds, writefds, exceptfds, timeout,
+			   &sigmask);
+#else
 	ret = sys_pselect6(nfds, readfds, writefds, exceptfds, timeout, NULL);
+#endif
 	if (ret < 0 && ret != -EINTR)
 		uk_pr_warn("Failed to halt LCPU: %d\n", ret);
 }
@@ -197,3 +197,9 @@ void ukplat_stack_set_current_thread(void *thread_addr __unused)
 {
 	/* For now, signals use the current process stack */
 }
+
+__sz ukplat_mem_hugepage_size(void)
+{
+	/* Mappings of the heap are managed by the host */
+	return 0;
+}
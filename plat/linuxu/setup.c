@@ -42,6 +42,9 @@
 #include <uk/assert.h>
 #include <uk/errptr.h>
 #include <uk/plat/common/cpu.h>
+#if CONFIG_LINUXU_SMP
+#include <linuxu/smp.h>
+#endif
 
 struct liblinuxuplat_opts _liblinuxuplat_opts = { 0 };
 
@@ -49,6 +52,10 @@ void _liblinuxuplat_entry(int argc, char *argv[]) __noreturn;
 
 void _liblinuxuplat_entry(int argc, char *argv[])
 {
+#if CONFIG_LINUXU_SMP
+	/* Has to come first: the current LCPU is looked up via GS */
+	_liblinuxuplat_init_lcpu();
+#endif
 	_init_cpufeatures();
 
 	/*
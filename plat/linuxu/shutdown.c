@@ -50,14 +50,14 @@ __noreturn void ukplat_terminate(enum ukplat_gstate request)
 	switch (request) {
 	case UKPLAT_HALT:
 	case UKPLAT_RESTART:
-		ret = sys_exit(0);
+		ret = sys_exit_group(0);
 		break;
 	default: /* UKPLAT_CRASH */
-		ret = sys_exit(1);
+		ret = sys_exit_group(1);
 		break;
 	}
 
-	uk_pr_crit("sys_exit() failed: %d\n", ret);
+	uk_pr_crit("sys_exit_group() failed: %d\n", ret);
 	for (;;)
 		; /* syscall failed, loop forever */
 }
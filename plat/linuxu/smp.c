@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The Unikraft Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <uk/config.h>
+#include <uk/arch/types.h>
+#include <uk/arch/atomic.h>
+#include <uk/arch/lcpu.h>
+#include <uk/plat/lcpu.h>
+#include <uk/assert.h>
+#include <uk/print.h>
+#include <uk/libparam.h>
+#include <linuxu/syscall.h>
+#include <linuxu/signal.h>
+#include <linuxu/smp.h>
+
+#define LCPU_STACK_SIZE (16 * 1024)
+
+/* Flags for creating a logical CPU as a thread of our process */
+#define CLONE_VM             0x00000100
+#define CLONE_FS             0x00000200
+#define CLONE_FILES          0x00000400
+#define CLONE_SIGHAND        0x00000800
+#define CLONE_THREAD         0x00010000
+#define CLONE_SYSVSEM        0x00040000
+#define CLONE_PARENT_SETTID  0x00100000
+
+#define LCPU_CLONE_FLAGS \
+	(CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND | \
+	 CLONE_THREAD | CLONE_SYSVSEM | CLONE_PARENT_SETTID)
+
+static __u32 lcpus = CONFIG_LINUXU_DEFAULT_LCPUS;
+UK_LIB_PARAM(lcpus, __u32);
+
+static struct linuxu_lcpu lcpu_info[UKPLAT_LCPU_MAXCOUNT];
+static __u8 lcpu_stacks[UKPLAT_LCPU_MAXCOUNT][LCPU_STACK_SIZE]
+	__align(16);
+
+/* Implemented in x86/lcpu64.S */
+long _linuxu_lcpu_clone(unsigned long flags, void *stack, int *ptid,
+			void (*fn)(void *), void *arg);
+
+void __restorer(void);
+
+static void lcpu_wakeup_handler(int sig __unused)
+{
+	/* Nothing to do: the signal just interrupts pselect() */
+}
+
+static void lcpu_set_current(struct linuxu_lcpu *lcpu)
+{
+	int rc;
+
+	lcpu->self = lcpu;
+	rc = sys_arch_prctl(ARCH_SET_GS, (unsigned long) lcpu);
+	if (unlikely(rc != 0))
+		UK_CRASH("Failed to set GS base for LCPU %u: %d\n",
+			 lcpu->id, rc);
+}
+
+void _liblinuxuplat_init_lcpu(void)
+{
+	struct linuxu_lcpu *bsp = &lcpu_info[0];
+	struct uk_sigaction action;
+	k_sigset_t set;
+	int rc;
+
+	bsp->id = 0;
+	bsp->tid = sys_getpid();
+	bsp->online = 1;
+	lcpu_set_current(bsp);
+
+	/*
+	 * The wakeup signal stays blocked all the time. It is only let
+	 * through while a logical CPU sleeps in pselect(), so that it
+	 * cannot interrupt anything else.
+	 */
+	memset(&action, 0, sizeof(action));
+	action.k_sa_handler = lcpu_wakeup_handler;
+	action.k_sa_flags = SA_RESTORER;
+	action.k_sa_restorer = __restorer;
+	rc = sys_sigaction(LINUXU_SIGWAKEUP, &action, NULL);
+	if (unlikely(rc != 0))
+		UK_CRASH("Failed to install LCPU wakeup handler: %d\n", rc);
+
+	k_sigemptyset(&set);
+	k_sigaddset(&set, LINUXU_SIGWAKEUP);
+	rc = sys_sigprocmask(SIG_BLOCK, &set, NULL);
+	if (unlikely(rc != 0))
+		UK_CRASH("Failed to block LCPU wakeup signal: %d\n", rc);
+}
+
+__u8 ukplat_lcpu_id(void)
+{
+	return linuxu_lcpu_current()->id;
+}
+
+__u8 ukplat_lcpu_count(void)
+{
+	if (lcpus < 1)
+		return 1;
+	if (lcpus > UKPLAT_LCPU_MAXCOUNT)
+		return UKPLAT_LCPU_MAXCOUNT;
+	return (__u8) lcpus;
+}
+
+static void lcpu_start_entry(void *arg)
+{
+	struct linuxu_lcpu *lcpu = (struct linuxu_lcpu *) arg;
+	k_sigset_t set;
+
+	lcpu_set_current(lcpu);
+
+	/*
+	 * Device interrupts (signals) are only delivered to the boot CPU,
+	 * so secondary CPUs keep all signals blocked and only track the
+	 * interrupt flag in software.
+	 */
+	k_sigfillset(&set);
+	sys_sigprocmask(SIG_SETMASK, &set, NULL);
+	lcpu->irq_enabled = 0;
+
+	__atomic_store_n(&lcpu->online, 1, __ATOMIC_RELEASE);
+	lcpu->entry(lcpu->arg);
+	UK_CRASH("LCPU %u returned from its entry\n", lcpu->id);
+}
+
+int ukplat_lcpu_start(__u8 id, ukplat_lcpu_entry_t entry, void *arg)
+{
+	struct linuxu_lcpu *lcpu;
+	long rc;
+
+	if (id == 0 || id >= ukplat_lcpu_count())
+		return -EINVAL;
+
+	lcpu = &lcpu_info[id];
+	if (lcpu->online)
+		return -EBUSY;
+
+	lcpu->id = id;
+	lcpu->entry = entry;
+	lcpu->arg = arg;
+
+	rc = _linuxu_lcpu_clone(LCPU_CLONE_FLAGS,
+				&lcpu_stacks[id][LCPU_STACK_SIZE],
+				&lcpu->tid, lcpu_start_entry, lcpu);
+	if (rc < 0) {
+		uk_pr_err("Failed to start LCPU %u: %ld\n", id, rc);
+		return (int) rc;
+	}
+
+	while (!__atomic_load_n(&lcpu->online, __ATOMIC_ACQUIRE))
+		ukarch_spinwait();
+
+	uk_pr_info("Started LCPU %u (tid %d)\n", id, lcpu->tid);
+	return 0;
+}
+
+void ukplat_lcpu_wakeup(__u8 id)
+{
+	UK_ASSERT(id < ukplat_lcpu_count());
+
+	if (!__atomic_load_n(&lcpu_info[id].online, __ATOMIC_ACQUIRE))
+		return;
+
+	sys_tgkill(lcpu_info[0].tid, lcpu_info[id].tid, LINUXU_SIGWAKEUP);
+}
@@ -34,6 +34,7 @@
 #include <string.h>
 #include <uk/plat/time.h>
 #include <uk/plat/irq.h>
+#include <uk/plat/common/_time.h>
 #include <uk/assert.h>
 #include <linuxu/syscall.h>
 #include <linuxu/time.h>
@@ -73,12 +74,18 @@ __nsec ukplat_wall_clock(void)
 	return ret;
 }
 
+void ukplat_time_set_deadline(__nsec deadline __unused)
+{
+	/* The timer ticks periodically with TIMER_INTVAL_NSEC */
+}
+
 static int timer_handler(void *arg __unused)
 {
 	/* We only use the timer interrupt to wake up. As we end up here, the
 	 * timer interrupt has already done its job and we can acknowledge
 	 * receiving it.
 	 */
+	time_irq_count_inc();
 	return 1;
 }
 
@@ -145,6 +145,11 @@ void block_domain(__snsec until)
 	}
 }
 
+void ukplat_time_set_deadline(__nsec deadline)
+{
+	set_vtimer_compare(ns_to_ticks(deadline) + cntvct_at_init);
+}
+
 void ukplat_time_init(void)
 {
 	uk_pr_info("Initialising timer interface\n");
@@ -121,25 +121,19 @@ static int network_tx_buf_gc(struct uk_netdev_tx_queue *txq)
 	return count;
 }
 
-static int netfront_xmit(struct uk_netdev *n,
+static int netfront_txq_enqueue(struct netfront_dev *nfdev,
 		struct uk_netdev_tx_queue *txq,
 		struct uk_netbuf *pkt)
 {
-	struct netfront_dev *nfdev;
 	unsigned long flags;
 	uint16_t id;
 	RING_IDX req_prod;
 	netif_tx_request_t *tx_req;
-	int notify;
-	int status = 0, count;
+	int count;
 
-	UK_ASSERT(n != NULL);
-	UK_ASSERT(txq != NULL);
 	UK_ASSERT(pkt != NULL);
 	UK_ASSERT(pkt->len < PAGE_SIZE);
 
-	nfdev = to_netfront_dev(n);
-
 	/* get request id */
 	if (unlikely(!uk_semaphore_down_try(&txq->sem))) {
 		/* try some cleanup */
@@ -170,20 +164,71 @@ static int netfront_xmit(struct uk_netdev *n,
 	tx_req->id = id;
 
 	txq->ring.req_prod_pvt = req_prod + 1;
+
+	return 0;
+}
+
+/* Publishes the enqueued requests, returns the number of reclaimed slots */
+static int netfront_txq_push(struct uk_netdev_tx_queue *txq)
+{
+	unsigned long flags;
+	int notify;
+	int count;
+
 	wmb(); /* Ensure backend sees requests */
 
 	RING_PUSH_REQUESTS_AND_CHECK_NOTIFY(&txq->ring, notify);
 	if (notify)
 		notify_remote_via_evtchn(txq->evtchn);
 
-	status |= UK_NETDEV_STATUS_SUCCESS;
-
 	/* some cleanup */
 	local_irq_save(flags);
 	count = network_tx_buf_gc(txq);
 	local_irq_restore(flags);
 
-	status |= likely(count > 0) ? UK_NETDEV_STATUS_MORE : 0x0;
+	return count;
+}
+
+static int netfront_xmit_burst(struct uk_netdev *n,
+		struct uk_netdev_tx_queue *txq,
+		struct uk_netbuf **pkts,
+		uint16_t *cnt)
+{
+	struct netfront_dev *nfdev;
+	uint16_t i;
+	int count;
+
+	UK_ASSERT(n != NULL);
+	UK_ASSERT(txq != NULL);
+	UK_ASSERT(pkts != NULL && cnt != NULL);
+
+	nfdev = to_netfront_dev(n);
+
+	for (i = 0; i < *cnt; i++) {
+		if (netfront_txq_enqueue(nfdev, txq, pkts[i]) < 0)
+			break;
+	}
+	*cnt = i;
+	if (unlikely(i == 0))
+		return 0x0;
+
+	/* Single push and notification for the whole burst */
+	count = netfront_txq_push(txq);
+
+	return UK_NETDEV_STATUS_SUCCESS
+		| (likely(count > 0) ? UK_NETDEV_STATUS_MORE : 0x0);
+}
+
+static int netfront_xmit(struct uk_netdev *n,
+		struct uk_netdev_tx_queue *txq,
+		struct uk_netbuf *pkt)
+{
+	uint16_t cnt = 1;
+	int status;
+
+	status = netfront_xmit_burst(n, txq, &pkt, &cnt);
+	if (unlikely(cnt == 0))
+		return -ENOSPC;
 
 	return status;
 }
@@ -195,7 +240,6 @@ static int netfront_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 	uint16_t id;
 	netif_rx_request_t *rx_req;
 	struct netfront_dev *nfdev;
-	int notify;
 
 	/* buffer must be page aligned */
 	UK_ASSERT(((unsigned long) netbuf->buf & ~PAGE_MASK) == 0);
@@ -220,13 +264,8 @@ static int netfront_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 			virt_to_mfn(netbuf->buf), 0);
 	UK_ASSERT(rx_req->gref != GRANT_INVALID_REF);
 
-	wmb(); /* Ensure backend sees requests */
 	rxq->ring.req_prod_pvt = req_prod + 1;
 
-	RING_PUSH_REQUESTS_AND_CHECK_NOTIFY(&rxq->ring, notify);
-	if (notify)
-		notify_remote_via_evtchn(rxq->evtchn);
-
 	return 0;
 }
 
@@ -278,13 +317,17 @@ out:
 
 static int netfront_rx_fillup(struct uk_netdev_rx_queue *rxq, uint16_t nb_desc)
 {
-	struct uk_netbuf *netbuf[nb_desc];
+	struct uk_netbuf *netbuf[nb_desc ? nb_desc : 1];
 	int rc, status = 0;
-	uint16_t cnt;
+	int notify;
+	uint16_t cnt, i;
+
+	if (!nb_desc)
+		return 0;
 
 	cnt = rxq->alloc_rxpkts(rxq->alloc_rxpkts_argp, netbuf, nb_desc);
 
-	for (uint16_t i = 0; i < cnt; i++) {
+	for (i = 0; i < cnt; i++) {
 		rc = netfront_rxq_enqueue(rxq, netbuf[i]);
 		if (unlikely(rc < 0)) {
 			uk_pr_err("Failed to add a buffer to rx queue %p: %d\n",
@@ -307,6 +350,13 @@ static int netfront_rx_fillup(struct uk_netdev_rx_queue *rxq, uint16_t nb_desc)
 		status |= UK_NETDEV_STATUS_UNDERRUN;
 
 out:
+	/* Single push and notification for all the new buffers */
+	if (i > 0) {
+		wmb(); /* Ensure backend sees requests */
+		RING_PUSH_REQUESTS_AND_CHECK_NOTIFY(&rxq->ring, notify);
+		if (notify)
+			notify_remote_via_evtchn(rxq->evtchn);
+	}
 	return status;
 }
 
@@ -326,59 +376,76 @@ static int netfront_rxq_intr_enable(struct uk_netdev_rx_queue *rxq)
 	return (more > 0);
 }
 
-static int netfront_recv(struct uk_netdev *n,
+static int netfront_recv_burst(struct uk_netdev *n,
 		struct uk_netdev_rx_queue *rxq,
-		struct uk_netbuf **pkt)
+		struct uk_netbuf **pkts,
+		uint16_t *cnt)
 {
 	int rc, status = 0;
+	uint16_t nb_pkts = 0, got;
 
 	UK_ASSERT(n != NULL);
 	UK_ASSERT(rxq != NULL);
-	UK_ASSERT(pkt != NULL);
+	UK_ASSERT(pkts != NULL && cnt != NULL);
 
 	/* Queue interrupts have to be off when calling receive */
 	UK_ASSERT(!(rxq->intr_enabled & NETFRONT_INTR_EN));
 
-	rc = netfront_rxq_dequeue(rxq, pkt);
-	UK_ASSERT(rc >= 0);
+	for (;;) {
+		got = 0;
+		while (nb_pkts < *cnt) {
+			rc = netfront_rxq_dequeue(rxq, &pkts[nb_pkts]);
+			UK_ASSERT(rc >= 0);
+			if (!rc)
+				break;
+			nb_pkts++;
+			got++;
+		}
 
-	status |= (*pkt) ? UK_NETDEV_STATUS_SUCCESS : 0x0;
-	status |= netfront_rx_fillup(rxq, rc);
+		/* Refill and notify once for all received packets */
+		status |= netfront_rx_fillup(rxq, got);
 
-	/* Enable interrupt only when user had previously enabled it */
-	if (rxq->intr_enabled & NETFRONT_INTR_USR_EN_MASK) {
-		/* Need to enable the interrupt on the last packet */
-		rc = netfront_rxq_intr_enable(rxq);
-		if (rc == 1 && !(*pkt)) {
-			/**
-			 * Packet arrive after reading the queue and before
-			 * enabling the interrupt
-			 */
-			rc = netfront_rxq_dequeue(rxq, pkt);
-			UK_ASSERT(rc >= 0);
-			status |= UK_NETDEV_STATUS_SUCCESS;
+		/**
+		 * For polling case, we report further packets unless we
+		 * emptied the queue.
+		 */
+		if (!(rxq->intr_enabled & NETFRONT_INTR_USR_EN_MASK)) {
+			if (nb_pkts == *cnt)
+				status |= UK_NETDEV_STATUS_MORE;
+			break;
+		}
 
-			/*
-			 * Since we received something, we need to fillup
-			 * and notify
-			 */
-			status |= netfront_rx_fillup(rxq, rc);
-
-			/* Need to enable the interrupt on the last packet */
-			rc = netfront_rxq_intr_enable(rxq);
-			status |= (rc == 1) ? UK_NETDEV_STATUS_MORE : 0x0;
-		} else if (*pkt) {
-			/* When we originally got a packet and there is more */
-			status |= (rc == 1) ? UK_NETDEV_STATUS_MORE : 0x0;
+		/* Enable interrupt only when user had previously enabled it.
+		 * This fails if there are more packets on the queue.
+		 */
+		rc = netfront_rxq_intr_enable(rxq);
+		if (rc != 1)
+			break;
+		if (nb_pkts == *cnt) {
+			status |= UK_NETDEV_STATUS_MORE;
+			break;
 		}
-	} else if (*pkt) {
 		/**
-		 * For polling case, we report always there are further
-		 * packets unless the queue is empty.
+		 * Packets arrived after reading the queue and before
+		 * enabling the interrupt
 		 */
-		status |= UK_NETDEV_STATUS_MORE;
 	}
 
+	*cnt = nb_pkts;
+	status |= nb_pkts ? UK_NETDEV_STATUS_SUCCESS : 0x0;
+	return status;
+}
+
+static int netfront_recv(struct uk_netdev *n,
+		struct uk_netdev_rx_queue *rxq,
+		struct uk_netbuf **pkt)
+{
+	uint16_t cnt = 1;
+	int status;
+
+	status = netfront_recv_burst(n, rxq, pkt, &cnt);
+	if (cnt == 0)
+		*pkt = NULL;
 	return status;
 }
 
@@ -667,7 +734,8 @@ exit:
 }
 
 static int netfront_configure(struct uk_netdev *n,
-		const struct uk_netdev_conf *conf)
+		const struct uk_netdev_conf *conf,
+		uint32_t offloads __unused)
 {
 	int rc;
 	struct netfront_dev *nfdev;
@@ -815,6 +883,8 @@ static int netfront_add_dev(struct xenbus_device *xendev)
 	/* register netdev */
 	nfdev->netdev.tx_one = netfront_xmit;
 	nfdev->netdev.rx_one = netfront_recv;
+	nfdev->netdev.tx_burst = netfront_xmit_burst;
+	nfdev->netdev.rx_burst = netfront_recv_burst;
 	nfdev->netdev.ops = &netfront_ops;
 	rc = uk_netdev_drv_register(&nfdev->netdev, drv_allocator, DRIVER_NAME);
 	if (rc < 0) {
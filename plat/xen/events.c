@@ -34,11 +34,13 @@
  */
 #include <stdlib.h>
 #include <stdint.h>
+#include <errno.h>
 #include <common/hypervisor.h>
 #include <common/events.h>
 #include <xen/xen.h>
 #include <uk/print.h>
 #include <uk/bitops.h>
+#include <uk/plat/irq.h>
 
 #define NR_EVS 1024
 
@@ -335,3 +337,11 @@ int ukplat_irq_init(struct uk_alloc *a __unused)
 	/* Nothing for now */
 	return 0;
 }
+
+int ukplat_irq_set_exit_handler(irq_exit_func_t func __unused)
+{
+	/* Events are handled on the hypervisor callback path, from which
+	 * we cannot switch threads
+	 */
+	return -ENOTSUP;
+}
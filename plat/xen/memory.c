@@ -163,3 +163,9 @@ void ukplat_stack_set_current_thread(void *thread_addr)
 	extern char irqstack[];
 	*((unsigned long *) irqstack) = (unsigned long) thread_addr;
 }
+
+__sz ukplat_mem_hugepage_size(void)
+{
+	/* Memory is mapped with 4K pages only */
+	return 0;
+}
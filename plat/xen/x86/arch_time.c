@@ -220,11 +220,17 @@ void time_block_until(__snsec until)
 	}
 }
 
+void ukplat_time_set_deadline(__nsec deadline)
+{
+	HYPERVISOR_set_timer_op(deadline);
+}
+
 static void timer_handler(evtchn_port_t ev __unused,
 		struct __regs *regs __unused, void *ign __unused)
 {
 	__nsec until = ukplat_monotonic_clock() + UKPLAT_TIME_TICK_NSEC;
 
+	time_irq_count_inc();
 	HYPERVISOR_set_timer_op(until);
 }
 